@@ -24,6 +24,18 @@
 #include <iosfwd>
 #include <array>
 #include <tiledarray.h>
+#include <TiledArray/pool_allocator.h>
+
+/// Array type of the CC examples
+
+/// Tiles are allocated with \c TiledArray::pool_allocator when the examples
+/// are built with \c TA_CC_USE_POOL_ALLOCATOR defined.
+#ifdef TA_CC_USE_POOL_ALLOCATOR
+typedef TiledArray::DistArray<TiledArray::Tensor<double,
+    TiledArray::pool_allocator<double> >, TiledArray::SparsePolicy> CCArray;
+#else
+typedef TiledArray::TSpArrayD CCArray;
+#endif // TA_CC_USE_POOL_ALLOCATOR
 
 /// Spin enum type
 typedef enum {
@@ -101,15 +113,15 @@ public:
 
   std::string name() const { return name_; }
 
-  TiledArray::TSpArrayD
+  CCArray
   make_f(TiledArray::World& w, const Spin s, const RangeOV ov1, const RangeOV ov2);
 
-  TiledArray::TSpArrayD
+  CCArray
   make_v_ab(TiledArray::World& w, const RangeOV ov1, const RangeOV ov2, const RangeOV ov3, const RangeOV ov4);
 
-  TiledArray::TSpArrayD::value_type
+  CCArray::value_type
   make_D_vo_tile(const TiledArray::Range& range) const {
-    typedef TiledArray::TSpArrayD::value_type tile_type;
+    typedef CCArray::value_type tile_type;
     typedef tile_type::range_type range_type;
 
     // computes tiles of  D(v,v,o,o)
@@ -120,9 +132,9 @@ public:
     return tile;
   }
 
-  TiledArray::TSpArrayD::value_type
+  CCArray::value_type
   make_D_vvoo_tile(const TiledArray::Range& range) const {
-    typedef TiledArray::TSpArrayD::value_type tile_type;
+    typedef CCArray::value_type tile_type;
     typedef tile_type::range_type range_type;
 
     // computes tiles of  D(v,v,o,o)
@@ -0,0 +1,118 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2015  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/math/parallel_gemm.h>
+
+int main(int argc, char** argv) {
+  // Get command line arguments
+  if(argc < 2) {
+    std::cout << "Usage: " << argv[0] << " matrix_size [block_size] [repetitions]\n";
+    return 0;
+  }
+  const long matrix_size = atol(argv[1]);
+  if (matrix_size <= 0) {
+    std::cerr << "Error: matrix size must be greater than zero.\n";
+    return 1;
+  }
+  const long block_size = (argc >= 3 ? atol(argv[2]) :
+      TiledArray::math::ParallelGemmParams::block_size());
+  if (block_size <= 0) {
+    std::cerr << "Error: block size must be greater than zero.\n";
+    return 1;
+  }
+  const long repeat = (argc >= 4 ? atol(argv[3]) : 5);
+  if (repeat <= 0) {
+    std::cerr << "Error: number of repetitions must be greater than zero.\n";
+    return 1;
+  }
+
+  std::cout << "\nMatrix size       = " << matrix_size << "x" << matrix_size
+            << "\nBlock size        = " << block_size << "x" << block_size
+            << "\nMemory per matrix = " << double(matrix_size * matrix_size * sizeof(double)) / 1.0e9
+            << " GB\n";
+
+  // Always use the blocked algorithm
+  TiledArray::math::ParallelGemmParams::threshold() = 0ul;
+  TiledArray::math::ParallelGemmParams::block_size() = block_size;
+
+  // Construct matrices
+  double* a = NULL;
+  if(posix_memalign(reinterpret_cast<void**>(&a), 128, sizeof(double) * matrix_size * matrix_size) != 0)
+    return 1;
+  double* b = NULL;
+  if(posix_memalign(reinterpret_cast<void**>(&b), 128, sizeof(double) * matrix_size * matrix_size) != 0)
+    return 1;
+  double* c_blas = NULL;
+  if(posix_memalign(reinterpret_cast<void**>(&c_blas), 128, sizeof(double) * matrix_size * matrix_size) != 0)
+    return 1;
+  double* c = NULL;
+  if(posix_memalign(reinterpret_cast<void**>(&c), 128, sizeof(double) * matrix_size * matrix_size) != 0)
+    return 1;
+  for(long i = 0l; i < matrix_size * matrix_size; ++i) {
+    a[i] = double(i % 101) / 101.0;
+    b[i] = double(i % 103) / 103.0;
+  }
+  std::fill_n(c_blas, matrix_size * matrix_size, 0.0);
+  std::fill_n(c, matrix_size * matrix_size, 0.0);
+
+  // BLAS dgemm arguments
+  char opa = 'n', opb = 'n';
+  const double alpha = 1l, beta = 0l;
+  const integer m = matrix_size, n = matrix_size, k = matrix_size;
+  const integer lda = matrix_size, ldb = matrix_size, ldc = matrix_size;
+  const double gflop = 2.0 * double(matrix_size * matrix_size * matrix_size) / 1.0e9;
+
+  // Vendor BLAS
+  const double blas_time_start = madness::wall_time();
+  for(int i = 0; i < repeat; ++i) {
+    F77_DGEMM(&opb, &opa, &n, &m, &k, &alpha, b, &ldb, a, &lda, &beta, c_blas, &ldc);
+  }
+  const double blas_time = (madness::wall_time() - blas_time_start) / double(repeat);
+
+  // Blocked, multithreaded gemm
+  const double parallel_time_start = madness::wall_time();
+  for(int i = 0; i < repeat; ++i) {
+    TiledArray::math::parallel_gemm(madness::cblas::NoTrans, madness::cblas::NoTrans,
+        m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  const double parallel_time = (madness::wall_time() - parallel_time_start) / double(repeat);
+
+  // Check the result
+  double max_error = 0.0;
+  for(long i = 0l; i < matrix_size * matrix_size; ++i)
+    max_error = std::max(max_error, std::abs(c[i] - c_blas[i]));
+
+  // Cleanup memory
+  free(a);
+  free(b);
+  free(c_blas);
+  free(c);
+
+  std::cout << "\nBLAS:"
+            << "\n  Average wall time = " << blas_time
+            << "\n  Average GFLOPS    = " << gflop / blas_time
+            << "\nparallel_gemm:"
+            << "\n  Average wall time = " << parallel_time
+            << "\n  Average GFLOPS    = " << gflop / parallel_time
+            << "\nMaximum difference = " << max_error << "\n";
+
+  return 0;
+}
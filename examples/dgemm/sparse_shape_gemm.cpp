@@ -0,0 +1,128 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  sparse_shape_gemm.cpp
+ *  Jun 8, 2018
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <tiledarray.h>
+
+// Construct a matrix shape where fill_percent of the tiles are non-zero
+TiledArray::SparseShape<float> make_shape(const TiledArray::TiledRange& trange,
+    const double fill_percent, const unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  TiledArray::Tensor<float> norms(trange.tiles_range(), 0.0f);
+  for(std::size_t i = 0ul; i < norms.size(); ++i)
+    if(distribution(generator) * 100.0 < fill_percent)
+      norms[i] = distribution(generator) *
+          std::sqrt(float(trange.make_tile_range(i).volume()));
+  return TiledArray::SparseShape<float>(norms, trange);
+}
+
+int main(int argc, char** argv) {
+  // Get command line arguments
+  if(argc < 2) {
+    std::cout << "Usage: " << argv[0] << " matrix_size [block_size] [threshold] [repetitions]\n";
+    return 0;
+  }
+  const long matrix_size = atol(argv[1]);
+  if (matrix_size <= 0) {
+    std::cerr << "Error: matrix size must be greater than zero.\n";
+    return 1;
+  }
+  const long block_size = (argc >= 3 ? atol(argv[2]) : 1l);
+  if (block_size <= 0) {
+    std::cerr << "Error: block size must be greater than zero.\n";
+    return 1;
+  }
+  const float threshold = (argc >= 4 ? atof(argv[3]) :
+      TiledArray::SparseShape<float>::threshold());
+  const long repeat = (argc >= 5 ? atol(argv[4]) : 5);
+  if (repeat <= 0) {
+    std::cerr << "Error: number of repetitions must be greater than zero.\n";
+    return 1;
+  }
+
+  // Construct the tiled range of the matrices, where each tile of the
+  // shape corresponds to a block_size x block_size block of the matrix
+  std::vector<long> blocking;
+  for(long i = 0l; i < matrix_size; i += block_size)
+    blocking.push_back(i);
+  blocking.push_back(matrix_size);
+  std::vector<TiledArray::TiledRange1> blocking2(2,
+      TiledArray::TiledRange1(blocking.begin(), blocking.end()));
+  TiledArray::TiledRange trange(blocking2.begin(), blocking2.end());
+  const long tiles = blocking.size() - 1ul;
+
+  TiledArray::SparseShape<float>::threshold(threshold);
+  const float screened_gemm_ratio = TiledArray::SparseShape<float>::screened_gemm_ratio();
+  const TiledArray::math::GemmHelper gemm_helper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u);
+
+  std::cout << "\nShape size        = " << tiles << "x" << tiles
+            << "\nThreshold         = " << threshold
+            << "\nScreened ratio    = " << screened_gemm_ratio << "\n\n"
+            << "  fill %     dense (s)  screened (s)   default (s)   result fill %   max rel. diff\n";
+
+  for(double fill_percent : { 1.0, 2.0, 5.0, 10.0, 20.0, 30.0, 50.0 }) {
+    const TiledArray::SparseShape<float> left = make_shape(trange, fill_percent, 23u);
+    const TiledArray::SparseShape<float> right = make_shape(trange, fill_percent, 82u);
+
+    // Time the dense, screened, and default algorithms
+    TiledArray::SparseShape<float> dense_result, screened_result;
+    double times[3];
+    const float ratios[3] = { 0.0f, 1.0f, screened_gemm_ratio };
+    for(int x = 0; x < 3; ++x) {
+      TiledArray::SparseShape<float>::screened_gemm_ratio(ratios[x]);
+      const double start = madness::wall_time();
+      for(long r = 0l; r < repeat; ++r) {
+        TiledArray::SparseShape<float> result = left.gemm(right, 1.0, gemm_helper);
+        if(x == 0)
+          dense_result = result;
+        else if(x == 1)
+          screened_result = result;
+      }
+      times[x] = (madness::wall_time() - start) / double(repeat);
+    }
+    TiledArray::SparseShape<float>::screened_gemm_ratio(screened_gemm_ratio);
+
+    // Check the result
+    double max_diff = 0.0;
+    for(long i = 0l; i < tiles * tiles; ++i) {
+      const double expected = dense_result[i];
+      if(expected > 0.0)
+        max_diff = std::max(max_diff, std::abs(screened_result[i] - expected) / expected);
+      else if(screened_result[i] != 0.0f)
+        max_diff = std::numeric_limits<double>::infinity();
+    }
+
+    std::cout << std::setw(8) << fill_percent
+              << std::setw(14) << times[0]
+              << std::setw(14) << times[1]
+              << std::setw(14) << times[2]
+              << std::setw(16) << 100.0 * (1.0 - dense_result.sparsity())
+              << std::setw(16) << max_diff << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Multiplies two dense matrices with decaying elements using each compression
+// mode for the SUMMA broadcasts, and reports the bytes saved, the CPU time
+// spent encoding and decoding, and the error of the result.
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 3) {
+      std::cout << "Usage: ta_compression matrix_size block_size [tolerance = 1e-8]\n";
+      return 0;
+    }
+    const long matrix_size = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    const double tolerance = (argc >= 4 ? atof(argv[3]) : 1.0e-8);
+    if (matrix_size <= 0) {
+      std::cerr << "Error: matrix size must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    if (tolerance <= 0.0) {
+      std::cerr << "Error: tolerance must be greater than zero.\n";
+      return 1;
+    }
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: compressed contraction test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of nodes     = " << world.size()
+                << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+                << "\nBlock size          = " << block_size << "x" << block_size
+                << "\nTolerance           = " << tolerance
+                << "\n";
+
+    // Construct TiledRange
+    std::vector<unsigned int> blocking;
+    for(long i = 0l; i < matrix_size; i += block_size)
+      blocking.push_back(i);
+    blocking.push_back(matrix_size);
+    const TiledArray::TiledRange1 trange1(blocking.begin(), blocking.end());
+    const TiledArray::TiledRange trange = { trange1, trange1 };
+
+    // Elements decay away from the diagonal, as in many physical operators
+    TiledArray::TArrayD a(world, trange), b(world, trange), c;
+    const auto decay = [] (const TiledArray::Range::index& i) {
+      const double d = double(i[0]) - double(i[1]);
+      return std::exp(-0.01 * std::abs(d)) * (i[0] % 2 ? 1.0 : -1.0);
+    };
+    a.init_elements(decay);
+    b.init_elements(decay);
+    world.gop.fence();
+
+    // Reference result
+    c("m,n") = a("m,k") * b("k,n");
+    world.gop.fence();
+
+    const TiledArray::TileCompression modes[] = {
+        TiledArray::TileCompression(),
+        TiledArray::TileCompression(TiledArray::TileCompression::lossless),
+        TiledArray::TileCompression(TiledArray::TileCompression::single),
+        TiledArray::TileCompression(TiledArray::TileCompression::bounded, tolerance) };
+    const char* names[] = { "none", "lossless", "single", "bounded" };
+
+    for(unsigned int m = 0u; m < 4u; ++m) {
+      a.compression(modes[m]);
+      b.compression(modes[m]);
+      TiledArray::TileCompression::reset_counters();
+      world.gop.fence();
+
+      TiledArray::TArrayD r;
+      const double start = madness::wall_time();
+      r("m,n") = a("m,k") * b("k,n");
+      world.gop.fence();
+      const double stop = madness::wall_time();
+
+      double stats[4] = {
+          double(TiledArray::TileCompression::raw_bytes()),
+          double(TiledArray::TileCompression::packed_bytes()),
+          TiledArray::TileCompression::encode_time(),
+          TiledArray::TileCompression::decode_time() };
+      world.gop.sum(stats, 4);
+      const double error = (r("m,n") - c("m,n")).abs_max().get();
+
+      if(world.rank() == 0) {
+        std::cout << "\nMode                 = " << names[m]
+                  << "\nContraction time     = " << stop - start << " s"
+                  << "\nMax abs error        = " << error;
+        if(stats[0] > 0.0)
+          std::cout << "\nBytes encoded        = " << stats[0]
+                    << "\nBytes sent           = " << stats[1]
+                    << "\nCompression ratio    = " << stats[0] / stats[1]
+                    << "\nEncode bandwidth     = " << stats[0] / stats[2] * 1.0e-9 << " GB/s"
+                    << "\nTotal decode time    = " << stats[3] << " s";
+        std::cout << "\n";
+      }
+    }
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
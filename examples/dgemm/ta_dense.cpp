@@ -20,6 +20,7 @@
 #include <iostream>
 #include <tiledarray.h>
 #include <TiledArray/version.h>
+#include <TiledArray/pool_allocator.h>
 #include <madness/world/worldmem.h>
 
 bool to_bool(const char* str) {
@@ -35,9 +36,19 @@ bool to_bool(const char* str) {
 }
 
 // Leave as underscore for now since without it is broken on gcc 11/03/2015 Drew
-template <typename T>
+template <typename T, typename A>
 void gemm_(TiledArray::World& world, const TiledArray::TiledRange& trange, long repeat);
 
+template <typename T>
+void gemm_(TiledArray::World& world, const TiledArray::TiledRange& trange,
+    long repeat, bool use_pool)
+{
+  if (use_pool)
+    gemm_<T, TiledArray::pool_allocator<T>>(world, trange, repeat);
+  else
+    gemm_<T, Eigen::aligned_allocator<T>>(world, trange, repeat);
+}
+
 int main(int argc, char** argv) {
   int rc = 0;
 
@@ -48,7 +59,7 @@ int main(int argc, char** argv) {
 
     // Get command line arguments
     if(argc < 3) {
-      std::cout << "Usage: " << argv[0] << " matrix_size block_size [repetitions] [use_complex]\n";
+      std::cout << "Usage: " << argv[0] << " matrix_size block_size [repetitions] [use_complex] [use_pool]\n";
       return 0;
     }
     const long matrix_size = atol(argv[1]);
@@ -71,6 +82,7 @@ int main(int argc, char** argv) {
       return 1;
     }
     const bool use_complex = (argc >= 5 ? to_bool(argv[4]) : false);
+    const bool use_pool = (argc >= 6 ? to_bool(argv[5]) : false);
 
     const std::size_t num_blocks = matrix_size / block_size;
     const std::size_t block_count = num_blocks * num_blocks;
@@ -85,6 +97,7 @@ int main(int argc, char** argv) {
                 << " GB\nNumber of blocks    = " << block_count
                 << "\nAverage blocks/node = " << double(block_count) / double(world.size())
                 << "\nComplex             = " << (use_complex ? "true" : "false")
+                << "\nPool allocator      = " << (use_pool ? "true" : "false")
                 << "\n";
 
     // Construct TiledRange
@@ -100,9 +113,9 @@ int main(int argc, char** argv) {
       trange(blocking2.begin(), blocking2.end());
 
     if (use_complex)
-      gemm_<std::complex<double>>(world, trange, repeat);
+      gemm_<std::complex<double>>(world, trange, repeat, use_pool);
     else
-      gemm_<double>(world, trange, repeat);
+      gemm_<double>(world, trange, repeat, use_pool);
 
     TiledArray::finalize();
 
@@ -126,9 +139,10 @@ int main(int argc, char** argv) {
   return rc;
 }
 
-template <typename T>
+template <typename T, typename A>
 void
 gemm_(TiledArray::World& world, const TiledArray::TiledRange& trange, long repeat) {
+  typedef TiledArray::DistArray<TiledArray::Tensor<T, A>> array_type;
 
   const bool do_memtrace = false;
 
@@ -148,9 +162,9 @@ gemm_(TiledArray::World& world, const TiledArray::TiledRange& trange, long repea
   memtrace("start");
   {  // array lifetime scope
     // Construct and initialize arrays
-    TiledArray::TArray<T> a(world, trange);
-    TiledArray::TArray<T> b(world, trange);
-    TiledArray::TArray<T> c(world, trange);
+    array_type a(world, trange);
+    array_type b(world, trange);
+    array_type c(world, trange);
     a.fill(1.0);
     b.fill(1.0);
     memtrace("allocated a and b");
@@ -184,6 +198,27 @@ gemm_(TiledArray::World& world, const TiledArray::TiledRange& trange, long repea
                 << " sec\nAverage GFLOPS      = "
                 << total_gflop_rate / double(repeat) << "\n";
 
+    // Print the inter-node traffic saved by node-aware SUMMA broadcasts
+    const auto node_map = TiledArray::detail::NodeMap::instance(world);
+    if (node_map->is_hierarchical()) {
+      double saved_bytes = TiledArray::detail::HierarchicalGroup::saved_bytes();
+      world.gop.sum(saved_bytes);
+      if (world.rank() == 0)
+        std::cout << "Compute nodes       = " << node_map->nodes()
+                  << "\nBcast bytes saved   = " << saved_bytes / 1.0e9 << " GB\n";
+    }
+
+    // Print the tile memory statistics of the pool allocator
+    if (std::is_same<A, TiledArray::pool_allocator<T>>::value) {
+      const TiledArray::detail::MemoryPool& pool = TiledArray::pool_allocator<T>::pool();
+      world.gop.fence();
+      if (world.rank() == 0)
+        std::cout << "Pool high-water mark = " << double(pool.high_water_mark()) / 1.0e9
+                  << " GB\nPool cached memory  = " << double(pool.cached_bytes()) / 1.0e9
+                  << " GB\nPool hits/misses    = " << pool.hits() << "/"
+                  << pool.misses() << "\n";
+    }
+
   }  // array lifetime scope
   memtrace("stop");
 }
@@ -0,0 +1,150 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Multiplies two matrices whose off-diagonal blocks are smooth, and hence
+// numerically low rank, using dense tiles and low-rank tiles, and reports the
+// time, the memory held by the local tiles, and the error of the result.
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 3) {
+      std::cout << "Usage: ta_low_rank matrix_size block_size [tolerance = 1e-8]\n";
+      return 0;
+    }
+    const long matrix_size = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    const double tolerance = (argc >= 4 ? atof(argv[3]) : 1.0e-8);
+    if (matrix_size <= 0) {
+      std::cerr << "Error: matrix size must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    if (tolerance < 0.0) {
+      std::cerr << "Error: tolerance must be non-negative.\n";
+      return 1;
+    }
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: low-rank contraction test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of nodes     = " << world.size()
+                << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+                << "\nBlock size          = " << block_size << "x" << block_size
+                << "\nTolerance           = " << tolerance
+                << "\n";
+
+    // Construct TiledRange
+    std::vector<unsigned int> blocking;
+    for(long i = 0l; i < matrix_size; i += block_size)
+      blocking.push_back(i);
+    blocking.push_back(matrix_size);
+    const TiledArray::TiledRange1 trange1(blocking.begin(), blocking.end());
+    const TiledArray::TiledRange trange = { trange1, trange1 };
+
+    // A smooth kernel, 1 / (1 + |x - y|), as in many integral operators
+    typedef TiledArray::LowRankTensor<double> low_rank_tile;
+    typedef TiledArray::DistArray<low_rank_tile> TArrayLR;
+    TiledArray::TArrayD a(world, trange), b(world, trange), c, r;
+    const auto kernel = [] (const TiledArray::Range::index& i) {
+      return 1.0 / (1.0 + std::abs(double(i[0]) - double(i[1])));
+    };
+    a.init_elements(kernel);
+    b.init_elements(kernel);
+    world.gop.fence();
+
+    const auto compress = [=] (const TiledArray::Tensor<double>& tile) {
+      return low_rank_tile(tile, tolerance);
+    };
+    TArrayLR la = TiledArray::to_new_tile_type(a, compress);
+    TArrayLR lb = TiledArray::to_new_tile_type(b, compress);
+    TArrayLR lc;
+    world.gop.fence();
+
+    // Dense contraction
+    double start = madness::wall_time();
+    c("m,n") = a("m,k") * b("k,n");
+    world.gop.fence();
+    const double dense_time = madness::wall_time() - start;
+
+    // Low-rank contraction
+    start = madness::wall_time();
+    lc("m,n") = la("m,k") * lb("k,n");
+    world.gop.fence();
+    const double low_rank_time = madness::wall_time() - start;
+
+    // Count the elements held by the local tiles
+    double stats[3] = { 0.0, 0.0, 0.0 };
+    for(auto it = lc.begin(); it != lc.end(); ++it) {
+      const low_rank_tile& tile = it->get();
+      stats[0] += double(tile.size());
+      stats[1] += double(tile.u().size() + tile.v().size());
+      stats[2] = std::max(stats[2], double(tile.rank()));
+    }
+    world.gop.sum(stats, 2);
+    world.gop.max(stats + 2, 1);
+
+    r = TiledArray::to_new_tile_type(lc,
+        [] (const low_rank_tile& tile) { return tile.dense(); });
+    const double error = (r("m,n") - c("m,n")).abs_max().get();
+
+    if(world.rank() == 0)
+      std::cout << "\nDense time           = " << dense_time << " s"
+                << "\nLow-rank time        = " << low_rank_time << " s"
+                << "\nDense elements       = " << stats[0]
+                << "\nLow-rank elements    = " << stats[1]
+                << "\nMemory ratio         = " << stats[0] / stats[1]
+                << "\nMax tile rank        = " << stats[2]
+                << "\nMax abs error        = " << error
+                << "\n";
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
@@ -0,0 +1,157 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Measures the write and read throughput of array checkpoints. Reading is
+// timed in two steps: mapping the data files, and the first pass over the
+// tile data, which loads the pages from disk.
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 4) {
+      std::cout << "Usage: ta_checkpoint matrix_size block_size path [repetitions]\n";
+      return 0;
+    }
+    const long matrix_size = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    const std::string path = argv[3];
+    if (matrix_size <= 0) {
+      std::cerr << "Error: matrix size must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    const long repeat = (argc >= 5 ? atol(argv[4]) : 5);
+    if (repeat <= 0) {
+      std::cerr << "Error: number of repetitions must be greater than zero.\n";
+      return 1;
+    }
+
+    const double gbytes = double(matrix_size) * double(matrix_size) *
+        double(sizeof(double)) * 1.0e-9;
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: checkpoint I/O test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of nodes     = " << world.size()
+                << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+                << "\nBlock size          = " << block_size << "x" << block_size
+                << "\nMemory per matrix   = " << gbytes << " GB"
+                << "\nPath                = " << path
+                << "\nRepetitions         = " << repeat
+                << "\n";
+
+    // Construct TiledRange
+    std::vector<unsigned int> blocking;
+    for(long i = 0l; i < matrix_size; i += block_size)
+      blocking.push_back(i);
+    blocking.push_back(matrix_size);
+    const TiledArray::TiledRange1 trange1(blocking.begin(), blocking.end());
+    const TiledArray::TiledRange trange = { trange1, trange1 };
+
+    TiledArray::TArrayD a(world, trange);
+    a.fill_local(1.0);
+    world.gop.fence();
+
+    double write_time = 0.0, map_time = 0.0, load_time = 0.0;
+    for(long r = 0l; r < repeat; ++r) {
+      // Write the checkpoint
+      world.gop.fence();
+      double start = madness::wall_time();
+      TiledArray::write_checkpoint(a, path);
+      double stop = madness::wall_time();
+      const double write_dt = stop - start;
+      write_time += write_dt;
+
+      // Map the checkpoint
+      start = madness::wall_time();
+      TiledArray::TArrayD b = TiledArray::read_checkpoint<TiledArray::TArrayD>(world, path);
+      world.gop.fence();
+      stop = madness::wall_time();
+      double read_dt = stop - start;
+      map_time += stop - start;
+
+      // Touch every element of the local tiles
+      start = madness::wall_time();
+      double sum = 0.0;
+      for(const std::size_t index : *b.pmap()) {
+        const TiledArray::TArrayD::value_type tile = b.find(index).get();
+        sum += tile.sum();
+      }
+      world.gop.sum(sum);
+      stop = madness::wall_time();
+      read_dt += stop - start;
+      load_time += stop - start;
+
+      if(world.rank() == 0 && sum != double(matrix_size) * double(matrix_size))
+        std::cout << "Error: checkpoint data does not match the array.\n";
+
+      if(world.rank() == 0)
+        std::cout << "Iteration " << r + 1
+                  << "   write = " << gbytes / write_dt << " GB/s"
+                  << "   read = " << gbytes / read_dt << " GB/s\n";
+    }
+
+    if(world.rank() == 0)
+      std::cout << "Average write time   = " << write_time / double(repeat) << " s"
+                << "\nWrite throughput     = " << gbytes * double(repeat) / write_time << " GB/s"
+                << "\nAverage map time     = " << map_time / double(repeat) << " s"
+                << "\nAverage load time    = " << load_time / double(repeat) << " s"
+                << "\nRead throughput      = " << gbytes * double(repeat) / (map_time + load_time) << " GB/s\n";
+
+    // Remove the checkpoint files
+    world.gop.fence();
+    std::remove(TiledArray::detail::CheckpointFormat::data_file(path, world.rank()).c_str());
+    if(world.rank() == 0)
+      std::remove(path.c_str());
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
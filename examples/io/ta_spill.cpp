@@ -0,0 +1,132 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Multiplies two dense matrices with a limited resident set, so tiles are
+// spilled to disk and read back by the contraction, and reports the spill
+// and fill bandwidth.
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 5) {
+      std::cout << "Usage: ta_spill matrix_size block_size resident_MB directory\n";
+      return 0;
+    }
+    const long matrix_size = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    const long resident = atol(argv[3]);
+    const std::string directory = argv[4];
+    if (matrix_size <= 0) {
+      std::cerr << "Error: matrix size must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    if (resident <= 0) {
+      std::cerr << "Error: resident set size must be greater than zero.\n";
+      return 1;
+    }
+
+    const double gbytes = double(matrix_size) * double(matrix_size) *
+        double(sizeof(double)) * 1.0e-9;
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: out-of-core contraction test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of nodes     = " << world.size()
+                << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+                << "\nBlock size          = " << block_size << "x" << block_size
+                << "\nMemory per matrix   = " << gbytes << " GB"
+                << "\nResident set        = " << resident << " MB per process"
+                << "\nDirectory           = " << directory
+                << "\n";
+
+    // Construct TiledRange
+    std::vector<unsigned int> blocking;
+    for(long i = 0l; i < matrix_size; i += block_size)
+      blocking.push_back(i);
+    blocking.push_back(matrix_size);
+    const TiledArray::TiledRange1 trange1(blocking.begin(), blocking.end());
+    const TiledArray::TiledRange trange = { trange1, trange1 };
+
+    // Arrays constructed after this point spill tiles
+    TiledArray::TileSpill& spill = TiledArray::TileSpill::instance();
+    spill.directory(directory);
+    spill.max_bytes(resident * 1000000l);
+
+    TiledArray::TArrayD a(world, trange), b(world, trange), c;
+    a.fill_local(1.0);
+    b.fill_local(1.0);
+    world.gop.fence();
+
+    double start = madness::wall_time();
+    c("m,n") = a("m,k") * b("k,n");
+    world.gop.fence();
+    double stop = madness::wall_time();
+
+    const double gflops = 2.0 * double(matrix_size) * double(matrix_size) *
+        double(matrix_size) * 1.0e-9;
+    const double sum = c("m,n").sum().get();
+    if(world.rank() == 0 && sum != double(matrix_size) * double(matrix_size) * double(matrix_size))
+      std::cout << "Error: the result is incorrect.\n";
+
+    if(world.rank() == 0)
+      std::cout << "Contraction time     = " << stop - start << " s"
+                << "\nFLOPS                = " << gflops / (stop - start) << " GFLOPS"
+                << "\nRank 0 statistics:"
+                << "\nTiles spilled        = " << spill.spill_count()
+                << "\nBytes spilled        = " << spill.spill_bytes()
+                << "\nSpill bandwidth      = " << spill.spill_bandwidth() * 1.0e-9 << " GB/s"
+                << "\nTiles filled         = " << spill.fill_count()
+                << "\nBytes filled         = " << spill.fill_bytes()
+                << "\nFill bandwidth       = " << spill.fill_bandwidth() * 1.0e-9 << " GB/s\n";
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
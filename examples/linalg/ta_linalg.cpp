@@ -0,0 +1,178 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  ta_linalg.cpp
+ *  Aug 8, 2018
+ *
+ */
+
+#include <cmath>
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 3) {
+      std::cout << "Usage: " << argv[0] << " matrix_size block_size [repetitions] [eigensolver]\n";
+      return 0;
+    }
+    const long matrix_size = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    if (matrix_size <= 0) {
+      std::cerr << "Error: matrix size must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    const long repeat = (argc >= 4 ? atol(argv[3]) : 5);
+    if (repeat <= 0) {
+      std::cerr << "Error: number of repetitions must be greater than zero.\n";
+      return 1;
+    }
+    const bool do_heig = (argc >= 5 ? atol(argv[4]) != 0 : false);
+
+    const std::size_t num_blocks = (matrix_size + block_size - 1) / block_size;
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: dense linear algebra test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of nodes     = " << world.size()
+                << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+                << "\nBlock size          = " << block_size << "x" << block_size
+                << "\nMemory per matrix   = " << double(matrix_size * matrix_size * sizeof(double)) / 1.0e9
+                << " GB\nNumber of blocks    = " << num_blocks * num_blocks
+                << "\nEigensolver         = " << (do_heig ? "true" : "false")
+                << "\n";
+
+    // Construct TiledRange
+    std::vector<unsigned int> blocking;
+    blocking.reserve(num_blocks + 1);
+    for(long i = 0l; i < matrix_size; i += block_size)
+      blocking.push_back(i);
+    blocking.push_back(matrix_size);
+
+    const TiledArray::TiledRange1 tr1(blocking.begin(), blocking.end());
+    const TiledArray::TiledRange trange({ tr1, tr1 });
+    const TiledArray::TiledRange rhs_trange({ tr1,
+        TiledArray::TiledRange1{ 0ul, std::size_t(block_size) } });
+
+    // Make a symmetric positive definite matrix and a right-hand side
+    auto make_array = [&world] (const TiledArray::TiledRange& tr, const bool diagonal) {
+      TiledArray::TArrayD array(world, tr);
+      for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+        array.set(*it, world.taskq.add([diagonal] (const TiledArray::Range& range) {
+          TiledArray::TArrayD::value_type tile(range);
+          for(auto idx : range) {
+            const double d = std::abs(double(idx[0]) - double(idx[1]));
+            tile[idx] = 1.0 / (1.0 + d) + (diagonal && idx[0] == idx[1] ? 4.0 : 0.0);
+          }
+          return tile;
+        }, array.trange().make_tile_range(*it)));
+      }
+      return array;
+    };
+    TiledArray::TArrayD a = make_array(trange, true);
+    TiledArray::TArrayD b = make_array(rhs_trange, false);
+    world.gop.fence();
+
+    const double n = matrix_size;
+    const double cholesky_gflop = n * n * n / 3.0e9;
+    const double solve_gflop = 2.0 * n * n * double(block_size) / 1.0e9;
+    double cholesky_time = 0.0, solve_time = 0.0;
+
+    for(long r = 0l; r < repeat; ++r) {
+      double start = madness::wall_time();
+      TiledArray::TArrayD l = TiledArray::cholesky(a);
+      world.gop.fence();
+      const double time = madness::wall_time() - start;
+      cholesky_time += time;
+
+      start = madness::wall_time();
+      TiledArray::TArrayD x = TiledArray::triangular_solve(l,
+          TiledArray::triangular_solve(l, b), true);
+      world.gop.fence();
+      solve_time += madness::wall_time() - start;
+
+      if(world.rank() == 0)
+        std::cout << "Iteration " << r + 1 << "   cholesky time=" << time
+                  << "   GFLOPS=" << cholesky_gflop / time << "\n";
+
+      if(r == 0l) {
+        TiledArray::TArrayD residual;
+        residual("i,j") = a("i,k") * x("k,j") - b("i,j");
+        const double norm = residual("i,j").norm().get();
+        if(world.rank() == 0)
+          std::cout << "Solve residual norm = " << norm << "\n";
+      }
+    }
+
+    if(world.rank() == 0)
+      std::cout << "Average cholesky wall time = " << cholesky_time / double(repeat)
+                << " sec\nAverage cholesky GFLOPS   = " << cholesky_gflop * double(repeat) / cholesky_time
+                << "\nAverage solve wall time    = " << solve_time / double(repeat)
+                << " sec\nAverage solve GFLOPS      = " << solve_gflop * double(repeat) / solve_time
+                << "\n";
+
+    if(do_heig) {
+      const double start = madness::wall_time();
+      std::vector<double> evals;
+      TiledArray::TArrayD evecs;
+      std::tie(evals, evecs) = TiledArray::heig(a);
+      world.gop.fence();
+      const double time = madness::wall_time() - start;
+
+      TiledArray::TArrayD vtv;
+      vtv("i,j") = evecs("k,i") * evecs("k,j");
+      const double trace = vtv("i,j").trace().get();
+
+      if(world.rank() == 0)
+        std::cout << "Eigensolver wall time = " << time
+                  << " sec\nLowest eigenvalue     = " << evals.front()
+                  << "\nHighest eigenvalue    = " << evals.back()
+                  << "\nTrace of V^T V        = " << trace << " (expected " << n << ")\n";
+    }
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
@@ -0,0 +1,144 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  sparse_pmap.cpp
+ *  Jun 6, 2018
+ *
+ */
+
+#include "tiledarray.h"
+#include "TiledArray/pmap/balanced_pmap.h"
+#include "TiledArray/pmap/hash_pmap.h"
+#include <iomanip>
+#include <numeric>
+#include <random>
+
+// Print the load imbalance, i.e. the ratio of the maximum and average load per
+// process, of the non-zero tiles and elements of a sparse array
+void print_imbalance(TiledArray::World& world, const char* name,
+    const std::shared_ptr<TiledArray::Pmap>& pmap,
+    const TiledArray::TiledRange& trange,
+    const TiledArray::SparseShape<float>& shape)
+{
+  std::vector<double> tiles(world.size(), 0.0);
+  std::vector<double> elements(world.size(), 0.0);
+  for(std::size_t i = 0ul; i < pmap->size(); ++i) {
+    if(shape.is_zero(i))
+      continue;
+    const std::size_t owner = pmap->owner(i);
+    tiles[owner] += 1.0;
+    elements[owner] += trange.make_tile_range(i).volume();
+  }
+
+  const double avg_tiles =
+      std::accumulate(tiles.begin(), tiles.end(), 0.0) / double(world.size());
+  const double avg_elements =
+      std::accumulate(elements.begin(), elements.end(), 0.0) / double(world.size());
+
+  if(world.rank() == 0)
+    std::cout << std::setw(10) << name
+        << "  tiles max/avg = " << std::setw(8) << std::setprecision(4)
+        << *std::max_element(tiles.begin(), tiles.end()) / avg_tiles
+        << "  elements max/avg = " << std::setw(8) << std::setprecision(4)
+        << *std::max_element(elements.begin(), elements.end()) / avg_elements
+        << "\n";
+}
+
+int main(int argc, char** argv) {
+  TiledArray::World& world = TiledArray::initialize(argc,argv);
+
+  // Get command line arguments
+  if(argc < 3) {
+    std::cout << "Usage: " << argv[0] << " matrix_size block_size [sparsity = 0.9]\n";
+    TiledArray::finalize();
+    return 0;
+  }
+  const long matrix_size = atol(argv[1]);
+  const long block_size = atol(argv[2]);
+  if (matrix_size <= 0) {
+    std::cerr << "Error: matrix size must be greater than zero.\n";
+    TiledArray::finalize();
+    return 1;
+  }
+  if (block_size <= 0) {
+    std::cerr << "Error: block size must be greater than zero.\n";
+    TiledArray::finalize();
+    return 1;
+  }
+  const double sparsity = (argc > 3 ? atof(argv[3]) : 0.9);
+  if((sparsity < 0.0) || (sparsity >= 1.0)) {
+    std::cerr << "Error: sparsity must be in the range [0, 1).\n";
+    TiledArray::finalize();
+    return 1;
+  }
+
+  // Construct a tiled range with a ragged last block
+  std::vector<long> blocking;
+  for(long i = 0l; i < matrix_size; i += block_size)
+    blocking.push_back(i);
+  blocking.push_back(matrix_size);
+  std::vector<TiledArray::TiledRange1> blocking2(2,
+      TiledArray::TiledRange1(blocking.begin(), blocking.end()));
+  TiledArray::TiledRange trange(blocking2.begin(), blocking2.end());
+
+  // Construct a block-sparse shape where the density of non-zero tiles decays
+  // away from the diagonal, which is typical of local correlation methods.
+  // The same seed is used on all processes so the shapes are identical.
+  const std::size_t n = trange.tiles_range().extent_data()[0];
+  const std::size_t tiles = trange.tiles_range().volume();
+  TiledArray::Tensor<float> norms(trange.tiles_range(), 0.0f);
+  std::size_t nonzero_tiles = 0ul;
+  std::mt19937 generator(42u);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  for(std::size_t i = 0ul; i < n; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      const double distance = std::abs(double(i) - double(j)) / double(n);
+      const double density = (1.0 - sparsity) * 2.0 * std::exp(-4.0 * distance);
+      if(distribution(generator) < density) {
+        norms[i * n + j] = 1.0f;
+        ++nonzero_tiles;
+      }
+    }
+  }
+  TiledArray::SparseShape<float> shape(norms, trange);
+
+  if(world.rank() == 0)
+    std::cout << "TiledArray: sparse process map imbalance"
+        << "\nNumber of nodes     = " << world.size()
+        << "\nMatrix size         = " << matrix_size << "x" << matrix_size
+        << "\nBlock size          = " << block_size << "x" << block_size
+        << "\nNon-zero tiles      = " << nonzero_tiles
+        << " of " << tiles << "\n\n";
+
+  std::shared_ptr<TiledArray::Pmap> blocked_pmap(
+      new TiledArray::detail::BlockedPmap(world, tiles));
+  std::shared_ptr<TiledArray::Pmap> cyclic_pmap =
+      TiledArray::detail::ProcGrid(world, n, n, matrix_size, matrix_size).make_pmap();
+  std::shared_ptr<TiledArray::Pmap> hash_pmap(
+      new TiledArray::detail::HashPmap(world, tiles));
+  std::shared_ptr<TiledArray::Pmap> balanced_pmap =
+      TiledArray::SparsePolicy::balanced_pmap(world, trange, shape);
+
+  print_imbalance(world, "Blocked", blocked_pmap, trange, shape);
+  print_imbalance(world, "Cyclic", cyclic_pmap, trange, shape);
+  print_imbalance(world, "Hash", hash_pmap, trange, shape);
+  print_imbalance(world, "Balanced", balanced_pmap, trange, shape);
+
+  TiledArray::finalize();
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Measures the throughput of small tile creation and permutation, which is
+// dominated by Range construction. Configure with RANGE_INLINE_RANK=0 to
+// compare against ranges that always allocate their data on the heap.
+
+template <typename T>
+void tile_test(TiledArray::World& world, const std::vector<std::size_t>& extent,
+    const long repeat);
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 2) {
+      std::cout << "Usage: ta_tile block_size [repetitions]\n";
+      return 0;
+    }
+    const long block_size = atol(argv[1]);
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    const long repeat = (argc >= 3 ? atol(argv[2]) : 100000);
+    if (repeat <= 0) {
+      std::cerr << "Error: number of repetitions must be greater than zero.\n";
+      return 1;
+    }
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: tile creation and permutation test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nBlock size          = " << block_size
+                << "\nRepetitions         = " << repeat
+                << "\nInline range rank   = " << TiledArray::Range::inline_rank
+                << "\n";
+
+    for(unsigned int rank = 2u; rank <= 4u; ++rank) {
+      if(world.rank() == 0)
+        std::cout << "\nRank " << rank << " tiles:\n";
+      tile_test<double>(world, std::vector<std::size_t>(rank, block_size), repeat);
+    }
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
+
+template <typename T>
+void
+tile_test(TiledArray::World& world, const std::vector<std::size_t>& extent,
+    const long repeat)
+{
+  typedef TiledArray::Tensor<T> tile_type;
+
+  const TiledArray::Range range(extent);
+  const tile_type tile(range, T(1));
+  std::vector<std::size_t> lower(extent.size(), 0ul), upper(extent);
+  for(auto& x : upper)
+    x = (x + 1ul) / 2ul;
+
+  // Reverse permutation of the tile dimensions
+  std::vector<unsigned int> perm_indices(extent.size());
+  for(unsigned int i = 0u; i < perm_indices.size(); ++i)
+    perm_indices[i] = perm_indices.size() - i - 1u;
+  const TiledArray::Permutation perm(perm_indices);
+
+  std::size_t check = 0ul;
+
+  double start = madness::wall_time();
+  for(long i = 0l; i < repeat; ++i) {
+    TiledArray::Range r(range);
+    check += r.volume();
+  }
+  double stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Range copy:       " << double(repeat) / (stop - start) << " /s\n";
+
+  start = madness::wall_time();
+  for(long i = 0l; i < repeat; ++i) {
+    tile_type t(range);
+    check += t.size();
+  }
+  stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Tile create:      " << double(repeat) / (stop - start) << " /s\n";
+
+  start = madness::wall_time();
+  for(long i = 0l; i < repeat; ++i) {
+    auto b = tile.block(lower, upper);
+    check += b.range().volume();
+  }
+  stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Tile block view:  " << double(repeat) / (stop - start) << " /s\n";
+
+  start = madness::wall_time();
+  for(long i = 0l; i < repeat; ++i) {
+    tile_type t = tile.permute(perm);
+    check += t.size();
+  }
+  stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Tile permute:     " << double(repeat) / (stop - start) << " /s\n";
+
+  if(check == 0ul)
+    std::cout << "Error: no tiles were created.\n";
+}
@@ -0,0 +1,139 @@
+/*
+ * This file is a part of TiledArray.
+ * Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <tiledarray.h>
+#include <TiledArray/version.h>
+
+// Measures the cost of constructing and copying TiledRange1 objects, and of
+// element to tile lookups, for uniform and nonuniform tilings.
+
+void trange1_test(TiledArray::World& world, const std::string& name,
+    const std::vector<std::size_t>& boundaries, const long repeat);
+
+int main(int argc, char** argv) {
+  int rc = 0;
+
+  try {
+
+    // Initialize runtime
+    TiledArray::World& world = TiledArray::initialize(argc, argv);
+
+    // Get command line arguments
+    if(argc < 3) {
+      std::cout << "Usage: ta_tiled_range1 num_elements block_size [repetitions]\n";
+      return 0;
+    }
+    const long num_elements = atol(argv[1]);
+    const long block_size = atol(argv[2]);
+    if (num_elements <= 0) {
+      std::cerr << "Error: number of elements must be greater than zero.\n";
+      return 1;
+    }
+    if (block_size <= 0) {
+      std::cerr << "Error: block size must be greater than zero.\n";
+      return 1;
+    }
+    const long repeat = (argc >= 4 ? atol(argv[3]) : 10000000);
+    if (repeat <= 0) {
+      std::cerr << "Error: number of repetitions must be greater than zero.\n";
+      return 1;
+    }
+
+    if(world.rank() == 0)
+      std::cout << "TiledArray: tiled range lookup test..."
+                << "\nGit HASH: " << TILEDARRAY_REVISION
+                << "\nNumber of elements  = " << num_elements
+                << "\nBlock size          = " << block_size
+                << "\nRepetitions         = " << repeat
+                << "\n";
+
+    // Uniform tiles, with a smaller last tile
+    std::vector<std::size_t> uniform;
+    for(long i = 0l; i < num_elements; i += block_size)
+      uniform.push_back(i);
+    uniform.push_back(num_elements);
+    trange1_test(world, "Uniform", uniform, repeat);
+
+    // Tiles with sizes between 1/2 and 3/2 of the block size
+    std::mt19937 generator(42u);
+    std::uniform_int_distribution<long> distribution(std::max(1l, block_size / 2l),
+        std::max(1l, block_size + block_size / 2l));
+    std::vector<std::size_t> nonuniform(1, 0ul);
+    for(long i = distribution(generator); i < num_elements; i += distribution(generator))
+      nonuniform.push_back(i);
+    nonuniform.push_back(num_elements);
+    trange1_test(world, "Nonuniform", nonuniform, repeat);
+
+    TiledArray::finalize();
+
+  } catch(TiledArray::Exception& e) {
+    std::cerr << "!! TiledArray exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(madness::MadnessException& e) {
+    std::cerr << "!! MADNESS exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(SafeMPI::Exception& e) {
+    std::cerr << "!! SafeMPI exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(std::exception& e) {
+    std::cerr << "!! std exception: " << e.what() << "\n";
+    rc = 1;
+  } catch(...) {
+    std::cerr << "!! exception: unknown exception\n";
+    rc = 1;
+  }
+
+  return rc;
+}
+
+void trange1_test(TiledArray::World& world, const std::string& name,
+    const std::vector<std::size_t>& boundaries, const long repeat)
+{
+  if(world.rank() == 0)
+    std::cout << "\n" << name << " tiling, " << boundaries.size() - 1ul << " tiles:\n";
+
+  double start = madness::wall_time();
+  const TiledArray::TiledRange1 trange1(boundaries.begin(), boundaries.end());
+  double stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Construct:        " << stop - start << " s\n";
+
+  start = madness::wall_time();
+  const TiledArray::TiledRange1 copy(trange1);
+  stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Copy:             " << stop - start << " s\n";
+
+  // Look up pseudo-random elements
+  const std::size_t num_elements = trange1.extent();
+  std::size_t element = 0ul, check = 0ul;
+  start = madness::wall_time();
+  for(long i = 0l; i < repeat; ++i) {
+    element = (element * 1103515245ul + 12345ul) % num_elements;
+    check += copy.element_to_tile(element);
+  }
+  stop = madness::wall_time();
+  if(world.rank() == 0)
+    std::cout << "Element to tile:  " << double(repeat) / (stop - start) << " /s\n";
+
+  if(check == 0ul && trange1.tile_extent() > 1ul)
+    std::cout << "Error: no tiles were found.\n";
+}
@@ -0,0 +1,343 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  cholesky.h
+ *  Aug 6, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_ALGEBRA_CHOLESKY_H__INCLUDED
+#define TILEDARRAY_ALGEBRA_CHOLESKY_H__INCLUDED
+
+#include <vector>
+#include <TiledArray/error.h>
+#include <TiledArray/conversions/eigen.h>
+#include "../dist_array.h"
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Check that an array is a square matrix with identical row and column tilings
+
+    /// \param array The array to be checked
+    /// \param message The error message
+    /// \throw TiledArray::Exception When \c array is not a square matrix or
+    /// the tilings of its rows and columns differ.
+    template <typename Tile, typename Policy>
+    inline void check_square_matrix(const DistArray<Tile, Policy>& array,
+        const char* const message)
+    {
+      TA_USER_ASSERT(array.trange().tiles_range().rank() == 2u, message);
+      TA_USER_ASSERT(array.trange().data()[0] == array.trange().data()[1], message);
+    }
+
+    /// Factorize a diagonal tile
+
+    /// \param a The diagonal tile of a Hermitian positive definite matrix
+    /// \return The lower triangular factor \c l of <tt>a = l * l^H</tt> , or
+    /// a zero tile when \c a is not positive definite
+    template <typename T, typename A>
+    Tensor<T, A> cholesky_tile(const Tensor<T, A>& a) {
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix_type;
+
+      Tensor<T, A> result(a.range(), T(0));
+      Eigen::LLT<matrix_type, Eigen::Lower> llt(eigen_map(a));
+      if(llt.info() == Eigen::Success)
+        eigen_map(result).template triangularView<Eigen::Lower>() = llt.matrixL();
+      return result;
+    }
+
+    /// Tiles of a distributed array that are fetched at most once
+
+    /// The tiles of a triangular factor are used by many tile updates on
+    /// each rank. This object holds the futures of the tiles that have been
+    /// requested, so every tile is fetched once per rank and shared by all
+    /// of its updates.
+    /// \tparam Array The array type
+    template <typename Array>
+    class TileFutures {
+    public:
+      typedef typename Array::value_type value_type; ///< The tile type
+
+    private:
+      const Array& array_; ///< The array that holds the tiles
+      std::vector<Future<value_type> > tiles_; ///< The requested tiles
+      std::vector<bool> requested_; ///< Request flags of the tiles
+
+    public:
+
+      /// Constructor
+
+      /// \param array The array that holds the tiles
+      explicit TileFutures(const Array& array) :
+        array_(array), tiles_(array.size()), requested_(array.size(), false)
+      { }
+
+      /// Tile accessor
+
+      /// \param i The ordinal index of the tile
+      /// \return A future to tile \c i
+      const Future<value_type>& operator[](const std::size_t i) {
+        if(! requested_[i]) {
+          tiles_[i] = array_.find(i);
+          requested_[i] = true;
+        }
+        return tiles_[i];
+      }
+    }; // class TileFutures
+
+    /// Subtract the product of two tiles
+
+    /// \param c The tile to be updated
+    /// \param left The left-hand tile
+    /// \param right The right-hand tile
+    /// \return <tt>c - left * right^H</tt>
+    template <typename T, typename A>
+    Tensor<T, A> cholesky_update_tile(const Tensor<T, A>& c,
+        const Tensor<T, A>& left, const Tensor<T, A>& right)
+    {
+      Tensor<T, A> result = c.clone();
+      eigen_map(result).noalias() -= eigen_map(left) * eigen_map(right).adjoint();
+      return result;
+    }
+
+    /// Solve for an off-diagonal tile of a Cholesky factor
+
+    /// \param l The lower triangular diagonal tile of the factor
+    /// \param b The updated tile of the matrix
+    /// \return \c x such that <tt>x * l^H = b</tt>
+    template <typename T, typename A>
+    Tensor<T, A> cholesky_solve_tile(const Tensor<T, A>& l, const Tensor<T, A>& b) {
+      Tensor<T, A> result = b.clone();
+      eigen_map(l).adjoint().template triangularView<Eigen::Upper>().
+          template solveInPlace<Eigen::OnTheRight>(eigen_map(result));
+      return result;
+    }
+
+    /// Subtract the product of a triangular factor tile and a solution tile
+
+    /// \param c The tile to be updated
+    /// \param l The tile of the triangular factor
+    /// \param x The tile of the solution
+    /// \param adjoint If \c true , use the adjoint of \c l
+    /// \return <tt>c - op(l) * x</tt>
+    template <typename T, typename A>
+    Tensor<T, A> triangular_update_tile(const Tensor<T, A>& c,
+        const Tensor<T, A>& l, const Tensor<T, A>& x, const bool adjoint)
+    {
+      Tensor<T, A> result = c.clone();
+      if(adjoint)
+        eigen_map(result).noalias() -= eigen_map(l).adjoint() * eigen_map(x);
+      else
+        eigen_map(result).noalias() -= eigen_map(l) * eigen_map(x);
+      return result;
+    }
+
+    /// Solve a triangular system for one tile of the solution
+
+    /// \param l The lower triangular diagonal tile
+    /// \param b The updated tile of the right-hand side
+    /// \param adjoint If \c true , use the adjoint of \c l
+    /// \return \c x such that <tt>op(l) * x = b</tt>
+    template <typename T, typename A>
+    Tensor<T, A> triangular_solve_tile(const Tensor<T, A>& l,
+        const Tensor<T, A>& b, const bool adjoint)
+    {
+      Tensor<T, A> result = b.clone();
+      if(adjoint)
+        eigen_map(l).adjoint().template triangularView<Eigen::Upper>().
+            solveInPlace(eigen_map(result));
+      else
+        eigen_map(l).template triangularView<Eigen::Lower>().
+            solveInPlace(eigen_map(result));
+      return result;
+    }
+
+  } // namespace detail
+
+  /// Cholesky factorization of a Hermitian positive definite matrix
+
+  /// The factor is computed with a left-looking tile algorithm, where each
+  /// tile of the result is computed by a chain of tasks on the rank that
+  /// owns it. Tasks depend on the tiles of the factor through futures, so
+  /// the factorization proceeds without global synchronization; each tile
+  /// of the factor is fetched once by each rank that uses it. This function
+  /// waits for the diagonal tiles of the factor that are owned by this rank,
+  /// which are the last tiles of each of its task chains, and checks on all
+  /// ranks that the matrix is positive definite. The strictly upper
+  /// triangular tiles of the result are zero. This is a collective
+  /// operation.
+  /// Usage:
+  /// \code
+  /// TiledArray::TArrayD a(world, trange);
+  /// // Fill a with a positive definite matrix ...
+  ///
+  /// TiledArray::TArrayD l = cholesky(a);
+  /// \endcode
+  /// \tparam T The element type
+  /// \tparam A The tile allocator type
+  /// \param a The matrix to be factorized; only the lower triangular tiles
+  /// are referenced
+  /// \return The lower triangular factor \c l of <tt>a = l * l^H</tt> ,
+  /// which is distributed in the same way as \c a
+  /// \throw TiledArray::Exception When \c a is not a square matrix with
+  /// identical row and column tilings.
+  /// \throw TiledArray::Exception When \c a is not positive definite; the
+  /// exception is thrown on all ranks.
+  template <typename T, typename A>
+  DistArray<Tensor<T, A>, DensePolicy>
+  cholesky(const DistArray<Tensor<T, A>, DensePolicy>& a) {
+    typedef DistArray<Tensor<T, A>, DensePolicy> array_type;
+    typedef typename array_type::value_type value_type;
+
+    detail::check_square_matrix(a,
+        "TiledArray::cholesky(): The array must be a square matrix with identical row and column tilings.");
+
+    World& world = a.world();
+    const std::size_t n = a.trange().tiles_range().extent(0);
+    array_type l(world, a.trange(), a.pmap());
+    detail::TileFutures<array_type> l_tiles(l);
+
+    for(auto it = l.pmap()->begin(); it != l.pmap()->end(); ++it) {
+      const std::size_t i = *it / n;
+      const std::size_t j = *it % n;
+
+      if(i < j) {
+        l.set(*it, value_type(l.trange().make_tile_range(*it), T(0)));
+        continue;
+      }
+
+      // Subtract the contributions of the preceding columns of the factor
+      Future<value_type> tile = a.find(*it);
+      for(std::size_t k = 0ul; k < j; ++k)
+        tile = world.taskq.add(& detail::cholesky_update_tile<T, A>, tile,
+            l_tiles[i * n + k], l_tiles[j * n + k]);
+
+      if(i == j)
+        tile = world.taskq.add(& detail::cholesky_tile<T, A>, tile);
+      else
+        tile = world.taskq.add(& detail::cholesky_solve_tile<T, A>,
+            l_tiles[j * n + j], tile);
+
+      l.set(*it, tile);
+    }
+
+    // The diagonal of the factor is positive if and only if the matrix is
+    // positive definite.
+    int failed = 0;
+    for(auto it = l.pmap()->begin(); it != l.pmap()->end(); ++it) {
+      if((*it / n) != (*it % n))
+        continue;
+      const value_type tile = l.find(*it).get();
+      if(! (eigen_map(tile).diagonal().real().minCoeff() > 0))
+        failed = 1;
+    }
+    world.gop.max(& failed, 1);
+    TA_USER_ASSERT(failed == 0,
+        "TiledArray::cholesky(): The matrix is not positive definite.");
+
+    return l;
+  }
+
+  /// Solve a lower triangular linear system
+
+  /// Solves <tt>l * x = b</tt> , or <tt>l^H * x = b</tt> when \c adjoint is
+  /// \c true , by forward (backward) substitution over the tile rows of
+  /// \c b . As with \c cholesky , the tiles of the solution are computed by
+  /// tasks on the ranks that own them, and the tiles of \c l and of the
+  /// solution are fetched once by each rank that uses them. This function
+  /// returns before the solution has been computed.
+  /// \tparam T The element type
+  /// \tparam A The tile allocator type
+  /// \param l The lower triangular matrix, e.g. the result of \c cholesky ;
+  /// only the lower triangular tiles are referenced
+  /// \param b The right-hand side matrix, whose rows are tiled like \c l
+  /// \param adjoint If \c true , solve with the adjoint of \c l
+  /// [default = false]
+  /// \return The solution \c x , which is distributed in the same way as
+  /// \c b
+  /// \throw TiledArray::Exception When \c l is not a square matrix with
+  /// identical row and column tilings.
+  /// \throw TiledArray::Exception When the rows of \c b are not tiled like
+  /// \c l .
+  template <typename T, typename A>
+  DistArray<Tensor<T, A>, DensePolicy>
+  triangular_solve(const DistArray<Tensor<T, A>, DensePolicy>& l,
+      const DistArray<Tensor<T, A>, DensePolicy>& b, const bool adjoint = false)
+  {
+    typedef DistArray<Tensor<T, A>, DensePolicy> array_type;
+    typedef typename array_type::value_type value_type;
+
+    detail::check_square_matrix(l,
+        "TiledArray::triangular_solve(): The triangular array must be a square matrix with identical row and column tilings.");
+    TA_USER_ASSERT(b.trange().tiles_range().rank() == 2u,
+        "TiledArray::triangular_solve(): The right-hand side array must be a matrix.");
+    TA_USER_ASSERT(b.trange().data()[0] == l.trange().data()[0],
+        "TiledArray::triangular_solve(): The rows of the right-hand side array must be tiled like the triangular array.");
+
+    World& world = b.world();
+    const std::size_t n = l.trange().tiles_range().extent(0);
+    const std::size_t m = b.trange().tiles_range().extent(1);
+    array_type x(world, b.trange(), b.pmap());
+    detail::TileFutures<array_type> l_tiles(l);
+    detail::TileFutures<array_type> x_tiles(x);
+
+    for(auto it = x.pmap()->begin(); it != x.pmap()->end(); ++it) {
+      const std::size_t i = *it / m;
+      const std::size_t c = *it % m;
+
+      // Subtract the contributions of the solved tile rows
+      Future<value_type> tile = b.find(*it);
+      if(adjoint) {
+        for(std::size_t k = i + 1ul; k < n; ++k)
+          tile = world.taskq.add(& detail::triangular_update_tile<T, A>, tile,
+              l_tiles[k * n + i], x_tiles[k * m + c], true);
+      } else {
+        for(std::size_t k = 0ul; k < i; ++k)
+          tile = world.taskq.add(& detail::triangular_update_tile<T, A>, tile,
+              l_tiles[i * n + k], x_tiles[k * m + c], false);
+      }
+
+      x.set(*it, world.taskq.add(& detail::triangular_solve_tile<T, A>,
+          l_tiles[i * n + i], tile, adjoint));
+    }
+
+    return x;
+  }
+
+  /// Solve a Hermitian positive definite linear system
+
+  /// Solves <tt>a * x = b</tt> with the Cholesky factorization of \c a ,
+  /// followed by forward and backward substitution.
+  /// \tparam T The element type
+  /// \tparam A The tile allocator type
+  /// \param a The Hermitian positive definite matrix
+  /// \param b The right-hand side matrix, whose rows are tiled like \c a
+  /// \return The solution \c x , which is distributed in the same way as
+  /// \c b
+  template <typename T, typename A>
+  DistArray<Tensor<T, A>, DensePolicy>
+  cholesky_solve(const DistArray<Tensor<T, A>, DensePolicy>& a,
+      const DistArray<Tensor<T, A>, DensePolicy>& b)
+  {
+    const DistArray<Tensor<T, A>, DensePolicy> l = cholesky(a);
+    return triangular_solve(l, triangular_solve(l, b), true);
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_ALGEBRA_CHOLESKY_H__INCLUDED
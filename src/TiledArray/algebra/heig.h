@@ -0,0 +1,391 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  heig.h
+ *  Aug 8, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_ALGEBRA_HEIG_H__INCLUDED
+#define TILEDARRAY_ALGEBRA_HEIG_H__INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+#include <TiledArray/error.h>
+#include <TiledArray/algebra/cholesky.h>
+#include <TiledArray/conversions/dense_to_sparse.h>
+#include <TiledArray/conversions/eigen.h>
+#include <TiledArray/expressions/tsr_expr.h>
+#include <TiledArray/policies/sparse_policy.h>
+#include "../dist_array.h"
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Tile data of a block Jacobi rotation
+
+    /// The rotation of a pair of tile rows is the matrix of eigenvectors of
+    /// the diagonal block of the pair. A tile of the rotation matrix is the
+    /// block of the pair rotation that starts at the given row and column.
+    struct JacobiTileRotation {
+      Range range; ///< The range of the rotation tile
+      std::size_t row_offset; ///< The first row of the tile in the pair rotation
+      std::size_t col_offset; ///< The first column of the tile in the pair rotation
+    }; // struct JacobiTileRotation
+
+    /// Compute the rotation that diagonalizes a pair of tile rows
+
+    /// The diagonal block of the pair,
+    /// <tt>s = [ a_pp, a_qp^H ; a_qp, a_qq ]</tt> , is diagonalized locally.
+    /// An unpaired tile row is given by empty \c a_qp and \c a_qq tiles.
+    /// \param a_pp The diagonal tile of the first tile row
+    /// \param a_qp The tile in the second tile row and first tile column
+    /// \param a_qq The diagonal tile of the second tile row
+    /// \return The eigenvectors of \c s , in order of ascending eigenvalues
+    template <typename T, typename A>
+    Tensor<T, A> jacobi_rotation(const Tensor<T, A>& a_pp,
+        const Tensor<T, A>& a_qp, const Tensor<T, A>& a_qq)
+    {
+      typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> matrix_type;
+
+      const std::size_t np = a_pp.range().extent(0);
+      const std::size_t nq = (a_qq.empty() ? 0ul : a_qq.range().extent(0));
+
+      // Only the lower triangle of s is referenced by the eigensolver
+      matrix_type s(np + nq, np + nq);
+      s.topLeftCorner(np, np) = eigen_map(a_pp);
+      if(nq) {
+        s.bottomLeftCorner(nq, np) = eigen_map(a_qp);
+        s.bottomRightCorner(nq, nq) = eigen_map(a_qq);
+      }
+
+      Eigen::SelfAdjointEigenSolver<matrix_type> solver(s);
+      TA_ASSERT(solver.info() == Eigen::Success);
+
+      Tensor<T, A> w(Range(np + nq, np + nq));
+      eigen_map(w) = solver.eigenvectors();
+      return w;
+    }
+
+    /// Extract a tile of the rotation matrix
+
+    /// \param w The rotation of the tile row pair
+    /// \param info The rotation data of the tile
+    /// \return The tile of \c w given by \c info
+    template <typename T, typename A>
+    Tensor<T, A> jacobi_rotation_tile(const Tensor<T, A>& w,
+        const JacobiTileRotation& info)
+    {
+      Tensor<T, A> result(info.range);
+      eigen_map(result) = eigen_map(w).block(info.row_offset, info.col_offset,
+          info.range.extent(0), info.range.extent(1));
+      return result;
+    }
+
+    /// Neglect only exactly zero tiles in block-sparse arithmetic
+
+    /// This object sets the zero threshold of \c SparseShape to the smallest
+    /// normalized \c float , so the shapes of block-sparse products keep every
+    /// tile that may be non-zero, and restores the threshold when it is
+    /// destroyed.
+    class ExactSparseShape {
+      float threshold_; ///< The threshold that is restored
+
+    public:
+      ExactSparseShape() : threshold_(SparseShape<float>::threshold()) {
+        SparseShape<float>::threshold(std::numeric_limits<float>::min());
+      }
+
+      ~ExactSparseShape() { SparseShape<float>::threshold(threshold_); }
+    }; // class ExactSparseShape
+
+    /// Copy columns between tiles
+
+    /// \param result The tile that receives the columns
+    /// \param source The tile that holds the columns
+    /// \param columns Pairs of result and source column indices, relative to
+    /// the tiles
+    /// \return A copy of \c result with the columns of \c source
+    template <typename T, typename A>
+    Tensor<T, A> copy_tile_columns(const Tensor<T, A>& result,
+        const Tensor<T, A>& source,
+        const std::vector<std::pair<std::size_t, std::size_t> >& columns)
+    {
+      Tensor<T, A> tile = result.clone();
+      auto tile_map = eigen_map(tile);
+      const auto source_map = eigen_map(source);
+      for(const auto& column : columns)
+        tile_map.col(column.first) = source_map.col(column.second);
+      return tile;
+    }
+
+    /// Compute the partners of tile rows in one step of a round-robin ordering
+
+    /// Over <tt>n + (n % 2) - 1</tt> consecutive steps each tile row is paired
+    /// with every other tile row exactly once. A tile row without a partner
+    /// in a step is its own partner.
+    /// \param n The number of tile rows
+    /// \param step The step index
+    /// \return The partner of each tile row
+    inline std::vector<std::size_t> round_robin_partners(const std::size_t n,
+        const std::size_t step)
+    {
+      const std::size_t m = n + (n % 2ul);
+      std::vector<std::size_t> players(m);
+      std::iota(players.begin(), players.end(), 0ul);
+      for(std::size_t s = 0ul; s < step % (m - 1ul); ++s)
+        std::rotate(players.begin() + 1, players.end() - 1, players.end());
+
+      std::vector<std::size_t> partners(n);
+      for(std::size_t i = 0ul; i < m / 2ul; ++i) {
+        const std::size_t p = players[i];
+        const std::size_t q = players[m - 1ul - i];
+        if(p < n)
+          partners[p] = (q < n ? q : p);
+        if(q < n)
+          partners[q] = (p < n ? p : q);
+      }
+
+      return partners;
+    }
+
+  } // namespace detail
+
+  /// Eigendecomposition of a Hermitian matrix
+
+  /// The matrix is diagonalized with the two-sided block Jacobi method,
+  /// where the tile rows are paired in a parallel round-robin ordering. In
+  /// each step the diagonal block of every pair of tile rows is
+  /// diagonalized by a task on the rank that owns the first diagonal tile of
+  /// the pair, and the rotation is broadcast to all ranks. The rotations of
+  /// all pairs form a block-sparse matrix \c w , which is applied to the
+  /// matrix, <tt>w^H * a * w</tt> , and to the eigenvectors, <tt>v * w</tt> ,
+  /// with block-sparse \c Summa contractions. The steps depend on each other
+  /// only through futures and the local completion of the contractions, so
+  /// the only collective synchronization is the reduction of the
+  /// off-diagonal norm at the end of each sweep over all pairs. Sweeps are
+  /// repeated until the Frobenius norm of the off-diagonal elements,
+  /// relative to that of the matrix, is less than \c tolerance . This is a
+  /// collective operation.
+  ///
+  /// Each sweep costs about \f$ 12 n^3 \f$ flops for an \f$ n \times n \f$
+  /// matrix, and 5 to 10 sweeps are typical, so the eigensolver needs about
+  /// 20 to 40 times the flops of a solver based on tridiagonal reduction
+  /// (about \f$ 4/3\, n^3 \f$ flops for the reduction and \f$ 2 n^3 \f$
+  /// flops for the back transformation of the eigenvectors). In exchange,
+  /// all flops are in tile GEMMs and no distributed panel factorizations
+  /// are needed.
+  /// Usage:
+  /// \code
+  /// TiledArray::TArrayD a(world, trange);
+  /// // Fill a with a symmetric matrix ...
+  ///
+  /// std::vector<double> evals;
+  /// TiledArray::TArrayD evecs;
+  /// std::tie(evals, evecs) = heig(a);
+  /// \endcode
+  /// \tparam T The element type
+  /// \tparam A The tile allocator type
+  /// \param a The Hermitian matrix; all tiles are referenced
+  /// \param tolerance The convergence threshold of the relative
+  /// off-diagonal norm
+  /// \param max_sweeps The maximum number of sweeps [default = 30]
+  /// \return The eigenvalues in ascending order, which are replicated on all
+  /// ranks, and the array of corresponding eigenvectors (columns), which is
+  /// distributed in the same way as \c a
+  /// \throw TiledArray::Exception When \c a is not a square matrix with
+  /// identical row and column tilings.
+  /// \throw TiledArray::Exception When the iterations do not converge within
+  /// \c max_sweeps sweeps.
+  template <typename T, typename A>
+  std::tuple<std::vector<detail::scalar_t<T> >, DistArray<Tensor<T, A>, DensePolicy> >
+  heig(const DistArray<Tensor<T, A>, DensePolicy>& a,
+      const detail::scalar_t<T> tolerance =
+          std::numeric_limits<detail::scalar_t<T> >::epsilon() * 1000,
+      const unsigned int max_sweeps = 30u)
+  {
+    typedef DistArray<Tensor<T, A>, DensePolicy> array_type;
+    typedef DistArray<Tensor<T, A>, SparsePolicy> sparse_array_type;
+    typedef typename array_type::value_type value_type;
+    typedef detail::scalar_t<T> real_type;
+
+    detail::check_square_matrix(a,
+        "TiledArray::heig(): The array must be a square matrix with identical row and column tilings.");
+
+    World& world = a.world();
+    const TiledRange& trange = a.trange();
+    const TiledRange1& tiling = trange.data()[0];
+    const std::size_t nt = trange.tiles_range().extent(0);
+    const std::size_t steps = nt + (nt % 2ul) - 1ul;
+    const Future<value_type> empty_tile(value_type{});
+
+    // The rotations are block-sparse; all other tiles may be non-zero
+    detail::ExactSparseShape exact_shape;
+    sparse_array_type d = to_sparse(a);
+
+    // Initialize the eigenvectors with the identity matrix
+    Tensor<float> v_norms(trange.tiles_range(), 0.0f);
+    for(std::size_t i = 0ul; i < nt; ++i)
+      v_norms[i * nt + i] = std::sqrt(float(trange.make_tile_range(i * nt + i).extent(0)));
+    sparse_array_type v(world, trange, SparseShape<float>(v_norms, trange));
+    for(auto it = v.pmap()->begin(); it != v.pmap()->end(); ++it) {
+      if(v.is_zero(*it))
+        continue;
+      value_type tile(trange.make_tile_range(*it), T(0));
+      eigen_map(tile).setIdentity();
+      v.set(*it, tile);
+    }
+
+    // Tile of d, where zero tiles are given explicitly
+    auto d_tile = [&] (const std::size_t index) {
+      return (d.is_zero(index) ?
+          Future<value_type>(value_type(trange.make_tile_range(index), T(0))) :
+          d.find(index));
+    };
+
+    for(unsigned int sweep = 0u; ; ++sweep) {
+
+      // Compute the off-diagonal and total norms of the matrix
+      real_type norms[2] = { 0, 0 };
+      for(auto it = d.pmap()->begin(); it != d.pmap()->end(); ++it) {
+        if(d.is_zero(*it))
+          continue;
+        const value_type tile = d.find(*it).get();
+        const real_type norm2 = eigen_map(tile).squaredNorm();
+        norms[0] += ((*it / nt) == (*it % nt) ?
+            norm2 - eigen_map(tile).diagonal().squaredNorm() : norm2);
+        norms[1] += norm2;
+      }
+      world.gop.sum(norms, 2);
+      if(norms[0] <= tolerance * tolerance * norms[1])
+        break;
+      if(sweep == max_sweeps)
+        TA_EXCEPTION("TiledArray::heig(): The eigensolver did not converge.");
+
+      for(std::size_t step = 0ul; step < steps; ++step) {
+        const std::vector<std::size_t> partners =
+            detail::round_robin_partners(nt, step);
+
+        // The first member of a pair is the tile row with the smaller index
+        auto first = [&partners] (const std::size_t p) {
+          return std::min(p, partners[p]); };
+        auto offset = [&] (const std::size_t p) {
+          return (p == first(p) ? 0ul :
+              tiling.tile(tiling.tiles_range().first + first(p)).second -
+              tiling.tile(tiling.tiles_range().first + first(p)).first);
+        };
+
+        // Compute the rotation of each pair once, on the rank that owns the
+        // first diagonal tile of the pair, and broadcast it to all ranks
+        std::vector<Future<value_type> > rotations(nt);
+        for(std::size_t p = 0ul; p < nt; ++p) {
+          const std::size_t q = partners[p];
+          if(q < p)
+            continue;
+          const ProcessID root = d.owner(p * nt + p);
+          if(root == world.rank())
+            rotations[p] = world.taskq.add(& detail::jacobi_rotation<T, A>,
+                d_tile(p * nt + p), (p != q ? d_tile(q * nt + p) : empty_tile),
+                (p != q ? d_tile(q * nt + q) : empty_tile));
+          world.gop.bcast(madness::DistributedID(d.id(), p), rotations[p], root);
+        }
+
+        // Assemble the block-sparse rotation matrix
+        Tensor<float> w_norms(trange.tiles_range(), 0.0f);
+        for(std::size_t r = 0ul; r < nt; ++r)
+          for(std::size_t c = 0ul; c < nt; ++c)
+            if(first(r) == first(c))
+              w_norms[r * nt + c] =
+                  std::sqrt(float(trange.make_tile_range(r * nt + c).extent(1)));
+        sparse_array_type w(world, trange, SparseShape<float>(w_norms, trange));
+        for(auto it = w.pmap()->begin(); it != w.pmap()->end(); ++it) {
+          if(w.is_zero(*it))
+            continue;
+          const std::size_t r = *it / nt;
+          const std::size_t c = *it % nt;
+          const detail::JacobiTileRotation info{ trange.make_tile_range(*it),
+              offset(r), offset(c) };
+          w.set(*it, world.taskq.add(& detail::jacobi_rotation_tile<T, A>,
+              rotations[first(c)], info));
+        }
+
+        // Rotate the matrix and the eigenvectors
+        sparse_array_type dw;
+        dw("i,j") = d("i,k") * w("k,j");
+        d("i,j") = w("k,i").conj() * dw("k,j");
+        v("i,j") = v("i,k") * w("k,j");
+      }
+    }
+
+    // Collect the eigenvalues from the diagonal tiles
+    const std::size_t n = trange.elements_range().extent(0);
+    const std::size_t first_element = tiling.elements_range().first;
+    std::vector<real_type> evals(n, real_type(0));
+    for(auto it = d.pmap()->begin(); it != d.pmap()->end(); ++it) {
+      if(((*it / nt) != (*it % nt)) || d.is_zero(*it))
+        continue;
+      const value_type tile = d.find(*it).get();
+      const std::size_t lower = tile.range().lobound(0) - first_element;
+      for(std::size_t i = 0ul; i < std::size_t(tile.range().extent(0)); ++i)
+        evals[lower + i] = std::real(eigen_map(tile)(i, i));
+    }
+    world.gop.sum(evals.data(), n);
+
+    // Sort the eigenvalues and permute the eigenvectors accordingly
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0ul);
+    std::stable_sort(order.begin(), order.end(),
+        [&evals] (const std::size_t i, const std::size_t j) {
+          return evals[i] < evals[j]; });
+
+    array_type evecs(world, trange, a.pmap());
+    for(auto it = evecs.pmap()->begin(); it != evecs.pmap()->end(); ++it) {
+      const std::size_t r = *it / nt;
+      const Range range = trange.make_tile_range(*it);
+      const std::size_t lower = range.lobound(1) - first_element;
+      const std::size_t upper = range.upbound(1) - first_element;
+
+      // Group the source columns of the tile by source tile
+      std::vector<std::vector<std::pair<std::size_t, std::size_t> > > columns(nt);
+      for(std::size_t j = lower; j < upper; ++j) {
+        const std::size_t source = tiling.element_to_tile(order[j] + first_element) -
+            tiling.tiles_range().first;
+        const std::size_t source_lower =
+            tiling.tile(tiling.tiles_range().first + source).first - first_element;
+        columns[source].emplace_back(j - lower, order[j] - source_lower);
+      }
+
+      Future<value_type> tile(value_type(range, T(0)));
+      for(std::size_t s = 0ul; s < nt; ++s)
+        if(! columns[s].empty() && ! v.is_zero(r * nt + s))
+          tile = world.taskq.add(& detail::copy_tile_columns<T, A>, tile,
+              v.find(r * nt + s), columns[s]);
+      evecs.set(*it, tile);
+    }
+
+    std::sort(evals.begin(), evals.end());
+
+    return std::make_tuple(evals, evecs);
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_ALGEBRA_HEIG_H__INCLUDED
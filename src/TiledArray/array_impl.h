@@ -488,6 +488,26 @@ namespace TiledArray {
         return get<std::initializer_list<Integer>>(i);
       }
 
+      /// Start loading a local tile
+
+      /// When tile spilling is enabled and local tile \c i has been spilled,
+      /// it is read back asynchronously. Otherwise this does nothing.
+      /// \param i The ordinal index of the tile
+      void prefetch(const size_type i) const { data_.prefetch(i); }
+
+      /// Transfer compression accessor
+
+      /// \return The encoding of the remote tiles used by this process
+      const TileCompression& compression() const { return data_.compression(); }
+
+      /// Set the transfer compression
+
+      /// The contract must be the same on all processes.
+      /// \param compression The encoding of the remote tiles used by this process
+      void compression(const TileCompression& compression) {
+        data_.compression(compression);
+      }
+
       /// Set tile
 
       /// Set the tile at \c i with \c value . \c Value type may be \c value_type ,
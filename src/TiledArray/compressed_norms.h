@@ -0,0 +1,500 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  compressed_norms.h
+ *  Jun 11, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_COMPRESSED_NORMS_H__INCLUDED
+#define TILEDARRAY_COMPRESSED_NORMS_H__INCLUDED
+
+#include <TiledArray/tensor.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Compressed storage for a sparse tensor of norms
+
+    /// Only the non-zero elements of the tensor are stored, as a list of
+    /// ordinal indices, in ascending order, and the corresponding values.
+    /// Since the ordinal index of a row-major matrix is sorted first by row
+    /// and then by column, the same data may be viewed as a compressed sparse
+    /// row matrix for any matricization of the tensor. Element access is
+    /// O(log nnz), and element-wise operations are O(nnz).
+    /// \tparam T The norm value type
+    template <typename T>
+    class CompressedNorms {
+    public:
+      typedef CompressedNorms<T> CompressedNorms_; ///< This object type
+      typedef T value_type; ///< The norm value type
+      typedef Range range_type; ///< Tensor range type
+      typedef range_type::ordinal_type ordinal_type; ///< Ordinal index type
+      typedef std::size_t size_type; ///< Size type
+
+    private:
+
+      range_type range_; ///< The range of the tensor
+      std::vector<ordinal_type> ordinals_; ///< The ordinals of the non-zero elements
+      std::vector<value_type> values_; ///< The values of the non-zero elements
+
+      /// Call \c op for each coordinate of the element at \c ordinal
+
+      /// \tparam Op The operation type, with signature
+      /// <tt>void(unsigned int dim, size_type i)</tt>
+      /// \param range The range of the tensor
+      /// \param ordinal The ordinal index of the element
+      /// \param op The operation, which is called with the dimension and the
+      /// coordinate, relative to the lower bound of \c range , of the element
+      template <typename Op>
+      static void for_each_coordinate(const range_type& range,
+          const ordinal_type ordinal, Op&& op)
+      {
+        const unsigned int rank = range.rank();
+        const auto* MADNESS_RESTRICT const extent = range.extent_data();
+        const auto* MADNESS_RESTRICT const stride = range.stride_data();
+        for(unsigned int d = 0u; d < rank; ++d)
+          op(d, (ordinal / stride[d]) % extent[d]);
+      }
+
+      /// Sort the elements by ordinal index
+      void sort() {
+        const size_type n = ordinals_.size();
+        std::vector<size_type> order(n);
+        std::iota(order.begin(), order.end(), size_type(0));
+        std::stable_sort(order.begin(), order.end(),
+            [this] (const size_type l, const size_type r)
+            { return ordinals_[l] < ordinals_[r]; });
+
+        std::vector<ordinal_type> ordinals(n);
+        std::vector<value_type> values(n);
+        for(size_type i = 0ul; i < n; ++i) {
+          ordinals[i] = ordinals_[order[i]];
+          values[i] = values_[order[i]];
+        }
+        ordinals_.swap(ordinals);
+        values_.swap(values);
+      }
+
+    public:
+
+      /// Default constructor
+
+      /// Construct an empty tensor with no range
+      CompressedNorms() = default;
+
+      /// Construct a zero tensor
+
+      /// \param range The range of the tensor
+      explicit CompressedNorms(const range_type& range) :
+        range_(range), ordinals_(), values_()
+      { }
+
+      /// Construct a tensor from a list of elements
+
+      /// \param range The range of the tensor
+      /// \param ordinals The ordinal indices of the non-zero elements, in
+      /// ascending order
+      /// \param values The values of the non-zero elements
+      CompressedNorms(const range_type& range, std::vector<ordinal_type> ordinals,
+          std::vector<value_type> values) :
+        range_(range), ordinals_(std::move(ordinals)), values_(std::move(values))
+      {
+        TA_ASSERT(ordinals_.size() == values_.size());
+        TA_ASSERT(std::is_sorted(ordinals_.begin(), ordinals_.end()));
+      }
+
+      /// Compress a dense tensor
+
+      /// \param tensor The tensor to be compressed, where only the non-zero
+      /// elements are stored
+      explicit CompressedNorms(const Tensor<value_type>& tensor) :
+        range_(tensor.range()), ordinals_(), values_()
+      {
+        const size_type volume = tensor.size();
+        const value_type* MADNESS_RESTRICT const data = tensor.data();
+        for(size_type i = 0ul; i < volume; ++i) {
+          if(data[i] != value_type(0)) {
+            ordinals_.push_back(i);
+            values_.push_back(data[i]);
+          }
+        }
+      }
+
+      /// Construct a tensor from a list of coordinate indices and values
+
+      /// When an index appears more than once, the last value is used.
+      /// \tparam SparseNormSequence the sequence of
+      /// \c std::pair<index,value_type> objects, where \c index is a
+      /// directly-addressable sequence of integers.
+      /// \param range The range of the tensor
+      /// \param elements The non-zero elements of the tensor
+      template <typename SparseNormSequence>
+      CompressedNorms(const range_type& range, const SparseNormSequence& elements) :
+        range_(range), ordinals_(), values_()
+      {
+        for(const auto& element : elements) {
+          ordinals_.push_back(range_.ordinal(element.first));
+          values_.push_back(element.second);
+        }
+        sort();
+
+        // Remove duplicate and zero elements
+        size_type n = 0ul;
+        for(size_type i = 0ul; i < ordinals_.size(); ++i) {
+          if((i + 1ul < ordinals_.size()) && (ordinals_[i + 1ul] == ordinals_[i]))
+            continue;
+          if(values_[i] != value_type(0)) {
+            ordinals_[n] = ordinals_[i];
+            values_[n] = values_[i];
+            ++n;
+          }
+        }
+        ordinals_.resize(n);
+        values_.resize(n);
+      }
+
+      CompressedNorms(const CompressedNorms_&) = default;
+      CompressedNorms(CompressedNorms_&&) = default;
+      CompressedNorms_& operator=(const CompressedNorms_&) = default;
+      CompressedNorms_& operator=(CompressedNorms_&&) = default;
+
+      /// Tensor range accessor
+
+      /// \return The range of the tensor
+      const range_type& range() const { return range_; }
+
+      /// Number of non-zero elements
+
+      /// \return The number of stored elements
+      size_type nnz() const { return ordinals_.size(); }
+
+      /// Ordinal indices of the non-zero elements
+
+      /// \return The ordinal indices in ascending order
+      const std::vector<ordinal_type>& ordinals() const { return ordinals_; }
+
+      /// Values of the non-zero elements
+
+      /// \return The values, in the same order as \c ordinals()
+      const std::vector<value_type>& values() const { return values_; }
+
+      /// Element accessor
+
+      /// \tparam Index An ordinal or coordinate index type
+      /// \param index The index of the element
+      /// \return The value of the element, or zero if it is not stored
+      template <typename Index>
+      value_type operator[](const Index& index) const {
+        const ordinal_type ordinal = range_.ordinal(index);
+        const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+        if((it == ordinals_.end()) || (*it != ordinal))
+          return value_type(0);
+        return values_[it - ordinals_.begin()];
+      }
+
+      /// Convert to a dense tensor
+
+      /// \return A dense tensor that contains the same elements as this
+      Tensor<value_type> tensor() const {
+        Tensor<value_type> result(range_, value_type(0));
+        for(size_type i = 0ul; i < ordinals_.size(); ++i)
+          result[ordinals_[i]] = values_[i];
+        return result;
+      }
+
+      /// Coordinate index helper
+
+      /// \tparam Op The operation type, with signature
+      /// <tt>void(unsigned int dim, size_type i)</tt>
+      /// \param ordinal The ordinal index of an element
+      /// \param op The operation, which is called with the dimension and the
+      /// coordinate, relative to the lower bound of the range, of the element
+      template <typename Op>
+      void coordinates(const ordinal_type ordinal, Op&& op) const {
+        for_each_coordinate(range_, ordinal, std::forward<Op>(op));
+      }
+
+      /// Unary operation
+
+      /// Elements for which \c op returns zero are removed from the result.
+      /// \tparam Op The operation type, with signature
+      /// <tt>value_type(value_type value, ordinal_type ordinal)</tt>
+      /// \param op The operation applied to each non-zero element
+      /// \return A new tensor that contains the result of \c op
+      template <typename Op>
+      CompressedNorms_ unary(Op&& op) const {
+        CompressedNorms_ result(range_);
+        result.ordinals_.reserve(ordinals_.size());
+        result.values_.reserve(values_.size());
+        for(size_type i = 0ul; i < ordinals_.size(); ++i) {
+          const value_type value = op(values_[i], ordinals_[i]);
+          if(value != value_type(0)) {
+            result.ordinals_.push_back(ordinals_[i]);
+            result.values_.push_back(value);
+          }
+        }
+        return result;
+      }
+
+      /// Binary operation over the union of the non-zero elements
+
+      /// Elements for which \c op returns zero are removed from the result.
+      /// \tparam Op The operation type, with signature
+      /// <tt>value_type(value_type left, value_type right, ordinal_type ordinal)</tt>
+      /// \param other The right-hand argument
+      /// \param op The operation applied to the elements that are non-zero in
+      /// \c this or \c other , where missing elements are zero
+      /// \return A new tensor that contains the result of \c op
+      template <typename Op>
+      CompressedNorms_ merge(const CompressedNorms_& other, Op&& op) const {
+        TA_ASSERT(range_.volume() == other.range_.volume());
+        CompressedNorms_ result(range_);
+        result.ordinals_.reserve(std::max(ordinals_.size(), other.ordinals_.size()));
+        result.values_.reserve(std::max(values_.size(), other.values_.size()));
+
+        size_type l = 0ul, r = 0ul;
+        const size_type l_end = ordinals_.size(), r_end = other.ordinals_.size();
+        while((l < l_end) || (r < r_end)) {
+          ordinal_type ordinal = 0ul;
+          value_type left = 0, right = 0;
+          if((r == r_end) || ((l < l_end) && (ordinals_[l] < other.ordinals_[r]))) {
+            ordinal = ordinals_[l];
+            left = values_[l++];
+          } else if((l == l_end) || (other.ordinals_[r] < ordinals_[l])) {
+            ordinal = other.ordinals_[r];
+            right = other.values_[r++];
+          } else {
+            ordinal = ordinals_[l];
+            left = values_[l++];
+            right = other.values_[r++];
+          }
+
+          const value_type value = op(left, right, ordinal);
+          if(value != value_type(0)) {
+            result.ordinals_.push_back(ordinal);
+            result.values_.push_back(value);
+          }
+        }
+
+        return result;
+      }
+
+      /// Binary operation over the intersection of the non-zero elements
+
+      /// Elements for which \c op returns zero are removed from the result.
+      /// \tparam Op The operation type, with signature
+      /// <tt>value_type(value_type left, value_type right, ordinal_type ordinal)</tt>
+      /// \param other The right-hand argument
+      /// \param op The operation applied to the elements that are non-zero in
+      /// both \c this and \c other
+      /// \return A new tensor that contains the result of \c op
+      template <typename Op>
+      CompressedNorms_ intersect(const CompressedNorms_& other, Op&& op) const {
+        TA_ASSERT(range_.volume() == other.range_.volume());
+        CompressedNorms_ result(range_);
+
+        size_type l = 0ul, r = 0ul;
+        const size_type l_end = ordinals_.size(), r_end = other.ordinals_.size();
+        while((l < l_end) && (r < r_end)) {
+          if(ordinals_[l] < other.ordinals_[r]) {
+            ++l;
+          } else if(other.ordinals_[r] < ordinals_[l]) {
+            ++r;
+          } else {
+            const value_type value = op(values_[l], other.values_[r], ordinals_[l]);
+            if(value != value_type(0)) {
+              result.ordinals_.push_back(ordinals_[l]);
+              result.values_.push_back(value);
+            }
+            ++l;
+            ++r;
+          }
+        }
+
+        return result;
+      }
+
+      /// Permute the tensor
+
+      /// \param perm The permutation to be applied
+      /// \return A permuted copy of this tensor
+      CompressedNorms_ permute(const Permutation& perm) const {
+        TA_ASSERT(perm.dim() == range_.rank());
+        CompressedNorms_ result(perm * range_);
+        const auto* MADNESS_RESTRICT const result_stride = result.range_.stride_data();
+
+        result.ordinals_.reserve(ordinals_.size());
+        for(const ordinal_type ordinal : ordinals_) {
+          ordinal_type result_ordinal = 0ul;
+          coordinates(ordinal, [&] (const unsigned int d, const size_type i)
+              { result_ordinal += i * result_stride[perm[d]]; });
+          result.ordinals_.push_back(result_ordinal);
+        }
+        result.values_ = values_;
+        result.sort();
+
+        return result;
+      }
+
+      /// Copy a sub-block of the tensor
+
+      /// The lower bound of the result range is zero.
+      /// \tparam Index The bound index type
+      /// \param lower_bound The lower bound of the sub-block
+      /// \param upper_bound The upper bound of the sub-block
+      /// \return A tensor that contains the sub-block of this tensor
+      template <typename Index>
+      CompressedNorms_ block(const Index& lower_bound, const Index& upper_bound) const {
+        const unsigned int rank = range_.rank();
+        TA_ASSERT(detail::size(lower_bound) == rank);
+        TA_ASSERT(detail::size(upper_bound) == rank);
+        const auto* MADNESS_RESTRICT const lower = detail::data(lower_bound);
+        const auto* MADNESS_RESTRICT const upper = detail::data(upper_bound);
+        const auto* MADNESS_RESTRICT const lobound = range_.lobound_data();
+
+        std::vector<size_type> extent(rank);
+        for(unsigned int d = 0u; d < rank; ++d)
+          extent[d] = upper[d] - lower[d];
+        CompressedNorms_ result((range_type(extent)));
+        const auto* MADNESS_RESTRICT const result_stride = result.range_.stride_data();
+
+        // Elements are visited in ascending order, so the result is sorted
+        for(size_type x = 0ul; x < ordinals_.size(); ++x) {
+          bool included = true;
+          ordinal_type result_ordinal = 0ul;
+          coordinates(ordinals_[x], [&] (const unsigned int d, const size_type i) {
+            const size_type index = i + lobound[d];
+            if((index < size_type(lower[d])) || (index >= size_type(upper[d])))
+              included = false;
+            else
+              result_ordinal += (index - lower[d]) * result_stride[d];
+          });
+          if(included) {
+            result.ordinals_.push_back(result_ordinal);
+            result.values_.push_back(values_[x]);
+          }
+        }
+
+        return result;
+      }
+
+      /// Replace a sub-block of the tensor
+
+      /// \tparam Index The bound index type
+      /// \param lower_bound The lower bound of the sub-block
+      /// \param upper_bound The upper bound of the sub-block
+      /// \param other The new sub-block, which has the same extent as the
+      /// sub-block
+      /// \return A copy of this tensor where the sub-block is replaced by
+      /// \c other
+      template <typename Index>
+      CompressedNorms_ update_block(const Index& lower_bound,
+          const Index& upper_bound, const CompressedNorms_& other) const
+      {
+        const unsigned int rank = range_.rank();
+        TA_ASSERT(detail::size(lower_bound) == rank);
+        TA_ASSERT(detail::size(upper_bound) == rank);
+        TA_ASSERT(other.range_.rank() == rank);
+        const auto* MADNESS_RESTRICT const lower = detail::data(lower_bound);
+        const auto* MADNESS_RESTRICT const upper = detail::data(upper_bound);
+        const auto* MADNESS_RESTRICT const lobound = range_.lobound_data();
+        const auto* MADNESS_RESTRICT const stride = range_.stride_data();
+
+        CompressedNorms_ result(range_);
+
+        // Copy the elements of this tensor that are outside the sub-block
+        for(size_type x = 0ul; x < ordinals_.size(); ++x) {
+          bool included = true;
+          coordinates(ordinals_[x], [&] (const unsigned int d, const size_type i) {
+            const size_type index = i + lobound[d];
+            if((index < size_type(lower[d])) || (index >= size_type(upper[d])))
+              included = false;
+          });
+          if(! included) {
+            result.ordinals_.push_back(ordinals_[x]);
+            result.values_.push_back(values_[x]);
+          }
+        }
+
+        // Copy the elements of other into the sub-block
+        for(size_type x = 0ul; x < other.ordinals_.size(); ++x) {
+          ordinal_type ordinal = 0ul;
+          other.coordinates(other.ordinals_[x], [&] (const unsigned int d, const size_type i) {
+            TA_ASSERT(i < size_type(upper[d] - lower[d]));
+            ordinal += (i + lower[d] - lobound[d]) * stride[d];
+          });
+          result.ordinals_.push_back(ordinal);
+          result.values_.push_back(other.values_[x]);
+        }
+        result.sort();
+
+        return result;
+      }
+
+      /// Serialize tensor data
+
+      /// \tparam Archive The serialization archive type
+      /// \param ar The serialization archive
+      template <typename Archive>
+      void serialize(Archive& ar) {
+        ar & range_ & ordinals_ & values_;
+      }
+
+    }; // class CompressedNorms
+
+    /// Sum reduction of compressed norms
+
+    /// This reduction operation is used to sum the contributions of all
+    /// processes to a compressed norm tensor.
+    /// \tparam T The norm value type
+    template <typename T>
+    class CompressedNormsSum {
+    public:
+      // typedefs
+      typedef CompressedNorms<T> result_type;
+      typedef CompressedNorms<T> argument_type;
+
+      // Reduction functions
+
+      // Make an empty result object
+      result_type operator()() const { return result_type(); }
+
+      // Post process the result
+      const result_type& operator()(const result_type& result) const { return result; }
+
+      // Reduce two result objects
+      void operator()(result_type& result, const result_type& arg) const {
+        // The result has no range until the first argument is reduced
+        if(result.range().rank() == 0u) {
+          result = arg;
+        } else if(arg.range().rank() != 0u) {
+          result = result.merge(arg,
+              [] (const T left, const T right, const typename result_type::ordinal_type)
+              { return left + right; });
+        }
+      }
+
+    }; // class CompressedNormsSum
+
+  }  // namespace detail
+}  // namespace TiledArray
+
+#endif // TILEDARRAY_COMPRESSED_NORMS_H__INCLUDED
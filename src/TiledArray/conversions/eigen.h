@@ -26,7 +26,10 @@
 #ifndef TILEDARRAY_CONVERSIONS_EIGEN_H__INCLUDED
 #define TILEDARRAY_CONVERSIONS_EIGEN_H__INCLUDED
 
+#include <array>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 #include <tiledarray_fwd.h>
 #include <TiledArray/tensor.h>
 #include <TiledArray/error.h>
@@ -317,6 +320,326 @@ namespace TiledArray {
       (*counter)++;
     }
 
+    /// Bounds of a rectangular matrix block
+
+    /// The bounds are stored as <tt>{ row_begin, row_end, col_begin, col_end }</tt>
+    /// and the end bounds are not included in the block.
+    typedef std::array<std::size_t, 4> MatrixBlockBounds;
+
+    /// Compute the matrix bounds of an array tile
+
+    /// Rank 1 tiles are treated as column vectors.
+    /// \param range The tile range
+    /// \return The matrix bounds of the tile
+    template <typename Range>
+    inline MatrixBlockBounds tile_block_bounds(const Range& range) {
+      const auto* MADNESS_RESTRICT const lower = range.lobound_data();
+      const auto* MADNESS_RESTRICT const upper = range.upbound_data();
+      if(range.rank() == 2u)
+        return MatrixBlockBounds{{ std::size_t(lower[0]), std::size_t(upper[0]),
+            std::size_t(lower[1]), std::size_t(upper[1]) }};
+      return MatrixBlockBounds{{ std::size_t(lower[0]), std::size_t(upper[0]),
+          0ul, 1ul }};
+    }
+
+    /// Compute the intersection of two matrix blocks
+
+    /// \param first The first block
+    /// \param second The second block
+    /// \param[out] result The intersection of \c first and \c second
+    /// \return \c true if the intersection is not empty
+    inline bool intersect_blocks(const std::size_t* const first,
+        const std::size_t* const second, MatrixBlockBounds& result)
+    {
+      result[0] = std::max(first[0], second[0]);
+      result[1] = std::min(first[1], second[1]);
+      result[2] = std::max(first[2], second[2]);
+      result[3] = std::min(first[3], second[3]);
+      return (result[0] < result[1]) && (result[2] < result[3]);
+    }
+
+    /// Collect the matrix blocks held by each rank
+
+    /// This is a collective operation; the bounds of the block held by rank
+    /// \c p are stored at <tt>[4 * p, 4 * p + 4)</tt> of the result.
+    /// \param world The world that holds the matrix blocks
+    /// \param block The bounds of the local block
+    /// \return The bounds of the blocks held by all ranks
+    inline std::vector<std::size_t>
+    gather_block_bounds(World& world, const MatrixBlockBounds& block) {
+      std::vector<std::size_t> blocks(4ul * world.size(), 0ul);
+      std::copy(block.begin(), block.end(), blocks.begin() + 4ul * world.rank());
+      world.gop.sum(blocks.data(), blocks.size());
+      return blocks;
+    }
+
+    /// Check that matrix blocks partition a matrix
+
+    /// The blocks of all ranks are checked, so the result is the same on
+    /// every rank. Empty blocks are ignored.
+    /// \param blocks The bounds of the blocks held by each rank (see
+    /// \c gather_block_bounds )
+    /// \param rows The number of rows of the matrix
+    /// \param cols The number of columns of the matrix
+    /// \return \c true if the blocks are contained in the matrix, do not
+    /// overlap, and cover each element of the matrix
+    inline bool is_block_partition(const std::vector<std::size_t>& blocks,
+        const std::size_t rows, const std::size_t cols)
+    {
+      const std::size_t nblocks = blocks.size() / 4ul;
+      std::size_t volume = 0ul;
+      MatrixBlockBounds bounds;
+      for(std::size_t p = 0ul; p < nblocks; ++p) {
+        const std::size_t* const block = blocks.data() + 4ul * p;
+        if((block[0] >= block[1]) || (block[2] >= block[3]))
+          continue;
+        if((block[1] > rows) || (block[3] > cols))
+          return false;
+        for(std::size_t q = p + 1ul; q < nblocks; ++q)
+          if(intersect_blocks(block, blocks.data() + 4ul * q, bounds))
+            return false;
+        volume += (block[1] - block[0]) * (block[3] - block[2]);
+      }
+
+      // Disjoint blocks that are contained in the matrix cover it if and
+      // only if their volumes add up to that of the matrix.
+      return volume == rows * cols;
+    }
+
+    /// Copy a block of an Eigen matrix into a tensor
+
+    /// \tparam T The tensor element type
+    /// \tparam Derived The matrix type
+    /// \param matrix The matrix that holds the block
+    /// \param row_offset The row index of the first row of \c matrix
+    /// \param col_offset The column index of the first column of \c matrix
+    /// \param bounds The bounds of the block to be copied
+    /// \return A rank 2 tensor that holds the block
+    template <typename T, typename Derived>
+    inline Tensor<T> make_matrix_block(const Eigen::MatrixBase<Derived>& matrix,
+        const std::size_t row_offset, const std::size_t col_offset,
+        const MatrixBlockBounds& bounds)
+    {
+      const std::size_t rows = bounds[1] - bounds[0];
+      const std::size_t cols = bounds[3] - bounds[2];
+      Tensor<T> block(Range(std::array<std::size_t, 2>{{ bounds[0], bounds[2] }},
+          std::array<std::size_t, 2>{{ bounds[1], bounds[3] }}));
+      eigen_map(block, rows, cols) = matrix.block(bounds[0] - row_offset,
+          bounds[2] - col_offset, rows, cols);
+      return block;
+    }
+
+    /// Assemble array tiles from matrix blocks distributed among ranks
+
+    /// Each rank sends the intersection of its local block with each tile to
+    /// the owner of the tile, which copies it into the tile. The tile is set
+    /// once all blocks that cover it have been received.
+    /// \tparam A The array type
+    template <typename A>
+    class MatrixBlocksToArray : public madness::WorldObject<MatrixBlocksToArray<A> > {
+    public:
+      typedef MatrixBlocksToArray<A> MatrixBlocksToArray_; ///< This object type
+      typedef madness::WorldObject<MatrixBlocksToArray_> WorldObject_; ///< Base object type
+      typedef typename A::size_type size_type; ///< Size type
+      typedef typename A::value_type value_type; ///< Tile type
+      typedef Tensor<typename value_type::value_type> block_type; ///< Block type
+
+    private:
+
+      A& array_; ///< The array that is being assembled
+      std::unordered_map<size_type, std::pair<value_type, madness::AtomicInt> >
+          tiles_; ///< Local tiles and the number of blocks they are waiting on
+      madness::AtomicInt complete_; ///< The number of completed local tiles
+
+      void receive_handler(const size_type i, const block_type& block) {
+        // Tiles are not inserted after construction, so no lock is needed to
+        // find the tile, and the blocks of a tile do not overlap.
+        auto it = tiles_.find(i);
+        TA_ASSERT(it != tiles_.end());
+        value_type& tile = it->second.first;
+        const MatrixBlockBounds tile_bounds = tile_block_bounds(tile.range());
+        const MatrixBlockBounds block_bounds = tile_block_bounds(block.range());
+        const std::size_t rows = block_bounds[1] - block_bounds[0];
+        const std::size_t cols = block_bounds[3] - block_bounds[2];
+        eigen_map(tile, tile_bounds[1] - tile_bounds[0],
+            tile_bounds[3] - tile_bounds[2]).block(block_bounds[0] - tile_bounds[0],
+            block_bounds[2] - tile_bounds[2], rows, cols) =
+                eigen_map(block, rows, cols);
+
+        if(it->second.second.dec_and_test()) {
+          array_.set(i, tile);
+          complete_++;
+        }
+      }
+
+    public:
+
+      /// Constructor
+
+      /// This is a collective operation; all ranks must construct the
+      /// assembler in the same order.
+      /// \param array The array that will hold the result
+      /// \param blocks The bounds of the blocks held by each rank, which must
+      /// partition the matrix (see \c is_block_partition )
+      MatrixBlocksToArray(A& array, const std::vector<std::size_t>& blocks) :
+        WorldObject_(array.world()), array_(array), tiles_()
+      {
+        complete_ = 0;
+
+        // Count the number of blocks that will be received for each local tile
+        const std::size_t nblocks = blocks.size() / 4ul;
+        for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+          const auto range = array.trange().make_tile_range(*it);
+          const MatrixBlockBounds tile_bounds = tile_block_bounds(range);
+          MatrixBlockBounds bounds;
+          int count = 0;
+          std::size_t volume = 0ul;
+          for(std::size_t p = 0ul; p < nblocks; ++p) {
+            if(intersect_blocks(tile_bounds.data(), blocks.data() + 4ul * p, bounds)) {
+              volume += (bounds[1] - bounds[0]) * (bounds[3] - bounds[2]);
+              ++count;
+            }
+          }
+          TA_ASSERT(volume == range.volume());
+
+          auto& tile = tiles_[*it];
+          tile.first = value_type(range);
+          tile.second = count;
+        }
+
+        WorldObject_::process_pending();
+      }
+
+      /// Send a block to the owner of a tile
+
+      /// \param i The tile index
+      /// \param block The block of tile \c i
+      void send(const size_type i, const block_type& block) {
+        WorldObject_::task(array_.owner(i), & MatrixBlocksToArray_::receive_handler,
+            i, block, madness::TaskAttributes::hipri());
+      }
+
+      /// Local tile completion query
+
+      /// \return \c true when all local tiles have been set
+      bool done() const { return complete_ == int(tiles_.size()); }
+
+    }; // class MatrixBlocksToArray
+
+    /// Assemble matrix blocks from array tiles distributed among ranks
+
+    /// The owner of each tile sends the intersection of the tile with the
+    /// block of each rank to that rank, which copies it into its block.
+    /// \tparam A The array type
+    /// \tparam Matrix The Eigen matrix type
+    template <typename A, typename Matrix>
+    class ArrayToMatrixBlocks : public madness::WorldObject<ArrayToMatrixBlocks<A, Matrix> > {
+    public:
+      typedef ArrayToMatrixBlocks<A, Matrix> ArrayToMatrixBlocks_; ///< This object type
+      typedef madness::WorldObject<ArrayToMatrixBlocks_> WorldObject_; ///< Base object type
+      typedef typename A::size_type size_type; ///< Size type
+      typedef typename A::value_type value_type; ///< Tile type
+      typedef Tensor<typename value_type::value_type> block_type; ///< Block type
+
+    private:
+
+      const A& array_; ///< The array that is being copied
+      Matrix& matrix_; ///< The local matrix block
+      std::vector<std::size_t> blocks_; ///< The bounds of the blocks held by each rank
+      madness::AtomicInt sent_; ///< The number of local tiles that have been sent
+      madness::AtomicInt received_; ///< The number of blocks that have been received
+
+      void receive_handler(const block_type& block) {
+        // The blocks received by this rank do not overlap.
+        const std::size_t* const local = blocks_.data() + 4ul * array_.world().rank();
+        const MatrixBlockBounds bounds = tile_block_bounds(block.range());
+        const std::size_t rows = bounds[1] - bounds[0];
+        const std::size_t cols = bounds[3] - bounds[2];
+        matrix_.block(bounds[0] - local[0], bounds[2] - local[2], rows, cols) =
+            eigen_map(block, rows, cols);
+        received_++;
+      }
+
+      void send_tile(const value_type& tile) {
+        const MatrixBlockBounds tile_bounds = tile_block_bounds(tile.range());
+        const auto tile_matrix = eigen_map(tile, tile_bounds[1] - tile_bounds[0],
+            tile_bounds[3] - tile_bounds[2]);
+        MatrixBlockBounds bounds;
+        const std::size_t nblocks = blocks_.size() / 4ul;
+        for(std::size_t p = 0ul; p < nblocks; ++p) {
+          if(intersect_blocks(tile_bounds.data(), blocks_.data() + 4ul * p, bounds))
+            WorldObject_::task(p, & ArrayToMatrixBlocks_::receive_handler,
+                make_matrix_block<typename value_type::value_type>(tile_matrix,
+                tile_bounds[0], tile_bounds[2], bounds),
+                madness::TaskAttributes::hipri());
+        }
+        sent_++;
+      }
+
+    public:
+
+      /// Constructor
+
+      /// This is a collective operation; all ranks must construct the
+      /// assembler in the same order.
+      /// \param array The array to be copied
+      /// \param matrix The local matrix block, which must be zero initialized
+      /// \param blocks The bounds of the blocks held by each rank
+      ArrayToMatrixBlocks(const A& array, Matrix& matrix,
+          const std::vector<std::size_t>& blocks) :
+        WorldObject_(array.world()), array_(array), matrix_(matrix),
+        blocks_(blocks)
+      {
+        sent_ = 0;
+        received_ = 0;
+        WorldObject_::process_pending();
+      }
+
+      /// Send the blocks of the local tiles to the ranks that hold them
+
+      /// \return The number of local tiles that will be sent
+      int send() {
+        int n = 0;
+        for(auto it = array_.pmap()->begin(); it != array_.pmap()->end(); ++it) {
+          if(array_.is_zero(*it))
+            continue;
+          array_.world().taskq.add(this, & ArrayToMatrixBlocks_::send_tile,
+              array_.find(*it));
+          ++n;
+        }
+        return n;
+      }
+
+      /// Count the blocks that this rank will receive
+
+      /// \return The number of non-zero tiles that intersect the local block
+      int expected() const {
+        const std::size_t* const local = blocks_.data() + 4ul * array_.world().rank();
+        MatrixBlockBounds bounds;
+        int n = 0;
+        for(std::size_t i = 0ul; i < array_.size(); ++i) {
+          if(array_.is_zero(i))
+            continue;
+          const MatrixBlockBounds tile_bounds =
+              tile_block_bounds(array_.trange().make_tile_range(i));
+          if(intersect_blocks(tile_bounds.data(), local, bounds))
+            ++n;
+        }
+        return n;
+      }
+
+      /// Completion query
+
+      /// \param sent The number of local tiles that will be sent
+      /// \param received The number of blocks that will be received
+      /// \return \c true when all local tiles have been sent and all blocks
+      /// have been received
+      bool done(const int sent, const int received) const {
+        return (sent_ == sent) && (received_ == received);
+      }
+
+    }; // class ArrayToMatrixBlocks
+
   } // namespace detail
 
   /// Convert an Eigen matrix into an Array object
@@ -357,6 +680,8 @@ namespace TiledArray {
   /// \throw TiledArray::Exception When world size is greater than 1
   /// \note If using 2 or more World ranks, set \c replicated=true and make sure \c matrix
   /// is the same on each rank!
+  /// Use \c eigen_block_to_array when each rank holds only a block of the
+  /// matrix.
   template <typename A, typename Derived>
   A eigen_to_array(World& world, const typename A::trange_type& trange,
       const Eigen::MatrixBase<Derived>& matrix, bool replicated = false)
@@ -429,6 +754,8 @@ namespace TiledArray {
   /// \c array is not replicated.
   /// \throw TiledArray::Exception When the number of dimensions of \c array
   /// is not equal to 1 or 2.
+  /// \note Use \c array_to_eigen_block to convert a distributed array
+  /// without replicating the matrix on each rank.
   template <typename Tile, typename Policy,
             unsigned int EigenStorageOrder = Eigen::ColMajor>
   Eigen::Matrix<typename Tile::value_type, Eigen::Dynamic, Eigen::Dynamic,
@@ -476,6 +803,179 @@ namespace TiledArray {
     return matrix;
   }
 
+  /// Convert an Eigen matrix that is distributed in blocks into an Array object
+
+  /// Each rank supplies one rectangular block of the full matrix, and the
+  /// blocks of all ranks must cover each element of the matrix exactly once,
+  /// e.g. the rows of the matrix may be partitioned among ranks. The blocks
+  /// are redistributed to the owners of the array tiles with point-to-point
+  /// messages, so no rank needs to hold more than its own block. This is a
+  /// collective operation, and this function will block until all local tiles
+  /// of the result array have been assembled.
+  /// Usage:
+  /// \code
+  /// // Each rank holds a slab of rows of a 100 x 100 matrix
+  /// const std::size_t first_row = 100ul * world.rank() / world.size();
+  /// const std::size_t last_row = 100ul * (world.rank() + 1) / world.size();
+  /// Eigen::MatrixXd slab(last_row - first_row, 100);
+  /// // Fill slab with data ...
+  ///
+  /// TiledArray::TArrayD array =
+  ///     eigen_block_to_array<TiledArray::TArrayD>(world, trange, slab, first_row);
+  /// \endcode
+  /// \tparam A The array type
+  /// \tparam Derived The Eigen matrix derived type
+  /// \param world The world where the array will live
+  /// \param trange The tiled range of the new array
+  /// \param block The local block of the matrix; for rank 1 arrays \c block
+  /// must have one column
+  /// \param row_offset The row index of the first row of \c block
+  /// \param col_offset The column index of the first column of \c block
+  /// [default = 0]
+  /// \return An \c Array object that holds the content of the matrix blocks
+  /// \throw TiledArray::Exception When the rank of \c trange is not 1 or 2.
+  /// \throw TiledArray::Exception When the blocks of all ranks are not
+  /// contained in \c trange , overlap, or do not cover each element; the
+  /// exception is thrown on all ranks.
+  template <typename A, typename Derived>
+  A eigen_block_to_array(World& world, const typename A::trange_type& trange,
+      const Eigen::MatrixBase<Derived>& block, const std::size_t row_offset,
+      const std::size_t col_offset = 0ul)
+  {
+    const auto rank = trange.tiles_range().rank();
+    TA_USER_ASSERT((rank == 2u) || (rank == 1u),
+        "TiledArray::eigen_block_to_array(): The array dimensions must be equal to 1 or 2.");
+
+    // Check that the blocks of all ranks partition the matrix. Every rank
+    // checks all blocks, so an invalid partition throws on every rank
+    // before any distributed object is constructed.
+    const auto* MADNESS_RESTRICT const extent = trange.elements_range().extent_data();
+    const detail::MatrixBlockBounds local{{ row_offset,
+        row_offset + std::size_t(block.rows()), col_offset,
+        col_offset + std::size_t(block.cols()) }};
+    const std::vector<std::size_t> blocks = detail::gather_block_bounds(world, local);
+    TA_USER_ASSERT(detail::is_block_partition(blocks, std::size_t(extent[0]),
+        (rank == 2u ? std::size_t(extent[1]) : 1ul)),
+        "TiledArray::eigen_block_to_array(): The matrix blocks must be contained in trange and cover each element exactly once.");
+
+    A array(world, trange);
+    detail::MatrixBlocksToArray<A> assembler(array, blocks);
+
+    // Send the intersection of the local block with each tile to its owner
+    if((local[0] < local[1]) && (local[2] < local[3])) {
+      detail::MatrixBlockBounds bounds;
+      for(std::size_t i = 0ul; i < array.size(); ++i) {
+        const detail::MatrixBlockBounds tile_bounds =
+            detail::tile_block_bounds(trange.make_tile_range(i));
+        if(detail::intersect_blocks(tile_bounds.data(), local.data(), bounds))
+          assembler.send(i, detail::make_matrix_block<typename A::value_type::value_type>(
+              block, row_offset, col_offset, bounds));
+      }
+    }
+
+    // Wait until the local tiles have been assembled. Tasks will be processed
+    // by this thread while waiting.
+    world.await([&assembler] () { return assembler.done(); });
+
+    return array;
+  }
+
+  /// Convert an Array object into Eigen matrix blocks distributed among ranks
+
+  /// Each rank receives one rectangular block of the matrix representation of
+  /// \c array , e.g. the rows of the matrix may be partitioned among ranks.
+  /// The blocks of different ranks may overlap or leave elements out. The
+  /// tiles are sent by their owners to the ranks whose blocks they intersect
+  /// with point-to-point messages, so \c array does not need to be
+  /// replicated. This is a collective operation, and this function will
+  /// block until the local block has been assembled.
+  /// Usage:
+  /// \code
+  /// // Each rank receives a slab of rows of a 100 x 100 array
+  /// const std::size_t first_row = 100ul * world.rank() / world.size();
+  /// const std::size_t last_row = 100ul * (world.rank() + 1) / world.size();
+  /// Eigen::MatrixXd slab =
+  ///     array_to_eigen_block(array, first_row, last_row - first_row, 0, 100);
+  /// \endcode
+  /// \tparam Tile The array tile type
+  /// \tparam EigenStorageOrder The storage order of the resulting Eigen::Matrix
+  ///      object; the default is Eigen::ColMajor, i.e. the column-major storage
+  /// \param array The array to be converted
+  /// \param row_offset The row index of the first row of the block
+  /// \param rows The number of rows in the block
+  /// \param col_offset The column index of the first column of the block
+  /// \param cols The number of columns in the block
+  /// \return The local block of the matrix representation of \c array
+  /// \throw TiledArray::Exception When the number of dimensions of \c array
+  /// is not equal to 1 or 2.
+  /// \throw TiledArray::Exception When the block is not contained in
+  /// \c array .
+  template <typename Tile, typename Policy,
+            unsigned int EigenStorageOrder = Eigen::ColMajor>
+  Eigen::Matrix<typename Tile::value_type, Eigen::Dynamic, Eigen::Dynamic,
+                EigenStorageOrder>
+  array_to_eigen_block(const DistArray<Tile, Policy>& array,
+      const std::size_t row_offset, const std::size_t rows,
+      const std::size_t col_offset, const std::size_t cols)
+  {
+    typedef Eigen::Matrix<typename Tile::value_type, Eigen::Dynamic,
+                          Eigen::Dynamic, EigenStorageOrder>
+        EigenMatrix;
+
+    const auto rank = array.trange().tiles_range().rank();
+    TA_USER_ASSERT((rank == 2u) || (rank == 1u),
+        "TiledArray::array_to_eigen_block(): The array dimensions must be equal to 1 or 2.");
+
+    // Check that the block is contained in the array
+    const auto* MADNESS_RESTRICT const extent = array.trange().elements_range().extent_data();
+    const detail::MatrixBlockBounds local{{ row_offset, row_offset + rows,
+        col_offset, col_offset + cols }};
+    TA_USER_ASSERT(local[1] <= std::size_t(extent[0]),
+        "TiledArray::array_to_eigen_block(): The rows of the matrix block are not contained in the array.");
+    TA_USER_ASSERT(local[3] <= (rank == 2u ? std::size_t(extent[1]) : 1ul),
+        "TiledArray::array_to_eigen_block(): The columns of the matrix block are not contained in the array.");
+
+    // if array is sparse must initialize to zero
+    EigenMatrix matrix = EigenMatrix::Zero(rows, cols);
+
+    const std::vector<std::size_t> blocks =
+        detail::gather_block_bounds(array.world(), local);
+    detail::ArrayToMatrixBlocks<DistArray<Tile, Policy>, EigenMatrix>
+        assembler(array, matrix, blocks);
+    const int received = assembler.expected();
+    const int sent = assembler.send();
+
+    // Wait until the local tiles have been sent and the local block has been
+    // assembled. Tasks will be processed by this thread while waiting.
+    array.world().await([&assembler,sent,received] () {
+      return assembler.done(sent, received); });
+
+    return matrix;
+  }
+
+  /// Convert an Array object into Eigen row slabs distributed among ranks
+
+  /// This is equivalent to \c array_to_eigen_block with blocks that span all
+  /// columns of \c array .
+  /// \tparam Tile The array tile type
+  /// \tparam EigenStorageOrder The storage order of the resulting Eigen::Matrix
+  ///      object; the default is Eigen::ColMajor, i.e. the column-major storage
+  /// \param array The array to be converted
+  /// \param row_offset The row index of the first row of the slab
+  /// \param rows The number of rows in the slab
+  /// \return The local row slab of the matrix representation of \c array
+  template <typename Tile, typename Policy,
+            unsigned int EigenStorageOrder = Eigen::ColMajor>
+  Eigen::Matrix<typename Tile::value_type, Eigen::Dynamic, Eigen::Dynamic,
+                EigenStorageOrder>
+  array_to_eigen_rows(const DistArray<Tile, Policy>& array,
+      const std::size_t row_offset, const std::size_t rows)
+  {
+    const auto& elements = array.trange().elements_range();
+    return array_to_eigen_block<Tile, Policy, EigenStorageOrder>(array,
+        row_offset, rows, 0ul, (elements.rank() == 2u ? elements.extent(1) : 1ul));
+  }
+
   /// Convert a row-major matrix buffer into an Array object
 
   /// This function will copy the content of \c buffer into an \c Array object
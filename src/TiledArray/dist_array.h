@@ -337,6 +337,54 @@ namespace TiledArray {
       return find<std::initializer_list<Integer>>(i);
     }
 
+    /// Start loading a local tile
+
+    /// This is a hint that tile \c i will be accessed soon. When
+    /// \c TileSpill is enabled and the tile is local and has been spilled to
+    /// disk, it is read back asynchronously. Otherwise this does nothing.
+    /// \param i The ordinal index of the tile
+    void prefetch(const size_type i) const {
+      check_index(i);
+      pimpl_->prefetch(i);
+    }
+
+    /// Transfer compression accessor
+
+    /// \return The accuracy contract of the tiles of this array that are
+    /// sent to other processes
+    const TileCompression& compression() const {
+      check_pimpl();
+      return pimpl_->compression();
+    }
+
+    /// Set the transfer compression
+
+    /// Tiles of this array that this process receives from other processes,
+    /// through \c find() or as arguments of a contraction, are encoded
+    /// according to \c compression . Lossy modes change the values that
+    /// other processes see, within the error bound of the contract. This is
+    /// a collective operation: it must be called on all processes with the
+    /// same contract, and it fences \c world() so that transfers in
+    /// progress use the previous contract on every process.
+    /// \param compression The accuracy contract
+    /// \throw TiledArray::Exception When the contract differs between
+    /// processes. It is thrown on all processes.
+    void compression(const TileCompression& compression) {
+      check_pimpl();
+      World& w = world();
+      w.gop.fence();
+
+      // SUMMA groups decode with the contract of the root, so all processes
+      // must agree on it
+      double contract[4] = { double(compression.mode()), compression.tolerance(),
+          -double(compression.mode()), -compression.tolerance() };
+      w.gop.max(contract, 4);
+      if((contract[0] != -contract[2]) || (contract[1] != -contract[3]))
+        TA_EXCEPTION("DistArray::compression(): the contract must be the same on all processes.");
+
+      pimpl_->compression(compression);
+    }
+
     /// Set a tile and fill it using a sequence
 
     /// \tparam Index An index or integral type
@@ -577,12 +625,16 @@ namespace TiledArray {
 
     /// Create a tensor expression
 
-    /// \param vars A string with a comma-separated list of variables
+    /// \param vars A string with a comma-separated list of variables; the
+    /// variables of the elements of a tensor of tensors follow a semicolon,
+    /// e.g. "i,j;a,b"
     /// \return A const tensor expression object
     TiledArray::expressions::TsrExpr<const DistArray_, true>
     operator ()(const std::string& vars) const {
 #ifndef NDEBUG
-      const unsigned int n = 1u + std::count_if(vars.begin(), vars.end(),
+      // Only the outer variables, which precede ';', are counted
+      const unsigned int n = 1u + std::count_if(vars.begin(),
+          std::find(vars.begin(), vars.end(), ';'),
           [](const char c) { return c == ','; });
       if(bool(pimpl_) && n != pimpl_->trange().tiles_range().rank()) {
         if(TiledArray::get_default_world().rank() == 0) {
@@ -600,12 +652,16 @@ namespace TiledArray {
 
     /// Create a tensor expression
 
-    /// \param vars A string with a comma-separated list of variables
+    /// \param vars A string with a comma-separated list of variables; the
+    /// variables of the elements of a tensor of tensors follow a semicolon,
+    /// e.g. "i,j;a,b"
     /// \return A non-const tensor expression object
     TiledArray::expressions::TsrExpr<DistArray_, true>
     operator ()(const std::string& vars) {
 #ifndef NDEBUG
-      const unsigned int n = 1u + std::count_if(vars.begin(), vars.end(),
+      // Only the outer variables, which precede ';', are counted
+      const unsigned int n = 1u + std::count_if(vars.begin(),
+          std::find(vars.begin(), vars.end(), ';'),
           [](const char c) { return c == ','; });
       if(bool(pimpl_) && n != pimpl_->trange().tiles_range().rank()) {
         if(TiledArray::get_default_world().rank() == 0) {
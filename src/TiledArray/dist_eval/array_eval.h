@@ -28,6 +28,7 @@
 
 #include <TiledArray/dist_eval/dist_eval.h>
 #include <TiledArray/block_range.h>
+#include <TiledArray/tile_cache.h>
 
 namespace TiledArray {
   namespace detail {
@@ -215,7 +216,10 @@ namespace TiledArray {
         Future<typename array_type::value_type> tile =
             array_.find(array_index);
 
-        const bool consumable_tile = ! array_.is_local(array_index);
+        // Remote tiles may be consumed by the tile operations, unless they
+        // are shared with other readers through the tile cache.
+        const bool consumable_tile = ! array_.is_local(array_index) &&
+            ! TileCache::instance().enabled();
         // Insert the tile into this evaluator for subsequent processing
         if(tile.probe()) {
           // Skip the task since the tile is ready
@@ -243,6 +247,23 @@ namespace TiledArray {
         const_cast<ArrayEvalImpl_*>(this)->notify();
       }
 
+      /// Hint that a tile will be needed soon
+
+      /// Spilled local tiles of the array are read back asynchronously.
+      /// \param i The index of the tile
+      virtual void prefetch_tile(size_type i) const {
+        size_type array_index = DistEvalImpl_::perm_index_to_source(i);
+        if(block_range_.rank())
+          array_index = block_range_.ordinal(array_index);
+        if(array_.is_local(array_index) && ! array_.is_zero(array_index))
+          array_.prefetch(array_index);
+      }
+
+      /// Transfer compression of the tiles
+
+      /// \return The transfer compression of the array
+      virtual TileCompression compression() const { return array_.compression(); }
+
     private:
 
       value_type make_tile(const typename array_type::value_type& tile, const bool consume) const {
@@ -0,0 +1,153 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  cached_eval.h
+ *  Jun 18, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_DIST_EVAL_CACHED_EVAL_H__INCLUDED
+#define TILEDARRAY_DIST_EVAL_CACHED_EVAL_H__INCLUDED
+
+#include <TiledArray/dist_eval/dist_eval.h>
+#include <TiledArray/tile_interface/cast.h>
+#include <TiledArray/tile_interface/clone.h>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Distributed evaluator for a previously evaluated expression
+
+    /// This evaluator provides copies of the tiles of an array that holds the
+    /// result of an expression that has already been evaluated. The array
+    /// must have the same tiled range and shape as this evaluator, but it may
+    /// have a different process map. If a source evaluator is given, it is
+    /// the evaluator that sets the tiles of the array, and this evaluator will
+    /// wait for its local tiles. Tiles are copied because the consumers of
+    /// evaluated tiles may modify them in place.
+    /// \tparam Array The array type that holds the evaluated tiles
+    /// \tparam Policy The evaluator policy type
+    template <typename Array, typename Policy>
+    class CachedEvalImpl :
+        public DistEvalImpl<typename Array::value_type, Policy>
+    {
+    public:
+      typedef CachedEvalImpl<Array, Policy> CachedEvalImpl_; ///< This object type
+      typedef DistEvalImpl<typename Array::value_type, Policy> DistEvalImpl_; ///< The base class type
+      typedef typename DistEvalImpl_::TensorImpl_ TensorImpl_; ///< The base, base class type
+      typedef Array array_type; ///< The array type
+      typedef DistEval<typename Array::value_type, Policy> source_type; ///< The source evaluator type
+      typedef typename DistEvalImpl_::size_type size_type; ///< Size type
+      typedef typename DistEvalImpl_::range_type range_type; ///< Range type
+      typedef typename DistEvalImpl_::shape_type shape_type; ///< Shape type
+      typedef typename DistEvalImpl_::pmap_interface pmap_interface; ///< Process map interface type
+      typedef typename DistEvalImpl_::trange_type trange_type; ///< Tiled range type
+      typedef typename DistEvalImpl_::value_type value_type; ///< Tile type
+      typedef typename DistEvalImpl_::eval_type eval_type; ///< Tile evaluation type
+
+      /// Constructor
+
+      /// \param array The array that holds the evaluated tiles
+      /// \param world The world where the tensor lives
+      /// \param trange The tiled range object
+      /// \param shape The tensor shape object
+      /// \param pmap The tile-process map
+      /// \param source The evaluator that sets the tiles of \c array , or
+      /// \c nullptr if the tiles have already been set
+      CachedEvalImpl(const array_type& array, World& world,
+          const trange_type& trange, const shape_type& shape,
+          const std::shared_ptr<pmap_interface>& pmap,
+          const std::shared_ptr<source_type>& source) :
+        DistEvalImpl_(world, trange, shape, pmap, Permutation()),
+        array_(array),
+        source_(source)
+      { }
+
+      /// Virtual destructor
+      virtual ~CachedEvalImpl() { }
+
+      /// Get tile at index \c i
+
+      /// \param i The index of the tile
+      /// \return A \c Future to the tile at index i
+      /// \throw TiledArray::Exception When tile \c i is owned by a remote node.
+      /// \throw TiledArray::Exception When tile \c i a zero tile.
+      virtual Future<value_type> get_tile(size_type i) const {
+        TA_ASSERT(TensorImpl_::is_local(i));
+        TA_ASSERT(! TensorImpl_::is_zero(i));
+        const madness::DistributedID key(DistEvalImpl_::id(), i);
+        return TensorImpl_::world().gop.template recv<value_type>(
+            TensorImpl_::world().rank(), key);
+      }
+
+      /// Discard a tile that is not needed
+
+      /// This function handles the cleanup for tiles that are not needed in
+      /// subsequent computation.
+      /// \param i The index of the tile
+      virtual void discard_tile(size_type i) const { get_tile(i); }
+
+    private:
+
+      /// Task function that copies a tile of the array
+
+      /// \param tile The array tile
+      /// \return A copy of \c tile
+      static value_type clone_tile(const value_type& tile) {
+        return TiledArray::clone(tile);
+      }
+
+      /// Evaluate the tiles of this tensor
+
+      /// This function will copy the local tiles of this distributed
+      /// evaluator from the array. It will block until the local tiles of the
+      /// source evaluator, if any, have been evaluated.
+      /// \return The number of tiles that will be set by this process
+      virtual int internal_eval() {
+        // Counter for the number of tasks submitted by this object
+        size_type task_count = 0ul;
+
+        // Copy the local tiles, which may be stored on other nodes if the
+        // array has a different process map.
+        const typename pmap_interface::const_iterator end = TensorImpl_::pmap()->end();
+        typename pmap_interface::const_iterator it = TensorImpl_::pmap()->begin();
+        for(; it != end; ++it) {
+          const size_type index = *it;
+          if(! TensorImpl_::is_zero(index)) {
+            DistEvalImpl_::set_tile(index, TensorImpl_::world().taskq.add(
+                & CachedEvalImpl_::clone_tile, array_.find(index)));
+            ++task_count;
+          }
+        }
+
+        // Wait for the local tiles of the source to be evaluated
+        if(source_) {
+          source_->wait();
+          source_.reset();
+        }
+
+        return task_count;
+      }
+
+      array_type array_; ///< The array that holds the evaluated tiles
+      std::shared_ptr<source_type> source_; ///< The evaluator of the array tiles
+    }; // class CachedEvalImpl
+
+  }  // namespace detail
+}  // namespace TiledArray
+
+#endif // TILEDARRAY_DIST_EVAL_CACHED_EVAL_H__INCLUDED
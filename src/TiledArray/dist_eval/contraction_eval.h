@@ -20,14 +20,17 @@
 #ifndef TILEDARRAY_DIST_EVAL_CONTRACTION_EVAL_H__INCLUDED
 #define TILEDARRAY_DIST_EVAL_CONTRACTION_EVAL_H__INCLUDED
 
+#include <atomic>
 #include <vector>
 
 #include <TiledArray/config.h>
 #include <TiledArray/dist_eval/dist_eval.h>
+#include <TiledArray/hierarchical_group.h>
 #include <TiledArray/proc_grid.h>
 #include <TiledArray/reduce_task.h>
 #include <TiledArray/type_traits.h>
 #include <TiledArray/shape.h>
+#include <TiledArray/tile_spill.h>
 
 //#define TILEDARRAY_ENABLE_SUMMA_TRACE_EVAL 1
 //#define TILEDARRAY_ENABLE_SUMMA_TRACE_INITIALIZE 1
@@ -38,6 +41,189 @@
 namespace TiledArray {
   namespace detail {
 
+    /// SUMMA memory limit
+
+    /// The limit is read from the \c TA_SUMMA_MAX_MEMORY environment variable,
+    /// which may include a unit (e.g. \c "2 GiB"). Limits smaller than
+    /// 100 MiB are increased to 100 MiB.
+    /// \return The maximum memory used per node, or zero if it is unbounded
+    inline std::size_t init_summa_max_memory() {
+      const char* max_memory = getenv("TA_SUMMA_MAX_MEMORY");
+      if(max_memory) {
+          // Convert the string into bytes
+          std::stringstream ss(max_memory);
+          double memory = 0.0;
+          if(ss >> memory) {
+              if(memory > 0.0) {
+                  std::string unit;
+                  if(ss >> unit) { // Failure == assume bytes
+                      if(unit == "KB" || unit == "kB") {
+                        memory *= 1000.0;
+                      } else if(unit == "KiB" || unit == "kiB") {
+                        memory *= 1024.0;
+                      } else if(unit == "MB") {
+                        memory *= 1000000.0;
+                      } else if(unit == "MiB") {
+                        memory *= 1048576.0;
+                      } else if(unit == "GB") {
+                        memory *= 1000000000.0;
+                      } else if(unit == "GiB") {
+                        memory *= 1073741824.0;
+                      }
+                  }
+              }
+          }
+
+          memory = std::max(memory, 104857600.0); // Minimum 100 MiB
+          return memory;
+      }
+
+      return 0ul;
+    }
+
+    /// SUMMA iteration governor
+
+    /// This object controls the number of concurrent SUMMA iterations (the
+    /// lookahead depth) of a single contraction. The initial depth is chosen
+    /// by \c Summa from the process grid, the tile sizes, and the shape
+    /// sparsity. While the contraction is running, the depth is reduced when
+    /// the broadcast data held by this process approaches the memory budget,
+    /// and it is tuned by hill climbing on the observed rate at which SUMMA
+    /// iterations complete.
+    class SummaGovernor {
+    public:
+      typedef std::size_t size_type; ///< Size type
+
+    private:
+      mutable madness::Spinlock lock_; ///< Governor lock
+      size_type budget_; ///< Memory budget in bytes (0 = unbounded)
+      size_type max_depth_; ///< The maximum depth
+      size_type depth_; ///< The current depth
+      size_type target_depth_; ///< The depth selected by hill climbing
+      size_type resident_; ///< Bytes held by iterations in flight
+      size_type step_bytes_; ///< Running estimate of bytes per iteration
+      double sample_start_; ///< Start time of the current throughput sample
+      size_type sample_steps_; ///< Iterations completed in the current sample
+      double rate_; ///< Iteration rate of the previous sample
+      int direction_; ///< Hill-climbing direction (-1, 0, or +1)
+
+    public:
+
+      /// Constructor
+
+      /// \param budget The memory budget, in bytes, for broadcast data held by
+      /// this process; 0 means unbounded
+      explicit SummaGovernor(const size_type budget = 0ul) :
+        lock_(), budget_(budget), max_depth_(1ul), depth_(1ul),
+        target_depth_(1ul), resident_(0ul), step_bytes_(0ul),
+        sample_start_(0.0), sample_steps_(0ul), rate_(0.0), direction_(1)
+      { }
+
+      /// Set the initial and maximum depth
+
+      /// \param depth The initial number of concurrent iterations
+      /// \param max_depth The maximum number of concurrent iterations
+      void initialize(const size_type depth, const size_type max_depth) {
+        madness::ScopedMutex<madness::Spinlock> locker(&lock_);
+        depth_ = target_depth_ = std::max<size_type>(depth, 1ul);
+        max_depth_ = std::max(max_depth, depth_);
+        sample_start_ = madness::wall_time();
+      }
+
+      /// Memory budget accessor
+
+      /// \return The memory budget in bytes, or 0 if unbounded
+      size_type budget() const { return budget_; }
+
+      /// Current depth accessor
+
+      /// \return The number of concurrent SUMMA iterations
+      size_type depth() const {
+        madness::ScopedMutex<madness::Spinlock> locker(&lock_);
+        return depth_;
+      }
+
+      /// Resident memory accessor
+
+      /// \return The number of bytes held by iterations in flight
+      size_type resident() const {
+        madness::ScopedMutex<madness::Spinlock> locker(&lock_);
+        return resident_;
+      }
+
+      /// Register the start of a SUMMA iteration
+
+      /// \param bytes The memory held by the iteration until its tile
+      /// contractions are complete
+      /// \param can_shrink The caller is able to reduce the depth
+      /// \param can_grow The caller is able to increase the depth
+      /// \return The change in depth that the caller must apply: -1, 0, or 1
+      int start_step(const size_type bytes, const bool can_shrink,
+          const bool can_grow)
+      {
+        madness::ScopedMutex<madness::Spinlock> locker(&lock_);
+        resident_ += bytes;
+        step_bytes_ = (step_bytes_ ? (3ul * step_bytes_ + bytes) / 4ul : bytes);
+
+        // Throttle the lookahead when the next iteration would exceed the budget
+        if(budget_ && ((resident_ + step_bytes_) > budget_)) {
+          target_depth_ = std::min(target_depth_, depth_);
+          if(can_shrink && (depth_ > 1ul)) {
+            target_depth_ = --depth_;
+            return -1;
+          }
+          return 0;
+        }
+
+        if((depth_ < target_depth_) && can_grow &&
+            (! budget_ || ((resident_ + 2ul * step_bytes_) <= budget_))) {
+          ++depth_;
+          return 1;
+        }
+
+        if((depth_ > target_depth_) && can_shrink) {
+          --depth_;
+          return -1;
+        }
+
+        return 0;
+      }
+
+      /// Register the completion of SUMMA iterations
+
+      /// \param bytes The memory released by the completed iterations
+      /// \param steps The number of completed iterations
+      void finish_steps(const size_type bytes, const size_type steps) {
+        madness::ScopedMutex<madness::Spinlock> locker(&lock_);
+        resident_ -= std::min(bytes, resident_);
+        sample_steps_ += steps;
+
+        // Sample the iteration rate over at least one full window
+        if(sample_steps_ < std::max<size_type>(depth_, 4ul))
+          return;
+
+        const double now = madness::wall_time();
+        const double rate = double(sample_steps_) / std::max(now - sample_start_, 1.0e-9);
+        if(rate_ > 0.0) {
+          if(rate < 0.9 * rate_)
+            // The last change made things worse, so go the other way
+            direction_ = (direction_ ? -direction_ : -1);
+          else if(rate < 1.1 * rate_)
+            // No significant change, so hold the current depth
+            direction_ = 0;
+        }
+        if(direction_ > 0)
+          target_depth_ = std::min(target_depth_ + 1ul, max_depth_);
+        else if(direction_ < 0)
+          target_depth_ = std::max<size_type>(target_depth_, 2ul) - 1ul;
+
+        rate_ = rate;
+        sample_start_ = now;
+        sample_steps_ = 0ul;
+      }
+
+    }; // class SummaGovernor
+
     /// \brief Distributed contraction evaluator implementation
 
     /// \tparam Left The left-hand argument evaluator type
@@ -68,6 +254,7 @@ namespace TiledArray {
       typedef typename DistEvalImpl_::value_type value_type; ///< Tile type
       typedef typename DistEvalImpl_::eval_type eval_type; ///< Tile evaluation type
       typedef Op op_type; ///< Tile evaluation operator type
+      typedef DistEval<value_type, Policy> accum_type; ///< The accumulated result evaluator type
 
     private:
       static size_type max_memory_; ///< Maximum memory used per node
@@ -77,15 +264,24 @@ namespace TiledArray {
       left_type left_; ///< The left-hand argument
       right_type right_; /// < The right-hand argument
       op_type op_; /// < The operation used to evaluate tile-tile contractions
+      std::shared_ptr<accum_type> accum_; ///< The result that the contraction is added to
+      const shape_type cont_shape_; ///< The shape of the contraction products
+      std::vector<bool> accum_only_; ///< Local reduce tasks that hold only an accumulated tile
 
       // Broadcast groups for dense arguments (empty for non-dense arguments)
       madness::Group row_group_; ///< The row process group for this rank
       madness::Group col_group_; ///< The column process group for this rank
+      std::shared_ptr<const NodeMap> node_map_; ///< The node of each process
 
       // Dimension information
       const size_type k_; ///< Number of tiles in the inner dimension
       const ProcGrid proc_grid_; ///< Process grid for this contraction
 
+      // Lookahead control
+      const size_type left_tile_bytes_; ///< Average size of a left-hand tile
+      const size_type right_tile_bytes_; ///< Average size of a right-hand tile
+      SummaGovernor governor_; ///< Controls the number of concurrent iterations
+
       // Contraction results
       ReducePairTask<op_type>* reduce_tasks_; ///< A pointer to the reduction tasks
 
@@ -122,39 +318,7 @@ namespace TiledArray {
 
 
       /// Initialize max_memory_ limit for SUMMA
-      static size_type init_max_memory() {
-        const char* max_memory = getenv("TA_SUMMA_MAX_MEMORY");
-        if(max_memory) {
-            // Convert the string into bytes
-            std::stringstream ss(max_memory);
-            double memory = 0.0;
-            if(ss >> memory) {
-                if(memory > 0.0) {
-                    std::string unit;
-                    if(ss >> unit) { // Failure == assume bytes
-                        if(unit == "KB" || unit == "kB") {
-                          memory *= 1000.0;
-                        } else if(unit == "KiB" || unit == "kiB") {
-                          memory *= 1024.0;
-                        } else if(unit == "MB") {
-                          memory *= 1000000.0;
-                        } else if(unit == "MiB") {
-                          memory *= 1048576.0;
-                        } else if(unit == "GB") {
-                          memory *= 1000000000.0;
-                        } else if(unit == "GiB") {
-                          memory *= 1073741824.0;
-                        }
-                    }
-                }
-            }
-
-            memory = std::max(memory, 104857600.0); // Minimum 100 MiB
-            return memory;
-        }
-
-        return 0ul;
-      }
+      static size_type init_max_memory() { return init_summa_max_memory(); }
 
 
       static size_type init_max_depth() {
@@ -164,6 +328,31 @@ namespace TiledArray {
         return 0ul;
       }
 
+      /// Average tile size of an argument
+
+      /// \tparam Arg The argument type
+      /// \param arg The argument
+      /// \return The average number of bytes in a tile of \c arg
+      template <typename Arg>
+      static size_type average_tile_bytes(const Arg& arg) {
+        const size_type tiles = arg.trange().tiles_range().volume();
+        if(tiles == 0ul) return 0ul;
+        return (arg.trange().elements_range().volume() / tiles) *
+            sizeof(typename numeric_type<typename Arg::eval_type>::type);
+      }
+
+      /// Memory held by a SUMMA iteration
+
+      /// \param col The left-hand tiles of the iteration
+      /// \param row The right-hand tiles of the iteration
+      /// \return The estimated number of bytes held by this process for the
+      /// iteration
+      size_type step_memory(const std::vector<col_datum>& col,
+          const std::vector<row_datum>& row) const
+      {
+        return col.size() * left_tile_bytes_ + row.size() * right_tile_bytes_;
+      }
+
 
       // Process groups --------------------------------------------------------
 
@@ -282,8 +471,8 @@ namespace TiledArray {
         const auto nproc_cols = proc_grid_.proc_cols();
         const auto my_proc_row = proc_grid_.rank_row();
 
-        // result shape
-        const auto& result_shape = TensorImpl_::shape();
+        // result shape, excluding tiles that are only accumulated
+        const auto& result_shape = cont_shape_;
 
         // if result is dense, include all processors
         if (result_shape.is_dense())
@@ -351,8 +540,8 @@ namespace TiledArray {
         const auto nproc_rows = proc_grid_.proc_rows();
         const auto my_proc_col = proc_grid_.rank_col();
 
-        // result shape
-        const auto& result_shape = TensorImpl_::shape();
+        // result shape, excluding tiles that are only accumulated
+        const auto& result_shape = cont_shape_;
 
         // if result is dense, include all processors
         if (result_shape.is_dense())
@@ -508,6 +697,26 @@ namespace TiledArray {
         TA_ASSERT(vec.size() > 0ul);
       }
 
+      /// Hint that non-zero local tiles of \c arg will be needed soon
+
+      /// This lets argument tiles that have been spilled to disk be read
+      /// while the current iteration runs.
+      /// \tparam Arg The argument type
+      /// \param[in] arg The owner of the input tiles
+      /// \param[in] index The index of the first tile
+      /// \param[in] end The end of the range of tiles
+      /// \param[in] stride The stride between tile indices
+      template <typename Arg>
+      void prefetch_vector(const Arg& arg, size_type index, const size_type end,
+          const size_type stride) const
+      {
+        if(! TileSpill::instance().enabled() || ! arg.is_local(index))
+          return;
+        for(; index < end; index += stride)
+          if(! arg.shape().is_zero(index))
+            arg.prefetch(index);
+      }
+
       /// Collect non-zero tiles from column \c k of \c left_
 
       /// \param[in] k The column to be retrieved
@@ -515,6 +724,11 @@ namespace TiledArray {
       void get_col(const size_type k, std::vector<col_datum>& col) const {
         col.reserve(proc_grid_.local_rows());
         get_vector(left_, left_start_local_ + k, left_end_, left_stride_local_, col);
+
+        // Start loading the tiles of the next column
+        if(k + 1ul < k_)
+          prefetch_vector(left_, left_start_local_ + k + 1ul, left_end_,
+              left_stride_local_);
       }
 
       /// Collect non-zero tiles from row \c k of \c right_
@@ -530,6 +744,76 @@ namespace TiledArray {
         begin += proc_grid_.rank_col();
 
         get_vector(right_, begin, end, right_stride_local_, row);
+
+        // Start loading the tiles of the next row
+        if(k + 1ul < k_)
+          prefetch_vector(right_, begin + proc_grid_.cols(),
+              end + proc_grid_.cols(), right_stride_local_);
+      }
+
+      /// Two-level broadcast group factory function
+
+      /// When several processes of \c group are on the same node, the result
+      /// broadcasts tiles once to each node and then within each node (see
+      /// \c HierarchicalGroup ).
+      /// \param group The process group where the tiles will be broadcast
+      /// \param group_root The root process of the broadcast
+      /// \param group_index The broadcast group index, which is \c k for
+      /// column groups and \c k+k_ for row groups
+      /// \return The broadcast group
+      HierarchicalGroup make_bcast_group(const madness::Group& group,
+          const ProcessID group_root, const size_type group_index) const
+      {
+        const ProcessID node = node_map_->node(TensorImpl_::world().rank());
+        return HierarchicalGroup(*node_map_, group, group_root,
+            madness::DistributedID(DistEvalImpl_::id(), 2ul * k_ + group_index),
+            madness::DistributedID(DistEvalImpl_::id(), 4ul * k_ +
+                group_index * node_map_->nodes() + node));
+      }
+
+      /// Intra-node broadcast key
+
+      /// \param index The broadcast key index of a tile
+      /// \return The key used to broadcast the tile within a node
+      madness::DistributedID intra_key(const size_type index) const {
+        return madness::DistributedID(DistEvalImpl_::id(),
+            left_.size() + right_.size() + index);
+      }
+
+      /// Broadcast a tile
+
+      /// When \c compression is enabled, the root encodes the tile with a
+      /// task, the encoded tile is broadcast, and the other group members
+      /// decode it with a task.
+      /// \tparam T The tile type
+      /// \param[in] group The broadcast group
+      /// \param[in] key The broadcast key
+      /// \param[in] local_key The intra-node broadcast key
+      /// \param[in,out] tile The tile, which is set on all group members
+      /// \param[in] tile_bytes The size of the tile
+      /// \param[in] compression The transfer compression of the tile
+      /// \param[in] root \c true if this process is the root of the broadcast
+      template <typename T>
+      void bcast_tile(const HierarchicalGroup& group,
+          const madness::DistributedID& key, const madness::DistributedID& local_key,
+          Future<T>& tile, const size_type tile_bytes,
+          const TileCompression& compression, const bool root) const
+      {
+        if(! compression.enabled()) {
+          group.bcast(key, local_key, tile, tile_bytes);
+          return;
+        }
+
+        typedef TileCodec<T> codec_type;
+        World& world = TensorImpl_::world();
+        Future<typename codec_type::packed_type> packed = (root ?
+            world.taskq.add(& codec_type::compress, tile, compression,
+                madness::TaskAttributes::hipri()) :
+            Future<typename codec_type::packed_type>());
+        group.bcast(key, local_key, packed, tile_bytes);
+        if(! root)
+          tile.set(world.taskq.add(& codec_type::decompress, packed,
+              madness::TaskAttributes::hipri()));
       }
 
       /// Broadcast tiles from \c arg
@@ -539,11 +823,16 @@ namespace TiledArray {
       /// \param[in] group The process group where the tiles will be broadcast
       /// \param[in] group_root The root process of the broadcast
       /// \param[in] key_offset The broadcast key offset value
+      /// \param[in] group_index The broadcast group index
+      /// \param[in] tile_bytes The average size of the tiles
+      /// \param[in] compression The transfer compression of the tiles
       /// \param[out] vec The vector that will hold broadcast tiles
       template <typename Datum>
       void bcast(const size_type start, const size_type stride,
           const madness::Group& group, const ProcessID group_root,
-          const size_type key_offset, std::vector<Datum>& vec) const
+          const size_type key_offset, const size_type group_index,
+          const size_type tile_bytes, const TileCompression& compression,
+          std::vector<Datum>& vec) const
       {
         TA_ASSERT(vec.size() != 0ul);
         TA_ASSERT(group.size() > 0);
@@ -560,13 +849,17 @@ namespace TiledArray {
         ss << "} tiles={ ";
 #endif // TILEDARRAY_ENABLE_SUMMA_TRACE_BCAST
 
+        const HierarchicalGroup bcast_group =
+            make_bcast_group(group, group_root, group_index);
+
         // Iterate over tiles to be broadcast
         for(typename std::vector<Datum>::iterator it = vec.begin(); it != vec.end(); ++it) {
           const size_type index = it->first * stride + start;
 
           // Broadcast the tile
           const madness::DistributedID key(DistEvalImpl_::id(), index + key_offset);
-          TensorImpl_::world().gop.bcast(key, it->second, group_root, group);
+          bcast_tile(bcast_group, key, intra_key(index + key_offset), it->second,
+              tile_bytes, compression, group.rank() == group_root);
 
 #ifdef TILEDARRAY_ENABLE_SUMMA_TRACE_BCAST
           ss  << index << " ";
@@ -611,7 +904,8 @@ namespace TiledArray {
         if (!row_group.empty()) {
           // Broadcast column k of left_.
           ProcessID group_root = get_row_group_root(k, row_group);
-          bcast(left_start_local_ + k, left_stride_local_, row_group, group_root, 0ul, col);
+          bcast(left_start_local_ + k, left_stride_local_, row_group, group_root,
+                0ul, k + k_, left_tile_bytes_, left_.compression(), col);
         }
       }
 
@@ -627,7 +921,8 @@ namespace TiledArray {
 
           // Broadcast row k of right_.
           bcast(k * proc_grid_.cols() + proc_grid_.rank_col(),
-                right_stride_local_, col_group, group_root, left_.size(), row);
+                right_stride_local_, col_group, group_root, left_.size(), k,
+                right_tile_bytes_, right_.compression(), row);
         }
       }
 
@@ -644,7 +939,7 @@ namespace TiledArray {
           // will create broadcast group only if needed
           bool have_group = false;
           madness::Group row_group;
-          ProcessID group_root;
+          HierarchicalGroup bcast_group;
           bool do_broadcast;
 
           // Search column k of left for non-zero tiles
@@ -658,14 +953,16 @@ namespace TiledArray {
               // broadcast if I am in this group and this group has others
               do_broadcast = !row_group.empty() && row_group.size() > 1;
               if (do_broadcast)
-                group_root = get_row_group_root(k, row_group);
+                bcast_group = make_bcast_group(row_group,
+                    get_row_group_root(k, row_group), k + k_);
             }
 
             if(do_broadcast) {
               // Broadcast the tile
               const madness::DistributedID key(DistEvalImpl_::id(), index);
               auto tile = get_tile(left_, index);
-              TensorImpl_::world().gop.bcast(key, tile, group_root, row_group);
+              bcast_tile(bcast_group, key, intra_key(index), tile,
+                  left_tile_bytes_, left_.compression(), true);
             } else {
               // Discard the tile
               left_.discard(index);
@@ -689,7 +986,7 @@ namespace TiledArray {
           // will create broadcast group only if needed
           bool have_group = false;
           madness::Group col_group;
-          ProcessID group_root;
+          HierarchicalGroup bcast_group;
           bool do_broadcast;
 
           // Search for and broadcast non-zero row
@@ -703,14 +1000,16 @@ namespace TiledArray {
               // broadcast if I am in this group and this group has others
               do_broadcast = !col_group.empty() && col_group.size() > 1;
               if (do_broadcast)
-                group_root = get_col_group_root(k, col_group);
+                bcast_group = make_bcast_group(col_group,
+                    get_col_group_root(k, col_group), k);
             }
 
             if(do_broadcast) {
               // Broadcast the tile
               const madness::DistributedID key(DistEvalImpl_::id(), index + left_.size());
               auto tile = get_tile(right_, index);
-              TensorImpl_::world().gop.bcast(key, tile, group_root, col_group);
+              bcast_tile(bcast_group, key, intra_key(index + left_.size()), tile,
+                  right_tile_bytes_, right_.compression(), true);
             } else {
               // Discard the tile
               right_.discard(index);
@@ -823,6 +1122,70 @@ namespace TiledArray {
       }
 
 
+      // Accumulation functions ------------------------------------------------
+
+      /// Process that evaluates a result tile
+
+      /// \param index The unpermuted index of the result tile
+      /// \return The rank of the process in the process grid that reduces
+      /// tile \c index
+      ProcessID proc_grid_owner(const size_type index) const {
+        // Compute tile coordinate in tile grid
+        const size_type tile_row = index / proc_grid_.cols();
+        const size_type tile_col = index % proc_grid_.cols();
+        // Compute process coordinate of tile in the process grid
+        const size_type proc_row = tile_row % proc_grid_.proc_rows();
+        const size_type proc_col = tile_col % proc_grid_.proc_cols();
+        // Compute the process that owns tile
+        return proc_row * proc_grid_.proc_cols() + proc_col;
+      }
+
+      /// Accumulated result tile key
+
+      /// The keys follow the result tile and argument broadcast keys.
+      /// \param index The index of the result tile
+      /// \return The key used to send tile \c index of the accumulated result
+      madness::DistributedID accum_key(const size_type index) const {
+        return madness::DistributedID(DistEvalImpl_::id(), TensorImpl_::size() +
+            2ul * (left_.size() + right_.size()) + index);
+      }
+
+      /// Accumulated result tile accessor
+
+      /// \param index The index of a local result tile
+      /// \return A future to tile \c index of the accumulated result, which
+      /// is received from its owner if it is not local
+      Future<value_type> accum_tile(const size_type index) const {
+        if(accum_->is_local(index))
+          return accum_->get(index);
+
+        return TensorImpl_::world().gop.template recv<value_type>(
+            accum_->owner(index), accum_key(index));
+      }
+
+      /// Send the local tiles of the accumulated result to the reducing process
+
+      /// Local tiles of the accumulated result are sent to the process that
+      /// reduces the corresponding result tile, if it is not this process.
+      /// Tiles that correspond to zero result tiles are discarded.
+      void send_accum_tiles() const {
+        const ProcessID rank = TensorImpl_::world().rank();
+        for(const size_type index : *accum_->pmap()) {
+          if(accum_->is_zero(index))
+            continue;
+
+          if(TensorImpl_::is_zero(index)) {
+            accum_->discard(index);
+          } else {
+            const ProcessID owner = proc_grid_owner(index);
+            if(owner != rank) {
+              TensorImpl_::world().gop.send(owner, accum_key(index),
+                  accum_->get(index));
+            }
+          }
+        }
+      }
+
       // Initialization functions ----------------------------------------------
 
       /// Initialize reduce tasks and construct broadcast groups
@@ -855,7 +1218,17 @@ namespace TiledArray {
         for(size_type t = 0ul; t < n; ++t) {
           // Initialize the reduction task
           ReducePairTask<op_type>* MADNESS_RESTRICT const reduce_task = reduce_tasks_ + t;
-          new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_);
+          if(accum_) {
+            // Compute the index of the t-th local tile
+            const size_type row = proc_grid_.rank_row() +
+                (t / proc_grid_.local_cols()) * proc_grid_.proc_rows();
+            const size_type col = proc_grid_.rank_col() +
+                (t % proc_grid_.local_cols()) * proc_grid_.proc_cols();
+            new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_,
+                accum_tile(row * proc_grid_.cols() + col));
+          } else {
+            new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_);
+          }
         }
 
         return proc_grid_.local_size();
@@ -873,6 +1246,8 @@ namespace TiledArray {
         // Allocate memory for the reduce pair tasks.
         std::allocator<ReducePairTask<op_type> > alloc;
         reduce_tasks_ = alloc.allocate(proc_grid_.local_size());
+        if(accum_)
+          accum_only_.assign(proc_grid_.local_size(), false);
 
         // Initialize iteration variables
         size_type row_start = proc_grid_.rank_row() * proc_grid_.cols();
@@ -901,7 +1276,17 @@ namespace TiledArray {
               ss << index << " ";
 #endif // TILEDARRAY_ENABLE_SUMMA_TRACE_INITIALIZE
 
-              new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_);
+              if(accum_ && ! accum_->is_zero(index)) {
+                new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(),
+                    op_, accum_tile(index));
+
+                // Tiles that are zero in the contraction shape are not
+                // contracted, as when the sum is evaluated term by term.
+                if(cont_shape_.is_zero(index))
+                  accum_only_[reduce_task - reduce_tasks_] = true;
+              } else {
+                new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_);
+              }
               ++tile_count;
             } else {
               // Construct an empty task to represent zero tiles.
@@ -1053,6 +1438,16 @@ namespace TiledArray {
 
       // Contraction functions -------------------------------------------------
 
+      /// Check for a reduce task that does not receive tile pairs
+
+      /// \param index The index of a local reduce task
+      /// \return \c true if the reduce task represents a zero tile, or a tile
+      /// of the accumulated result that is zero in the contraction shape
+      bool skip_reduce_task(const size_type index) const {
+        return (! reduce_tasks_[index]) ||
+            ((! accum_only_.empty()) && accum_only_[index]);
+      }
+
       /// Schedule local contraction tasks for \c col and \c row tile pairs
 
       /// Schedule tile contractions for each tile pair of \c row and \c col. A
@@ -1107,7 +1502,7 @@ namespace TiledArray {
             const size_type reduce_task_index = reduce_task_offset + row[j].first;
 
             // Skip zero tiles
-            if(! reduce_tasks_[reduce_task_index])
+            if(skip_reduce_task(reduce_task_index))
               continue;
 
             // Schedule task for contraction pairs
@@ -1170,7 +1565,7 @@ namespace TiledArray {
             const size_type reduce_task_index = offset + row[j].first;
 
             // Skip zero tiles
-            if(! reduce_tasks_[reduce_task_index])
+            if(skip_reduce_task(reduce_task_index))
               continue;
 
             if(task)
@@ -1203,6 +1598,8 @@ namespace TiledArray {
         FinalizeTask* finalize_task_; ///< The SUMMA finalization task
         StepTask* next_step_task_ = nullptr; ///< The next SUMMA step task
         StepTask* tail_step_task_ = nullptr; ///< The last SUMMA step task that currently exists
+        std::atomic<size_type> release_bytes_{0ul}; ///< Memory of the iterations that this task waits on
+        std::atomic<size_type> release_steps_{0ul}; ///< Number of iterations that this task waits on
 
         void get_col(const size_type k) {
           owner_->get_col(k, col_);
@@ -1294,11 +1691,51 @@ namespace TiledArray {
           printf("step:  start rank=%i k=%lu\n", owner_->world().rank(), k);
 #endif // TILEDARRAY_ENABLE_SUMMA_TRACE_STEP
 
+          // The contractions of the iterations that this task waited on are
+          // complete, so release their memory.
+          const size_type release_steps = release_steps_.exchange(0ul);
+          if(release_steps)
+            owner_->governor_.finish_steps(release_bytes_.exchange(0ul), release_steps);
+
           if(k < owner_->k_) {
-            // Initialize next tail task and submit next task
             TA_ASSERT(next_step_task_);
-            next_step_task_->tail_step_task_ =
-                new Derived(static_cast<Derived*>(tail_step_task_), 1);  // <- ndep=1, will control its scheduling by this task
+            TA_ASSERT(tail_step_task_);
+
+            // Ask the governor whether the lookahead should change
+            const size_type step_bytes = owner_->step_memory(col_, row_);
+            const int delta = owner_->governor_.start_step(step_bytes,
+                tail_step_task_ != next_step_task_, true);
+
+            if(delta < 0) {
+              // Do not extend the pipeline, instead the current tail task will
+              // also wait for the contractions of the next iteration.
+              if (trace_tasks)
+                tail_step_task_->inc_debug("StepTask nth ctor");
+              else
+                tail_step_task_->inc();
+              next_step_task_->tail_step_task_ = tail_step_task_;
+            } else {
+              Derived* tail = static_cast<Derived*>(tail_step_task_);
+              if(delta > 0) {
+                // Extend the pipeline with an extra task that does not wait
+                // on the contractions of any iteration.
+                tail = new Derived(tail, 1);
+                if (trace_tasks)
+                  tail->notify_debug("StepTask nth ctor");
+                else
+                  tail->notify();
+              }
+
+              // Initialize next tail task
+              next_step_task_->tail_step_task_ =
+                  new Derived(tail, 1);  // <- ndep=1, will control its scheduling by this task
+            }
+
+            // The tail task will run after the contractions for this iteration
+            // are complete.
+            tail_step_task_->release_bytes_ += step_bytes;
+            ++tail_step_task_->release_steps_;
+
             // submit next step task ... even if it's same as tail_step_task_ it is safe to submit
             // because its ndep > 0 (see StepTask::make_next_step_tasks)
             TA_ASSERT(tail_step_task_->ndep() > 0);
@@ -1477,17 +1914,31 @@ namespace TiledArray {
       /// \param k The number of tiles in the inner dimension
       /// \param proc_grid The process grid that defines the layout of the tiles
       ///                  during the contraction evaluation
+      /// \param accum The evaluator of a result that the contraction is added
+      ///              to, or \c nullptr
+      /// \param cont_shape The shape of the contraction, which selects the
+      ///                   contracted result tiles when \c shape is the shape
+      ///                   of the accumulated result, or \c nullptr
       /// \note The trange, shape, and pmap refer to the final,
       ///       permuted, state for the result, NOT to the result during
       ///       the SUMMA evaluation.
+      /// \note The tiles of \c accum are the initial values of the reductions
+      ///       and are modified in place. \c accum must have the same tiled
+      ///       range as the result, and \c perm must be empty.
       Summa(const left_type& left, const right_type& right,
           World& world, const trange_type trange, const shape_type& shape,
           const std::shared_ptr<pmap_interface>& pmap, const Permutation& perm,
-          const op_type& op, const size_type k, const ProcGrid& proc_grid) :
+          const op_type& op, const size_type k, const ProcGrid& proc_grid,
+          const std::shared_ptr<accum_type>& accum = nullptr,
+          const shape_type* cont_shape = nullptr) :
         DistEvalImpl_(world, trange, shape, pmap, perm),
-        left_(left), right_(right), op_(op),
-        row_group_(), col_group_(),
+        left_(left), right_(right), op_(op), accum_(accum),
+        cont_shape_(cont_shape ? *cont_shape : shape), accum_only_(),
+        row_group_(), col_group_(), node_map_(NodeMap::instance(world)),
         k_(k), proc_grid_(proc_grid),
+        left_tile_bytes_(average_tile_bytes(left)),
+        right_tile_bytes_(average_tile_bytes(right)),
+        governor_(max_memory_),
         reduce_tasks_(NULL),
         left_start_local_(proc_grid_.rank_row() * k),
         left_end_(left.size()),
@@ -1495,7 +1946,10 @@ namespace TiledArray {
         left_stride_local_(proc_grid.proc_rows() * k),
         right_stride_(1ul),
         right_stride_local_(proc_grid.proc_cols())
-      { }
+      {
+        TA_ASSERT(! (accum && perm));
+        TA_ASSERT(accum || ! cont_shape);
+      }
 
       virtual ~Summa() { }
 
@@ -1509,16 +1963,8 @@ namespace TiledArray {
         TA_ASSERT(TensorImpl_::is_local(i));
         TA_ASSERT(! TensorImpl_::is_zero(i));
 
-        const size_type source_index = DistEvalImpl_::perm_index_to_source(i);
-
-        // Compute tile coordinate in tile grid
-        const size_type tile_row = source_index / proc_grid_.cols();
-        const size_type tile_col = source_index % proc_grid_.cols();
-        // Compute process coordinate of tile in the process grid
-        const size_type proc_row = tile_row % proc_grid_.proc_rows();
-        const size_type proc_col = tile_col % proc_grid_.proc_cols();
-        // Compute the process that owns tile
-        const ProcessID source = proc_row * proc_grid_.proc_cols() + proc_col;
+        const ProcessID source =
+            proc_grid_owner(DistEvalImpl_::perm_index_to_source(i));
 
         const madness::DistributedID key(DistEvalImpl_::id(), i);
         return TensorImpl_::world().gop.template recv<value_type>(source, key);
@@ -1550,18 +1996,16 @@ namespace TiledArray {
 
           // Compute the average memory requirement per iteration of this process
           const std::size_t local_memory_per_iter_left =
-              (left_.trange().elements_range().volume() / left_.trange().tiles_range().volume()) *
-              sizeof(typename numeric_type<typename left_type::eval_type>::type) *
-              proc_grid_.local_rows() * (1.0f - left_sparsity);
+              left_tile_bytes_ * proc_grid_.local_rows() * (1.0f - left_sparsity);
           const std::size_t local_memory_per_iter_right =
-              (right_.trange().elements_range().volume() / right_.trange().tiles_range().volume()) *
-              sizeof(typename numeric_type<typename right_type::eval_type>::type) *
-              proc_grid_.local_cols() * (1.0f - right_sparsity);
+              right_tile_bytes_ * proc_grid_.local_cols() * (1.0f - right_sparsity);
+          const std::size_t local_memory_per_iter =
+              std::max<std::size_t>(local_memory_per_iter_left +
+              local_memory_per_iter_right, 1ul);
 
           // Compute the maximum number of iterations based on available memory
           const size_type mem_bound_depth =
-              ((local_memory_per_iter_left + local_memory_per_iter_right) /
-              available_memory);
+              available_memory / local_memory_per_iter;
 
           // Check if the memory bounded depth is less than the optimal depth
           if(depth > mem_bound_depth) {
@@ -1585,6 +2029,16 @@ namespace TiledArray {
         return depth;
       }
 
+      /// Upper bound for the depth selected by the governor
+
+      /// \param depth The initial iteration depth
+      /// \return The user defined depth bound, if set, otherwise twice the
+      /// initial depth; no more than the number of iterations
+      size_type max_governed_depth(const size_type depth) const {
+        const size_type max_depth = (max_depth_ ? max_depth_ : 2ul * depth);
+        return std::max(std::min(max_depth, k_), depth);
+      }
+
       /// Evaluate the tiles of this tensor
 
       /// This function will evaluate the children of this distributed evaluator
@@ -1600,6 +2054,10 @@ namespace TiledArray {
         // Start evaluate child tensors
         left_.eval();
         right_.eval();
+        if(accum_) {
+          accum_->eval();
+          send_accum_tiles();
+        }
 
 #ifdef TILEDARRAY_ENABLE_SUMMA_TRACE_EVAL
         printf("eval: finished eval children rank=%i\n", TensorImpl_::world().rank());
@@ -1628,8 +2086,9 @@ namespace TiledArray {
             depth = mem_bound_depth(depth, 0.0f, 0.0f);
 
             // Enforce user defined depth bound
-            if(max_depth_) std::min(depth, max_depth_);
+            if(max_depth_) depth = std::min(depth, max_depth_);
 
+            governor_.initialize(depth, max_governed_depth(depth));
             TensorImpl_::world().taskq.add(new DenseStepTask(shared_from_this(),
                                                              depth));
           } else {
@@ -1655,8 +2114,9 @@ namespace TiledArray {
             depth = mem_bound_depth(depth, left_sparsity, right_sparsity);
 
             // Enforce user defined depth bound
-            if(max_depth_) std::min(depth, max_depth_);
+            if(max_depth_) depth = std::min(depth, max_depth_);
 
+            governor_.initialize(depth, max_governed_depth(depth));
             TensorImpl_::world().taskq.add(new SparseStepTask(shared_from_this(),
                                                               depth));
           }
@@ -1669,6 +2129,10 @@ namespace TiledArray {
         // Wait for child tensors to be evaluated, and process tasks while waiting.
         left_.wait();
         right_.wait();
+        if(accum_) {
+          accum_->wait();
+          accum_.reset();
+        }
 
 #ifdef TILEDARRAY_ENABLE_SUMMA_TRACE_EVAL
         printf("eval: finished wait children rank=%i\n", TensorImpl_::world().rank());
@@ -23,6 +23,7 @@
 #include <TiledArray/tensor_impl.h>
 #include <TiledArray/permutation.h>
 #include <TiledArray/perm_index.h>
+#include <TiledArray/tile_compression.h>
 #include <TiledArray/type_traits.h>
 
 namespace TiledArray {
@@ -137,6 +138,18 @@ namespace TiledArray {
       /// \param i The index of the tile
       virtual void discard_tile(size_type i) const = 0;
 
+      /// Hint that a tile will be needed soon
+
+      /// The default implementation does nothing.
+      /// \param i The index of the tile
+      virtual void prefetch_tile(size_type) const { }
+
+      /// Transfer compression of the tiles
+
+      /// The default implementation does not compress tiles.
+      /// \return The accuracy contract of tiles sent to other processes
+      virtual TileCompression compression() const { return TileCompression(); }
+
       /// Set tensor value
 
       /// This will store \c value at ordinal index \c i . Typically, this
@@ -336,6 +349,16 @@ namespace TiledArray {
       /// \param i The index of the tile
       virtual void discard(size_type i) const { pimpl_->discard_tile(i); }
 
+      /// Hint that a tile will be needed soon
+
+      /// \param i The index of the tile
+      void prefetch(size_type i) const { pimpl_->prefetch_tile(i); }
+
+      /// Transfer compression of the tiles
+
+      /// \return The accuracy contract of tiles sent to other processes
+      TileCompression compression() const { return pimpl_->compression(); }
+
       /// World object accessor
 
       /// \return A reference to the world object
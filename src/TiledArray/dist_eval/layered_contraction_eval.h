@@ -0,0 +1,631 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  layered_contraction_eval.h
+ *  Jun 4, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_DIST_EVAL_LAYERED_CONTRACTION_EVAL_H__INCLUDED
+#define TILEDARRAY_DIST_EVAL_LAYERED_CONTRACTION_EVAL_H__INCLUDED
+
+#include <TiledArray/dist_eval/contraction_eval.h>
+#include <sstream>
+#include <string>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Parse a \c TA_CONTRACTION_LAYERS setting
+
+    /// \param value The setting: a positive number of layers, \c auto , or
+    /// null when the variable is not set
+    /// \return The number of layers, or zero for \c auto . Settings that are
+    /// not set or not valid select one layer, i.e. a 2D grid.
+    inline std::size_t parse_contraction_layers(const char* const value) {
+      if(! value)
+        return 1ul;
+      const std::string setting(value);
+      if(setting == "auto")
+        return 0ul;
+
+      std::stringstream ss(setting);
+      long long layers = 0ll;
+      std::string rest;
+      if((ss >> layers) && !(ss >> rest) && (layers > 0ll))
+        return layers;
+
+      printf("!! WARNING TiledArray: TA_CONTRACTION_LAYERS=%s is not valid, "
+             "a 2D process grid is used.\n", value);
+      return 1ul;
+    }
+
+    /// The \c TA_CONTRACTION_LAYERS setting of this process
+
+    /// \return The number of layers, or zero for \c auto
+    inline std::size_t contraction_layers_setting() {
+      static const std::size_t layers =
+          parse_contraction_layers(getenv("TA_CONTRACTION_LAYERS"));
+      return layers;
+    }
+
+    /// Select the number of process grid layers for a contraction
+
+    /// Layered (2.5D) contractions are opt-in: a 2D grid is used unless the
+    /// \c TA_CONTRACTION_LAYERS environment variable sets the number of
+    /// layers, or is \c auto . In the latter case the number of layers,
+    /// \f$ L \f$, is selected to minimize the data received by a process of a
+    /// layered SUMMA,
+    /// \f[
+    ///   V = \frac{Kk (Mm + Nn)}{L \sqrt{P/L}} + \frac{(L - 1) L Mm Nn}{P}
+    /// \f]
+    /// where the first term is the broadcast volume of the arguments within a
+    /// layer and the second term is the volume of the partial results that are
+    /// reduced onto the first layer. Each layer holds a copy of the result, so
+    /// \f$ L \f$ is also limited such that the partial result tiles held by a
+    /// process use no more than half of the per-process SUMMA memory limit
+    /// (see \c TA_SUMMA_MAX_MEMORY ). A 2D grid is always selected with fewer
+    /// than 8 processes.
+    /// \param nprocs The number of processes
+    /// \param M The number of tile rows in the result
+    /// \param N The number of tile columns in the result
+    /// \param K The number of tiles in the inner dimension
+    /// \param Mm The number of element rows in the result
+    /// \param Nn The number of element columns in the result
+    /// \param Kk The number of elements in the inner dimension
+    /// \param element_bytes The size of a result element
+    /// \param setting The number of layers, or zero to select it
+    /// automatically
+    /// \return The number of process grid layers
+    inline ProcGrid::size_type contraction_layers(const ProcGrid::size_type nprocs,
+        const std::size_t M, const std::size_t N, const std::size_t K,
+        const std::size_t Mm, const std::size_t Nn, const std::size_t Kk,
+        const std::size_t element_bytes,
+        const std::size_t setting = contraction_layers_setting())
+    {
+      if(setting)
+        return std::max<std::size_t>(1ul,
+            std::min<std::size_t>(setting, std::min<std::size_t>(nprocs, K)));
+
+      if(nprocs < 8u)
+        return 1u;
+
+      // Communication does not improve beyond P^(1/3) layers, and each layer
+      // needs at least one tile of the inner dimension.
+      const std::size_t max_layers =
+          std::min<std::size_t>(std::cbrt(double(nprocs)) + 0.5, K);
+      static const std::size_t max_memory = init_summa_max_memory();
+      const double tile_bytes = double(Mm) * double(Nn) * double(element_bytes)
+          / double(std::max<std::size_t>(M * N, 1ul));
+
+      // Select the number of layers with the minimum communication volume
+      std::size_t layers = 1ul;
+      double min_volume = double(Kk) * double(Mm + Nn) / std::sqrt(double(nprocs));
+      for(std::size_t L = 2ul; L <= max_layers; ++L) {
+        // Limit the memory used by a process to hold the partial result
+        // tiles of its layer
+        if(max_memory) {
+          const std::size_t layer_procs = nprocs / L;
+          const std::size_t rows = std::max<std::size_t>(
+              std::sqrt(double(layer_procs)), 1ul);
+          const std::size_t cols = std::max<std::size_t>(layer_procs / rows, 1ul);
+          const double local_bytes = double((M + rows - 1ul) / rows)
+              * double((N + cols - 1ul) / cols) * tile_bytes;
+          if(local_bytes > 0.5 * double(max_memory))
+            break;
+        }
+
+        const double volume =
+            double(Kk) * double(Mm + Nn) / (double(L) * std::sqrt(double(nprocs / L)))
+            + double(L - 1ul) * double(L) * double(Mm) * double(Nn) / double(nprocs);
+        if(volume < min_volume) {
+          layers = L;
+          min_volume = volume;
+        }
+      }
+
+      return layers;
+    }
+
+    /// Distributed contraction evaluator with a layered (2.5D) process grid
+
+    /// The processes are divided into the layers of \c proc_grid , and each
+    /// layer evaluates the contraction over the inner-dimension tiles
+    /// \f$ k \equiv l \pmod{L} \f$ with the SUMMA algorithm on its own 2D
+    /// process grid. The partial results of the layers are then reduced onto
+    /// the first layer, which sets the result tiles. Compared to \c Summa ,
+    /// each process broadcasts and receives \f$ L \f$ times fewer argument
+    /// tiles at the cost of holding a partial result tile for each result tile
+    /// of its layer.
+    /// \tparam Left The left-hand argument evaluator type
+    /// \tparam Right The right-hand argument evaluator type
+    /// \tparam Op The contraction/reduction operation type
+    /// \tparam Policy The tensor policy class
+    /// \note The arguments must be distributed with the process maps
+    /// constructed by \c ProcGrid::make_row_phase_pmap() and
+    /// \c ProcGrid::make_col_phase_pmap() .
+    template <typename Left, typename Right, typename Op, typename Policy>
+    class LayeredSumma :
+        public DistEvalImpl<typename Op::result_type, Policy>,
+        public std::enable_shared_from_this<LayeredSumma<Left, Right, Op, Policy> >
+    {
+    public:
+      typedef LayeredSumma<Left, Right, Op, Policy> LayeredSumma_; ///< This object type
+      typedef DistEvalImpl<typename Op::result_type, Policy> DistEvalImpl_; ///< The base class type
+      typedef typename DistEvalImpl_::TensorImpl_ TensorImpl_; ///< The base, base class type
+      typedef Left left_type; ///< The left-hand argument type
+      typedef Right right_type; ///< The right-hand argument type
+      typedef typename DistEvalImpl_::size_type size_type; ///< Size type
+      typedef typename DistEvalImpl_::range_type range_type; ///< Range type
+      typedef typename DistEvalImpl_::shape_type shape_type; ///< Shape type
+      typedef typename DistEvalImpl_::pmap_interface pmap_interface; ///< Process map interface type
+      typedef typename DistEvalImpl_::trange_type trange_type; ///< Tiled range type
+      typedef typename DistEvalImpl_::value_type value_type; ///< Tile type
+      typedef typename DistEvalImpl_::eval_type eval_type; ///< Tile evaluation type
+      typedef Op op_type; ///< Tile evaluation operator type
+
+    private:
+
+      // Arguments and operation
+      left_type left_; ///< The left-hand argument
+      right_type right_; /// < The right-hand argument
+      op_type op_; /// < The operation used to evaluate tile-tile contractions
+
+      // Broadcast groups of this process's layer
+      madness::Group row_group_; ///< The row process group for this rank
+      madness::Group col_group_; ///< The column process group for this rank
+
+      // Dimension information
+      const size_type k_; ///< Number of tiles in the inner dimension
+      const ProcGrid proc_grid_; ///< Layered process grid for this contraction
+
+      // Contraction results
+      ReducePairTask<op_type>* reduce_tasks_; ///< A pointer to the reduction tasks
+
+      typedef Future<typename right_type::eval_type> right_future; ///< Future to a right-hand argument tile
+      typedef Future<typename left_type::eval_type> left_future; ///< Future to a left-hand argument tile
+      typedef std::pair<size_type, right_future> row_datum; ///< Datum element type for a right-hand argument row
+      typedef std::pair<size_type, left_future> col_datum; ///< Datum element type for a left-hand argument column
+
+    protected:
+
+      // Import base class functions
+      using std::enable_shared_from_this<LayeredSumma_>::shared_from_this;
+
+    private:
+
+      // Tile access -----------------------------------------------------------
+
+      /// Conversion function
+
+      /// \tparam Tile The input tile type
+      /// \param tile The input tile
+      /// \return The evaluated version of the lazy tile
+      template <typename Tile>
+      static auto convert_tile(const Tile& tile) {
+        TiledArray::Cast<typename eval_trait<Tile>::type, Tile> cast;
+        return cast(tile);
+      }
+
+      /// Get a non-lazy tile from \c arg
+      template <typename Arg>
+      static typename std::enable_if<
+          ! is_lazy_tile<typename Arg::value_type>::value,
+          Future<typename Arg::eval_type> >::type
+      get_tile(Arg& arg, const typename Arg::size_type index) { return arg.get(index); }
+
+      /// Get a lazy tile from \c arg and spawn a task to evaluate it
+      template <typename Arg>
+      static typename std::enable_if<
+          is_lazy_tile<typename Arg::value_type>::value,
+          Future<typename Arg::eval_type> >::type
+      get_tile(Arg& arg, const typename Arg::size_type index) {
+        auto convert_tile_fn =
+            &LayeredSumma_::template convert_tile<typename Arg::value_type>;
+        return arg.world().taskq.add(convert_tile_fn, arg.get(index),
+                                     madness::TaskAttributes::hipri());
+      }
+
+      /// Collect and broadcast the non-zero tiles of a row or column
+
+      /// Local tiles are read from \c arg , and the remaining tiles are
+      /// received from the root of \c group .
+      /// \param[in] arg The owner of the input tiles
+      /// \param[in] index The index of the first tile
+      /// \param[in] end The end of the range of tiles
+      /// \param[in] stride The stride between tile indices
+      /// \param[in] group The process group where the tiles will be broadcast
+      /// \param[in] group_root The root process of the broadcast
+      /// \param[in] key_offset The broadcast key offset value
+      /// \param[out] vec The vector that will hold broadcast tiles
+      template <typename Arg, typename Datum>
+      void bcast_vector(Arg& arg, size_type index, const size_type end,
+          const size_type stride, const madness::Group& group,
+          const ProcessID group_root, const size_type key_offset,
+          std::vector<Datum>& vec) const
+      {
+        const bool local = arg.is_local(index);
+        for(size_type i = 0ul; index < end; ++i, index += stride) {
+          if(arg.shape().is_zero(index)) continue;
+          vec.emplace_back(i, (local ? get_tile(arg, index) :
+              Future<typename Arg::eval_type>()));
+
+          const madness::DistributedID key(DistEvalImpl_::id(), index + key_offset);
+          TensorImpl_::world().gop.bcast(key, vec.back().second, group_root, group);
+        }
+      }
+
+      /// Key used to reduce the partial result tiles of the layers
+
+      /// \param index The result tile index
+      /// \param layer The layer that holds the partial result
+      /// \return The distributed id of the partial result
+      madness::DistributedID partial_key(const size_type index, const size_type layer) const {
+        return madness::DistributedID(DistEvalImpl_::id(), left_.size() +
+            right_.size() + index * proc_grid_.layers() + layer);
+      }
+
+      /// Check for a partial result of \c layer
+
+      /// \param layer The layer to be checked
+      /// \param index The result tile index
+      /// \return \c true if \c layer contributes a partial result to result
+      /// tile \c index , otherwise \c false .
+      bool has_partial(const size_type layer, const size_type index) const {
+        if(left_.shape().is_dense() && right_.shape().is_dense())
+          return true;
+
+        const size_type i = index / proc_grid_.cols();
+        const size_type j = index % proc_grid_.cols();
+        for(size_type k = layer; k < k_; k += proc_grid_.layers())
+          if(! (left_.shape().is_zero(i * k_ + k) ||
+              right_.shape().is_zero(k * proc_grid_.cols() + j)))
+            return true;
+
+        return false;
+      }
+
+      /// Sum two partial result tiles
+      value_type add_partials(value_type result, const value_type& arg) const {
+        op_(result, arg);
+        return result;
+      }
+
+
+      // Evaluation ------------------------------------------------------------
+
+      /// Initialize reduce tasks and construct broadcast groups
+
+      /// \return The number of result tiles that will be set by this process
+      size_type initialize() {
+        row_group_ = proc_grid_.make_row_group(
+            madness::DistributedID(DistEvalImpl_::id(), k_));
+        col_group_ = proc_grid_.make_col_group(
+            madness::DistributedID(DistEvalImpl_::id(), 0ul));
+
+        // Allocate memory for the reduce pair tasks.
+        std::allocator<ReducePairTask<op_type> > alloc;
+        reduce_tasks_ = alloc.allocate(proc_grid_.local_size());
+
+        // Initialize iteration variables
+        size_type row_start = proc_grid_.rank_row() * proc_grid_.cols();
+        size_type row_end = row_start + proc_grid_.cols();
+        row_start += proc_grid_.rank_col();
+        const size_type col_stride = // The stride to iterate down a column
+            proc_grid_.proc_rows() * proc_grid_.cols();
+        const size_type row_stride = // The stride to iterate across a row
+            proc_grid_.proc_cols();
+        const size_type end = TensorImpl_::size();
+        const size_type layer = proc_grid_.rank_layer();
+
+        // Iterate over all local tiles
+        size_type tile_count = 0ul;
+        ReducePairTask<op_type>* MADNESS_RESTRICT reduce_task = reduce_tasks_;
+        for(; row_start < end; row_start += col_stride, row_end += col_stride) {
+          for(size_type index = row_start; index < row_end; index += row_stride, ++reduce_task) {
+            if(TensorImpl_::shape().is_zero(DistEvalImpl_::perm_index_to_target(index))) {
+              new(reduce_task) ReducePairTask<op_type>();
+              continue;
+            }
+
+            // Only the first layer sets result tiles
+            if(layer == 0)
+              ++tile_count;
+
+            if(has_partial(layer, index))
+              new(reduce_task) ReducePairTask<op_type>(TensorImpl_::world(), op_);
+            else
+              new(reduce_task) ReducePairTask<op_type>();
+          }
+        }
+
+        return tile_count;
+      }
+
+      /// Broadcast and contract the tiles of SUMMA iteration \c k
+
+      /// \param k The inner dimension index of the iteration
+      /// \param task The task that depends on the tile contractions
+      void step(const size_type k, madness::TaskInterface* const task) {
+        const size_type layer_k = k / proc_grid_.layers();
+
+        // Broadcast column k of left_ to the process row
+        std::vector<col_datum> col;
+        col.reserve(proc_grid_.local_rows());
+        bcast_vector(left_, proc_grid_.rank_row() * k_ + k, left_.size(),
+            proc_grid_.proc_rows() * k_, row_group_,
+            layer_k % proc_grid_.proc_cols(), 0ul, col);
+
+        // Broadcast row k of right_ to the process column
+        std::vector<row_datum> row;
+        row.reserve(proc_grid_.local_cols());
+        const size_type row_begin = k * proc_grid_.cols();
+        bcast_vector(right_, row_begin + proc_grid_.rank_col(),
+            row_begin + proc_grid_.cols(), proc_grid_.proc_cols(), col_group_,
+            layer_k % proc_grid_.proc_rows(), left_.size(), row);
+
+        // Schedule the tile contractions
+        for(size_type i = 0ul; i < col.size(); ++i) {
+          const size_type reduce_task_offset = col[i].first * proc_grid_.local_cols();
+          for(size_type j = 0ul; j < row.size(); ++j) {
+            const size_type reduce_task_index = reduce_task_offset + row[j].first;
+
+            // Skip zero tiles
+            if(! reduce_tasks_[reduce_task_index])
+              continue;
+
+            task->inc();
+            reduce_tasks_[reduce_task_index].add(col[i].second, row[j].second, task);
+          }
+        }
+      }
+
+      /// Reduce the partial results and set the result tiles
+      void finalize() {
+        // Initialize iteration variables
+        size_type row_start = proc_grid_.rank_row() * proc_grid_.cols();
+        size_type row_end = row_start + proc_grid_.cols();
+        row_start += proc_grid_.rank_col();
+        const size_type col_stride = // The stride to iterate down a column
+            proc_grid_.proc_rows() * proc_grid_.cols();
+        const size_type row_stride = // The stride to iterate across a row
+            proc_grid_.proc_cols();
+        const size_type end = TensorImpl_::size();
+        const size_type layer = proc_grid_.rank_layer();
+
+        // Iterate over all local tiles
+        for(ReducePairTask<op_type>* reduce_task = reduce_tasks_;
+            row_start < end; row_start += col_stride, row_end += col_stride) {
+          for(size_type index = row_start; index < row_end; index += row_stride, ++reduce_task) {
+            const size_type perm_index = DistEvalImpl_::perm_index_to_target(index);
+
+            if(! TensorImpl_::shape().is_zero(perm_index)) {
+              if(layer == 0ul) {
+                // Sum the partial results of all layers
+                bool has_result = *reduce_task;
+                Future<value_type> result =
+                    (has_result ? reduce_task->submit() : Future<value_type>());
+                for(size_type l = 1ul; l < proc_grid_.layers(); ++l) {
+                  if(! has_partial(l, index)) continue;
+
+                  Future<value_type> partial =
+                      TensorImpl_::world().gop.template recv<value_type>(
+                      proc_grid_.map_layer(l), partial_key(index, l));
+                  result = (has_result ? TensorImpl_::world().taskq.add(
+                      shared_from_this(), & LayeredSumma_::add_partials,
+                      result, partial) : partial);
+                  has_result = true;
+                }
+
+                // No layer contributes to the tile, so set it to the identity
+                // of the reduction, as Summa does
+                if(! has_result)
+                  result = Future<value_type>(op_());
+                DistEvalImpl_::set_tile(perm_index, result);
+              } else if(*reduce_task) {
+                // Send the partial result to the first layer
+                TensorImpl_::world().gop.send(proc_grid_.map_layer(0ul),
+                    partial_key(index, layer), reduce_task->submit());
+              }
+            }
+
+            // Destroy the reduce task
+            reduce_task->~ReducePairTask<op_type>();
+          }
+        }
+
+        // Deallocate the memory for the reduce pair tasks.
+        std::allocator<ReducePairTask<op_type> >().deallocate(reduce_tasks_,
+            proc_grid_.local_size());
+      }
+
+      /// Layered SUMMA finalization task
+
+      /// This task will reduce the partial results, set the tiles, and do
+      /// cleanup.
+      class FinalizeTask : public madness::TaskInterface {
+      private:
+        std::shared_ptr<LayeredSumma_> owner_; ///< The parent object for this task
+
+      public:
+        FinalizeTask(const std::shared_ptr<LayeredSumma_>& owner, const int ndep) :
+          madness::TaskInterface(ndep, madness::TaskAttributes::hipri()),
+          owner_(owner)
+        { }
+
+        virtual ~FinalizeTask() { }
+
+        virtual void run(const madness::TaskThreadEnv&) { owner_->finalize(); }
+
+      }; // class FinalizeTask
+
+      /// Layered SUMMA iteration task
+
+      /// Each task broadcasts and contracts the tiles of one iteration. The
+      /// tile contractions are registered as dependencies of the task
+      /// \c depth iterations later (or the finalize task), which limits the
+      /// number of iterations that hold broadcast tiles.
+      class StepTask : public madness::TaskInterface {
+      private:
+        std::shared_ptr<LayeredSumma_> owner_; ///< The parent object for this task
+        const size_type k_; ///< The inner dimension index of this iteration
+        madness::TaskInterface* const next_; ///< The task that waits on the contractions of this iteration
+
+      public:
+        StepTask(const std::shared_ptr<LayeredSumma_>& owner, const size_type k,
+            const int ndep, madness::TaskInterface* const next) :
+          madness::TaskInterface(ndep, madness::TaskAttributes::hipri()),
+          owner_(owner), k_(k), next_(next)
+        { }
+
+        virtual ~StepTask() { }
+
+        virtual void run(const madness::TaskThreadEnv&) {
+          owner_->step(k_, next_);
+          next_->notify();
+        }
+
+      }; // class StepTask
+
+    public:
+
+      /// Constructor
+
+      /// \param left The left-hand argument evaluator
+      /// \param right The right-hand argument evaluator
+      /// \param world The world where the result lives
+      /// \param trange The tiled range object for the result
+      /// \param shape The tensor shape object for the result
+      /// \param pmap The tile-process map for the result
+      /// \param perm The permutation that is applied to result tile indices
+      /// \param op The tile transform operation
+      /// \param k The number of tiles in the inner dimension
+      /// \param proc_grid The layered process grid that defines the layout of
+      ///                  the tiles during the contraction evaluation
+      /// \note The trange, shape, and pmap refer to the final,
+      ///       permuted, state for the result, NOT to the result during
+      ///       the SUMMA evaluation.
+      LayeredSumma(const left_type& left, const right_type& right,
+          World& world, const trange_type trange, const shape_type& shape,
+          const std::shared_ptr<pmap_interface>& pmap, const Permutation& perm,
+          const op_type& op, const size_type k, const ProcGrid& proc_grid) :
+        DistEvalImpl_(world, trange, shape, pmap, perm),
+        left_(left), right_(right), op_(op),
+        row_group_(), col_group_(),
+        k_(k), proc_grid_(proc_grid),
+        reduce_tasks_(NULL)
+      {
+        TA_ASSERT(proc_grid_.layers() <= k_);
+      }
+
+      virtual ~LayeredSumma() { }
+
+      /// Get tile at index \c i
+
+      /// \param i The index of the tile
+      /// \return A \c Future to the tile at index i
+      /// \throw TiledArray::Exception When tile \c i is owned by a remote node.
+      /// \throw TiledArray::Exception When tile \c i a zero tile.
+      virtual Future<value_type> get_tile(size_type i) const {
+        TA_ASSERT(TensorImpl_::is_local(i));
+        TA_ASSERT(! TensorImpl_::is_zero(i));
+
+        const size_type source_index = DistEvalImpl_::perm_index_to_source(i);
+
+        // Compute tile coordinate in tile grid
+        const size_type tile_row = source_index / proc_grid_.cols();
+        const size_type tile_col = source_index % proc_grid_.cols();
+        // Compute process coordinate of tile in the first layer of the
+        // process grid
+        const size_type proc_row = tile_row % proc_grid_.proc_rows();
+        const size_type proc_col = tile_col % proc_grid_.proc_cols();
+        // Compute the process that owns tile
+        const ProcessID source = proc_row * proc_grid_.proc_cols() + proc_col;
+
+        const madness::DistributedID key(DistEvalImpl_::id(), i);
+        return TensorImpl_::world().gop.template recv<value_type>(source, key);
+      }
+
+
+      /// Discard a tile that is not needed
+
+      /// This function handles the cleanup for tiles that are not needed in
+      /// subsequent computation.
+      /// \param i The index of the tile
+      virtual void discard_tile(size_type i) const { get_tile(i); }
+
+    private:
+
+      /// Evaluate the tiles of this tensor
+
+      /// This function will evaluate the children of this distributed evaluator
+      /// and evaluate the tiles for this distributed evaluator. It will block
+      /// until the tasks for the children are evaluated (not for the tasks of
+      /// this object).
+      /// \return The number of tiles that will be set by this process
+      virtual int internal_eval() {
+        // Start evaluate child tensors
+        left_.eval();
+        right_.eval();
+
+        size_type tile_count = 0ul;
+        if(proc_grid_.local_size() > 0ul) {
+          tile_count = initialize();
+
+          // The iterations of this layer
+          const size_type layer = proc_grid_.rank_layer();
+          const size_type steps =
+              (k_ - layer + proc_grid_.layers() - 1ul) / proc_grid_.layers();
+
+          // The number of concurrent iterations is equal to the smallest
+          // dimension of the layer grid, but no less than 2
+          const size_type depth = std::min<size_type>(steps,
+              std::max(ProcGrid::size_type(2),
+              std::min(proc_grid_.proc_rows(), proc_grid_.proc_cols())));
+
+          // Construct the iteration tasks from last to first so that each task
+          // knows the task that depends on its contractions.
+          std::shared_ptr<LayeredSumma_> self = shared_from_this();
+          FinalizeTask* const finalize_task = new FinalizeTask(self, depth);
+          std::vector<StepTask*> step_tasks(steps, nullptr);
+          for(size_type s = steps; s > 0ul; --s) {
+            const size_type step = s - 1ul;
+            madness::TaskInterface* const next = (step + depth < steps ?
+                static_cast<madness::TaskInterface*>(step_tasks[step + depth]) :
+                finalize_task);
+            step_tasks[step] = new StepTask(self,
+                layer + step * proc_grid_.layers(), (step < depth ? 0 : 1), next);
+          }
+
+          for(size_type step = 0ul; step < steps; ++step)
+            TensorImpl_::world().taskq.add(step_tasks[step]);
+          TensorImpl_::world().taskq.add(finalize_task);
+        }
+
+        // Wait for child tensors to be evaluated, and process tasks while waiting.
+        left_.wait();
+        right_.wait();
+
+        return tile_count;
+      }
+
+    }; // class LayeredSumma
+
+  } // namespace detail
+}  // namespace TiledArray
+
+#endif // TILEDARRAY_DIST_EVAL_LAYERED_CONTRACTION_EVAL_H__INCLUDED
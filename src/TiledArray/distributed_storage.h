@@ -21,6 +21,11 @@
 #define TILEDARRAY_DISTRIBUTED_STORAGE_H__INCLUDED
 
 #include <TiledArray/pmap/pmap.h>
+#include <TiledArray/tile_cache.h>
+#include <TiledArray/tile_compression.h>
+#include <TiledArray/tile_spill.h>
+#include <madness/world/vector_archive.h>
+#include <unistd.h>
 
 namespace TiledArray {
   namespace detail {
@@ -34,14 +39,22 @@ namespace TiledArray {
     /// initialized because they will be added to the container when the element
     /// is first accessed, though you may manually initialize an element with
     /// the \c insert() function. All elements are stored in \c Future ,
-    /// which may be set only once.
+    /// which may be set only once. When \c TileCache is enabled, remote
+    /// elements are cached by the requesting node. When \c TileSpill is
+    /// enabled at construction, local elements that have been set are moved
+    /// to a spill file when they are evicted from the resident set, and are
+    /// read back when they are accessed again. Remote elements are encoded
+    /// for transfer according to the \c TileCompression contract of the
+    /// requesting container.
     /// \note This object is derived from \c WorldObject , which means
     /// the order of construction of object must be the same on all nodes. This
     /// can easily be achieved by only constructing world objects in the main
     /// thread. DO NOT construct world objects within tasks where the order of
     /// execution is nondeterministic.
     template <typename T>
-    class DistributedStorage : public madness::WorldObject<DistributedStorage<T> > {
+    class DistributedStorage :
+        public madness::WorldObject<DistributedStorage<T> >, public SpillTarget
+    {
     public:
       typedef DistributedStorage<T> DistributedStorage_; ///< This object type
       typedef madness::WorldObject<DistributedStorage_> WorldObject_; ///< Base object type
@@ -60,6 +73,8 @@ namespace TiledArray {
       const size_type max_size_; ///< The maximum number of elements that can be stored by this container
       std::shared_ptr<pmap_interface> pmap_; ///< The process map that defines the element distribution
       mutable container_type data_; ///< The local data container
+      std::unique_ptr<SpillFile> spill_file_; ///< The spill file, null when spilling is disabled
+      TileCompression compression_; ///< The encoding of remote elements requested by this container
 
       // not allowed
       DistributedStorage(const DistributedStorage_&);
@@ -70,8 +85,61 @@ namespace TiledArray {
 
         // Return the local element.
         const_accessor acc;
-        data_.insert(acc, i);
-        return acc->second;
+        const bool inserted = data_.insert(acc, i);
+        future f = acc->second;
+        acc.release();
+
+        if(spill_file_) {
+          if(inserted && spill_file_->contains(i)) {
+            // Read the spilled element back
+            get_world().taskq.add(const_cast<DistributedStorage_*>(this),
+                & DistributedStorage_::fill, i, madness::TaskAttributes::hipri());
+          } else if(f.probe()) {
+            TileSpill::instance().insert(const_cast<DistributedStorage_*>(this),
+                WorldObject_::id(), i, tile_bytes(f.get(), 0));
+          }
+        }
+
+        return f;
+      }
+
+      /// Read a spilled element from the spill file
+
+      /// \param i The element index
+      void fill(const size_type i) {
+        future f;
+        {
+          const_accessor acc;
+          data_.find(acc, i);
+          f = acc->second;
+        }
+
+        const double start = madness::wall_time();
+        std::vector<unsigned char> buffer;
+        spill_file_->read(i, buffer);
+        value_type value;
+        madness::archive::VectorInputArchive ar(buffer);
+        ar & value;
+        TileSpill::instance().record_fill(buffer.size(),
+            madness::wall_time() - start);
+
+        f.set(std::move(value));
+        resident(i, f);
+      }
+
+      /// Add a local element to the resident set when it is set
+
+      /// \param i The element index
+      /// \param f The future of the element
+      void resident(const size_type i, const future& f) {
+        if(! spill_file_)
+          return;
+        if(f.probe()) {
+          TileSpill::instance().insert(this, WorldObject_::id(), i,
+              tile_bytes(f.get(), 0));
+        } else {
+          const_cast<future&>(f).register_callback(new Resident(*this, i, f));
+        }
       }
 
       void set_handler(const size_type i, const value_type& value) {
@@ -84,6 +152,7 @@ namespace TiledArray {
 #endif // NDEBUG
 
         f.set(value);
+        resident(i, f);
       }
 
       void get_handler(const size_type i, const typename future::remote_refT& ref) {
@@ -92,6 +161,18 @@ namespace TiledArray {
         remote_f.set(f);
       }
 
+      typedef typename TileCodec<value_type>::packed_type packed_type; ///< Encoded element type
+
+      void get_compressed_handler(const size_type i, const TileCompression& compression,
+          const typename Future<packed_type>::remote_refT& ref)
+      {
+        Future<packed_type> packed = get_world().taskq.add(
+            & TileCodec<value_type>::compress, get_local(i), compression,
+            madness::TaskAttributes::hipri());
+        Future<packed_type> remote_f(ref);
+        remote_f.set(packed);
+      }
+
       void set_remote(const size_type i, const value_type& value) {
         WorldObject_::task(owner(i), & DistributedStorage_::set_handler,
             i, value, madness::TaskAttributes::hipri());
@@ -117,6 +198,27 @@ namespace TiledArray {
         }
       }; // struct DelayedSet
 
+      struct Resident : public madness::CallbackInterface {
+      private:
+        DistributedStorage_& ds_; ///< A reference to the owning object
+        size_type index_; ///< The index of the element
+        future future_; ///< The future of the element
+
+      public:
+
+        Resident(DistributedStorage_& ds, size_type i, const future& f) :
+            ds_(ds), index_(i), future_(f)
+        { }
+
+        virtual ~Resident() { }
+
+        virtual void notify() {
+          TileSpill::instance().insert(&ds_, ds_.id(), index_,
+              tile_bytes(future_.get(), 0));
+          delete this;
+        }
+      }; // struct Resident
+
     public:
 
       /// Makes an initialized, empty container with default data distribution (no communication)
@@ -132,17 +234,35 @@ namespace TiledArray {
           const std::shared_ptr<pmap_interface>& pmap) :
         WorldObject_(world), max_size_(max_size),
         pmap_(pmap),
-        data_((max_size / world.size()) + 11)
+        data_((max_size / world.size()) + 11), spill_file_(), compression_()
       {
         // Check that the process map is appropriate for this storage object
         TA_ASSERT(pmap_);
         TA_ASSERT(pmap_->size() == max_size);
         TA_ASSERT(pmap_->rank() == pmap_interface::size_type(world.rank()));
         TA_ASSERT(pmap_->procs() == pmap_interface::size_type(world.size()));
+
+        TileSpill& spill = TileSpill::instance();
+        if(spill.enabled()) {
+          const madness::uniqueidT& id = WorldObject_::id();
+          spill_file_.reset(new SpillFile(spill.directory() + "/ta_spill." +
+              std::to_string(::getpid()) + "." + std::to_string(id.get_world_id()) +
+              "." + std::to_string(id.get_obj_id())));
+        }
+
         WorldObject_::process_pending();
       }
 
-      virtual ~DistributedStorage() { }
+      virtual ~DistributedStorage() {
+        // Remove the local elements of this container from the resident set
+        if(spill_file_)
+          TileSpill::instance().erase(this, WorldObject_::id());
+
+        // Remove the remote elements of this container from the cache. Tasks
+        // of other containers may use the cache concurrently, so its state is
+        // only accessed under the cache lock by erase.
+        TileCache::instance().erase(WorldObject_::id());
+      }
 
       using WorldObject_::get_world;
 
@@ -188,8 +308,29 @@ namespace TiledArray {
       /// \throw nothing
       size_type max_size() const { return max_size_; }
 
+      /// Transfer compression accessor
+
+      /// \return The encoding of the remote elements that are requested by
+      /// this process
+      const TileCompression& compression() const { return compression_; }
+
+      /// Set the transfer compression
+
+      /// Only remote elements requested by this process after the call are
+      /// affected. The contract must be the same on all processes, since
+      /// SUMMA broadcasts are encoded by the root and decoded by the other
+      /// members of the group; \c DistArray::compression sets it
+      /// collectively.
+      /// \param compression The encoding of the remote elements that are
+      /// requested by this process
+      void compression(const TileCompression& compression) {
+        compression_ = compression;
+      }
+
       /// Get local or remote element
 
+      /// Remote elements are taken from \c TileCache when it is enabled and
+      /// contains the element.
       /// \param i The element to get
       /// \return A future to element \c i
       /// \throw TiledArray::Exception If \c i is greater than or equal to \c max_size() .
@@ -198,10 +339,24 @@ namespace TiledArray {
         if(is_local(i)) {
           return get_local(i);
         } else {
-          // Send a request to the owner of i for the element.
           future result;
-          WorldObject_::task(owner(i), & DistributedStorage_::get_handler, i,
-              result.remote_ref(get_world()), madness::TaskAttributes::hipri());
+          TileCache& cache = TileCache::instance();
+          if(cache.enabled() && cache.find_or_insert(WorldObject_::id(), i, result))
+            return result;
+
+          if(compression_.enabled()) {
+            // Request the encoded element, and decode it when it arrives.
+            Future<packed_type> packed;
+            WorldObject_::task(owner(i), & DistributedStorage_::get_compressed_handler,
+                i, compression_, packed.remote_ref(get_world()),
+                madness::TaskAttributes::hipri());
+            result.set(get_world().taskq.add(& TileCodec<value_type>::decompress,
+                packed, madness::TaskAttributes::hipri()));
+          } else {
+            // Send a request to the owner of i for the element.
+            WorldObject_::task(owner(i), & DistributedStorage_::get_handler, i,
+                result.remote_ref(get_world()), madness::TaskAttributes::hipri());
+          }
 
           return result;
         }
@@ -246,6 +401,10 @@ namespace TiledArray {
 #endif // NDEBUG
             // Set the future
             existing_f.set(f);
+            resident(i, existing_f);
+          } else {
+            acc.release();
+            resident(i, f);
           }
         } else {
           if(f.probe()) {
@@ -257,6 +416,48 @@ namespace TiledArray {
         }
       }
 
+      /// Start reading a spilled local element
+
+      /// If element \c i is local and has been spilled to disk, a task is
+      /// spawned to read it back, so it is resident when it is needed.
+      /// Otherwise this function does nothing.
+      /// \param i The element to prefetch
+      void prefetch(size_type i) const {
+        TA_ASSERT(i < max_size_);
+        if(spill_file_ && is_local(i) && spill_file_->contains(i))
+          get_local(i);
+      }
+
+      /// Move a local element to the spill file
+
+      /// The element is written to the spill file, unless the file already
+      /// holds the same data, and removed from the container. Elements that
+      /// have not been set, or that are shared with other objects, are not
+      /// moved.
+      /// \param i The element to move
+      /// \return \c false if the element must stay in the container
+      virtual bool spill(const size_type i) {
+        TA_ASSERT(spill_file_);
+        accessor acc;
+        if(! data_.find(acc, i))
+          return true;
+        future f = acc->second;
+        // Shared tiles would not be released, and would be duplicated when
+        // they are read back
+        if(! f.probe() || is_shared_tile(f.get(), 0))
+          return false;
+
+        const double start = madness::wall_time();
+        std::vector<unsigned char> buffer;
+        madness::archive::VectorOutputArchive ar(buffer);
+        ar & f.get();
+        const size_type bytes = spill_file_->write(i, buffer);
+        data_.erase(acc);
+        TileSpill::instance().record_spill(bytes, madness::wall_time() - start);
+
+        return true;
+      }
+
     }; // class DistributedStorage
 
   }  // namespace detail
@@ -194,11 +194,28 @@ namespace TiledArray {
         return op_type(op_base_type(), perm);
       }
 
+      /// Element operation factory function
+
+      /// \return The element-wise operation of this expression
+      static TiledArray::detail::ElementAdd make_element_op() {
+        return TiledArray::detail::ElementAdd();
+      }
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
       const char* make_tag() const { return "[+] "; }
 
+      /// Construct the distributed evaluator for this expression
+
+      /// Contractions in the right-hand argument are accumulated directly
+      /// into the tiles of the left-hand argument when possible and
+      /// \c fused_sum_contractions() is selected.
+      /// \return The distributed evaluator that will evaluate this expression
+      dist_eval_type make_dist_eval() const {
+        return BinaryEngine_::make_sum_dist_eval(false);
+      }
+
     }; // class AddEngine
 
 
@@ -303,6 +320,13 @@ namespace TiledArray {
       /// \return The scaling factor
       scalar_type factor() { return factor_; }
 
+      /// Element operation factory function
+
+      /// \return The element-wise operation of this expression
+      TiledArray::detail::ElementScalAdd<scalar_type> make_element_op() const {
+        return TiledArray::detail::ElementScalAdd<scalar_type>{factor_};
+      }
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
@@ -312,6 +336,13 @@ namespace TiledArray {
         return ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return "[+] [" + exact_factor(factor_) + "] ";
+      }
+
     }; // class ScalAddEngine
 
   }  // namespace expressions
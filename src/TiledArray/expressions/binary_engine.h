@@ -28,6 +28,10 @@
 
 #include <TiledArray/expressions/expr_engine.h>
 #include <TiledArray/dist_eval/binary_eval.h>
+#include <TiledArray/tile_op/fused_reduction.h>
+#include <cstdlib>
+#include <sstream>
+#include <string>
 
 namespace TiledArray {
   namespace expressions {
@@ -35,6 +39,58 @@ namespace TiledArray {
     // Forward declarations
     template <typename> class BinaryExpr;
     template <typename> class BinaryEngine;
+    template <typename> class LeafEngine;
+    template <typename> class ContEngine;
+
+    /// Selection of accumulated sums of contractions
+
+    /// Sums and differences whose right-hand argument is a contraction are
+    /// evaluated term by term unless this value is \c true , in which case
+    /// the contraction is accumulated into the tiles of the left-hand
+    /// argument (see \c is_accumulable_sum ). It is \c false unless the
+    /// \c TA_FUSED_SUM_CONTRACTIONS environment variable is a non-zero
+    /// integer, and may be changed at runtime by assigning to the returned
+    /// value. All processes must use the same value.
+    /// \return A reference to the selection
+    inline bool& fused_sum_contractions() {
+      static bool enabled = [] () {
+        const char* const value = getenv("TA_FUSED_SUM_CONTRACTIONS");
+        if(! value)
+          return false;
+        std::stringstream ss(value);
+        long long setting = 0ll;
+        std::string rest;
+        return (ss >> setting) && !(ss >> rest) && (setting != 0ll);
+      }();
+      return enabled;
+    }
+
+    /// Sum accumulation trait
+
+    /// \c value is \c true when the right-hand argument of the binary
+    /// expression engine \c Engine is a contraction that may be evaluated
+    /// directly into the tiles of the left-hand argument, i.e. the left-hand
+    /// argument is not a leaf and its tiles are consumable, and the arguments
+    /// and result have the same tile type.
+    /// \tparam Engine The binary expression engine type
+    template <typename Engine, typename Enabler = void>
+    struct is_accumulable_sum : public std::false_type { };
+
+    template <typename Engine>
+    struct is_accumulable_sum<Engine, typename std::enable_if<
+        std::is_base_of<ContEngine<typename EngineTrait<Engine>::right_type>,
+            typename EngineTrait<Engine>::right_type>::value>::type> :
+        public std::integral_constant<bool,
+            (! std::is_base_of<LeafEngine<typename EngineTrait<Engine>::left_type>,
+                typename EngineTrait<Engine>::left_type>::value) &&
+            EngineTrait<typename EngineTrait<Engine>::left_type>::consumable &&
+            std::is_same<typename EngineTrait<typename EngineTrait<Engine>::left_type>::value_type,
+                typename EngineTrait<Engine>::value_type>::value &&
+            std::is_same<typename EngineTrait<typename EngineTrait<Engine>::right_type>::value_type,
+                typename EngineTrait<Engine>::value_type>::value &&
+            TiledArray::detail::is_numeric<typename EngineTrait<
+                typename EngineTrait<Engine>::right_type>::scalar_type>::value>
+    { };
 
     template <typename Derived>
     class BinaryEngine : public ExprEngine<Derived> {
@@ -215,6 +271,72 @@ namespace TiledArray {
         return dist_eval_type(pimpl);
       }
 
+      /// Reduce the local tiles of this expression without evaluating them
+
+      /// The tile reduction is applied in the same loop over the argument
+      /// tiles as the element-wise operation of this expression, which is
+      /// constructed by \c Derived::make_element_op() , so the result tiles
+      /// are never stored. The permutation of the result is ignored, since it
+      /// does not change the reduction.
+      /// \tparam Op The tile reduction type
+      /// \param op The tile reduction
+      /// \return The reduction of the local tiles of this expression
+      template <typename Op>
+      Future<typename Op::result_type> fused_reduce(const Op& op) const {
+        typedef TiledArray::detail::FusedBinaryReduction<Op,
+            decltype(ExprEngine_::derived().make_element_op())> kernel_type;
+
+        // Construct left and right distributed evaluators
+        const typename left_type::dist_eval_type left = left_.make_dist_eval();
+        const typename right_type::dist_eval_type right = right_.make_dist_eval();
+
+        return TiledArray::detail::fused_reduce(op,
+            kernel_type(op, ExprEngine_::derived().make_element_op()), left,
+            right, shape_);
+      }
+
+      /// Expression structure key
+
+      /// \return A key that identifies the structure of this expression
+      std::string make_key() const {
+        return ExprEngine_::make_key() + " (" + left_.make_key() + ", "
+            + right_.make_key() + ")";
+      }
+
+    protected:
+
+      /// Construct the distributed evaluator for the sum of the arguments
+
+      /// If \c fused_sum_contractions() is selected, \c is_accumulable_sum is
+      /// \c true for this engine, the result is not permuted, and the
+      /// right-hand contraction is accumulable, the contraction is evaluated
+      /// directly into the tiles of the left-hand argument. Chained sums of contractions, e.g.
+      /// <tt>a("i,j") * b("j,k") + c("i,l") * d("l,k")</tt>, are accumulated
+      /// into the same result tiles without evaluating separate contraction
+      /// results. Otherwise, the sum is evaluated with \c make_dist_eval().
+      /// \param negate Subtract the right-hand argument from the left-hand
+      /// argument
+      /// \return The distributed evaluator that will evaluate this expression
+      dist_eval_type make_sum_dist_eval(const bool negate) const {
+        return make_sum_dist_eval(negate, is_accumulable_sum<Derived>());
+      }
+
+    private:
+
+      dist_eval_type make_sum_dist_eval(const bool, std::false_type) const {
+        return make_dist_eval();
+      }
+
+      dist_eval_type make_sum_dist_eval(const bool negate, std::true_type) const {
+        if((! fused_sum_contractions()) || perm_ || (! right_.accumulable()))
+          return make_dist_eval();
+
+        return right_.make_accum_dist_eval(left_.make_dist_eval(), negate,
+            shape_);
+      }
+
+    public:
+
       /// Expression print
 
       /// \param os The output stream
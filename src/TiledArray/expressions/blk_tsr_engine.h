@@ -569,6 +569,13 @@ namespace TiledArray {
         return BlkTsrEngineBase_::make_tag() + ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return BlkTsrEngineBase_::make_tag() + "[block] [" + exact_factor(factor_) + "] ";
+      }
+
     }; // class ScalBlkTsrEngine
 
 
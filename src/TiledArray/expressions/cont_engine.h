@@ -27,9 +27,12 @@
 #define TILEDARRAY_EXPRESSIONS_CONT_ENGINE_H__INCLUDED
 
 #include <TiledArray/expressions/binary_engine.h>
+#include <TiledArray/expressions/expr_cache.h>
 #include <TiledArray/dist_eval/contraction_eval.h>
+#include <TiledArray/dist_eval/layered_contraction_eval.h>
 #include <TiledArray/tile_op/contract_reduce.h>
 #include <TiledArray/proc_grid.h>
+#include <TiledArray/policies/sparse_policy.h>
 
 namespace TiledArray {
   namespace expressions {
@@ -104,6 +107,8 @@ namespace TiledArray {
     protected:
 
       scalar_type factor_; ///< Contraction scaling factor
+      TiledArray::math::NestedProduct nested_; ///< The product of the inner
+          ///< tensors of tensor-of-tensor tiles
 
     private:
 
@@ -114,6 +119,8 @@ namespace TiledArray {
       op_type op_; ///< Tile operation
       TiledArray::detail::ProcGrid proc_grid_; ///< Process grid for the contraction
       size_type K_; ///< Inner dimension size
+      bool parallel_gemm_; ///< Use the multithreaded GEMM for the tile
+          ///< contractions
 
 
       static unsigned int
@@ -126,6 +133,107 @@ namespace TiledArray {
         return i;
       }
 
+    protected:
+
+      /// Initialize the inner variable lists of tensor-of-tensor arguments
+
+      /// The inner variables of the arguments are appended to the argument
+      /// variable lists. The inner variables of the result are taken from
+      /// \c target_vars , when given; otherwise they are the inner variables
+      /// of the arguments when these are equal (Hadamard product), or the
+      /// free inner variables of the left- and right-hand arguments
+      /// (contraction).
+      /// \param target_vars The target variable list for this expression, or
+      /// \c nullptr if there is no target
+      void init_inner_vars(const VariableList* target_vars) {
+        const VariableList left_inner = left_.vars().inner();
+        const VariableList right_inner = right_.vars().inner();
+        const bool target_inner = target_vars && (target_vars->inner_dim() != 0u);
+        if((left_inner.dim() == 0u) && (right_inner.dim() == 0u) && ! target_inner)
+          return;
+
+        left_vars_ = VariableList(left_vars_, left_inner);
+        right_vars_ = VariableList(right_vars_, right_inner);
+        if(target_inner) {
+          vars_ = VariableList(vars_, target_vars->inner());
+        } else if(left_inner == right_inner) {
+          vars_ = VariableList(vars_, left_inner);
+        } else {
+          std::vector<std::string> inner;
+          for(const auto& var : left_inner)
+            if(find(right_inner, var, 0u, right_inner.dim()) == right_inner.dim())
+              inner.push_back(var);
+          for(const auto& var : right_inner)
+            if(find(left_inner, var, 0u, left_inner.dim()) == left_inner.dim())
+              inner.push_back(var);
+          vars_ = VariableList(vars_, VariableList(inner.begin(), inner.end()));
+        }
+      }
+
+      /// Construct the product of the inner tensors of tensor-of-tensor tiles
+
+      /// The inner tensors are multiplied coefficient-wise when their
+      /// variable lists are equal, e.g. \c ("a,b")*("a,b")->("a,b") .
+      /// Otherwise they are contracted, which requires that the result
+      /// variables are the free left-hand variables followed by the free
+      /// right-hand variables, and that the contracted variables are
+      /// contiguous and in the same order in both arguments, e.g.
+      /// \c ("a,c")*("c,b")->("a,b") or \c ("c,a")*("b,c")->("a,b") .
+      /// \param left The inner variables of the left-hand argument
+      /// \param right The inner variables of the right-hand argument
+      /// \param result The inner variables of the result
+      /// \return The product of the inner tensors
+      /// \throw TiledArray::Exception When the inner variables cannot be
+      /// evaluated without permuting the inner tensors.
+      static TiledArray::math::NestedProduct
+      make_nested_product(const VariableList& left, const VariableList& right,
+          const VariableList& result)
+      {
+        if((left == right) && (left == result))
+          return TiledArray::math::NestedProduct();
+
+        // Partition the argument variables into free and contracted variables
+        std::vector<std::string> left_free, right_free, left_cont, right_cont;
+        for(const auto& var : left) {
+          if(find(right, var, 0u, right.dim()) == right.dim())
+            left_free.push_back(var);
+          else
+            left_cont.push_back(var);
+        }
+        for(const auto& var : right) {
+          if(find(left, var, 0u, left.dim()) == left.dim())
+            right_free.push_back(var);
+          else
+            right_cont.push_back(var);
+        }
+
+        // Check that the arguments are in matrix form
+        const bool left_no_trans = std::equal(left_free.begin(), left_free.end(),
+            left.begin());
+        const bool left_trans = std::equal(left_cont.begin(), left_cont.end(),
+            left.begin());
+        const bool right_no_trans = std::equal(right_cont.begin(),
+            right_cont.end(), right.begin());
+        const bool right_trans = std::equal(right_free.begin(),
+            right_free.end(), right.begin());
+
+        std::vector<std::string> result_vars(left_free);
+        result_vars.insert(result_vars.end(), right_free.begin(), right_free.end());
+
+        if((left.dim() == 0u) || (right.dim() == 0u) || (left_cont != right_cont)
+            || (result_vars != result.data()) || ! (left_no_trans || left_trans)
+            || ! (right_no_trans || right_trans))
+          TA_EXCEPTION("The inner variables of the arguments and result of a "
+              "tensor-of-tensor product must define a Hadamard product or a "
+              "contraction in matrix form; permutation of inner tensors is not "
+              "supported.");
+
+        return TiledArray::math::NestedProduct(TiledArray::math::GemmHelper(
+            (left_no_trans ? madness::cblas::NoTrans : madness::cblas::Trans),
+            (right_no_trans ? madness::cblas::NoTrans : madness::cblas::Trans),
+            result.dim(), left.dim(), right.dim()));
+      }
+
     public:
 
       /// Constructor
@@ -135,9 +243,9 @@ namespace TiledArray {
       /// \param expr The parent expression
       template <typename L, typename R>
       ContEngine(const MultExpr<L, R>& expr) :
-        BinaryEngine_(expr), factor_(1), left_vars_(), right_vars_(),
+        BinaryEngine_(expr), factor_(1), nested_(), left_vars_(), right_vars_(),
         left_op_(permute_to_no_trans), right_op_(permute_to_no_trans), op_(),
-        proc_grid_(), K_(1u)
+        proc_grid_(), K_(1u), parallel_gemm_(expr.parallel_gemm())
       { }
 
       /// Constructor
@@ -148,9 +256,10 @@ namespace TiledArray {
       /// \param expr The parent expression
       template <typename L, typename R, typename S>
       ContEngine(const ScalMultExpr<L, R, S>& expr) :
-        BinaryEngine_(expr), factor_(expr.factor()), left_vars_(), right_vars_(),
+        BinaryEngine_(expr), factor_(expr.factor()), nested_(), left_vars_(),
+        right_vars_(),
         left_op_(permute_to_no_trans), right_op_(permute_to_no_trans), op_(),
-        proc_grid_(), K_(1u)
+        proc_grid_(), K_(1u), parallel_gemm_(expr.parallel_gemm())
       { }
 
       // Pull base class functions into this class.
@@ -165,6 +274,8 @@ namespace TiledArray {
       /// result of this expression will be permuted to match \c target_vars.
       /// \param target_vars The target variable list for this expression
       void perm_vars(const VariableList& target_vars) {
+        init_inner_vars(&target_vars);
+
         // Only permute if the arguments can be permuted
         if((left_op_ == permute_to_no_trans) || (right_op_ == permute_to_no_trans)) {
 
@@ -271,6 +382,7 @@ namespace TiledArray {
             right_vars.push_back(var);
             result_vars.push_back(var);
           }
+          init_inner_vars(nullptr);
           return; // Quick exit
         }
 
@@ -328,6 +440,8 @@ namespace TiledArray {
           }
         }
 
+        init_inner_vars(nullptr);
+
         // Here we set the type of permutation that will be applied to the
         // argument tensors. If an argument is in matrix form, permutation of
         // the tiles is disabled.
@@ -358,6 +472,14 @@ namespace TiledArray {
       /// for the result tensor as well as the tile operation.
       /// \param target_vars The target variable list for the result tensor
       void init_struct(const VariableList& target_vars) {
+        // Permuted arguments are contracted without permuting their tiles. The
+        // arguments permute their tiled range and shape, and the tile
+        // permutations are applied by the contraction kernel.
+        if(left_op_ == permute_to_no_trans)
+          left_.permute_tiles(false);
+        if(right_op_ == permute_to_no_trans)
+          right_.permute_tiles(false);
+
         // Initialize children
         left_.init_struct(left_vars_);
         right_.init_struct(right_vars_);
@@ -365,26 +487,35 @@ namespace TiledArray {
         // Initialize the tile operation in this function because it is used to
         // evaluate the tiled range and shape.
 
+        nested_ = make_nested_product(left_.vars().inner(),
+            right_.vars().inner(), vars_.inner());
+
         const madness::cblas::CBLAS_TRANSPOSE left_op =
             (left_op_ == trans ? madness::cblas::Trans : madness::cblas::NoTrans);
         const madness::cblas::CBLAS_TRANSPOSE right_op =
             (right_op_ == trans ? madness::cblas::Trans : madness::cblas::NoTrans);
+        const Permutation left_perm =
+            (left_op_ == permute_to_no_trans ? left_.perm() : Permutation());
+        const Permutation right_perm =
+            (right_op_ == permute_to_no_trans ? right_.perm() : Permutation());
 
 
         if(target_vars != vars_) {
           // Initialize permuted structure
           perm_ = ExprEngine_::make_perm(target_vars);
           op_ = op_type(left_op, right_op, factor_, vars_.dim(), left_vars_.dim(),
-              right_vars_.dim(), (permute_tiles_ ? perm_ : Permutation()));
+              right_vars_.dim(), (permute_tiles_ ? perm_ : Permutation()),
+              left_perm, right_perm, nested_);
           trange_ = ContEngine_::make_trange(perm_);
           shape_ = ContEngine_::make_shape(perm_);
         } else {
           // Initialize non-permuted structure
           op_ = op_type(left_op, right_op, factor_, vars_.dim(), left_vars_.dim(),
-              right_vars_.dim());
+              right_vars_.dim(), Permutation(), left_perm, right_perm, nested_);
           trange_ = ContEngine_::make_trange();
           shape_ = ContEngine_::make_shape();
         }
+        op_.parallel_gemm(parallel_gemm_);
 
         if(ExprEngine_::override_ptr_ && ExprEngine_::override_ptr_->shape){
             shape_ = shape_.mask(*ExprEngine_::override_ptr_->shape);
@@ -414,21 +545,27 @@ namespace TiledArray {
             right_.trange().elements_range().extent_data();
 
         // Compute the fused sizes of the contraction
-        size_type M = 1ul, m = 1ul, N = 1ul, n = 1ul;
+        size_type M = 1ul, m = 1ul, N = 1ul, n = 1ul, k = 1ul;
         unsigned int i = 0u;
         for(; i < left_outer_rank; ++i) {
           M *= left_tiles_size[i];
           m *= left_element_size[i];
         }
-        for(; i < left_rank; ++i)
+        for(; i < left_rank; ++i) {
           K_ *= left_tiles_size[i];
+          k *= left_element_size[i];
+        }
         for(i = inner_rank; i < right_rank; ++i) {
           N *= right_tiles_size[i];
           n *= right_element_size[i];
         }
 
-        // Construct the process grid.
-        proc_grid_ = TiledArray::detail::ProcGrid(*world, M, N, m, n);
+        // Construct the process grid, which is divided into layers over the
+        // inner dimension when TA_CONTRACTION_LAYERS requests it.
+        const TiledArray::detail::ProcGrid::size_type layers =
+            TiledArray::detail::contraction_layers(world->size(), M, N, K_, m,
+            n, k, sizeof(typename TiledArray::detail::numeric_type<value_type>::type));
+        proc_grid_ = TiledArray::detail::ProcGrid(*world, M, N, m, n, layers);
 
         // Initialize children
         left_.init_distribution(world, proc_grid_.make_row_phase_pmap(K_));
@@ -436,7 +573,7 @@ namespace TiledArray {
 
         // Initialize the process map in not already defined
         if(! pmap)
-          pmap = proc_grid_.make_pmap();
+          pmap = make_result_pmap(*world, shape_);
         ExprEngine_::init_distribution(world, pmap);
       }
 
@@ -524,14 +661,125 @@ namespace TiledArray {
                                   perm);
       }
 
+      /// Construct the distributed evaluator for this expression
+
+      /// If an expression cache is active, the result of this contraction is
+      /// taken from, or stored in, the cache.
+      /// \return The distributed evaluator that will evaluate this expression
       dist_eval_type make_dist_eval() const {
-        // Define the impl type
+        ExprCache* const cache = ExprCache::active();
+        if(cache && ! ExprEngine_::override_ptr_)
+          return cache->make_dist_eval(ExprEngine_::derived(),
+              [this] () { return make_summa_dist_eval(); });
+
+        return make_summa_dist_eval();
+      }
+
+      /// Check that this contraction can be added to another result in place
+
+      /// The contraction can be evaluated directly into the tiles of another
+      /// result when the result tiles are not permuted, the process grid has
+      /// a single layer, and the result is not cached or overridden.
+      /// \return \c true if \c make_accum_dist_eval() may be used
+      bool accumulable() const {
+        return (! perm_) && (proc_grid_.layers() == 1u) &&
+            (! ExprEngine_::override_ptr_) && (! ExprCache::active());
+      }
+
+      /// Construct a distributed evaluator that adds this contraction to a result
+
+      /// The tiles of \c accum are used as the initial values of the
+      /// contraction reductions, so the contraction is accumulated directly
+      /// into them without storing the contraction result.
+      /// \param accum The distributed evaluator of the result, which must
+      /// have the same tiled range and process map as this expression, and
+      /// tiles that may be modified in place
+      /// \param negate Subtract the contraction from \c accum
+      /// \param shape The shape of the sum. Result tiles that are zero in the
+      /// shape of this contraction are copied from \c accum .
+      /// \return The distributed evaluator of the sum
+      dist_eval_type make_accum_dist_eval(const dist_eval_type& accum,
+          const bool negate, const shape_type& shape) const
+      {
+        TA_ASSERT(accumulable());
+
+        typename left_type::dist_eval_type left = left_.make_dist_eval();
+        typename right_type::dist_eval_type right = right_.make_dist_eval();
+
+        op_type op = op_;
+        if(negate) {
+          op = op_type(op_.gemm_helper().left_op(), op_.gemm_helper().right_op(),
+              -op_.factor(), op_.result_rank(), op_.left_rank(),
+              op_.right_rank(), op_.perm(), op_.left_perm(), op_.right_perm(),
+              op_.nested_product());
+          op.parallel_gemm(parallel_gemm_);
+        }
+
         typedef TiledArray::detail::Summa<typename left_type::dist_eval_type,
             typename right_type::dist_eval_type, op_type, typename Derived::policy> impl_type;
 
+        std::shared_ptr<impl_type> pimpl =
+            std::make_shared<impl_type>(left, right, *world_, trange_, shape,
+                                        pmap_, perm_, op, K_, proc_grid_,
+                                        std::make_shared<dist_eval_type>(accum),
+                                        &shape_);
+
+        return dist_eval_type(pimpl);
+      }
+
+    private:
+
+      /// Construct the process map of the result
+
+      /// \return The process map of the process grid
+      template <typename Shape>
+      std::shared_ptr<pmap_interface>
+      make_result_pmap(World&, const Shape&) const {
+        return proc_grid_.make_pmap();
+      }
+
+      /// Construct the process map of a sparse result
+
+      /// \param world The world where the result will be distributed
+      /// \param shape The shape of the result
+      /// \return A process map that balances the estimated cost of the
+      /// result tiles when \c SparsePolicy::balanced_contractions() is
+      /// selected and the result is not permuted and uses a 2D process grid,
+      /// otherwise the process map of the process grid
+      std::shared_ptr<pmap_interface>
+      make_result_pmap(World& world, const SparsePolicy::shape_type& shape) const {
+        if(perm_ || (! SparsePolicy::balanced_contractions()) ||
+            (world.size() == 1) || (proc_grid_.layers() > 1u))
+          return proc_grid_.make_pmap();
+
+        return proc_grid_.make_pmap(SparsePolicy::contraction_costs(
+            left_.trange(), left_.shape(), right_.trange(), right_.shape(),
+            trange_, shape));
+      }
+
+      /// Construct the SUMMA distributed evaluator for this expression
+
+      /// \return The distributed evaluator that will evaluate this expression
+      dist_eval_type make_summa_dist_eval() const {
         typename left_type::dist_eval_type left = left_.make_dist_eval();
         typename right_type::dist_eval_type right = right_.make_dist_eval();
 
+        if(proc_grid_.layers() > 1u) {
+          // Define the impl type for a layered process grid
+          typedef TiledArray::detail::LayeredSumma<typename left_type::dist_eval_type,
+              typename right_type::dist_eval_type, op_type, typename Derived::policy> impl_type;
+
+          std::shared_ptr<impl_type> pimpl =
+              std::make_shared<impl_type>(left, right, *world_, trange_, shape_,
+                                          pmap_, perm_, op_, K_, proc_grid_);
+
+          return dist_eval_type(pimpl);
+        }
+
+        // Define the impl type
+        typedef TiledArray::detail::Summa<typename left_type::dist_eval_type,
+            typename right_type::dist_eval_type, op_type, typename Derived::policy> impl_type;
+
         std::shared_ptr<impl_type> pimpl =
             std::make_shared<impl_type>(left, right, *world_, trange_, shape_,
                                         pmap_, perm_, op_, K_, proc_grid_);
@@ -539,6 +787,8 @@ namespace TiledArray {
         return dist_eval_type(pimpl);
       }
 
+    public:
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
@@ -550,6 +800,13 @@ namespace TiledArray {
         return ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return (factor_ != scalar_type(1) ? "[*][" + exact_factor(factor_) + "]" : std::string("[*]"));
+      }
+
 
       /// Expression print
 
@@ -27,13 +27,16 @@
 #define TILEDARRAY_EXPRESSIONS_EXPR_H__INCLUDED
 
 #include "expr_engine.h"
+#include "../math/parallel_gemm.h"
 #include "../reduce_task.h"
+#include "../shape.h"
 #include "../tile_interface/cast.h"
 #include "../tile_interface/scale.h"
 #include "../tile_op/shift.h"
 #include "../tile_op/unary_wrapper.h"
 #include "../tile_op/unary_reduction.h"
 #include "../tile_op/binary_reduction.h"
+#include "../tile_op/fused_reduction.h"
 #include "../tile_op/reduce_wrapper.h"
 
 namespace TiledArray {
@@ -73,6 +76,25 @@ namespace TiledArray {
        static constexpr const bool value = std::is_same<std::true_type, decltype(__test<E>(0))>::value;
     };
 
+    /// Fused reduction trait
+
+    /// \c value is \c true when the tile reduction \c Op of the result of
+    /// \c Engine can be fused into the element-wise operation of the
+    /// expression, i.e. \c Engine provides \c make_element_op() , \c Op has
+    /// an element-wise kernel, and the result tiles are tensors.
+    /// \tparam Engine The expression engine type
+    /// \tparam Op The tile reduction type
+    template <typename Engine, typename Op, typename Enabler = void>
+    struct is_fused_reduction : public std::false_type { };
+
+    template <typename Engine, typename Op>
+    struct is_fused_reduction<Engine, Op, TiledArray::detail::void_t<
+        decltype(std::declval<const Engine&>().make_element_op())> > :
+        public std::integral_constant<bool,
+            TiledArray::detail::ElementReduction<Op>::fusable &&
+            TiledArray::detail::is_tensor<typename EngineTrait<Engine>::eval_type>::value>
+    { };
+
 
     /// Base class for expression evaluation
 
@@ -98,6 +120,9 @@ namespace TiledArray {
       typedef EngineParamOverride<engine_type>
           override_type; ///< Expression engine parameters
       std::shared_ptr<override_type> override_ptr_;
+      bool truncate_ = false; ///< Truncate the result shape in \c eval_to
+      bool parallel_gemm_ = math::ParallelGemmParams::enabled();
+          ///< Use the multithreaded GEMM for the tile contractions
 
     public:
       /// \param shape the shape to use for the result
@@ -136,6 +161,40 @@ namespace TiledArray {
         return derived();
       }
 
+      /// Truncate the shape of the result of this expression
+
+      /// When this expression is assigned to a sparse array, the norm of each
+      /// result tile is computed as soon as the tile has been evaluated, and
+      /// tiles with negligible norm are dropped before they are stored. This
+      /// is equivalent to calling \c truncate on the result, but it avoids a
+      /// second pass over the result tiles. It has no effect on dense arrays
+      /// or assignments to blocks of arrays.
+      /// \param truncate If \c true , truncate the result [default = true]
+      Expr<Derived>& set_truncate(const bool truncate = true) {
+        truncate_ = truncate;
+        return derived();
+      }
+
+      /// Select the multithreaded GEMM for the contraction of this expression
+
+      /// Tile contractions are evaluated in tasks that already keep all cores
+      /// busy, so by default (see \c math::ParallelGemmParams::enabled() )
+      /// each tile GEMM runs on one thread. Contractions with a few large
+      /// tiles may select \c math::parallel_gemm with this function; it
+      /// applies to the top-level contraction of this expression only.
+      /// \param parallel If \c true , use the multithreaded GEMM
+      /// [default = true]
+      Expr<Derived>& set_parallel_gemm(const bool parallel = true) {
+        parallel_gemm_ = parallel;
+        return derived();
+      }
+
+      /// Multithreaded GEMM selection accessor
+
+      /// \return \c true if the contraction of this expression uses the
+      /// multithreaded GEMM
+      bool parallel_gemm() const { return parallel_gemm_; }
+
     private:
 
       /// Task function used to evaluate a lazy tile and apply an op
@@ -259,6 +318,127 @@ namespace TiledArray {
         array.set(index, array.world().taskq.add(eval_tile_fn_ptr, tile, op));
       }
 
+      /// Convert a lazy tile to a result tile
+
+      /// \tparam A The array type
+      /// \tparam T The lazy tile type
+      /// \param world The world where the tile is evaluated
+      /// \param tile The lazy tile
+      /// \return A future to the result tile
+      template <typename A, typename T,
+          typename std::enable_if<
+              ! std::is_same<typename A::value_type, T>::value &&
+              is_lazy_tile<T>::value
+          >::type* = nullptr>
+      static Future<typename A::value_type>
+      result_tile(World& world, const Future<T>& tile) {
+        return world.taskq.add(TiledArray::Cast<typename A::value_type, T>(), tile);
+      }
+
+      /// Convert a tile to a result tile
+
+      /// \tparam A The array type
+      /// \tparam T The tile type
+      /// \param tile The tile
+      /// \return \c tile
+      template <typename A, typename T,
+          typename std::enable_if<
+              std::is_same<typename A::value_type, T>::value
+          >::type* = nullptr>
+      static Future<typename A::value_type>
+      result_tile(World&, const Future<T>& tile) {
+        return tile;
+      }
+
+      /// Construct the result array of a distributed evaluator
+
+      /// The tiles of \c dist_eval are moved into the result array. There is
+      /// no communication in this step.
+      /// \tparam A The array type
+      /// \tparam DistEval The distributed evaluator type
+      /// \param dist_eval The distributed evaluator
+      /// \return The result array
+      template <typename A, typename DistEval>
+      A make_result(DistEval& dist_eval) const {
+        A result(dist_eval.world(), dist_eval.trange(),
+            dist_eval.shape(), dist_eval.pmap());
+        for(const auto index : *dist_eval.pmap()) {
+          if(! dist_eval.is_zero(index))
+            set_tile(result, index, dist_eval.get(index));
+        }
+
+        return result;
+      }
+
+      /// Construct the truncated result array of a distributed evaluator
+
+      /// Dense arrays are never truncated.
+      /// \tparam A The array type
+      /// \tparam DistEval The distributed evaluator type
+      /// \param dist_eval The distributed evaluator
+      /// \return The result array
+      template <typename A, typename DistEval,
+          typename std::enable_if<
+              is_dense<typename A::shape_type>::value
+          >::type* = nullptr>
+      A make_truncated_result(DistEval& dist_eval) const {
+        return make_result<A>(dist_eval);
+      }
+
+      /// Construct the truncated result array of a distributed evaluator
+
+      /// The norm of each local result tile is computed by a task that runs
+      /// as soon as the tile has been evaluated. The result shape is built
+      /// from these norms, so tiles with negligible norm are never stored in
+      /// the result array.
+      /// \tparam A The array type
+      /// \tparam DistEval The distributed evaluator type
+      /// \param dist_eval The distributed evaluator
+      /// \return The result array
+      template <typename A, typename DistEval,
+          typename std::enable_if<
+              ! is_dense<typename A::shape_type>::value
+          >::type* = nullptr>
+      A make_truncated_result(DistEval& dist_eval) const {
+        typedef typename A::value_type value_type;
+        typedef typename A::shape_type shape_type;
+        typedef typename shape_type::value_type norm_type;
+        typedef typename A::size_type size_type;
+
+        World& world = dist_eval.world();
+        Tensor<norm_type> tile_norms(dist_eval.trange().tiles_range(), norm_type(0));
+
+        // Compute the norms of the local tiles
+        std::vector<std::pair<size_type, Future<value_type> > > tiles;
+        madness::AtomicInt counter;
+        counter = 0;
+        for(const auto index : *dist_eval.pmap()) {
+          if(dist_eval.is_zero(index))
+            continue;
+          norm_type* const norm = tile_norms.data() + index;
+          tiles.emplace_back(index, world.taskq.add(
+              [norm,&counter] (const value_type& tile) -> value_type {
+                *norm = TiledArray::norm(tile);
+                ++counter;
+                return tile;
+              }, result_tile<A>(world, dist_eval.get(index))));
+        }
+        const int n = tiles.size();
+        world.await([&counter,n] () { return counter == n; });
+
+        // Construct the result array with the tight shape, and drop the
+        // tiles that are zero in it.
+        A result(world, dist_eval.trange(), shape_type(world, tile_norms,
+            dist_eval.trange(), dist_eval.shape().is_compressed()),
+            dist_eval.pmap());
+        for(const auto& tile : tiles) {
+          if(! result.is_zero(tile.first))
+            result.set(tile.first, tile.second);
+        }
+
+        return result;
+      }
+
      public:
 
       // Compiler generated functions
@@ -279,7 +459,11 @@ namespace TiledArray {
 
       /// This expression is evaluated in parallel in distributed environments,
       /// where the content of \c tsr will be replaced by the results of the
-      /// evaluated tensor expression.
+      /// evaluated tensor expression. A contraction of single precision arrays
+      /// that is assigned to a double precision array is accumulated in
+      /// double precision (see \c result_engine ). If truncation was requested
+      /// with \c set_truncate , the shape of a sparse result is computed from
+      /// the norms of the result tiles.
       /// \tparam A The array type
       /// \tparam Alias Tile alias flag
       /// \param tsr The tensor to be assigned
@@ -287,6 +471,8 @@ namespace TiledArray {
       void eval_to(TsrExpr<A, Alias>& tsr) const {
         static_assert(! is_lazy_tile<typename A::value_type>::value,
             "Assignment to an array of lazy tiles is not supported.");
+        typedef typename result_engine<engine_type,
+            typename A::value_type>::type result_engine_type;
 
         // Get the target world
         // 1. result's world is assigned, use it
@@ -308,23 +494,17 @@ namespace TiledArray {
         VariableList target_vars(tsr.vars());
 
         // Construct the expression engine
-        engine_type engine(derived());
+        result_engine_type engine(derived());
         engine.init(world, pmap, target_vars);
 
         // Create the distributed evaluator from this expression
-        typename engine_type::dist_eval_type dist_eval = engine.make_dist_eval();
+        typename result_engine_type::dist_eval_type dist_eval =
+            engine.make_dist_eval();
         dist_eval.eval();
 
-        // Create the result array
-        A result(dist_eval.world(), dist_eval.trange(),
-            dist_eval.shape(), dist_eval.pmap());
-
-        // Move the data from dist_eval into the result array. There is no
-        // communication in this step.
-        for(const auto index : *dist_eval.pmap()) {
-          if(! dist_eval.is_zero(index))
-            set_tile(result, index, dist_eval.get(index));
-        }
+        // Create the result array and move the data from dist_eval into it
+        A result = (truncate_ ? make_truncated_result<A>(dist_eval) :
+            make_result<A>(dist_eval));
 
         // Wait for child expressions of dist_eval
         dist_eval.wait();
@@ -460,11 +640,9 @@ namespace TiledArray {
         return default_world_helper<Derived>(this->derived()).get();
       }
 
-    public:
-
       template <typename Op>
       Future<typename Op::result_type>
-      reduce(const Op& op, World& world) const {
+      reduce(const Op& op, World& world, std::false_type) const {
         // Typedefs
         typedef madness::TaggedKey<madness::uniqueidT, ExpressionReduceTag> key_type;
         typedef TiledArray::math::UnaryReduceWrapper<typename engine_type::value_type,
@@ -498,6 +676,45 @@ namespace TiledArray {
         return result;
       }
 
+      template <typename Op>
+      Future<typename Op::result_type>
+      reduce(const Op& op, World& world, std::true_type) const {
+        // Typedefs
+        typedef madness::TaggedKey<madness::uniqueidT, ExpressionReduceTag> key_type;
+
+        // Construct the expression engine
+        engine_type engine(derived());
+        engine.init(world, std::shared_ptr<typename engine_type::pmap_interface>(),
+            VariableList());
+
+        // Reduce the local tiles without storing the result tiles
+        Future<typename Op::result_type> local_result = engine.fused_reduce(op);
+
+        // All reduce the result of the expression
+        return world.gop.all_reduce(key_type(world.unique_obj_id()),
+            local_result, op);
+      }
+
+    public:
+
+      /// Reduce the result of this expression
+
+      /// When this expression is an element-wise unary or binary operation,
+      /// e.g. <tt>(a("i,j") - b("i,j")).norm()</tt> , and \c Op is an
+      /// element-wise reduction, the reduction is fused into the tile
+      /// operation of the expression. Each result tile is then reduced in the
+      /// loop that would compute it, and is never stored. Otherwise the
+      /// expression is evaluated and its tiles are reduced.
+      /// \tparam Op The tile reduction type
+      /// \param op The tile reduction
+      /// \param world The world where the expression is evaluated
+      /// \return The reduced value of this expression
+      template <typename Op>
+      Future<typename Op::result_type>
+      reduce(const Op& op, World& world) const {
+        return reduce(op, world, is_fused_reduction<engine_type, Op>());
+      }
+
       template <typename Op>
       Future<typename Op::result_type>
       reduce(const Op& op) const {
@@ -0,0 +1,165 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  expr_cache.h
+ *  Jun 18, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_EXPRESSIONS_EXPR_CACHE_H__INCLUDED
+#define TILEDARRAY_EXPRESSIONS_EXPR_CACHE_H__INCLUDED
+
+#include <TiledArray/dist_eval/cached_eval.h>
+#include <unordered_map>
+#include <typeinfo>
+#include <sstream>
+
+namespace TiledArray {
+
+  template <typename, typename> class DistArray;
+
+  namespace expressions {
+
+    /// Cache of evaluated subexpressions
+
+    /// While an \c ExprCache object is in scope, the result of each
+    /// contraction in an expression is stored and reused by structurally
+    /// identical contractions in subsequent expressions, i.e. contractions
+    /// of the same arrays with the same annotations, permutations, and scaling
+    /// factors. For example:
+    /// \code
+    /// {
+    ///   TiledArray::expressions::ExprCache cache;
+    ///   r1("i,j") = a("i,k") * (b("k,l") * c("l,j"));
+    ///   r2("i,j") = d("i,k") * (b("k,l") * c("l,j"));
+    /// }
+    /// \endcode
+    /// evaluates <tt>b("k,l") * c("l,j")</tt> once. Arrays are identified by
+    /// their unique id, so assigning a new value to an array invalidates
+    /// cached results that depend on it. Results that depend on arrays that
+    /// are modified in place (e.g. with \c DistArray::set ) are not
+    /// invalidated, and the cache should be cleared or destroyed before such
+    /// changes. Cached results are held until the cache is cleared or
+    /// destroyed. Caches are nested: the most recently constructed cache is
+    /// active. The cache must be constructed and used by all processes in
+    /// the same order.
+    class ExprCache {
+    public:
+      typedef std::size_t size_type; ///< Size type
+
+    private:
+
+      std::unordered_map<std::string, std::shared_ptr<void> > cache_; ///< Cached results
+      size_type hits_; ///< The number of reused results
+      size_type misses_; ///< The number of stored results
+      ExprCache* prev_; ///< The cache that was active when this was constructed
+
+      /// The active cache pointer
+
+      /// \return A reference to the pointer to the active cache
+      static ExprCache*& active_cache() {
+        static ExprCache* cache = nullptr;
+        return cache;
+      }
+
+    public:
+
+      /// Construct and activate a cache
+      ExprCache() : cache_(), hits_(0ul), misses_(0ul), prev_(active_cache()) {
+        active_cache() = this;
+      }
+
+      ExprCache(const ExprCache&) = delete;
+      ExprCache& operator=(const ExprCache&) = delete;
+
+      /// Deactivate this cache and release cached results
+      ~ExprCache() { active_cache() = prev_; }
+
+      /// Active cache accessor
+
+      /// \return A pointer to the active cache, or \c nullptr if no cache is
+      /// in scope
+      static ExprCache* active() { return active_cache(); }
+
+      /// Release all cached results
+      void clear() { cache_.clear(); }
+
+      /// The number of cached results
+      size_type size() const { return cache_.size(); }
+
+      /// The number of results that have been reused
+      size_type hits() const { return hits_; }
+
+      /// The number of results that have been evaluated and stored
+      size_type misses() const { return misses_; }
+
+      /// Construct a distributed evaluator that uses a cached result
+
+      /// If the result of \c engine is cached, the returned evaluator copies
+      /// the tiles of the cached result. Otherwise, the evaluator constructed
+      /// by \c op is evaluated into an array that is added to the cache.
+      /// \tparam Engine The expression engine type
+      /// \tparam Op The evaluator factory type
+      /// \param engine The expression engine, which must be initialized
+      /// \param op A function that constructs the distributed evaluator of
+      /// \c engine
+      /// \return The distributed evaluator for \c engine
+      template <typename Engine, typename Op>
+      typename Engine::dist_eval_type
+      make_dist_eval(const Engine& engine, const Op& op) {
+        typedef typename Engine::dist_eval_type dist_eval_type;
+        typedef typename Engine::policy policy;
+        typedef DistArray<typename dist_eval_type::value_type, policy> array_type;
+        typedef TiledArray::detail::CachedEvalImpl<array_type, policy> impl_type;
+
+        std::stringstream ss;
+        ss << engine.world()->id() << " " << typeid(dist_eval_type).name()
+            << " " << engine.make_key();
+        const std::string key = ss.str();
+
+        std::shared_ptr<array_type> array;
+        std::shared_ptr<dist_eval_type> source;
+        auto it = cache_.find(key);
+        if(it != cache_.end()) {
+          array = std::static_pointer_cast<array_type>(it->second);
+          ++hits_;
+        } else {
+          // Evaluate the expression and move its tiles to the cached array.
+          // There is no communication in this step.
+          source = std::make_shared<dist_eval_type>(op());
+          source->eval();
+          array = std::make_shared<array_type>(source->world(),
+              source->trange(), source->shape(), source->pmap());
+          for(const auto index : *source->pmap()) {
+            if(! source->is_zero(index))
+              array->set(index, source->get(index));
+          }
+          cache_.emplace(key, array);
+          ++misses_;
+        }
+
+        return dist_eval_type(std::make_shared<impl_type>(*array,
+            *engine.world(), engine.trange(), engine.shape(), engine.pmap(),
+            source));
+      }
+
+    }; // class ExprCache
+
+  }  // namespace expressions
+} // namespace TiledArray
+
+#endif // TILEDARRAY_EXPRESSIONS_EXPR_CACHE_H__INCLUDED
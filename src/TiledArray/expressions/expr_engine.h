@@ -28,6 +28,7 @@
 
 #include <TiledArray/madness.h>
 #include <TiledArray/expressions/expr_trace.h>
+#include <sstream>
 
 namespace TiledArray {
   namespace expressions {
@@ -37,6 +38,34 @@ namespace TiledArray {
     template <typename> class Expr;
     template <typename> struct EngineTrait;
 
+    /// Exact text form of a scaling factor
+
+    /// The factor is printed in hexadecimal floating-point notation, so
+    /// factors that differ in any bit have different text forms.
+    /// \tparam Scalar The scalar type
+    /// \param factor The scaling factor
+    /// \return The text form of \c factor
+    template <typename Scalar>
+    inline std::string exact_factor(const Scalar& factor) {
+      std::stringstream ss;
+      ss << std::hexfloat << factor;
+      return ss.str();
+    }
+
+    /// Engine that evaluates an expression to a given result tile type
+
+    /// By default, the engine type of an expression is not changed, and the
+    /// result tile type must match that of the engine. Engines that can
+    /// compute their result directly in another tile type specialize this
+    /// trait; e.g. a contraction of single precision arrays that is assigned
+    /// to a double precision array is accumulated in double precision.
+    /// \tparam Engine The expression engine type
+    /// \tparam Result The result tile type
+    template <typename Engine, typename Result>
+    struct result_engine {
+      typedef Engine type; ///< The engine type
+    };
+
     /// Expression engine
     template <typename Derived>
     class ExprEngine : private NO_DEFAULTS {
@@ -77,9 +106,33 @@ namespace TiledArray {
       template <typename D>
       ExprEngine(const Expr<D> &expr) :
         world_(NULL), vars_(), permute_tiles_(true), perm_(), trange_(), shape_(),
-        pmap_(), override_ptr_(expr.override_ptr_)
+        pmap_(), override_ptr_(convert_override(expr.override_ptr_))
       { }
 
+    private:
+
+      static const std::shared_ptr<EngineParamOverride<Derived> >&
+      convert_override(const std::shared_ptr<EngineParamOverride<Derived> >& other) {
+        return other;
+      }
+
+      // Copy the engine parameters of an expression that is evaluated by
+      // another engine type (see \c result_engine )
+      template <typename E>
+      static std::shared_ptr<EngineParamOverride<Derived> >
+      convert_override(const std::shared_ptr<EngineParamOverride<E> >& other) {
+        std::shared_ptr<EngineParamOverride<Derived> > result;
+        if(other) {
+          result = std::make_shared<EngineParamOverride<Derived> >();
+          result->world = other->world;
+          result->pmap = other->pmap;
+          result->shape = other->shape;
+        }
+        return result;
+      }
+
+    public:
+
       /// Construct and initialize the expression engine
 
       /// This function will initialize all expression engines in the expression
@@ -241,6 +294,25 @@ namespace TiledArray {
       /// \return An expression tag used to identify this expression
       const char* make_tag() const { return ""; }
 
+      /// Expression structure tag
+
+      /// Unlike \c make_tag() , which is printed, the structure tag must
+      /// contain the exact value of scaling factors; see \c exact_factor() .
+      /// \return A tag used to identify the structure of this expression
+      std::string make_key_tag() const { return derived().make_tag(); }
+
+      /// Expression structure key
+
+      /// Expressions with equal keys produce the same result.
+      /// \return A key that identifies the structure of this expression
+      std::string make_key() const {
+        std::stringstream ss;
+        ss << derived().make_key_tag() << vars_;
+        if(perm_)
+          ss << " [P " << perm_ << (permute_tiles_ ? "]" : " no permute tiles]");
+        return ss.str();
+      }
+
     }; // class ExprEngine
 
   }  // namespace expressions
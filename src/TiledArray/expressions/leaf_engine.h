@@ -28,6 +28,7 @@
 
 #include <TiledArray/expressions/expr_engine.h>
 #include <TiledArray/dist_eval/array_eval.h>
+#include <TiledArray/tile_op/fused_reduction.h>
 
 namespace TiledArray {
   namespace expressions {
@@ -98,6 +99,8 @@ namespace TiledArray {
 
       /// This function only checks for valid variable lists.
       /// \param target_vars The target variable list for this expression
+      /// \throw TiledArray::Exception When the inner variables of
+      /// \c target_vars are not equal to those of the array
       void init_vars(const VariableList& target_vars) {
 #ifndef NDEBUG
         if(! target_vars.is_permutation(vars_)) {
@@ -111,6 +114,19 @@ namespace TiledArray {
           TA_EXCEPTION("Target variable is not a permutation of the given array variable list.");
         }
 #endif // NDEBUG
+
+        // The inner tensors are never permuted, so this is checked
+        // in all builds to avoid silently wrong results
+        if((target_vars.inner_dim() != 0u) && (target_vars.inner() != vars_.inner())) {
+          if(TiledArray::get_default_world().rank() == 0) {
+            TA_USER_ERROR_MESSAGE( \
+                "The inner variable list of the array is not equal to the expected output:" \
+                << "\n    expected = " << target_vars \
+                << "\n    array    = " << vars_ );
+          }
+
+          TA_EXCEPTION("Permutation of the inner tensors of a tensor of tensors is not supported.");
+        }
       }
 
 
@@ -152,6 +168,15 @@ namespace TiledArray {
       make_shape(const Permutation& perm) { return array_.shape().perm(perm); }
 
 
+      /// Expression structure key
+
+      /// \return A key that identifies the structure of this expression
+      std::string make_key() const {
+        std::stringstream ss;
+        ss << ExprEngine_::make_key() << " [" << array_.id() << "]";
+        return ss.str();
+      }
+
       /// Construct the distributed evaluator for array
       dist_eval_type make_dist_eval() const {
         // Define the distributed evaluator implementation type
@@ -165,6 +190,26 @@ namespace TiledArray {
         return dist_eval_type(pimpl);
       }
 
+      /// Reduce the local tiles of this expression without evaluating them
+
+      /// The tile reduction is applied directly to the array tiles, together
+      /// with the element-wise form of the tile operation of this expression,
+      /// which is constructed by \c Derived::make_element_op() . The
+      /// permutation of the tiles is ignored, since it does not change the
+      /// reduction.
+      /// \tparam Op The tile reduction type
+      /// \param op The tile reduction
+      /// \return The reduction of the local tiles of this expression
+      template <typename Op>
+      Future<typename Op::result_type> fused_reduce(const Op& op) const {
+        typedef TiledArray::detail::FusedUnaryReduction<Op,
+            decltype(derived().make_element_op())> kernel_type;
+
+        return TiledArray::detail::fused_reduce(op,
+            kernel_type(op, derived().make_element_op()), make_dist_eval(),
+            shape_);
+      }
+
     }; // class LeafEngine
 
   }  // namespace expressions
@@ -0,0 +1,378 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  mult_chain.h
+ *  Jun 19, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_EXPRESSIONS_MULT_CHAIN_H__INCLUDED
+#define TILEDARRAY_EXPRESSIONS_MULT_CHAIN_H__INCLUDED
+
+#include <TiledArray/expressions/leaf_engine.h>
+#include <TiledArray/tile_op/tile_interface.h>
+#include <functional>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+namespace TiledArray {
+  namespace expressions {
+
+    // Forward declarations
+    template <typename, typename> class MultExpr;
+    template <typename, typename, typename> class MultEngine;
+
+    /// Size estimate of a product argument
+    struct MultChainArg {
+      std::vector<std::string> vars; ///< The argument variables
+      std::vector<double> extents; ///< The number of elements of each variable
+      std::vector<double> tiles; ///< The number of tiles of each variable
+      double fill; ///< The fraction of non-zero tiles
+    }; // struct MultChainArg
+
+    /// Construct the size estimate of a leaf expression
+
+    /// \tparam Engine The leaf engine type
+    /// \param engine The leaf engine
+    /// \return The size estimate of the tensor evaluated by \c engine
+    template <typename Engine>
+    inline MultChainArg make_mult_chain_arg(Engine& engine) {
+      const auto trange = engine.make_trange();
+      MultChainArg arg;
+      arg.vars = engine.vars().data();
+      for(const auto& tr1 : trange.data()) {
+        arg.extents.push_back(double(tr1.elements_range().second -
+            tr1.elements_range().first));
+        arg.tiles.push_back(double(tr1.tiles_range().second -
+            tr1.tiles_range().first));
+      }
+      arg.fill = 1.0 - double(engine.make_shape().sparsity());
+      return arg;
+    }
+
+    /// Estimate the cost of a pairwise product
+
+    /// The cost is the number of floating point operations of the dense
+    /// product scaled by the fraction of non-zero tiles of both arguments.
+    /// The fraction of non-zero tiles in the result is the probability that
+    /// at least one of the contracted tile pairs is non-zero.
+    /// \param left The size estimate of the left-hand argument
+    /// \param right The size estimate of the right-hand argument
+    /// \param[out] result The size estimate of the product
+    /// \return The estimated cost of the product, or a negative value if the
+    /// product is not a contraction or an outer product
+    inline double
+    mult_chain_cost(const MultChainArg& left, const MultChainArg& right,
+        MultChainArg& result)
+    {
+      result = MultChainArg();
+      double volume = 1.0, inner_tiles = 1.0;
+      std::size_t inner_rank = 0ul;
+
+      for(std::size_t i = 0ul; i < left.vars.size(); ++i) {
+        volume *= left.extents[i];
+        if(std::find(right.vars.begin(), right.vars.end(), left.vars[i]) ==
+            right.vars.end())
+        {
+          result.vars.push_back(left.vars[i]);
+          result.extents.push_back(left.extents[i]);
+          result.tiles.push_back(left.tiles[i]);
+        } else {
+          inner_tiles *= left.tiles[i];
+          ++inner_rank;
+        }
+      }
+      for(std::size_t i = 0ul; i < right.vars.size(); ++i) {
+        if(std::find(left.vars.begin(), left.vars.end(), right.vars[i]) ==
+            left.vars.end())
+        {
+          volume *= right.extents[i];
+          result.vars.push_back(right.vars[i]);
+          result.extents.push_back(right.extents[i]);
+          result.tiles.push_back(right.tiles[i]);
+        }
+      }
+
+      // Arguments with the same variables are multiplied element-wise
+      if((inner_rank == left.vars.size()) && (inner_rank == right.vars.size()))
+        return -1.0;
+
+      const double fill = left.fill * right.fill;
+      result.fill = (inner_rank ? 1.0 - std::pow(1.0 - fill, inner_tiles) : fill);
+
+      return 2.0 * volume * fill;
+    }
+
+
+    /// Evaluation order of a product chain
+
+    /// The primary template is used by products that are not a chain of three
+    /// leaf expressions, which are always evaluated from left to right.
+    /// \tparam Left The left-hand engine type
+    /// \tparam Right The right-hand engine type
+    /// \tparam Result The result tile type
+    template <typename Left, typename Right, typename Result,
+        typename Enabler = void>
+    class MultChain {
+    public:
+
+      template <typename E>
+      MultChain(const E&) { }
+
+      void enable(const bool) { }
+
+      bool init(const VariableList*) { return false; }
+
+      bool reordered() const { return false; }
+
+      template <typename Op>
+      void apply(const Op&) const { }
+
+      void print(ExprOStream) const { }
+
+    }; // class MultChain
+
+    /// Alternative engine types of a product chain
+
+    /// A chain <tt>(a * b) * c</tt> may also be evaluated as
+    /// <tt>a * (b * c)</tt> or <tt>(a * c) * b</tt>.
+    /// \tparam A The first leaf engine type
+    /// \tparam B The second leaf engine type
+    /// \tparam C The third leaf engine type
+    template <typename A, typename B, typename C>
+    struct MultChainTrait {
+      typedef MultEngine<B, C, result_of_mult_t<
+          typename EngineTrait<B>::eval_type,
+          typename EngineTrait<C>::eval_type> >
+          right_pair_type; ///< The engine type of <tt>b * c</tt>
+      typedef MultEngine<A, right_pair_type, result_of_mult_t<
+          typename EngineTrait<A>::eval_type,
+          typename EngineTrait<right_pair_type>::eval_type> >
+          right_first_type; ///< The engine type of <tt>a * (b * c)</tt>
+      typedef MultEngine<A, C, result_of_mult_t<
+          typename EngineTrait<A>::eval_type,
+          typename EngineTrait<C>::eval_type> >
+          outer_pair_type; ///< The engine type of <tt>a * c</tt>
+      typedef MultEngine<outer_pair_type, B, result_of_mult_t<
+          typename EngineTrait<outer_pair_type>::eval_type,
+          typename EngineTrait<B>::eval_type> >
+          outer_first_type; ///< The engine type of <tt>(a * c) * b</tt>
+    }; // struct MultChainTrait
+
+    /// Evaluation order of a chain of three leaf expressions
+
+    /// The cost of each evaluation order of <tt>(a * b) * c</tt> is estimated
+    /// from the tiled ranges and shapes of the arguments, and the cheapest
+    /// order is selected. Chains are only reordered when each variable appears
+    /// in at most two arguments and all products are contractions or outer
+    /// products, so that every order gives the same result. Chains of
+    /// tensor-of-tensor arrays are not reordered.
+    /// \tparam A The first leaf engine type
+    /// \tparam B The second leaf engine type
+    /// \tparam AB The result tile type of <tt>a * b</tt>
+    /// \tparam C The third leaf engine type
+    /// \tparam Result The result tile type
+    template <typename A, typename B, typename AB, typename C, typename Result>
+    class MultChain<MultEngine<A, B, AB>, C, Result,
+        typename std::enable_if<
+            (! TiledArray::detail::is_tensor_of_tensor<
+                typename EngineTrait<A>::eval_type>::value) &&
+            std::is_base_of<LeafEngine<A>, A>::value &&
+            std::is_base_of<LeafEngine<B>, B>::value &&
+            std::is_base_of<LeafEngine<C>, C>::value &&
+            std::is_same<typename EngineTrait<typename MultChainTrait<A, B,
+                C>::right_first_type>::value_type,
+                typename EngineTrait<MultEngine<MultEngine<A, B, AB>, C,
+                Result> >::value_type>::value &&
+            std::is_same<typename EngineTrait<typename MultChainTrait<A, B,
+                C>::outer_first_type>::value_type,
+                typename EngineTrait<MultEngine<MultEngine<A, B, AB>, C,
+                Result> >::value_type>::value
+        >::type>
+    {
+    public:
+      typedef typename MultChainTrait<A, B, C>::right_first_type
+          right_first_type; ///< The engine type of <tt>a * (b * c)</tt>
+      typedef typename MultChainTrait<A, B, C>::outer_first_type
+          outer_first_type; ///< The engine type of <tt>(a * c) * b</tt>
+
+    private:
+
+      bool enable_; ///< Reordering flag
+      bool selected_; ///< Order selection flag (true == costs are estimated)
+      unsigned int order_; ///< The selected order (0 == <tt>(a * b) * c</tt>,
+                           ///< 1 == <tt>a * (b * c)</tt>, 2 == <tt>(a * c) * b</tt>)
+      std::array<double, 3> cost_; ///< The estimated cost of each order
+      std::array<VariableList, 3> vars_; ///< The argument variables
+      std::function<std::array<MultChainArg, 3>()> make_args_; ///< Argument size estimate factory
+      std::function<std::shared_ptr<right_first_type>()>
+          make_right_first_; ///< <tt>a * (b * c)</tt> engine factory
+      std::function<std::shared_ptr<outer_first_type>()>
+          make_outer_first_; ///< <tt>(a * c) * b</tt> engine factory
+      std::shared_ptr<right_first_type> right_first_; ///< <tt>a * (b * c)</tt> engine
+      std::shared_ptr<outer_first_type> outer_first_; ///< <tt>(a * c) * b</tt> engine
+
+    public:
+
+      /// Constructor
+
+      /// \tparam EA The first argument expression type
+      /// \tparam EB The second argument expression type
+      /// \tparam EC The third argument expression type
+      /// \param expr The product chain expression
+      template <typename EA, typename EB, typename EC>
+      MultChain(const MultExpr<MultExpr<EA, EB>, EC>& expr) :
+        enable_(true), selected_(false), order_(0u), cost_(), vars_(), make_args_(),
+        make_right_first_(), make_outer_first_(), right_first_(),
+        outer_first_()
+      {
+        const EA a = expr.left().left();
+        const EB b = expr.left().right();
+        const EC c = expr.right();
+
+        make_args_ = [a, b, c] () {
+          A engine_a(a);
+          B engine_b(b);
+          C engine_c(c);
+          return std::array<MultChainArg, 3>{{ make_mult_chain_arg(engine_a),
+              make_mult_chain_arg(engine_b), make_mult_chain_arg(engine_c) }};
+        };
+        make_right_first_ = [a, b, c] () {
+          auto engine = std::make_shared<right_first_type>(
+              MultExpr<EA, MultExpr<EB, EC> >(a, MultExpr<EB, EC>(b, c)));
+          engine->reorder_chain(false);
+          return engine;
+        };
+        make_outer_first_ = [a, b, c] () {
+          auto engine = std::make_shared<outer_first_type>(
+              MultExpr<MultExpr<EA, EC>, EB>(MultExpr<EA, EC>(a, c), b));
+          engine->reorder_chain(false);
+          return engine;
+        };
+      }
+
+      /// Set the reordering flag
+
+      /// \param status The new reordering status (true == reorder the chain
+      /// if another order is cheaper)
+      void enable(const bool status) { enable_ = status; }
+
+      /// Select the evaluation order
+
+      /// \param target_vars The target variable list of the chain, or
+      /// \c nullptr if the result variables are not fixed
+      /// \return \c true if the chain is not evaluated from left to right
+      bool init(const VariableList* target_vars) {
+        if(! enable_)
+          return false;
+
+        const std::array<MultChainArg, 3> args = make_args_();
+
+        // Every order gives the same result only if each variable is summed
+        // over by exactly one product.
+        std::map<std::string, unsigned int> count;
+        for(const auto& arg : args) {
+          for(const auto& var : arg.vars) {
+            if(std::count(arg.vars.begin(), arg.vars.end(), var) != 1)
+              return false;
+            ++count[var];
+          }
+        }
+        for(const auto& var : count)
+          if(var.second > 2u)
+            return false;
+        for(unsigned int i = 0u; i < 3u; ++i)
+          vars_[i] = VariableList(args[i].vars.begin(), args[i].vars.end());
+
+        // Estimate the cost of each order
+        const unsigned int first[3][2] = { { 0u, 1u }, { 1u, 2u }, { 0u, 2u } };
+        const unsigned int last[3] = { 2u, 0u, 1u };
+        MultChainArg result;
+        for(unsigned int i = 0u; i < 3u; ++i) {
+          MultChainArg pair;
+          const double pair_cost =
+              mult_chain_cost(args[first[i][0]], args[first[i][1]], pair);
+          const double last_cost = (i == 1u ?
+              mult_chain_cost(args[last[i]], pair, result) :
+              mult_chain_cost(pair, args[last[i]], result));
+          cost_[i] = ((pair_cost < 0.0) || (last_cost < 0.0) ?
+              -1.0 : pair_cost + last_cost);
+
+          if((i == 0u) && ((cost_[i] < 0.0) || (target_vars &&
+              ! target_vars->is_permutation(VariableList(result.vars.begin(),
+              result.vars.end())))))
+            return false;
+        }
+
+        selected_ = true;
+        for(unsigned int i = 1u; i < 3u; ++i)
+          if((cost_[i] >= 0.0) && (cost_[i] < cost_[order_]))
+            order_ = i;
+
+        if(order_ == 1u)
+          right_first_ = make_right_first_();
+        else if(order_ == 2u)
+          outer_first_ = make_outer_first_();
+
+        return reordered();
+      }
+
+      /// Reordering query
+
+      /// \return \c true if the chain is not evaluated from left to right
+      bool reordered() const { return order_ != 0u; }
+
+      /// Apply an operation to the engine of the selected order
+
+      /// \tparam Op The operation type
+      /// \param op The operation, which is called with the engine of the
+      /// selected order
+      template <typename Op>
+      void apply(const Op& op) const {
+        TA_ASSERT(reordered());
+        if(order_ == 1u)
+          op(*right_first_);
+        else
+          op(*outer_first_);
+      }
+
+      /// Print the estimated cost of each order
+
+      /// Nothing is printed if the order was not selected by cost.
+      /// \param os The output stream
+      void print(ExprOStream os) const {
+        if(! selected_)
+          return;
+
+        std::stringstream ss;
+        ss << "[order] (" << vars_[0] << " * " << vars_[1] << ") * " << vars_[2]
+            << " = " << cost_[0] << ", " << vars_[0] << " * (" << vars_[1]
+            << " * " << vars_[2] << ") = " << cost_[1] << ", (" << vars_[0]
+            << " * " << vars_[2] << ") * " << vars_[1] << " = " << cost_[2]
+            << " [selected " << order_ << "]\n";
+        os << ss.str();
+      }
+
+    }; // class MultChain
+
+  }  // namespace expressions
+} // namespace TiledArray
+
+#endif // TILEDARRAY_EXPRESSIONS_MULT_CHAIN_H__INCLUDED
@@ -27,7 +27,9 @@
 #define TILEDARRAY_EXPRESSIONS_MULT_ENGINE_H__INCLUDED
 
 #include <TiledArray/expressions/cont_engine.h>
+#include <TiledArray/expressions/mult_chain.h>
 #include <TiledArray/tile_op/mult.h>
+#include <TiledArray/tile_op/nested_mult.h>
 #include <TiledArray/tile_op/binary_wrapper.h>
 
 
@@ -51,11 +53,19 @@ namespace TiledArray {
       typedef Right right_type; ///< The right-hand expression type
 
       // Operational typedefs
-      typedef TiledArray::detail::Mult<Result,
-          typename EngineTrait<Left>::eval_type,
-          typename EngineTrait<Right>::eval_type, EngineTrait<Left>::consumable,
-          EngineTrait<Right>::consumable>
-          op_base_type; ///< The base tile operation type
+      typedef typename std::conditional<
+          TiledArray::detail::is_tensor_of_tensor<
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type>::value,
+          TiledArray::detail::NestedMult<Result,
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type,
+              typename TiledArray::detail::numeric_type<Result>::type>,
+          TiledArray::detail::Mult<Result,
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type,
+              EngineTrait<Left>::consumable, EngineTrait<Right>::consumable>
+          >::type op_base_type; ///< The base tile operation type
       typedef TiledArray::detail::BinaryWrapper<op_base_type>
           op_type; ///< The tile operation type
       typedef typename op_type::result_type
@@ -92,11 +102,18 @@ namespace TiledArray {
 
       // Operational typedefs
       typedef Scalar scalar_type; ///< Tile scalar type
-      typedef TiledArray::detail::ScalMult<Result,
-          typename EngineTrait<Left>::eval_type,
-          typename EngineTrait<Right>::eval_type, scalar_type,
-          EngineTrait<Left>::consumable, EngineTrait<Right>::consumable>
-          op_base_type; ///< The base tile operation type
+      typedef typename std::conditional<
+          TiledArray::detail::is_tensor_of_tensor<
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type>::value,
+          TiledArray::detail::NestedMult<Result,
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type, scalar_type>,
+          TiledArray::detail::ScalMult<Result,
+              typename EngineTrait<Left>::eval_type,
+              typename EngineTrait<Right>::eval_type, scalar_type,
+              EngineTrait<Left>::consumable, EngineTrait<Right>::consumable>
+          >::type op_base_type; ///< The base tile operation type
       typedef TiledArray::detail::BinaryWrapper<op_base_type>
           op_type; ///< The tile operation type
       typedef typename op_type::result_type
@@ -119,6 +136,25 @@ namespace TiledArray {
           EngineTrait<Left>::leaves + EngineTrait<Right>::leaves;
     };
 
+    /// Multiplication engine with a different result tile type
+
+    /// Contractions are evaluated directly in the result tile type, so the
+    /// argument tiles are broadcast in their own type and the products are
+    /// accumulated in the result type.
+    template <typename Left, typename Right, typename Result, typename T>
+    struct result_engine<MultEngine<Left, Right, Result>, T> {
+      typedef MultEngine<Left, Right, T> type; ///< The engine type
+    };
+
+    /// Scaled multiplication engine with a different result tile type
+
+    /// \sa result_engine<MultEngine<Left, Right, Result>, T>
+    template <typename Left, typename Right, typename Scalar, typename Result,
+        typename T>
+    struct result_engine<ScalMultEngine<Left, Right, Scalar, Result>, T> {
+      typedef ScalMultEngine<Left, Right, Scalar, T> type; ///< The engine type
+    };
+
 
     /// Multiplication expression engine
 
@@ -127,6 +163,12 @@ namespace TiledArray {
     /// pure contractions, e.g. \code (c("i,j")=)a("i,k")*b("k,j") \endcode .
     /// \internal mixed Hadamard-contraction case, e.g. \code c("i,j,l")=a("i,l,k")*b("j,l,k") \endcode , is not supported since
     ///   this requires that the result labels are assigned by user (currently they are computed by this engine)
+    /// A chain of three array products, e.g.
+    /// \code (c("i,j")=)a("i,k")*b("k,l")*c("l,j") \endcode , is evaluated in
+    /// the order with the lowest estimated cost (see \c MultChain ).
+    /// The elements of tensor-of-tensor arrays are multiplied or contracted
+    /// as defined by their inner variables, e.g.
+    /// \code (c("i,j;a,b")=)a("i,k;a,c")*b("k,j;c,b") \endcode .
     /// \tparam Left The left-hand engine type
     /// \tparam Right The right-hand engine type
     /// \tparam Result The result tile type
@@ -174,6 +216,37 @@ namespace TiledArray {
 
       bool contract_; ///< Expression type flag (true == contraction, false ==
                       ///< coefficent-wise multiplication)
+      MultChain<Left, Right, Result> chain_; ///< The product chain evaluation order
+
+      // Construct the base tile operation for tensor-of-tensor tiles
+      template <typename Nested>
+      op_base_type make_op_base(const Nested&, typename std::enable_if<
+          Nested::value>::type* = nullptr) const
+      {
+        return op_base_type(ContEngine_::nested_);
+      }
+
+      // Construct the base tile operation for plain tiles
+      template <typename Nested>
+      op_base_type make_op_base(const Nested&, typename std::enable_if<
+          ! Nested::value>::type* = nullptr) const
+      {
+        return op_base_type();
+      }
+
+      /// Copy the result of the reordered product chain
+
+      /// \tparam Engine The engine type of the selected order
+      /// \param engine The engine of the selected order
+      template <typename Engine>
+      void copy_chain(const Engine& engine) {
+        ExprEngine_::world_ = engine.world();
+        ExprEngine_::vars_ = engine.vars();
+        ExprEngine_::perm_ = engine.perm();
+        ExprEngine_::trange_ = engine.trange();
+        ExprEngine_::shape_ = engine.shape();
+        ExprEngine_::pmap_ = engine.pmap();
+      }
 
     public:
 
@@ -184,8 +257,18 @@ namespace TiledArray {
       /// \param expr The parent expression
       template <typename L, typename R>
       MultEngine(const MultExpr<L, R>& expr) :
-        ContEngine_(expr), contract_(false)
-      { }
+        ContEngine_(expr), contract_(false), chain_(expr)
+      {
+        // The engine parameters of the expression do not apply to other orders
+        if(ExprEngine_::override_ptr_)
+          chain_.enable(false);
+      }
+
+      /// Set the product chain reordering flag
+
+      /// \param status The new reordering status (true == evaluate a chain of
+      /// products in the order with the lowest estimated cost)
+      void reorder_chain(const bool status) { chain_.enable(status); }
 
 
       /// Set the variable list for this expression
@@ -196,10 +279,17 @@ namespace TiledArray {
       /// result of this expression will be permuted to match \c target_vars.
       /// \param target_vars The target variable list for this expression
       void perm_vars(const VariableList& target_vars) {
-        if(contract_)
+        if(chain_.reordered()) {
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            engine.perm_vars(target_vars);
+            this->copy_chain(engine);
+          });
+        } else if(contract_)
           ContEngine_::perm_vars(target_vars);
         else {
           BinaryEngine_::perm_vars(target_vars);
+          ContEngine_::init_inner_vars(&target_vars);
         }
       }
 
@@ -208,7 +298,13 @@ namespace TiledArray {
       /// This function will set the variable list for this expression and its
       /// children such that the number of permutations is minimized.
       void perm_vars() {
-        if(contract_)
+        if(chain_.reordered()) {
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            engine.perm_vars();
+            this->copy_chain(engine);
+          });
+        } else if(contract_)
           ContEngine_::perm_vars();
         else {
           BinaryEngine_::perm_vars();
@@ -219,11 +315,21 @@ namespace TiledArray {
 
       /// \param target_vars The target variable list for this expression
       void init_vars(const VariableList& target_vars) {
+        if(chain_.init(&target_vars)) {
+          contract_ = true;
+          chain_.apply([&] (auto& engine) {
+            engine.init_vars(target_vars);
+            this->copy_chain(engine);
+          });
+          return;
+        }
+
         BinaryEngine_::left_.init_vars();
         BinaryEngine_::right_.init_vars();
 
         if(BinaryEngine_::left_.vars().is_permutation(BinaryEngine_::right_.vars())) {
           BinaryEngine_::perm_vars(target_vars);
+          ContEngine_::init_inner_vars(&target_vars);
         } else {
           contract_ = true;
           ContEngine_::init_vars();
@@ -233,6 +339,15 @@ namespace TiledArray {
 
       /// Initialize the variable list of this expression
       void init_vars() {
+        if(chain_.init(nullptr)) {
+          contract_ = true;
+          chain_.apply([&] (auto& engine) {
+            engine.init_vars();
+            this->copy_chain(engine);
+          });
+          return;
+        }
+
         BinaryEngine_::left_.init_vars();
         BinaryEngine_::right_.init_vars();
 
@@ -241,6 +356,7 @@ namespace TiledArray {
             ExprEngine_::vars_ = BinaryEngine_::left_.vars();
           else
             ExprEngine_::vars_ = BinaryEngine_::right_.vars();
+          ContEngine_::init_inner_vars(nullptr);
         } else {
           contract_ = true;
           ContEngine_::init_vars();
@@ -253,10 +369,20 @@ namespace TiledArray {
       /// for the result tensor.
       /// \param target_vars The target variable list for the result tensor
       void init_struct(const VariableList& target_vars) {
-        if(contract_)
+        if(chain_.reordered()) {
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            engine.init_struct(target_vars);
+            this->copy_chain(engine);
+          });
+        } else if(contract_)
           ContEngine_::init_struct(target_vars);
-        else
+        else {
+          ContEngine_::nested_ = ContEngine_::make_nested_product(
+              BinaryEngine_::left_.vars().inner(),
+              BinaryEngine_::right_.vars().inner(), ExprEngine_::vars_.inner());
           BinaryEngine_::init_struct(target_vars);
+        }
       }
 
       /// Initialize result tensor distribution
@@ -266,7 +392,12 @@ namespace TiledArray {
       /// \param world The world were the result will be distributed
       /// \param pmap The process map for the result tensor tiles
       void init_distribution(World* world, std::shared_ptr<pmap_interface> pmap) {
-        if(contract_)
+        if(chain_.reordered()) {
+          chain_.apply([&] (auto& engine) {
+            engine.init_distribution(world, pmap);
+            this->copy_chain(engine);
+          });
+        } else if(contract_)
           ContEngine_::init_distribution(world, pmap);
         else
           BinaryEngine_::init_distribution(world, pmap);
@@ -311,24 +442,63 @@ namespace TiledArray {
       /// Non-permuting tile operation factory function
 
       /// \return The tile operation
-      static op_type make_tile_op() { return op_type(op_base_type()); }
+      op_type make_tile_op() const {
+        return op_type(make_op_base(TiledArray::detail::is_tensor_of_tensor<
+            typename op_base_type::left_type,
+            typename op_base_type::right_type>()));
+      }
 
       /// Permuting tile operation factory function
 
       /// \param perm The permutation to be applied to tiles
       /// \return The tile operation
-      static op_type make_tile_op(const Permutation& perm) { return op_type(op_base_type(), perm); }
+      op_type make_tile_op(const Permutation& perm) const {
+        return op_type(make_op_base(TiledArray::detail::is_tensor_of_tensor<
+            typename op_base_type::left_type,
+            typename op_base_type::right_type>()), perm);
+      }
 
       /// Construct the distributed evaluator for this expression
 
       /// \return The distributed evaluator that will evaluate this expression
       dist_eval_type make_dist_eval() const {
-        if(contract_)
+        if(chain_.reordered()) {
+          std::shared_ptr<dist_eval_type> dist_eval;
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            dist_eval = std::make_shared<dist_eval_type>(engine.make_dist_eval());
+          });
+          return *dist_eval;
+        } else if(contract_)
           return ContEngine_::make_dist_eval();
         else
           return BinaryEngine_::make_dist_eval();
       }
 
+      /// Check that this contraction can be added to another result in place
+
+      /// \return \c true if this expression is a contraction that is
+      /// evaluated in the order written and \c ContEngine::accumulable() is
+      /// \c true
+      bool accumulable() const {
+        return contract_ && (! chain_.reordered()) && ContEngine_::accumulable();
+      }
+
+      /// Expression structure key
+
+      /// \return A key that identifies the structure of this expression
+      std::string make_key() const {
+        if(chain_.reordered()) {
+          std::string key;
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            key = engine.make_key();
+          });
+          return key;
+        }
+        return ContEngine_::make_key();
+      }
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
@@ -339,7 +509,13 @@ namespace TiledArray {
       /// \param os The output stream
       /// \param target_vars The target variable list for this expression
       void print(ExprOStream os, const VariableList& target_vars) const {
-        if(contract_)
+        chain_.print(os);
+        if(chain_.reordered()) {
+          chain_.apply([&] (auto& engine) {
+            engine.permute_tiles(this->permute_tiles_);
+            engine.print(os, target_vars);
+          });
+        } else if(contract_)
           return ContEngine_::print(os, target_vars);
         else
           return BinaryEngine_::print(os, target_vars);
@@ -405,6 +581,22 @@ namespace TiledArray {
       bool contract_; ///< Expression type flag (true == contraction, false ==
                       ///< coefficent-wise multiplication)
 
+      // Construct the base tile operation for tensor-of-tensor tiles
+      template <typename Nested>
+      op_base_type make_op_base(const Nested&, typename std::enable_if<
+          Nested::value>::type* = nullptr) const
+      {
+        return op_base_type(ContEngine_::nested_, ContEngine_::factor_);
+      }
+
+      // Construct the base tile operation for plain tiles
+      template <typename Nested>
+      op_base_type make_op_base(const Nested&, typename std::enable_if<
+          ! Nested::value>::type* = nullptr) const
+      {
+        return op_base_type(ContEngine_::factor_);
+      }
+
     public:
 
       /// Constructor
@@ -428,6 +620,7 @@ namespace TiledArray {
           ContEngine_::perm_vars(target_vars);
         else {
           BinaryEngine_::perm_vars(target_vars);
+          ContEngine_::init_inner_vars(&target_vars);
         }
       }
 
@@ -452,6 +645,7 @@ namespace TiledArray {
 
         if(BinaryEngine_::left_.vars().is_permutation(BinaryEngine_::right_.vars())) {
           BinaryEngine_::perm_vars(target_vars);
+          ContEngine_::init_inner_vars(&target_vars);
         } else {
           contract_ = true;
           ContEngine_::init_vars();
@@ -469,6 +663,7 @@ namespace TiledArray {
             ExprEngine_::vars_ = BinaryEngine_::left_.vars();
           else
             ExprEngine_::vars_ = BinaryEngine_::right_.vars();
+          ContEngine_::init_inner_vars(nullptr);
         } else {
           contract_ = true;
           ContEngine_::init_vars();
@@ -483,8 +678,12 @@ namespace TiledArray {
       void init_struct(const VariableList& target_vars) {
         if(contract_)
           ContEngine_::init_struct(target_vars);
-        else
+        else {
+          ContEngine_::nested_ = ContEngine_::make_nested_product(
+              BinaryEngine_::left_.vars().inner(),
+              BinaryEngine_::right_.vars().inner(), ExprEngine_::vars_.inner());
           BinaryEngine_::init_struct(target_vars);
+        }
       }
 
       /// Initialize result tensor distribution
@@ -510,6 +709,14 @@ namespace TiledArray {
           return BinaryEngine_::make_dist_eval();
       }
 
+      /// Check that this contraction can be added to another result in place
+
+      /// \return \c true if this expression is a contraction and
+      /// \c ContEngine::accumulable() is \c true
+      bool accumulable() const {
+        return contract_ && ContEngine_::accumulable();
+      }
+
       /// Non-permuting tiled range factory function
 
       /// \return The result tiled range object
@@ -551,14 +758,20 @@ namespace TiledArray {
       /// Non-permuting tile operation factory function
 
       /// \return The tile operation
-      op_type make_tile_op() const { return op_type(op_base_type(ContEngine_::factor_)); }
+      op_type make_tile_op() const {
+        return op_type(make_op_base(TiledArray::detail::is_tensor_of_tensor<
+            typename op_base_type::left_type,
+            typename op_base_type::right_type>()));
+      }
 
       /// Permuting tile operation factory function
 
       /// \param perm The permutation to be applied to tiles
       /// \return The tile operation
       op_type make_tile_op(const Permutation& perm) const {
-        return op_type(op_base_type(ContEngine_::factor_), perm);
+        return op_type(make_op_base(TiledArray::detail::is_tensor_of_tensor<
+            typename op_base_type::left_type,
+            typename op_base_type::right_type>()), perm);
       }
 
 
@@ -572,6 +785,13 @@ namespace TiledArray {
         return ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return "[*] [" + exact_factor(ContEngine_::factor_) + "] ";
+      }
+
       /// Expression print
 
       /// \param os The output stream
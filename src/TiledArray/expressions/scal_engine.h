@@ -139,6 +139,13 @@ namespace TiledArray {
       /// \return The tile operation
       op_type make_tile_op(const Permutation& perm) const { return op_type(perm, factor_); }
 
+      /// Element operation factory function
+
+      /// \return The element-wise operation of this expression
+      TiledArray::detail::ElementScal<scalar_type> make_element_op() const {
+        return TiledArray::detail::ElementScal<scalar_type>{factor_};
+      }
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
@@ -148,6 +155,13 @@ namespace TiledArray {
         return ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return "[" + exact_factor(factor_) + "] ";
+      }
+
     }; // class ScalEngine
 
 
@@ -137,6 +137,13 @@ namespace TiledArray {
         return op_type(op_base_type(factor_), perm);
       }
 
+      /// Element operation factory function
+
+      /// \return The element-wise operation of this expression
+      TiledArray::detail::ElementScal<scalar_type> make_element_op() const {
+        return TiledArray::detail::ElementScal<scalar_type>{factor_};
+      }
+
       /// Expression identification tag
 
       /// \return An expression tag used to identify this expression
@@ -146,6 +153,13 @@ namespace TiledArray {
         return ss.str();
       }
 
+      /// Expression structure tag
+
+      /// \return A tag with the exact value of the scaling factor
+      std::string make_key_tag() const {
+        return "[" + exact_factor(factor_) + "] ";
+      }
+
     }; // class ScalTsrEngine
 
   }  // namespace expressions
@@ -28,6 +28,7 @@
 
 #include <TiledArray/expressions/expr_engine.h>
 #include <TiledArray/dist_eval/unary_eval.h>
+#include <TiledArray/tile_op/fused_reduction.h>
 
 namespace TiledArray {
   namespace expressions {
@@ -175,6 +176,32 @@ namespace TiledArray {
         return dist_eval_type(pimpl);
       }
 
+      /// Reduce the local tiles of this expression without evaluating them
+
+      /// The tile reduction is applied in the same loop over the argument
+      /// tiles as the element-wise operation of this expression, which is
+      /// constructed by \c Derived::make_element_op() , so the result tiles
+      /// are never stored.
+      /// \tparam Op The tile reduction type
+      /// \param op The tile reduction
+      /// \return The reduction of the local tiles of this expression
+      template <typename Op>
+      Future<typename Op::result_type> fused_reduce(const Op& op) const {
+        typedef TiledArray::detail::FusedUnaryReduction<Op,
+            decltype(derived().make_element_op())> kernel_type;
+
+        return TiledArray::detail::fused_reduce(op,
+            kernel_type(op, derived().make_element_op()),
+            arg_.make_dist_eval(), shape_);
+      }
+
+      /// Expression structure key
+
+      /// \return A key that identifies the structure of this expression
+      std::string make_key() const {
+        return ExprEngine_::make_key() + " (" + arg_.make_key() + ")";
+      }
+
       /// Expression print
 
       /// \param os The output stream
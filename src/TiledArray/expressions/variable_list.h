@@ -108,12 +108,18 @@ namespace TiledArray {
     /// Each variable is separated by commas. All spaces are ignored and removed
     /// from variable list. So, "a c" will be converted to "ac" and will be
     /// considered a single variable. All variables must be unique.
+    ///
+    /// The variables of the elements of a tensor of tensors follow the
+    /// variables of the outer tensor and are separated from them by a
+    /// semicolon, e.g. "i,j;a,b". The iterators, accessors, and permutation
+    /// functions of this object refer to the outer variables only; the inner
+    /// variables are accessed with \c inner() .
     class VariableList {
     public:
       typedef std::vector<std::string>::const_iterator const_iterator;
 
       /// Constructs an empty variable list.
-      VariableList() : vars_() { }
+      VariableList() : vars_(), inner_vars_() { }
 
       /// constructs a variable lists
       explicit VariableList(const std::string& vars) {
@@ -132,15 +138,28 @@ namespace TiledArray {
 
       }
 
-      VariableList(const VariableList& other) : vars_(other.vars_) { }
+      /// Construct a nested variable list
+
+      /// \param outer The outer variables
+      /// \param inner The variables of the inner tensors
+      VariableList(const VariableList& outer, const VariableList& inner) :
+        vars_(outer.vars_), inner_vars_(inner.vars_)
+      { }
+
+      VariableList(const VariableList& other) :
+        vars_(other.vars_), inner_vars_(other.inner_vars_)
+      { }
 
       VariableList& operator =(const VariableList& other) {
         vars_ = other.vars_;
+        inner_vars_ = other.inner_vars_;
 
         return *this;
       }
 
       VariableList& operator =(const std::string& vars) {
+        vars_.clear();
+        inner_vars_.clear();
         init_(vars);
         return *this;
       }
@@ -171,21 +190,30 @@ namespace TiledArray {
 
       const std::vector<std::string>& data() const { return vars_; }
 
-      std::string string() const {
-        std::string result;
-        std::vector<std::string>::const_iterator it = vars_.begin();
-        if(it == vars_.end())
-          return result;
+      /// Returns the number of variables of the inner tensors.
+      unsigned int inner_dim() const { return inner_vars_.size(); }
 
-        for(result = *it++; it != vars_.end(); ++it) {
-          result += "," + *it;
-        }
+      /// Returns the outer variables of a nested variable list.
+      VariableList outer() const {
+        return VariableList(vars_.begin(), vars_.end());
+      }
+
+      /// Returns the variables of the inner tensors.
+      VariableList inner() const {
+        return VariableList(inner_vars_.begin(), inner_vars_.end());
+      }
+
+      std::string string() const {
+        std::string result = join_(vars_);
+        if(! inner_vars_.empty())
+          result += ";" + join_(inner_vars_);
 
         return result;
       }
 
       void swap(VariableList& other) {
         std::swap(vars_, other.vars_);
+        std::swap(inner_vars_, other.inner_vars_);
       }
 
       /// Generate permutation relationship for variable lists
@@ -223,19 +251,45 @@ namespace TiledArray {
     private:
 
       /// Copies a comma separated list into a vector of strings. All spaces are
-      /// removed from the sub-strings.
+      /// removed from the sub-strings. The variables that follow a semicolon
+      /// are copied to the list of inner variables.
       void init_(const std::string& vars) {
-        std::string::const_iterator start = vars.begin();
-        std::string::const_iterator finish = vars.begin();
-        for(; finish != vars.end(); ++finish) {
+        const std::string::size_type semicolon = vars.find(';');
+        const std::string::const_iterator outer_end =
+            (semicolon == std::string::npos ? vars.end() : vars.begin() + semicolon);
+        split_(vars.begin(), outer_end, vars_);
+        if(outer_end != vars.end())
+          split_(outer_end + 1, vars.end(), inner_vars_);
+      }
+
+      /// Copies a comma separated list into a vector of strings.
+      static void split_(std::string::const_iterator start,
+          const std::string::const_iterator last, std::vector<std::string>& vars)
+      {
+        std::string::const_iterator finish = start;
+        for(; finish != last; ++finish) {
           if(*finish == ',') {
-            vars_.push_back(trim_spaces_(start, finish));
+            vars.push_back(trim_spaces_(start, finish));
             start = finish + 1;
           }
         }
-        vars_.push_back(trim_spaces_(start, finish));
+        vars.push_back(trim_spaces_(start, finish));
+
+        TA_ASSERT( (unique_(vars.begin(), vars.end())));
+      }
+
+      /// Returns a comma separated list of \c vars .
+      static std::string join_(const std::vector<std::string>& vars) {
+        std::string result;
+        std::vector<std::string>::const_iterator it = vars.begin();
+        if(it == vars.end())
+          return result;
+
+        for(result = *it++; it != vars.end(); ++it) {
+          result += "," + *it;
+        }
 
-        TA_ASSERT( (unique_(vars_.begin(), vars_.end())));
+        return result;
       }
 
       /// Returns a string with all the spaces ( ' ' ) removed from the string
@@ -256,7 +310,7 @@ namespace TiledArray {
 
       /// Returns true if all vars contained by the list are unique.
       template<typename InIter>
-      bool unique_(InIter first, InIter last) const {
+      static bool unique_(InIter first, InIter last) {
         for(; first != last; ++first) {
           InIter it2 = first;
           for(++it2; it2 != last; ++it2)
@@ -275,7 +329,8 @@ namespace TiledArray {
 
       friend void swap(VariableList&, VariableList&);
 
-      std::vector<std::string> vars_;
+      std::vector<std::string> vars_; ///< The outer variables
+      std::vector<std::string> inner_vars_; ///< The variables of the inner tensors
 
       friend VariableList operator*(const ::TiledArray::Permutation&, const VariableList&);
 
@@ -284,8 +339,13 @@ namespace TiledArray {
     /// Exchange the content of the two variable lists.
     inline void swap(VariableList& v0, VariableList& v1) {
       std::swap(v0.vars_, v1.vars_);
+      std::swap(v0.inner_vars_, v1.inner_vars_);
     }
 
+    /// Compare the outer variables of two variable lists
+
+    /// The variables of the inner tensors are not compared, since they are
+    /// not permuted with the outer variables.
     inline bool operator ==(const VariableList& v0, const VariableList& v1) {
       return (v0.dim() == v1.dim()) && std::equal(v0.begin(), v0.end(), v1.begin());
     }
@@ -298,6 +358,7 @@ namespace TiledArray {
       TA_ASSERT(p.dim() == v.dim());
       VariableList result;
       result.vars_ = p * v.vars_;
+      result.inner_vars_ = v.inner_vars_;
 
       return result;
     }
@@ -311,6 +372,8 @@ namespace TiledArray {
         out << v[d] << ", ";
       }
       out << v[d];
+      if(v.inner_dim() != 0u)
+        out << "; " << v.inner().string();
       out << ")";
       return out;
     }
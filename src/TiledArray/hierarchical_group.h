@@ -0,0 +1,409 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  hierarchical_group.h
+ *  Jun 14, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_HIERARCHICAL_GROUP_H__INCLUDED
+#define TILEDARRAY_HIERARCHICAL_GROUP_H__INCLUDED
+
+#include <TiledArray/madness.h>
+#include <TiledArray/error.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Map of processes to compute nodes
+
+    /// Processes on the same node are numbered by the order in which the nodes
+    /// first appear in the process list, so node 0 holds process 0.
+    class NodeMap {
+      std::vector<ProcessID> nodes_; ///< The node of each process
+      ProcessID node_count_; ///< The number of nodes
+
+      static madness::Spinlock& lock() {
+        static madness::Spinlock lock;
+        return lock;
+      }
+
+      /// The node maps of all worlds, indexed by world id
+      static std::map<unsigned long, std::shared_ptr<const NodeMap> >& maps() {
+        static std::map<unsigned long, std::shared_ptr<const NodeMap> > maps;
+        return maps;
+      }
+
+      /// Construct the node map of \c world
+
+      /// If the \c TA_RANKS_PER_NODE environment variable is set, consecutive
+      /// blocks of that many processes are placed on each node. Otherwise,
+      /// processes with the same host name are on the same node.
+      /// \note This function is collective over \c world , unless
+      /// \c TA_RANKS_PER_NODE is set.
+      static std::shared_ptr<const NodeMap> make(World& world) {
+        const char* ranks_per_node = getenv("TA_RANKS_PER_NODE");
+        if(ranks_per_node)
+          return std::make_shared<const NodeMap>(block(world.size(),
+              std::max<ProcessID>(std::atoi(ranks_per_node), 1)));
+
+        if(world.size() == 1)
+          return std::make_shared<const NodeMap>(block(1, 1));
+
+        // Gather a hash of the host name of each process
+        char host[256] = { '\0' };
+        gethostname(host, sizeof(host) - 1ul);
+        std::vector<unsigned long> hosts(world.size(), 0ul);
+        hosts[world.rank()] = std::hash<std::string>()(std::string(host));
+        world.gop.sum(hosts.data(), hosts.size());
+
+        return std::make_shared<const NodeMap>(
+            std::vector<ProcessID>(hosts.begin(), hosts.end()));
+      }
+
+    public:
+
+      /// Default constructor
+
+      /// Construct an empty node map
+      NodeMap() : nodes_(), node_count_(0) { }
+
+      /// Construct a node map from node labels
+
+      /// \tparam T The node label type
+      /// \param labels A label for the node of each process; processes with
+      /// equal labels are on the same node
+      template <typename T>
+      explicit NodeMap(const std::vector<T>& labels) :
+        nodes_(labels.size(), -1), node_count_(0)
+      {
+        for(std::size_t p = 0ul; p < labels.size(); ++p) {
+          if(nodes_[p] != -1) continue;
+          for(std::size_t q = p; q < labels.size(); ++q)
+            if(labels[q] == labels[p])
+              nodes_[q] = node_count_;
+          ++node_count_;
+        }
+      }
+
+      /// Construct a node map with consecutive processes on each node
+
+      /// \param size The number of processes
+      /// \param ranks_per_node The number of processes on each node
+      /// \return A node map where process \c p is on node
+      /// \c p/ranks_per_node
+      static NodeMap block(const ProcessID size, const ProcessID ranks_per_node) {
+        TA_ASSERT(size >= 0);
+        TA_ASSERT(ranks_per_node > 0);
+        std::vector<ProcessID> labels(size);
+        for(ProcessID p = 0; p < size; ++p)
+          labels[p] = p / ranks_per_node;
+        return NodeMap(labels);
+      }
+
+      /// Construct the node map of a world
+
+      /// This is called for the default world by \c TiledArray::initialize .
+      /// Other worlds use one node per process until it is called for them.
+      /// Nothing is done if the node map of \c world is already set.
+      /// \param world The world
+      /// \note This function is collective over \c world (see \c make() ).
+      static void setup(World& world) {
+        {
+          madness::ScopedMutex<madness::Spinlock> locker(& lock());
+          if(maps().find(world.id()) != maps().end())
+            return;
+        }
+
+        std::shared_ptr<const NodeMap> node_map = make(world);
+        madness::ScopedMutex<madness::Spinlock> locker(& lock());
+        maps().emplace(world.id(), node_map);
+      }
+
+      /// The node map of a world
+
+      /// This function does not communicate. When the node map of \c world
+      /// has not been set up (see \c setup() ), each process is on its own
+      /// node, so broadcasts are not hierarchical.
+      /// \param world The world
+      /// \return A shared pointer to the node map of \c world
+      static std::shared_ptr<const NodeMap> instance(World& world) {
+        {
+          madness::ScopedMutex<madness::Spinlock> locker(& lock());
+          auto it = maps().find(world.id());
+          if(it != maps().end())
+            return it->second;
+        }
+
+        return std::make_shared<const NodeMap>(block(world.size(), 1));
+      }
+
+      /// Set the node map of a world
+
+      /// This may be used to simulate node boundaries. It must be called on
+      /// all processes of \c world .
+      /// \param world The world
+      /// \param node_map The node map of \c world , or an empty pointer to
+      /// reset the node map
+      static void instance(World& world, const std::shared_ptr<const NodeMap>& node_map) {
+        TA_ASSERT(! node_map || (node_map->size() == world.size()));
+        madness::ScopedMutex<madness::Spinlock> locker(& lock());
+        if(node_map)
+          maps()[world.id()] = node_map;
+        else
+          maps().erase(world.id());
+      }
+
+      /// Process count accessor
+
+      /// \return The number of processes
+      ProcessID size() const { return nodes_.size(); }
+
+      /// Node count accessor
+
+      /// \return The number of nodes
+      ProcessID nodes() const { return node_count_; }
+
+      /// Node of a process
+
+      /// \param rank The process rank
+      /// \return The node of process \c rank
+      ProcessID node(const ProcessID rank) const {
+        TA_ASSERT(rank >= 0);
+        TA_ASSERT(rank < size());
+        return nodes_[rank];
+      }
+
+      /// Hierarchical query
+
+      /// \return \c true if there is more than one node, and at least one node
+      /// holds more than one process
+      bool is_hierarchical() const {
+        return (node_count_ > 1) && (node_count_ < size());
+      }
+
+    }; // class NodeMap
+
+
+    /// Two-level broadcast group
+
+    /// A broadcast through a \c madness::Group sends the data once to every
+    /// process in the group, so data that is sent to several processes on one
+    /// node crosses the network several times. \c HierarchicalGroup divides a
+    /// group into an inter-node group, which holds one leader process per
+    /// node, and intra-node groups, which hold the group members of each node.
+    /// The broadcast root is the leader of its node, and the leader of the
+    /// other nodes is the member with the lowest rank. Data is broadcast to
+    /// the leaders first, and then by each leader to the other members of its
+    /// node, so it crosses the network once per node.
+    ///
+    /// When a group has no more than one member on each node, or all members
+    /// are on one node, the broadcast uses the original group.
+    class HierarchicalGroup {
+    public:
+      typedef std::size_t size_type; ///< Size type
+
+    private:
+      madness::Group inter_; ///< Leader group, or the original group
+      madness::Group intra_; ///< Members on the node of this process
+      ProcessID inter_root_; ///< The root of \c inter_
+      ProcessID intra_root_; ///< The root of \c intra_
+      bool hierarchical_; ///< \c true if the broadcast has two levels
+      size_type saved_messages_; ///< Inter-node messages saved by each broadcast (root only)
+
+      static std::atomic<size_type>& saved_bytes_counter() {
+        static std::atomic<size_type> counter(0ul);
+        return counter;
+      }
+
+    public:
+
+      /// Partition the members of a group
+
+      /// \param[in] node_map The node of each process
+      /// \param[in] members The world ranks of the group members, in
+      /// increasing order
+      /// \param[in] root The world rank of the broadcast root
+      /// \param[in] rank The world rank of this process
+      /// \param[out] leaders The world ranks of the node leaders of the group,
+      /// in increasing order
+      /// \param[out] local The world ranks of the group members on the node of
+      /// \c rank , in increasing order
+      static void partition(const NodeMap& node_map,
+          const std::vector<ProcessID>& members, const ProcessID root,
+          const ProcessID rank, std::vector<ProcessID>& leaders,
+          std::vector<ProcessID>& local)
+      {
+        leaders.clear();
+        local.clear();
+        std::vector<bool> has_leader(node_map.nodes(), false);
+
+        // The root is the leader of its node
+        has_leader[node_map.node(root)] = true;
+
+        const ProcessID node = node_map.node(rank);
+        for(ProcessID p : members) {
+          const ProcessID p_node = node_map.node(p);
+          if(p == root) {
+            leaders.push_back(p);
+          } else if(! has_leader[p_node]) {
+            has_leader[p_node] = true;
+            leaders.push_back(p);
+          }
+          if(p_node == node)
+            local.push_back(p);
+        }
+      }
+
+      /// Default constructor
+
+      /// Construct an empty group
+      HierarchicalGroup() :
+        inter_(), intra_(), inter_root_(0), intra_root_(0), hierarchical_(false),
+        saved_messages_(0ul)
+      { }
+
+      /// Construct a two-level group
+
+      /// This constructor is called by all members of \c group with the same
+      /// arguments.
+      /// \param node_map The node of each process
+      /// \param group The broadcast group
+      /// \param group_root The root of the broadcast, in \c group
+      /// \param inter_did The distributed id of the leader group
+      /// \param intra_did The distributed id of the intra-node group of this
+      /// process; it must be different for each node
+      HierarchicalGroup(const NodeMap& node_map, const madness::Group& group,
+          const ProcessID group_root, const madness::DistributedID& inter_did,
+          const madness::DistributedID& intra_did) :
+        inter_(group), intra_(), inter_root_(group_root), intra_root_(0),
+        hierarchical_(false), saved_messages_(0ul)
+      {
+        TA_ASSERT(! group.empty());
+        TA_ASSERT(group_root < group.size());
+        if(! node_map.is_hierarchical())
+          return;
+
+        World& world = group.get_world();
+        std::vector<ProcessID> members(group.size());
+        for(ProcessID p = 0; p < group.size(); ++p)
+          members[p] = group.world_rank(p);
+        const ProcessID root = members[group_root];
+
+        std::vector<ProcessID> leaders, local;
+        partition(node_map, members, root, world.rank(), leaders, local);
+
+        // Use the original group when it would not save messages
+        if((leaders.size() == 1ul) || (leaders.size() == members.size()))
+          return;
+
+        // Messages to members on the same node as the root never leave the
+        // node; the other nodes receive one message each instead of one
+        // message per member.
+        if(world.rank() == root) {
+          const ProcessID root_node = node_map.node(root);
+          const size_type remote_members = std::count_if(members.begin(),
+              members.end(), [&](const ProcessID p)
+              { return node_map.node(p) != root_node; });
+          saved_messages_ = remote_members - (leaders.size() - 1ul);
+        }
+
+        // Construct the leader group, if this process is a leader
+        hierarchical_ = true;
+        const ProcessID leader =
+            (node_map.node(root) == node_map.node(world.rank()) ? root : local.front());
+        if(leader == world.rank()) {
+          inter_ = madness::Group(world, leaders, inter_did);
+          inter_root_ = std::find(leaders.begin(), leaders.end(), root) - leaders.begin();
+        } else {
+          inter_ = madness::Group();
+          inter_root_ = 0;
+        }
+
+        // Construct the intra-node group
+        if(local.size() > 1ul) {
+          intra_ = madness::Group(world, local, intra_did);
+          intra_root_ = std::find(local.begin(), local.end(), leader) - local.begin();
+        }
+      }
+
+      /// Hierarchical query
+
+      /// \return \c true if broadcasts use a leader group and intra-node
+      /// groups, \c false if they use the original group
+      bool is_hierarchical() const { return hierarchical_; }
+
+      /// Leader group accessor
+
+      /// \return The leader group, the original group, or an empty group if
+      /// this process is not a leader
+      const madness::Group& inter_group() const { return inter_; }
+
+      /// Intra-node group accessor
+
+      /// \return The group members on the node of this process, or an empty
+      /// group if there are no other members on this node
+      const madness::Group& intra_group() const { return intra_; }
+
+      /// Broadcast a value
+
+      /// \tparam T The value type
+      /// \param key The key of the broadcast in the leader group
+      /// \param intra_key The key of the broadcast in the intra-node group
+      /// \param[in,out] value The value, which is set on all group members
+      /// \param bytes The size of the value, which is used to count the bytes
+      /// saved by the two-level broadcast
+      template <typename T>
+      void bcast(const madness::DistributedID& key,
+          const madness::DistributedID& intra_key, Future<T>& value,
+          const size_type bytes) const
+      {
+        if(! inter_.empty() && (inter_.size() > 1))
+          inter_.get_world().gop.bcast(key, value, inter_root_, inter_);
+        if(! intra_.empty())
+          intra_.get_world().gop.bcast(intra_key, value, intra_root_, intra_);
+        if(saved_messages_ != 0ul)
+          saved_bytes_counter() += saved_messages_ * bytes;
+      }
+
+      /// Saved bytes accessor
+
+      /// \return The estimated number of bytes that were not sent between
+      /// nodes by the broadcasts rooted at this process
+      static size_type saved_bytes() { return saved_bytes_counter(); }
+
+      /// Reset the saved bytes counter
+      static void reset_saved_bytes() { saved_bytes_counter() = 0ul; }
+
+    }; // class HierarchicalGroup
+
+    /// Construct the node map of \c world (see \c NodeMap::setup )
+    inline void setup_node_map(World& world) { NodeMap::setup(world); }
+
+  } // namespace detail
+} // namespace TiledArray
+
+#endif // TILEDARRAY_HIERARCHICAL_GROUP_H__INCLUDED
@@ -0,0 +1,421 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  checkpoint.h
+ *  Jun 20, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_IO_CHECKPOINT_H__INCLUDED
+#define TILEDARRAY_IO_CHECKPOINT_H__INCLUDED
+
+#include <TiledArray/dense_shape.h>
+#include <TiledArray/sparse_shape.h>
+#include <TiledArray/tensor.h>
+#include <TiledArray/tiled_range.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TiledArray {
+
+  // Forward declarations
+  template <typename, typename> class DistArray;
+
+  namespace detail {
+
+    /// Checkpoint file format constants
+    struct CheckpointFormat {
+      static constexpr const char* magic = "TACHKPT"; ///< Header file signature (with the terminating null, 8 bytes)
+      static constexpr std::uint64_t version = 1ul; ///< Format version
+      static constexpr std::uint64_t alignment = 64ul; ///< Alignment of tile data in data files
+
+      /// Data file name
+
+      /// \param path The checkpoint path
+      /// \param rank The rank of the process that wrote the data file
+      /// \return The path of the data file of \c rank
+      static std::string data_file(const std::string& path, const std::uint64_t rank) {
+        return path + "." + std::to_string(rank);
+      }
+    }; // struct CheckpointFormat
+
+    /// Read-only, copy-on-write memory map of a checkpoint data file
+
+    /// Pages of the file are loaded on demand. Modifications of the mapped
+    /// memory are private to this process and are not written to the file.
+    class MappedFile {
+      char* data_; ///< The mapped file data
+      std::size_t size_; ///< The size of the file in bytes
+
+    public:
+      /// Map a file
+
+      /// \param path The path of the file
+      /// \throw TiledArray::Exception When the file cannot be mapped
+      explicit MappedFile(const std::string& path) : data_(nullptr), size_(0ul) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+          TA_EXCEPTION("Unable to open checkpoint data file");
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0) {
+          ::close(fd);
+          TA_EXCEPTION("Unable to stat checkpoint data file");
+        }
+        size_ = st.st_size;
+
+        if(size_ > 0ul) {
+          void* const data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE, fd, 0);
+          if(data == MAP_FAILED) {
+            ::close(fd);
+            TA_EXCEPTION("Unable to map checkpoint data file");
+          }
+          data_ = static_cast<char*>(data);
+        }
+        ::close(fd);
+      }
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      ~MappedFile() {
+        if(data_)
+          ::munmap(data_, size_);
+      }
+
+      /// Mapped data accessor
+
+      /// \return A pointer to the first byte of the file
+      char* data() const { return data_; }
+
+      /// File size accessor
+
+      /// \return The size of the file in bytes
+      std::size_t size() const { return size_; }
+    }; // class MappedFile
+
+    /// Write a value to a checkpoint file
+
+    /// \tparam T The value type
+    /// \param os The output stream
+    /// \param value The value to be written
+    template <typename T>
+    inline void checkpoint_write(std::ostream& os, const T& value) {
+      os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /// Write a string to a checkpoint file
+
+    /// \param os The output stream
+    /// \param str The string to be written
+    inline void checkpoint_write(std::ostream& os, const std::string& str) {
+      checkpoint_write(os, std::uint64_t(str.size()));
+      os.write(str.data(), str.size());
+    }
+
+    /// Read a value from a checkpoint file
+
+    /// \tparam T The value type
+    /// \param is The input stream
+    /// \return The value that was read
+    /// \throw TiledArray::Exception When the file is truncated
+    template <typename T>
+    inline T checkpoint_read(std::istream& is) {
+      T value;
+      is.read(reinterpret_cast<char*>(&value), sizeof(T));
+      if(! is)
+        TA_EXCEPTION("Checkpoint header file is truncated");
+      return value;
+    }
+
+    /// Read a string from a checkpoint file
+
+    /// \param is The input stream
+    /// \return The string that was read
+    inline std::string checkpoint_read_string(std::istream& is) {
+      std::string str(checkpoint_read<std::uint64_t>(is), '\0');
+      is.read(&str[0], str.size());
+      if(! is)
+        TA_EXCEPTION("Checkpoint header file is truncated");
+      return str;
+    }
+
+    /// Write the norms of a dense shape
+
+    /// Dense shapes have no norms, so only the shape kind is written.
+    /// \param os The output stream
+    inline void checkpoint_write_shape(std::ostream& os, const DenseShape&) {
+      checkpoint_write(os, std::uint64_t(0));
+    }
+
+    /// Write the norms of a sparse shape
+
+    /// \tparam T The norm type
+    /// \param os The output stream
+    /// \param shape The shape to be written
+    template <typename T>
+    inline void checkpoint_write_shape(std::ostream& os, const SparseShape<T>& shape) {
+      checkpoint_write(os, std::uint64_t(shape.is_compressed() ? 2 : 1));
+      const Tensor<T> norms =
+          (shape.is_compressed() ? shape.decompress().data() : shape.data());
+      for(const T norm : norms)
+        checkpoint_write(os, double(norm));
+    }
+
+    /// Read a dense shape
+
+    /// \param is The input stream
+    /// \param kind The shape kind
+    /// \return The shape
+    inline DenseShape checkpoint_read_shape(std::istream&, const std::uint64_t kind,
+        const TiledRange&, DenseShape*)
+    {
+      if(kind != 0ul)
+        TA_EXCEPTION("Checkpoint holds a sparse array");
+      return DenseShape();
+    }
+
+    /// Read a sparse shape
+
+    /// \tparam T The norm type
+    /// \param is The input stream
+    /// \param kind The shape kind
+    /// \param trange The tiled range of the array
+    /// \return The shape
+    template <typename T>
+    inline SparseShape<T> checkpoint_read_shape(std::istream& is,
+        const std::uint64_t kind, const TiledRange& trange, SparseShape<T>*)
+    {
+      if(kind == 0ul)
+        TA_EXCEPTION("Checkpoint holds a dense array");
+
+      // The stored norms are per element, and the shape constructor expects
+      // the norms of the tiles.
+      Tensor<T> norms(trange.tiles_range());
+      for(std::size_t i = 0ul; i < norms.size(); ++i)
+        norms[i] = checkpoint_read<double>(is) *
+            double(trange.make_tile_range(i).volume());
+      return SparseShape<T>(norms, trange, kind == 2ul);
+    }
+
+  }  // namespace detail
+
+  /// Write an array checkpoint
+
+  /// Each process writes its local tiles to the data file
+  /// <tt>path.<rank></tt>, and process 0 writes the header file \c path ,
+  /// which holds the tiled range, the shape, and the location of each tile.
+  /// The files must be on a file system that is shared by all processes if
+  /// the checkpoint is read by a different set of processes. This function
+  /// must be called by all processes in the world of \c array .
+  /// \tparam T The tensor element type, which must be trivially copyable
+  /// \tparam A The tensor allocator type
+  /// \tparam Policy The array policy type
+  /// \param array The array to be written
+  /// \param path The path of the checkpoint header file
+  /// \throw TiledArray::Exception When a file cannot be written
+  template <typename T, typename A, typename Policy>
+  inline void write_checkpoint(const DistArray<Tensor<T, A>, Policy>& array,
+      const std::string& path)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "Checkpoints require trivially copyable tensor elements");
+    typedef detail::CheckpointFormat format;
+
+    World& world = array.world();
+    const TiledRange& trange = array.trange();
+    const std::size_t volume = trange.tiles_range().volume();
+
+    // Write the local tiles. The file of each tile is stored as rank + 1, so
+    // zero tiles have a file index of 0.
+    std::vector<std::uint64_t> files(volume, 0ul), offsets(volume, 0ul);
+    {
+      std::ofstream os(format::data_file(path, world.rank()),
+          std::ios::binary | std::ios::trunc);
+      if(! os)
+        TA_EXCEPTION("Unable to open checkpoint data file");
+
+      const char padding[format::alignment] = { };
+      std::uint64_t offset = 0ul;
+      for(const std::size_t index : *array.pmap()) {
+        if(array.is_zero(index))
+          continue;
+
+        const Tensor<T, A> tile = array.find(index).get();
+        TA_ASSERT(tile.range().volume() == trange.make_tile_range(index).volume());
+
+        const std::uint64_t pad = (format::alignment - offset % format::alignment)
+            % format::alignment;
+        os.write(padding, pad);
+        offset += pad;
+
+        files[index] = world.rank() + 1ul;
+        offsets[index] = offset;
+        const std::uint64_t bytes = tile.size() * sizeof(T);
+        os.write(reinterpret_cast<const char*>(tile.data()), bytes);
+        offset += bytes;
+      }
+
+      os.flush();
+      if(! os)
+        TA_EXCEPTION("Unable to write checkpoint data file");
+    }
+
+    // Collect the tile locations
+    world.gop.sum(files.data(), volume);
+    world.gop.sum(offsets.data(), volume);
+
+    if(world.rank() == 0) {
+      std::ofstream os(path, std::ios::binary | std::ios::trunc);
+      if(! os)
+        TA_EXCEPTION("Unable to open checkpoint header file");
+
+      os.write(format::magic, 8);
+      detail::checkpoint_write(os, format::version);
+      detail::checkpoint_write(os, std::uint64_t(sizeof(T)));
+      detail::checkpoint_write(os, std::string(typeid(T).name()));
+      detail::checkpoint_write(os, std::uint64_t(world.size()));
+
+      // Tiled range
+      detail::checkpoint_write(os, std::uint64_t(trange.rank()));
+      for(const TiledRange1& tr1 : trange.data()) {
+        detail::checkpoint_write(os, std::uint64_t(tr1.tiles_range().second -
+            tr1.tiles_range().first + 1ul));
+        detail::checkpoint_write(os, std::uint64_t(tr1.tile(
+            tr1.tiles_range().first).first));
+        for(const auto& tile : tr1)
+          detail::checkpoint_write(os, std::uint64_t(tile.second));
+      }
+
+      // Shape and tile index
+      detail::checkpoint_write_shape(os, array.shape());
+      for(std::size_t i = 0ul; i < volume; ++i) {
+        detail::checkpoint_write(os, files[i]);
+        detail::checkpoint_write(os, offsets[i]);
+      }
+
+      os.flush();
+      if(! os)
+        TA_EXCEPTION("Unable to write checkpoint header file");
+    }
+
+    world.gop.fence();
+  }
+
+  /// Read an array checkpoint
+
+  /// The checkpoint may be read by a different number of processes, and with
+  /// a different process map, than it was written with. The tiles of the
+  /// array reference memory mapped data files, so they are not copied when
+  /// the checkpoint is read and are loaded on demand. Tiles may be modified
+  /// in place without modifying the checkpoint. This function must be called
+  /// by all processes in \c world .
+  /// \tparam Array The array type, which must have \c Tensor tiles
+  /// \param world The world where the array will live
+  /// \param path The path of the checkpoint header file
+  /// \param pmap The process map of the array [ default = the default
+  /// process map of \c Array ]
+  /// \return The array
+  /// \throw TiledArray::Exception When the checkpoint cannot be read, or it
+  /// does not hold an array of type \c Array
+  template <typename Array>
+  inline Array read_checkpoint(World& world, const std::string& path,
+      const std::shared_ptr<typename Array::pmap_interface>& pmap =
+          std::shared_ptr<typename Array::pmap_interface>())
+  {
+    typedef typename Array::value_type value_type;
+    typedef typename value_type::value_type element_type;
+    typedef typename Array::shape_type shape_type;
+    typedef detail::CheckpointFormat format;
+
+    std::ifstream is(path, std::ios::binary);
+    if(! is)
+      TA_EXCEPTION("Unable to open checkpoint header file");
+
+    char magic[8];
+    is.read(magic, 8);
+    if((! is) || std::memcmp(magic, format::magic, 8) != 0)
+      TA_EXCEPTION("Invalid checkpoint header file");
+    if(detail::checkpoint_read<std::uint64_t>(is) != format::version)
+      TA_EXCEPTION("Unsupported checkpoint format version");
+    if((detail::checkpoint_read<std::uint64_t>(is) != sizeof(element_type)) ||
+        (detail::checkpoint_read_string(is) != typeid(element_type).name()))
+      TA_EXCEPTION("Checkpoint element type does not match the array element type");
+    const std::uint64_t nfiles = detail::checkpoint_read<std::uint64_t>(is);
+
+    // Tiled range
+    std::vector<TiledRange1> ranges(detail::checkpoint_read<std::uint64_t>(is));
+    for(TiledRange1& tr1 : ranges) {
+      std::vector<std::size_t> boundaries(detail::checkpoint_read<std::uint64_t>(is));
+      for(std::size_t& boundary : boundaries)
+        boundary = detail::checkpoint_read<std::uint64_t>(is);
+      tr1 = TiledRange1(boundaries.begin(), boundaries.end());
+    }
+    const TiledRange trange(ranges.begin(), ranges.end());
+
+    // Shape
+    const std::uint64_t kind = detail::checkpoint_read<std::uint64_t>(is);
+    const shape_type shape = detail::checkpoint_read_shape(is, kind, trange,
+        static_cast<shape_type*>(nullptr));
+
+    // Tile index
+    const std::size_t volume = trange.tiles_range().volume();
+    std::vector<std::uint64_t> files(volume), offsets(volume);
+    for(std::size_t i = 0ul; i < volume; ++i) {
+      files[i] = detail::checkpoint_read<std::uint64_t>(is);
+      offsets[i] = detail::checkpoint_read<std::uint64_t>(is);
+    }
+
+    Array array(world, trange, shape, pmap);
+
+    // Map the data files that hold local tiles, and set the local tiles.
+    std::vector<std::shared_ptr<detail::MappedFile> > mapped(nfiles);
+    for(const std::size_t index : *array.pmap()) {
+      if(array.is_zero(index))
+        continue;
+      if((files[index] == 0ul) || (files[index] > nfiles))
+        TA_EXCEPTION("Checkpoint does not hold a non-zero tile");
+
+      std::shared_ptr<detail::MappedFile>& file = mapped[files[index] - 1ul];
+      if(! file)
+        file = std::make_shared<detail::MappedFile>(
+            format::data_file(path, files[index] - 1ul));
+
+      const Range range = trange.make_tile_range(index);
+      if(offsets[index] + range.volume() * sizeof(element_type) > file->size())
+        TA_EXCEPTION("Checkpoint data file is truncated");
+
+      array.set(index, value_type(range,
+          reinterpret_cast<element_type*>(file->data() + offsets[index]),
+          file));
+    }
+
+    return array;
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_IO_CHECKPOINT_H__INCLUDED
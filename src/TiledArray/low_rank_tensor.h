@@ -0,0 +1,1121 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  low_rank_tensor.h
+ *  Jul 9, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_LOW_RANK_TENSOR_H__INCLUDED
+#define TILEDARRAY_LOW_RANK_TENSOR_H__INCLUDED
+
+#include <TiledArray/tensor.h>
+#include <TiledArray/math/eigen.h>
+#include <TiledArray/math/gemm_helper.h>
+#include <numeric>
+
+namespace TiledArray {
+
+  /// Low-rank tile
+
+  /// A low-rank tile stores the matricization of a tensor in factored form,
+  /// \f$ A = U V^T \f$ , where the rows of \f$ A \f$ are indexed by the first
+  /// \c split() dimensions of the tile range and the columns by the remaining
+  /// dimensions. For a tile with numerical rank \f$ r \f$ , the factors hold
+  /// \f$ r (m + n) \f$ elements instead of \f$ m n \f$ , and contractions cost
+  /// \f$ O(r(mk + kn + mn)) \f$ or less instead of \f$ O(mnk) \f$ .
+  ///
+  /// The factors are recompressed after every operation that increases the
+  /// rank (addition, contraction, and element-wise multiplication): the
+  /// smallest singular values are discarded as long as the Frobenius norm of
+  /// the discarded part does not exceed \c tolerance() . The tolerance of a
+  /// result is the largest tolerance of its arguments. Operations that need
+  /// a different matricization than that of an argument (e.g. a contraction
+  /// over the leading dimensions, or a permutation that mixes the row and
+  /// column dimensions) factorize the dense argument again.
+  ///
+  /// \c LowRankTensor implements the intrusive tile interface, so it may be
+  /// used as the tile type of \c DistArray with either policy. Copies are
+  /// shallow; the factors of a tile are never modified, so in-place
+  /// operations replace the factors of the modified object only.
+  /// \tparam T The element type
+  template <typename T>
+  class LowRankTensor {
+    static_assert(std::is_floating_point<T>::value,
+        "LowRankTensor<T>: T must be a real floating point type.");
+  public:
+    typedef LowRankTensor<T> LowRankTensor_; ///< This class type
+    typedef Range range_type; ///< Tensor range type
+    typedef typename range_type::size_type size_type; ///< Size type
+    typedef T value_type; ///< Element type
+    typedef T numeric_type; ///< The scalar type used in arithmetic
+    typedef T scalar_type; ///< The scalar type of norms
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+        matrix_type; ///< Factor matrix type
+    typedef Tensor<T> dense_type; ///< The dense tensor type
+
+  private:
+
+    struct Impl {
+      range_type range_; ///< The tile range
+      unsigned int split_; ///< The number of row dimensions
+      matrix_type u_; ///< The row factor
+      matrix_type v_; ///< The column factor
+      double tolerance_; ///< The truncation tolerance
+    }; // struct Impl
+
+    std::shared_ptr<const Impl> pimpl_; ///< The tile data
+
+    /// Number of rows of the matricization
+
+    /// \param range The tile range
+    /// \param split The number of row dimensions
+    /// \return The product of the extents of the first \c split dimensions
+    static size_type rows(const range_type& range, const unsigned int split) {
+      return std::accumulate(range.extent_data(), range.extent_data() + split,
+          size_type(1), std::multiplies<size_type>());
+    }
+
+    /// Number of columns of the matricization
+
+    /// \param range The tile range
+    /// \param split The number of row dimensions
+    /// \return The product of the extents of the last dimensions
+    static size_type cols(const range_type& range, const unsigned int split) {
+      return std::accumulate(range.extent_data() + split,
+          range.extent_data() + range.rank(), size_type(1),
+          std::multiplies<size_type>());
+    }
+
+    /// Number of singular values to keep
+
+    /// \param s The singular values, in decreasing order
+    /// \param tolerance The largest Frobenius norm of the discarded values
+    /// \param scale An upper bound of the norm of the factored matrix times
+    /// its largest dimension, which determines the numerical zero
+    /// \return The truncated rank
+    template <typename Vector>
+    static Eigen::Index truncated_rank(const Vector& s, const double tolerance,
+        const double scale)
+    {
+      Eigen::Index k = s.size();
+
+      // Always discard singular values that are numerically zero
+      const double threshold = std::max(tolerance,
+          double(std::numeric_limits<T>::epsilon()) * scale);
+      double tail = 0.0;
+      while(k > 0) {
+        const double next = tail + double(s[k - 1]) * double(s[k - 1]);
+        if(next > threshold * threshold)
+          break;
+        tail = next;
+        --k;
+      }
+      return k;
+    }
+
+    /// Recompress factors
+
+    /// The factors are orthogonalized with QR decompositions and the product
+    /// of the triangular factors is truncated with an SVD.
+    /// \param[in,out] u The row factor
+    /// \param[in,out] v The column factor
+    /// \param tolerance The truncation tolerance
+    static void recompress(matrix_type& u, matrix_type& v, const double tolerance) {
+      TA_ASSERT(u.cols() == v.cols());
+      const Eigen::Index r = u.cols();
+      if(r == 0)
+        return;
+
+      const Eigen::HouseholderQR<matrix_type> qru(u), qrv(v);
+      const Eigen::Index ku = std::min(u.rows(), r);
+      const Eigen::Index kv = std::min(v.rows(), r);
+      const matrix_type ru = qru.matrixQR().topRows(ku).template
+          triangularView<Eigen::Upper>();
+      const matrix_type rv = qrv.matrixQR().topRows(kv).template
+          triangularView<Eigen::Upper>();
+      const Eigen::BDCSVD<matrix_type> svd(ru * rv.transpose(),
+          Eigen::ComputeThinU | Eigen::ComputeThinV);
+      const Eigen::Index k = truncated_rank(svd.singularValues(), tolerance,
+          double(ru.norm() * rv.norm()) * double(std::max(u.rows(), v.rows())));
+
+      const matrix_type qu = qru.householderQ() * matrix_type::Identity(u.rows(), ku);
+      const matrix_type qv = qrv.householderQ() * matrix_type::Identity(v.rows(), kv);
+      u = qu * (svd.matrixU().leftCols(k) *
+          svd.singularValues().head(k).asDiagonal());
+      v = qv * svd.matrixV().leftCols(k);
+    }
+
+    /// Permute the rows of a factor
+
+    /// Each row of \c x is an element of a tensor with extents \c extent ,
+    /// which is moved to its position in the permuted tensor.
+    /// \param x The factor
+    /// \param extent The extents of the row dimensions
+    /// \param perm The permutation of the row dimensions
+    /// \return The factor with permuted rows
+    static matrix_type permute_rows(const matrix_type& x,
+        const size_type* const extent, const std::vector<unsigned int>& perm)
+    {
+      const unsigned int n = perm.size();
+      std::vector<size_type> result_extent(n), result_stride(n), stride(n);
+      for(unsigned int i = 0u; i < n; ++i)
+        result_extent[perm[i]] = extent[i];
+      size_type volume = 1ul;
+      for(unsigned int i = n; i > 0u; --i) {
+        result_stride[i - 1u] = volume;
+        volume *= result_extent[i - 1u];
+      }
+      for(unsigned int i = 0u; i < n; ++i)
+        stride[i] = result_stride[perm[i]];
+
+      matrix_type result(x.rows(), x.cols());
+      for(Eigen::Index row = 0; row < x.rows(); ++row) {
+        size_type index = row, target = 0ul;
+        for(unsigned int i = n; i > 0u; --i) {
+          target += (index % extent[i - 1u]) * stride[i - 1u];
+          index /= extent[i - 1u];
+        }
+        result.row(target) = x.row(row);
+      }
+      return result;
+    }
+
+    /// Construct a tile from its parts
+
+    /// \param range The tile range
+    /// \param split The number of row dimensions
+    /// \param u The row factor
+    /// \param v The column factor
+    /// \param tolerance The truncation tolerance
+    /// \param truncate Recompress the factors when \c true
+    LowRankTensor(const range_type& range, const unsigned int split,
+        matrix_type&& u, matrix_type&& v, const double tolerance,
+        const bool truncate) :
+      pimpl_()
+    {
+      TA_ASSERT(split <= range.rank());
+      TA_ASSERT(size_type(u.rows()) == rows(range, split));
+      TA_ASSERT(size_type(v.rows()) == cols(range, split));
+      TA_ASSERT(u.cols() == v.cols());
+      if(truncate)
+        recompress(u, v, tolerance);
+      pimpl_ = std::make_shared<const Impl>(Impl{ range, split, std::move(u),
+          std::move(v), tolerance });
+    }
+
+    /// Linear combination of tiles
+
+    /// \param left The left-hand tile
+    /// \param left_factor The left-hand scaling factor
+    /// \param right The right-hand tile
+    /// \param right_factor The right-hand scaling factor
+    /// \return <tt>left * left_factor + right * right_factor</tt> , with the
+    /// matricization of \c left
+    static LowRankTensor_ combine(const LowRankTensor_& left,
+        const numeric_type left_factor, const LowRankTensor_& right,
+        const numeric_type right_factor)
+    {
+      TA_ASSERT(! left.empty());
+      TA_ASSERT(! right.empty());
+      TA_ASSERT(left.range() == right.range());
+      const LowRankTensor_ arg = right.resplit(left.split());
+      const Eigen::Index rl = left.rank(), rr = arg.rank();
+
+      matrix_type u(left.u().rows(), rl + rr), v(left.v().rows(), rl + rr);
+      u.leftCols(rl) = left.u() * left_factor;
+      u.rightCols(rr) = arg.u() * right_factor;
+      v.leftCols(rl) = left.v();
+      v.rightCols(rr) = arg.v();
+      return LowRankTensor_(left.range(), left.split(), std::move(u),
+          std::move(v), std::max(left.tolerance(), right.tolerance()), true);
+    }
+
+    /// Add a constant to a tile
+
+    /// A constant tensor has rank one, so the result rank increases by at
+    /// most one.
+    /// \param arg The tile
+    /// \param value The constant
+    /// \return <tt>arg + value</tt>
+    static LowRankTensor_ combine(const LowRankTensor_& arg,
+        const numeric_type value)
+    {
+      TA_ASSERT(! arg.empty());
+      const Eigen::Index r = arg.rank();
+      matrix_type u(arg.u().rows(), r + 1), v(arg.v().rows(), r + 1);
+      u.leftCols(r) = arg.u();
+      u.col(r).setConstant(value);
+      v.leftCols(r) = arg.v();
+      v.col(r).setOnes();
+      return LowRankTensor_(arg.range(), arg.split(), std::move(u),
+          std::move(v), arg.tolerance(), true);
+    }
+
+    /// Element-wise product of tiles
+
+    /// The rows of the factors of the product are the Kronecker products of
+    /// the corresponding rows of the argument factors.
+    /// \param left The left-hand tile
+    /// \param right The right-hand tile
+    /// \param factor The scaling factor
+    /// \return <tt>(left * right) * factor</tt>
+    static LowRankTensor_ hadamard(const LowRankTensor_& left,
+        const LowRankTensor_& right, const numeric_type factor)
+    {
+      TA_ASSERT(! left.empty());
+      TA_ASSERT(! right.empty());
+      TA_ASSERT(left.range() == right.range());
+      const LowRankTensor_ arg = right.resplit(left.split());
+      const Eigen::Index rl = left.rank(), rr = arg.rank();
+
+      matrix_type u(left.u().rows(), rl * rr), v(left.v().rows(), rl * rr);
+      for(Eigen::Index a = 0; a < rl; ++a) {
+        for(Eigen::Index b = 0; b < rr; ++b) {
+          u.col(a * rr + b) = left.u().col(a).cwiseProduct(arg.u().col(b)) * factor;
+          v.col(a * rr + b) = left.v().col(a).cwiseProduct(arg.v().col(b));
+        }
+      }
+      return LowRankTensor_(left.range(), left.split(), std::move(u),
+          std::move(v), std::max(left.tolerance(), right.tolerance()), true);
+    }
+
+    /// Contract the factors of two tiles
+
+    /// \param left The left-hand tile
+    /// \param right The right-hand tile
+    /// \param factor The scaling factor
+    /// \param gemm_helper The *GEMM operation meta data
+    /// \param[out] u The row factor of the product
+    /// \param[out] v The column factor of the product
+    static void gemm_factors(const LowRankTensor_& left,
+        const LowRankTensor_& right, const numeric_type factor,
+        const math::GemmHelper& gemm_helper, matrix_type& u, matrix_type& v)
+    {
+      // Matricize the arguments as required by the GEMM operation
+      const bool left_notrans = (gemm_helper.left_op() == madness::cblas::NoTrans);
+      const bool right_notrans = (gemm_helper.right_op() == madness::cblas::NoTrans);
+      const LowRankTensor_ l = left.resplit(left_notrans ?
+          gemm_helper.left_outer_end() : gemm_helper.left_inner_end());
+      const LowRankTensor_ r = right.resplit(right_notrans ?
+          gemm_helper.right_inner_end() : gemm_helper.right_outer_end());
+
+      // op(left) = ua * va^T and op(right) = ub * vb^T
+      const matrix_type& ua = (left_notrans ? l.u() : l.v());
+      const matrix_type& va = (left_notrans ? l.v() : l.u());
+      const matrix_type& ub = (right_notrans ? r.u() : r.v());
+      const matrix_type& vb = (right_notrans ? r.v() : r.u());
+      TA_ASSERT(va.rows() == ub.rows());
+
+      // Fold the small core matrix into the factor with the smaller rank
+      const matrix_type w = va.transpose() * ub;
+      if(w.rows() <= w.cols()) {
+        u = ua * factor;
+        v = vb * w.transpose();
+      } else {
+        u = (ua * w) * factor;
+        v = vb;
+      }
+    }
+
+  public:
+
+    // Constructors and destructor ---------------------------------------------
+
+    /// Construct an empty tile
+    LowRankTensor() : pimpl_() { }
+
+    LowRankTensor(const LowRankTensor_&) = default;
+    LowRankTensor(LowRankTensor_&&) = default;
+    LowRankTensor_& operator=(const LowRankTensor_&) = default;
+    LowRankTensor_& operator=(LowRankTensor_&&) = default;
+    ~LowRankTensor() = default;
+
+    /// Construct a tile from factors
+
+    /// \param range The tile range
+    /// \param split The number of row dimensions
+    /// \param u The row factor
+    /// \param v The column factor
+    /// \param tolerance The truncation tolerance
+    /// \throw TiledArray::Exception When the factor dimensions do not match
+    /// \c range and \c split
+    LowRankTensor(const range_type& range, const unsigned int split,
+        matrix_type u, matrix_type v, const double tolerance = 0.0) :
+      LowRankTensor(range, split, std::move(u), std::move(v), tolerance, true)
+    { }
+
+    /// Construct a constant tile
+
+    /// \param range The tile range
+    /// \param value The value of all elements
+    LowRankTensor(const range_type& range, const numeric_type value) :
+      LowRankTensor(range, range.rank() / 2u,
+          matrix_type(matrix_type::Constant(rows(range, range.rank() / 2u), 1, value)),
+          matrix_type(matrix_type::Ones(cols(range, range.rank() / 2u), 1)), 0.0,
+          true)
+    { }
+
+    /// Factor a dense tile
+
+    /// The matricization of \c tensor is factored with a truncated SVD.
+    /// \param tensor The dense tile
+    /// \param tolerance The truncation tolerance
+    /// \param split The number of row dimensions
+    LowRankTensor(const dense_type& tensor, const double tolerance,
+        const unsigned int split) :
+      pimpl_()
+    {
+      TA_ASSERT(! tensor.empty());
+      TA_ASSERT(split <= tensor.range().rank());
+      const size_type m = rows(tensor.range(), split);
+      const size_type n = cols(tensor.range(), split);
+      const Eigen::BDCSVD<matrix_type> svd(math::eigen_map(tensor.data(), m, n),
+          Eigen::ComputeThinU | Eigen::ComputeThinV);
+      const Eigen::Index k = truncated_rank(svd.singularValues(), tolerance,
+          (svd.singularValues().size() ? double(svd.singularValues()[0]) : 0.0) *
+          double(std::max(m, n)));
+      pimpl_ = std::make_shared<const Impl>(Impl{ tensor.range(), split,
+          svd.matrixU().leftCols(k) * svd.singularValues().head(k).asDiagonal(),
+          svd.matrixV().leftCols(k), tolerance });
+    }
+
+    /// Factor a dense tile
+
+    /// The first half of the dimensions of \c tensor index the rows of the
+    /// matricization.
+    /// \param tensor The dense tile
+    /// \param tolerance The truncation tolerance
+    explicit LowRankTensor(const dense_type& tensor, const double tolerance = 0.0) :
+      LowRankTensor(tensor, tolerance, tensor.range().rank() / 2u)
+    { }
+
+    /// Copy this tile
+
+    /// The factors are never modified, so the copy shares them with this tile.
+    /// \return A copy of this tile
+    LowRankTensor_ clone() const { return *this; }
+
+    // Accessors ---------------------------------------------------------------
+
+    /// Tile range accessor
+
+    /// \return The tile range
+    const range_type& range() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->range_;
+    }
+
+    /// Tile size accessor
+
+    /// \return The number of elements of the tile
+    size_type size() const { return (pimpl_ ? pimpl_->range_.volume() : 0ul); }
+
+    /// Check for an empty tile
+
+    /// \return \c true if this tile was default constructed
+    bool empty() const { return ! pimpl_; }
+
+    /// Matricization accessor
+
+    /// \return The number of dimensions that index the rows of the factored
+    /// matrix
+    unsigned int split() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->split_;
+    }
+
+    /// Rank accessor
+
+    /// \return The number of columns of the factors
+    size_type rank() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->u_.cols();
+    }
+
+    /// Row factor accessor
+
+    /// \return The row factor \f$ U \f$
+    const matrix_type& u() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->u_;
+    }
+
+    /// Column factor accessor
+
+    /// \return The column factor \f$ V \f$
+    const matrix_type& v() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->v_;
+    }
+
+    /// Tolerance accessor
+
+    /// \return The truncation tolerance
+    double tolerance() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->tolerance_;
+    }
+
+    /// Dense tile
+
+    /// \return The dense tile with the elements of this tile
+    dense_type dense() const {
+      TA_ASSERT(pimpl_);
+      dense_type result(pimpl_->range_);
+      math::eigen_map(result.data(), pimpl_->u_.rows(), pimpl_->v_.rows()) =
+          pimpl_->u_ * pimpl_->v_.transpose();
+      return result;
+    }
+
+    /// Dense tile conversion
+
+    /// \return The dense tile with the elements of this tile
+    explicit operator dense_type() const { return dense(); }
+
+    /// Change the matricization
+
+    /// \param split The number of row dimensions
+    /// \return This tile if \c split is equal to \c split() , otherwise this
+    /// tile factored with \c split row dimensions
+    LowRankTensor_ resplit(const unsigned int split) const {
+      TA_ASSERT(pimpl_);
+      if(split == pimpl_->split_)
+        return *this;
+      return LowRankTensor_(dense(), pimpl_->tolerance_, split);
+    }
+
+    // Serialization -----------------------------------------------------------
+
+    /// Output serialization function
+
+    /// \tparam Archive The output archive type
+    /// \param[out] ar The output archive
+    template <typename Archive,
+        typename std::enable_if<
+          madness::archive::is_output_archive<Archive>::value>::type* = nullptr>
+    void serialize(Archive& ar) {
+      const bool empty = ! pimpl_;
+      ar & empty;
+      if(! empty) {
+        ar & pimpl_->range_ & pimpl_->split_ & pimpl_->tolerance_ &
+            size_type(pimpl_->u_.cols());
+        ar & madness::archive::wrap(pimpl_->u_.data(), pimpl_->u_.size());
+        ar & madness::archive::wrap(pimpl_->v_.data(), pimpl_->v_.size());
+      }
+    }
+
+    /// Input serialization function
+
+    /// \tparam Archive The input archive type
+    /// \param[out] ar The input archive
+    template <typename Archive,
+        typename std::enable_if<
+          madness::archive::is_input_archive<Archive>::value>::type* = nullptr>
+    void serialize(Archive& ar) {
+      bool empty = true;
+      ar & empty;
+      if(! empty) {
+        range_type range;
+        unsigned int split = 0u;
+        double tolerance = 0.0;
+        size_type r = 0ul;
+        ar & range & split & tolerance & r;
+        matrix_type u(rows(range, split), r), v(cols(range, split), r);
+        ar & madness::archive::wrap(u.data(), u.size());
+        ar & madness::archive::wrap(v.data(), v.size());
+        pimpl_ = std::make_shared<const Impl>(Impl{ std::move(range), split,
+            std::move(u), std::move(v), tolerance });
+      } else {
+        pimpl_.reset();
+      }
+    }
+
+    // Permutation and shift ---------------------------------------------------
+
+    /// Permute this tile
+
+    /// Permutations that keep the row and column dimensions apart permute the
+    /// rows of the factors; other permutations factor the permuted dense tile.
+    /// \param perm The permutation
+    /// \return A permuted copy of this tile
+    LowRankTensor_ permute(const Permutation& perm) const {
+      TA_ASSERT(pimpl_);
+      TA_ASSERT(perm.dim() == pimpl_->range_.rank());
+      const unsigned int n = perm.dim();
+      const unsigned int s = pimpl_->split_;
+      const size_type* const extent = pimpl_->range_.extent_data();
+      const bool rows_first = std::all_of(perm.begin(), perm.begin() + s,
+          [=] (const unsigned int p) { return p < s; });
+      const bool rows_last = std::all_of(perm.begin(), perm.begin() + s,
+          [=] (const unsigned int p) { return p >= n - s; });
+
+      if(rows_first) {
+        std::vector<unsigned int> pu(perm.begin(), perm.begin() + s);
+        std::vector<unsigned int> pv(perm.begin() + s, perm.end());
+        for(auto& p : pv)
+          p -= s;
+        return LowRankTensor_(perm * pimpl_->range_, s,
+            permute_rows(pimpl_->u_, extent, pu),
+            permute_rows(pimpl_->v_, extent + s, pv), pimpl_->tolerance_,
+            false);
+      } else if(rows_last) {
+        // The column dimensions of this tile are the row dimensions of the result
+        std::vector<unsigned int> pu(perm.begin(), perm.begin() + s);
+        std::vector<unsigned int> pv(perm.begin() + s, perm.end());
+        for(auto& p : pu)
+          p -= n - s;
+        return LowRankTensor_(perm * pimpl_->range_, n - s,
+            permute_rows(pimpl_->v_, extent + s, pv),
+            permute_rows(pimpl_->u_, extent, pu), pimpl_->tolerance_, false);
+      }
+
+      return LowRankTensor_(dense().permute(perm), pimpl_->tolerance_, s);
+    }
+
+    /// Shift the lower and upper bound of this tile
+
+    /// \tparam Index The shift array type
+    /// \param bound_shift The shift to be applied to the tile range
+    /// \return A reference to this tile
+    template <typename Index>
+    LowRankTensor_& shift_to(const Index& bound_shift) {
+      TA_ASSERT(pimpl_);
+      range_type range = pimpl_->range_;
+      range.inplace_shift(bound_shift);
+      pimpl_ = std::make_shared<const Impl>(Impl{ std::move(range),
+          pimpl_->split_, pimpl_->u_, pimpl_->v_, pimpl_->tolerance_ });
+      return *this;
+    }
+
+    /// Shift the lower and upper bound of this tile
+
+    /// \tparam Index The shift array type
+    /// \param bound_shift The shift to be applied to the tile range
+    /// \return A shifted copy of this tile
+    template <typename Index>
+    LowRankTensor_ shift(const Index& bound_shift) const {
+      LowRankTensor_ result = *this;
+      result.shift_to(bound_shift);
+      return result;
+    }
+
+    // Scaling operations ------------------------------------------------------
+
+    /// Scale this tile
+
+    /// \tparam Scalar A scalar type
+    /// \param factor The scaling factor
+    /// \return A new tile where the elements of this tile are scaled by
+    /// \c factor
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ scale(const Scalar factor) const {
+      TA_ASSERT(pimpl_);
+      return LowRankTensor_(pimpl_->range_, pimpl_->split_,
+          matrix_type(pimpl_->u_ * numeric_type(factor)), matrix_type(pimpl_->v_),
+          pimpl_->tolerance_, false);
+    }
+
+    /// Scale and permute this tile
+
+    /// \tparam Scalar A scalar type
+    /// \param factor The scaling factor
+    /// \param perm The permutation to be applied to this tile
+    /// \return A new tile where the elements of this tile are scaled by
+    /// \c factor and permuted by \c perm
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ scale(const Scalar factor, const Permutation& perm) const {
+      return scale(factor).permute(perm);
+    }
+
+    /// Scale this tile in place
+
+    /// \tparam Scalar A scalar type
+    /// \param factor The scaling factor
+    /// \return A reference to this tile
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_& scale_to(const Scalar factor) {
+      *this = scale(factor);
+      return *this;
+    }
+
+    // Addition operations -----------------------------------------------------
+
+    /// Add this and \c right to construct a new tile
+
+    /// \param right The tile that will be added to this tile
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c right
+    LowRankTensor_ add(const LowRankTensor_& right) const {
+      return combine(*this, numeric_type(1), right, numeric_type(1));
+    }
+
+    /// Add this and \c right to construct a new, permuted tile
+
+    /// \param right The tile that will be added to this tile
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c right , permuted by \c perm
+    LowRankTensor_ add(const LowRankTensor_& right, const Permutation& perm) const {
+      return add(right).permute(perm);
+    }
+
+    /// Scale and add this and \c right to construct a new tile
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be added to this tile
+    /// \param factor The scaling factor
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c right , scaled by \c factor
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ add(const LowRankTensor_& right, const Scalar factor) const {
+      return combine(*this, numeric_type(factor), right, numeric_type(factor));
+    }
+
+    /// Scale and add this and \c right to construct a new, permuted tile
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be added to this tile
+    /// \param factor The scaling factor
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c right , scaled by \c factor and permuted by \c perm
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ add(const LowRankTensor_& right, const Scalar factor,
+        const Permutation& perm) const
+    {
+      return add(right, factor).permute(perm);
+    }
+
+    /// Add a constant to a copy of this tile
+
+    /// \param value The constant to be added to this tile
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c value
+    LowRankTensor_ add(const numeric_type value) const {
+      return combine(*this, value);
+    }
+
+    /// Add a constant to a permuted copy of this tile
+
+    /// \param value The constant to be added to this tile
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the sum of the elements of
+    /// \c this and \c value , permuted by \c perm
+    LowRankTensor_ add(const numeric_type value, const Permutation& perm) const {
+      return add(value).permute(perm);
+    }
+
+    /// Add \c right to this tile
+
+    /// \param right The tile that will be added to this tile
+    /// \return A reference to this tile
+    LowRankTensor_& add_to(const LowRankTensor_& right) {
+      *this = add(right);
+      return *this;
+    }
+
+    /// Add \c right to this tile, and scale the result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be added to this tile
+    /// \param factor The scaling factor
+    /// \return A reference to this tile
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_& add_to(const LowRankTensor_& right, const Scalar factor) {
+      *this = add(right, factor);
+      return *this;
+    }
+
+    /// Add a constant to this tile
+
+    /// \param value The constant to be added
+    /// \return A reference to this tile
+    LowRankTensor_& add_to(const numeric_type value) {
+      *this = add(value);
+      return *this;
+    }
+
+    // Subtraction operations --------------------------------------------------
+
+    /// Subtract \c right from this tile to construct a new tile
+
+    /// \param right The tile that will be subtracted from this tile
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c right
+    LowRankTensor_ subt(const LowRankTensor_& right) const {
+      return combine(*this, numeric_type(1), right, numeric_type(-1));
+    }
+
+    /// Subtract \c right from this tile to construct a new, permuted tile
+
+    /// \param right The tile that will be subtracted from this tile
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c right , permuted by \c perm
+    LowRankTensor_ subt(const LowRankTensor_& right, const Permutation& perm) const {
+      return subt(right).permute(perm);
+    }
+
+    /// Subtract \c right from this tile and scale the result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be subtracted from this tile
+    /// \param factor The scaling factor
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c right , scaled by \c factor
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ subt(const LowRankTensor_& right, const Scalar factor) const {
+      return combine(*this, numeric_type(factor), right, -numeric_type(factor));
+    }
+
+    /// Subtract \c right from this tile, and scale and permute the result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be subtracted from this tile
+    /// \param factor The scaling factor
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c right , scaled by \c factor and permuted by
+    /// \c perm
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ subt(const LowRankTensor_& right, const Scalar factor,
+        const Permutation& perm) const
+    {
+      return subt(right, factor).permute(perm);
+    }
+
+    /// Subtract a constant from a copy of this tile
+
+    /// \param value The constant to be subtracted
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c value
+    LowRankTensor_ subt(const numeric_type value) const {
+      return combine(*this, -value);
+    }
+
+    /// Subtract a constant from a permuted copy of this tile
+
+    /// \param value The constant to be subtracted
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the difference of the
+    /// elements of \c this and \c value , permuted by \c perm
+    LowRankTensor_ subt(const numeric_type value, const Permutation& perm) const {
+      return subt(value).permute(perm);
+    }
+
+    /// Subtract \c right from this tile
+
+    /// \param right The tile that will be subtracted from this tile
+    /// \return A reference to this tile
+    LowRankTensor_& subt_to(const LowRankTensor_& right) {
+      *this = subt(right);
+      return *this;
+    }
+
+    /// Subtract \c right from this tile, and scale the result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be subtracted from this tile
+    /// \param factor The scaling factor
+    /// \return A reference to this tile
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_& subt_to(const LowRankTensor_& right, const Scalar factor) {
+      *this = subt(right, factor);
+      return *this;
+    }
+
+    /// Subtract a constant from this tile
+
+    /// \param value The constant to be subtracted
+    /// \return A reference to this tile
+    LowRankTensor_& subt_to(const numeric_type value) {
+      *this = subt(value);
+      return *this;
+    }
+
+    // Multiplication operations -----------------------------------------------
+
+    /// Multiply this tile by \c right element-wise
+
+    /// The rank of the product is at most the product of the argument ranks.
+    /// \param right The tile that will be multiplied by this tile
+    /// \return A new tile where the elements are the product of the elements
+    /// of \c this and \c right
+    LowRankTensor_ mult(const LowRankTensor_& right) const {
+      return hadamard(*this, right, numeric_type(1));
+    }
+
+    /// Multiply this tile by \c right element-wise, and permute the result
+
+    /// \param right The tile that will be multiplied by this tile
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the product of the elements
+    /// of \c this and \c right , permuted by \c perm
+    LowRankTensor_ mult(const LowRankTensor_& right, const Permutation& perm) const {
+      return mult(right).permute(perm);
+    }
+
+    /// Multiply this tile by \c right element-wise, and scale the result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be multiplied by this tile
+    /// \param factor The scaling factor
+    /// \return A new tile where the elements are the product of the elements
+    /// of \c this and \c right , scaled by \c factor
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ mult(const LowRankTensor_& right, const Scalar factor) const {
+      return hadamard(*this, right, numeric_type(factor));
+    }
+
+    /// Multiply this tile by \c right element-wise, and scale and permute the
+    /// result
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be multiplied by this tile
+    /// \param factor The scaling factor
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile where the elements are the product of the elements
+    /// of \c this and \c right , scaled by \c factor and permuted by \c perm
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ mult(const LowRankTensor_& right, const Scalar factor,
+        const Permutation& perm) const
+    {
+      return mult(right, factor).permute(perm);
+    }
+
+    /// Multiply this tile by \c right element-wise, in place
+
+    /// \param right The tile that will be multiplied by this tile
+    /// \return A reference to this tile
+    LowRankTensor_& mult_to(const LowRankTensor_& right) {
+      *this = mult(right);
+      return *this;
+    }
+
+    /// Multiply this tile by \c right element-wise and scale the result, in
+    /// place
+
+    /// \tparam Scalar A scalar type
+    /// \param right The tile that will be multiplied by this tile
+    /// \param factor The scaling factor
+    /// \return A reference to this tile
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_& mult_to(const LowRankTensor_& right, const Scalar factor) {
+      *this = mult(right, factor);
+      return *this;
+    }
+
+    // Negation operations -----------------------------------------------------
+
+    /// Negate this tile
+
+    /// \return A new tile that contains the negative values of this tile
+    LowRankTensor_ neg() const { return scale(numeric_type(-1)); }
+
+    /// Negate and permute this tile
+
+    /// \param perm The permutation to be applied to the result
+    /// \return A new tile that contains the negative values of this tile,
+    /// permuted by \c perm
+    LowRankTensor_ neg(const Permutation& perm) const {
+      return neg().permute(perm);
+    }
+
+    /// Negate this tile in place
+
+    /// \return A reference to this tile
+    LowRankTensor_& neg_to() { return scale_to(numeric_type(-1)); }
+
+    // Contraction operations --------------------------------------------------
+
+    /// Contract this tile with \c other
+
+    /// The product of the factors is formed without the dense tiles, so the
+    /// cost is proportional to the ranks of the arguments. The arguments are
+    /// factored again if their matricization does not match \c gemm_helper .
+    /// \tparam Scalar A scalar type
+    /// \param other The tile that will be contracted with this tile
+    /// \param factor Multiply the result by this constant
+    /// \param gemm_helper The *GEMM operation meta data
+    /// \return A new tile which is the result of contracting this tile with
+    /// \c other and scaled by \c factor
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_ gemm(const LowRankTensor_& other, const Scalar factor,
+        const math::GemmHelper& gemm_helper) const
+    {
+      TA_ASSERT(pimpl_);
+      TA_ASSERT(pimpl_->range_.rank() == gemm_helper.left_rank());
+      TA_ASSERT(! other.empty());
+      TA_ASSERT(other.range().rank() == gemm_helper.right_rank());
+      TA_ASSERT(gemm_helper.left_right_congruent(pimpl_->range_.extent_data(),
+          other.range().extent_data()));
+
+      matrix_type u, v;
+      gemm_factors(*this, other, numeric_type(factor), gemm_helper, u, v);
+      return LowRankTensor_(
+          gemm_helper.make_result_range<range_type>(pimpl_->range_, other.range()),
+          gemm_helper.left_outer_end() - gemm_helper.left_outer_begin(),
+          std::move(u), std::move(v),
+          std::max(pimpl_->tolerance_, other.tolerance()), true);
+    }
+
+    /// Contract two tiles and accumulate the scaled result to this tile
+
+    /// \tparam Scalar A scalar type
+    /// \param left The left-hand tile that will be contracted
+    /// \param right The right-hand tile that will be contracted
+    /// \param factor The contraction result will be scaling by this value,
+    /// then accumulated into \c this
+    /// \param gemm_helper The *GEMM operation meta data
+    /// \return A reference to \c this
+    template <typename Scalar,
+        typename std::enable_if<detail::is_numeric<Scalar>::value>::type* = nullptr>
+    LowRankTensor_& gemm(const LowRankTensor_& left, const LowRankTensor_& right,
+        const Scalar factor, const math::GemmHelper& gemm_helper)
+    {
+      TA_ASSERT(pimpl_);
+      TA_ASSERT(pimpl_->range_.rank() == gemm_helper.result_rank());
+      TA_ASSERT(! left.empty());
+      TA_ASSERT(left.range().rank() == gemm_helper.left_rank());
+      TA_ASSERT(! right.empty());
+      TA_ASSERT(right.range().rank() == gemm_helper.right_rank());
+      TA_ASSERT(gemm_helper.left_result_congruent(left.range().extent_data(),
+          pimpl_->range_.extent_data()));
+      TA_ASSERT(gemm_helper.right_result_congruent(right.range().extent_data(),
+          pimpl_->range_.extent_data()));
+      TA_ASSERT(gemm_helper.left_right_congruent(left.range().extent_data(),
+          right.range().extent_data()));
+
+      matrix_type u, v;
+      gemm_factors(left, right, numeric_type(factor), gemm_helper, u, v);
+
+      // Append the product to the factors of this tile
+      const LowRankTensor_ result = resplit(gemm_helper.left_outer_end() -
+          gemm_helper.left_outer_begin());
+      const Eigen::Index r = result.rank(), rp = u.cols();
+      matrix_type ur(u.rows(), r + rp), vr(v.rows(), r + rp);
+      ur.leftCols(r) = result.u();
+      ur.rightCols(rp) = u;
+      vr.leftCols(r) = result.v();
+      vr.rightCols(rp) = v;
+      *this = LowRankTensor_(pimpl_->range_, result.split(), std::move(ur),
+          std::move(vr), std::max({ pimpl_->tolerance_, left.tolerance(),
+          right.tolerance() }), true);
+      return *this;
+    }
+
+    // Reduction operations ----------------------------------------------------
+
+    /// Generalized tile trace
+
+    /// \return The sum of the hyper-diagonal elements of this tile
+    numeric_type trace() const { return dense().trace(); }
+
+    /// Sum of elements
+
+    /// \return The sum of all elements of this tile
+    numeric_type sum() const {
+      TA_ASSERT(pimpl_);
+      return pimpl_->u_.colwise().sum().dot(pimpl_->v_.colwise().sum());
+    }
+
+    /// Product of elements
+
+    /// \return The product of all elements of this tile
+    numeric_type product() const { return dense().product(); }
+
+    /// Square of vector 2-norm
+
+    /// \return The sum of the squared elements of this tile
+    scalar_type squared_norm() const {
+      TA_ASSERT(pimpl_);
+      return ((pimpl_->u_.transpose() * pimpl_->u_).cwiseProduct(
+          pimpl_->v_.transpose() * pimpl_->v_)).sum();
+    }
+
+    /// Vector 2-norm
+
+    /// \return The vector norm of this tile
+    scalar_type norm() const { return std::sqrt(squared_norm()); }
+
+    /// Minimum element
+
+    /// \return The minimum element of this tile
+    numeric_type min() const { return dense().min(); }
+
+    /// Maximum element
+
+    /// \return The maximum element of this tile
+    numeric_type max() const { return dense().max(); }
+
+    /// Absolute minimum element
+
+    /// \return The minimum absolute element of this tile
+    scalar_type abs_min() const { return dense().abs_min(); }
+
+    /// Absolute maximum element
+
+    /// \return The maximum absolute element of this tile
+    scalar_type abs_max() const { return dense().abs_max(); }
+
+    /// Vector dot product
+
+    /// \param other The tile to be reduced with this tile
+    /// \return The inner product of the this and \c other
+    numeric_type dot(const LowRankTensor_& other) const {
+      TA_ASSERT(pimpl_);
+      TA_ASSERT(! other.empty());
+      TA_ASSERT(pimpl_->range_ == other.range());
+      const LowRankTensor_ arg = other.resplit(pimpl_->split_);
+      return ((pimpl_->u_.transpose() * arg.u()).cwiseProduct(
+          pimpl_->v_.transpose() * arg.v())).sum();
+    }
+
+  }; // class LowRankTensor
+
+  /// LowRankTensor output operator
+
+  /// \tparam T The element type
+  /// \param os The output stream
+  /// \param tile The tile to be printed
+  /// \return A reference to the output stream
+  template <typename T>
+  inline std::ostream& operator<<(std::ostream& os, const LowRankTensor<T>& tile) {
+    if(tile.empty())
+      os << "[empty]";
+    else
+      os << tile.dense();
+    return os;
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_LOW_RANK_TENSOR_H__INCLUDED
@@ -42,6 +42,9 @@ namespace TiledArray {
   // DSL on a per-scope basis ... this assumes that only 1 thread (usually, main)
   // parses TiledArray DSL
   namespace detail {
+    /// Construct the node map of \c world (see \c NodeMap::setup )
+    inline void setup_node_map(World& world);
+
     struct default_world {
       static World& get() {
         if (!world()) {
@@ -125,6 +128,7 @@ namespace TiledArray {
   inline World& initialize(int& argc, char**& argv, const SafeMPI::Intracomm& comm) {
     auto& default_world = madness::initialize(argc, argv, comm);
     TiledArray::set_default_world(default_world);
+    detail::setup_node_map(default_world);
     return default_world;
   }
 
@@ -145,4 +149,7 @@ namespace TiledArray {
 
 }  // namespace TiledArray
 
+// Defines detail::setup_node_map
+#include <TiledArray/hierarchical_group.h>
+
 #endif // TILEDARRAY_MADNESS_H__INCLUDED
@@ -164,10 +164,76 @@ namespace TiledArray {
     }
 
 
+    // Mixed-precision _GEMM wrapper functions
+
+    namespace detail {
+
+      /// Copy a matrix to a higher precision
+
+      /// \tparam U The result element type
+      /// \tparam T The argument element type
+      /// \param rows The number of rows in \c a
+      /// \param cols The number of columns in \c a
+      /// \param a A pointer to the first element of the row-major matrix
+      /// \param lda The leading dimension of \c a
+      /// \return A contiguous, row-major copy of \c a
+      template <typename U, typename T>
+      inline Eigen::Matrix<U, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      promote_matrix(const integer rows, const integer cols, const T* a,
+          const integer lda)
+      {
+        typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix_type;
+        return Eigen::Map<const matrix_type, Eigen::AutoAlign, Eigen::OuterStride<> >(
+            a, rows, cols, Eigen::OuterStride<>(lda)).template cast<U>();
+      }
+
+      /// Contract single precision matrices into a double precision result
+
+      /// The arguments are promoted to double precision, where the products
+      /// of single precision numbers are exact, so the only rounding is that
+      /// of the double precision accumulation.
+      template <typename S1, typename T, typename S2, typename U>
+      inline void mixed_gemm(madness::cblas::CBLAS_TRANSPOSE op_a,
+          madness::cblas::CBLAS_TRANSPOSE op_b, const integer m, const integer n,
+          const integer k, const S1 alpha, const T* a, const integer lda,
+          const T* b, const integer ldb, const S2 beta, U* c, const integer ldc)
+      {
+        const integer a_cols = (op_a == madness::cblas::NoTrans ? k : m);
+        const integer b_cols = (op_b == madness::cblas::NoTrans ? n : k);
+        const auto A = promote_matrix<U>((op_a == madness::cblas::NoTrans ? m : k),
+            a_cols, a, lda);
+        const auto B = promote_matrix<U>((op_b == madness::cblas::NoTrans ? k : n),
+            b_cols, b, ldb);
+        math::gemm(op_a, op_b, m, n, k, U(alpha), A.data(), std::max<integer>(a_cols, 1),
+            B.data(), std::max<integer>(b_cols, 1), U(beta), c, ldc);
+      }
+
+    } // namespace detail
+
+    template <typename S1, typename S2>
+    inline void gemm(madness::cblas::CBLAS_TRANSPOSE op_a,
+        madness::cblas::CBLAS_TRANSPOSE op_b, const integer m, const integer n,
+        const integer k, const S1 alpha, const float* a, const integer lda,
+        const float* b, const integer ldb, const S2 beta, double* c, const integer ldc)
+    {
+      detail::mixed_gemm(op_a, op_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+
+    template <typename S1, typename S2>
+    inline void gemm(madness::cblas::CBLAS_TRANSPOSE op_a,
+        madness::cblas::CBLAS_TRANSPOSE op_b, const integer m, const integer n,
+        const integer k, const S1 alpha, const std::complex<float>* a,
+        const integer lda, const std::complex<float>* b, const integer ldb,
+        const S2 beta, std::complex<double>* c, const integer ldc)
+    {
+      detail::mixed_gemm(op_a, op_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+
+
     // BLAS _SCAL wrapper functions
 
     template <typename T, typename U>
-    inline typename std::enable_if<detail::is_numeric<T>::value>::type
+    inline typename std::enable_if<TiledArray::detail::is_numeric<T>::value>::type
     scale(const integer n, const T alpha, U* x) {
       eigen_map(x, n) *= alpha;
     }
@@ -29,7 +29,10 @@
 #pragma GCC diagnostic push
 #pragma GCC system_header
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
 #include <Eigen/QR>
+#include <Eigen/SVD>
 #pragma GCC diagnostic pop
 
 #include <TiledArray/error.h>
@@ -57,7 +57,7 @@ namespace TiledArray {
       }
         left_, ///< Left-hand argument range data
         right_; ///< Right-hand argument range data
-
+      bool parallel_; ///< Use the multithreaded GEMM (see \c parallel_gemm )
 
     public:
 
@@ -66,7 +66,7 @@ namespace TiledArray {
           const unsigned int result_rank, const unsigned int left_rank,
           const unsigned int right_rank) :
         left_op_(left_op), right_op_(right_op),
-        result_rank_(result_rank), left_(), right_()
+        result_rank_(result_rank), left_(), right_(), parallel_(false)
       {
         // Compute the number of contracted dimensions in left and right.
         TA_ASSERT(((left_rank + right_rank - result_rank) % 2u) == 0u);
@@ -105,7 +105,7 @@ namespace TiledArray {
       GemmHelper(const GemmHelper& other) :
         left_op_(other.left_op_), right_op_(other.right_op_),
         result_rank_(other.result_rank_),
-        left_(other.left_), right_(other.right_)
+        left_(other.left_), right_(other.right_), parallel_(other.parallel_)
       { }
 
       /// Functor assignment operator
@@ -117,10 +117,23 @@ namespace TiledArray {
         result_rank_ = other.result_rank_;
         left_ = other.left_;
         right_ = other.right_;
+        parallel_ = other.parallel_;
 
         return *this;
       }
 
+      /// Multithreaded GEMM selection accessor
+
+      /// \return \c true if the GEMM of this contraction may use
+      /// \c parallel_gemm with more than one thread
+      bool parallel() const { return parallel_; }
+
+      /// Select the multithreaded GEMM
+
+      /// \param parallel If \c true , the GEMM of this contraction may use
+      /// \c parallel_gemm with more than one thread
+      void parallel(const bool parallel) { parallel_ = parallel; }
+
       /// Compute the number of contracted ranks
 
       /// \return The number of ranks that are summed by this operation
@@ -274,6 +287,57 @@ namespace TiledArray {
       madness::cblas::CBLAS_TRANSPOSE right_op() const { return right_op_; }
     }; // class GemmHelper
 
+    /// Product of the inner tensors of nested tensors
+
+    /// The elements of a tensor of tensors are multiplied either
+    /// coefficient-wise (Hadamard product) or by a contraction that is mapped
+    /// to a GEMM. For example,
+    /// \code
+    /// c("i,j;a,b") = a("i,k;a,b") * b("k,j;a,b"); // Hadamard product
+    /// c("i,j;a,b") = a("i,k;a,c") * b("k,j;c,b"); // contraction
+    /// \endcode
+    /// contract the outer index \c k and multiply the inner tensors with the
+    /// given product.
+    class NestedProduct {
+    private:
+
+      GemmHelper gemm_helper_; ///< The inner contraction meta data
+      bool contract_; ///< Product type flag (true == contraction, false ==
+                      ///< Hadamard product)
+
+    public:
+
+      /// Construct a Hadamard product
+      NestedProduct() :
+        gemm_helper_(madness::cblas::NoTrans, madness::cblas::NoTrans, 0u, 0u, 0u),
+        contract_(false)
+      { }
+
+      /// Construct a contraction
+
+      /// \param gemm_helper The *GEMM meta data of the inner contraction
+      explicit NestedProduct(const GemmHelper& gemm_helper) :
+        gemm_helper_(gemm_helper), contract_(true)
+      { }
+
+      /// Contraction query
+
+      /// \return \c true if the inner tensors are contracted, \c false if they
+      /// are multiplied coefficient-wise
+      bool is_contraction() const { return contract_; }
+
+      /// Inner contraction meta data accessor
+
+      /// \return A const reference to the *GEMM meta data of the inner
+      /// contraction
+      /// \throw TiledArray::Exception When this is a Hadamard product.
+      const GemmHelper& gemm_helper() const {
+        TA_ASSERT(contract_);
+        return gemm_helper_;
+      }
+
+    }; // class NestedProduct
+
   }  // namespace math
 } // namespace TiledArray
 
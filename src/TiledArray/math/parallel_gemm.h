@@ -26,144 +26,394 @@
 #ifndef TILEDARRAY_PARALLEL_GEMM_H__INCLUDED
 #define TILEDARRAY_PARALLEL_GEMM_H__INCLUDED
 
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <TiledArray/madness.h>
-#include <TiledArray/vector_op.h>
-#include <TiledArray/blas.h>
+#include <TiledArray/math/blas.h>
+#include <TiledArray/tensor/complex.h>
 
-#define TILEDARRAY_DYNAMIC_BLOCK_SIZE std::numeric_limits<std::size_t>::max();
+#ifdef HAVE_INTEL_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif // HAVE_INTEL_TBB
 
 namespace TiledArray {
   namespace math {
 
-//#ifdef HAVE_INTEL_TBB
+    /// Parameters that control the blocked, multithreaded GEMM
+
+    /// Tile contractions run in MADNESS tasks, which already use all cores,
+    /// so the multithreaded GEMM is disabled by default. It may be selected
+    /// for all contractions with \c enabled() , or for one contraction with
+    /// \c Expr::set_parallel_gemm() . The default values may be overridden
+    /// with the \c TA_PARALLEL_GEMM , \c TA_PARALLEL_GEMM_THRESHOLD ,
+    /// \c TA_PARALLEL_GEMM_BLOCK_SIZE , and \c TA_PARALLEL_GEMM_THREADS
+    /// environment variables, or at runtime by assigning to the values
+    /// returned by the accessors.
+    class ParallelGemmParams {
+
+      /// Read a non-negative integer from the environment
+
+      /// \param name The name of the environment variable
+      /// \param value The default value
+      /// \return The value of \c name , or \c value if it is not set or not a
+      /// non-negative integer
+      static long long init_value(const char* const name, const long long value) {
+        const char* const str = getenv(name);
+        if(str) {
+          std::stringstream ss(str);
+          long long result = 0ll;
+          std::string rest;
+          if((ss >> result) && !(ss >> rest) && (result >= 0ll))
+            return result;
+        }
+        return value;
+      }
 
+    public:
 
-    template <typename T, integer Size>
-    class MatrixBlockTask : public tbb::task {
+      /// Default selection of the multithreaded GEMM for tile contractions
 
-      const integer rows_;
-      const integer cols_;
-      T* data_;
-      const integer ld_;
-      std::shared_ptr<T> result_;
+      /// Contractions that do not select the algorithm with
+      /// \c Expr::set_parallel_gemm() use this value, which is \c false
+      /// unless \c TA_PARALLEL_GEMM is a non-zero integer.
+      /// \return A reference to the default selection
+      static bool& enabled() {
+        static bool enabled_ = (init_value("TA_PARALLEL_GEMM", 0ll) != 0ll);
+        return enabled_;
+      }
 
-      /// Copy a \c Size^2 block from \c data to \c result
+      /// Minimum \c m*n*k for which the blocked algorithm is used
 
-      /// \param[out] result A pointer to the first element of the result block
-      /// \param[in] data A pointer to the first element of the block to be copied
-      /// \param[in] ld The leading dimension stride for the \c data block
-      void copy_block(T* result, const T* data, const integer ld) {
-        const T* const block_end = result + (TILEDARRAY_LOOP_UNWIND * Size);
-        for(; result < block_end; result += Size, data += ld)
-          TiledArray::math::copy_block(result, data);
+      /// GEMM operations with fewer multiply-add operations than this are
+      /// handed directly to \c gemm . A value of zero forces the blocked
+      /// algorithm for all matrices larger than a single block.
+      /// \return A reference to the threshold
+      static std::size_t& threshold() {
+        static std::size_t threshold_ =
+            init_value("TA_PARALLEL_GEMM_THRESHOLD", 16777216ll);
+        return threshold_;
       }
 
-      /// Copy a rectangular \c m*n block from \c data to \c result
+      /// Number of rows and columns in each packed block
 
-      /// \param[in] m The number of rows to copy
-      /// \param[in] n The number of columns to copy
-      /// \param[out] result A pointer to the first element of the result block
-      /// \param[in] data A pointer to the first element of the block to be copied
-      /// \param[in] ld The leading dimension stride for the \c data block
-      void copy_block(const integer m, const integer n, T* result,
-          const T* data, const integer ld)
-      {
-        const T* const block_end = result + (m * Size);
-        for(; result < block_end; result += Size, data += ld)
-          TiledArray::math::copy_block(n, result, data);
+      /// \return A reference to the block size, which is at least 8
+      static integer& block_size() {
+        static integer block_size_ = std::max<integer>(
+            init_value("TA_PARALLEL_GEMM_BLOCK_SIZE", 128ll), 8);
+        return block_size_;
       }
 
-    public:
-      MatrixBlockTask(const integer rows, const integer cols,
-          const T* const data, const integer ld) :
-        rows_(rows), cols_(cols), data_(data), ld_(ld)
-      { }
-
-      /// Task body
-      virtual tbb::task* execut() {
-
-        // Compute block iteration limit
-        constexpr integer index_mask = ~integer(TILEDARRAY_LOOP_UNWIND - 1ul);
-        const integer mx = rows_ & index_mask; // = rows - rows % TILEDARRAY_LOOP_UNWIND
-        const integer nx = cols_ & index_mask; // = cols - cols % TILEDARRAY_LOOP_UNWIND
-        const integer m_tail = rows_ - mx;
-        const integer n_tail = cols_ - nx;
-
-        // Copy data into block_
-        integer i = 0ul;
-        T* result_i = result_.get();
-        const T* data_i = data_;
-        for(; i < mx; i += TILEDARRAY_LOOP_UNWIND, result_i += Size, data_i += ld_) {
-
-          integer j = 0ul;
-          for(; j < nx; j += TILEDARRAY_LOOP_UNWIND)
-            copy_block(result_i + j, data_i + j);
-
-          if(n_tail)
-            copy_block(TILEDARRAY_LOOP_UNWIND, n_tail, result_i + j, data_i + j);
-        }
+      /// Maximum number of threads used by a multithreaded GEMM
 
-        if(m_tail) {
+      /// A value of zero uses the default number of TBB threads.
+      /// \return A reference to the maximum number of threads
+      static int& max_threads() {
+        static int max_threads_ =
+            int(init_value("TA_PARALLEL_GEMM_THREADS", 0ll));
+        return max_threads_;
+      }
 
-          integer j = 0ul;
-          for(; j < nx; j += TILEDARRAY_LOOP_UNWIND)
-            copy_block(m_tail, TILEDARRAY_LOOP_UNWIND, result_i + j, data_i + j);
+    }; // class ParallelGemmParams
 
-          if(n_tail)
-            copy_block(m_tail, n_tail, result_i + j, data_i + j);
+    namespace detail {
 
-        }
+      /// \c true while a multithreaded GEMM is running in this process
+      inline std::atomic<bool>& parallel_gemm_active() {
+        static std::atomic<bool> active(false);
+        return active;
+      }
+
+      /// Claim the multithreaded GEMM of this process
 
-        return nullptr;
+      /// \return \c true if no other multithreaded GEMM is running, in which
+      /// case the caller must release it with \c release_parallel_gemm()
+      inline bool acquire_parallel_gemm() {
+        bool active = false;
+        return parallel_gemm_active().compare_exchange_strong(active, true);
+      }
+
+      /// Release the multithreaded GEMM of this process
+      inline void release_parallel_gemm() { parallel_gemm_active() = false; }
+
+      /// Element type of the packed arguments of a GEMM
+
+      /// Single precision arguments of a double precision result are promoted
+      /// when they are packed, so that each element is converted once and the
+      /// blocks are contracted with double precision GEMM.
+      /// \tparam T The argument element type
+      /// \tparam R The result element type
+      template <typename T, typename R>
+      struct packed_element { typedef T type; };
+
+      template <>
+      struct packed_element<float, double> { typedef double type; };
+
+      template <>
+      struct packed_element<std::complex<float>, std::complex<double> > {
+        typedef std::complex<double> type;
+      };
+
+      /// Pack a block of <tt>op(A)</tt> into a contiguous, row-major buffer
+
+      /// \tparam T The matrix element type
+      /// \tparam U The packed element type
+      /// \param op The matrix operation that is applied to \c a
+      /// \param rows The number of rows of <tt>op(A)</tt> to copy
+      /// \param cols The number of columns of <tt>op(A)</tt> to copy
+      /// \param a A pointer to the first element of the block in \c a
+      /// \param lda The leading dimension of \c a
+      /// \param[out] result The packed block with leading dimension \c cols
+      template <typename T, typename U>
+      void pack_block(const madness::cblas::CBLAS_TRANSPOSE op,
+          const integer rows, const integer cols, const T* MADNESS_RESTRICT a,
+          const integer lda, U* MADNESS_RESTRICT result)
+      {
+        switch(op) {
+          case madness::cblas::NoTrans:
+            for(integer i = 0; i < rows; ++i, a += lda, result += cols)
+              std::copy(a, a + cols, result);
+            break;
+          case madness::cblas::Trans:
+            for(integer i = 0; i < rows; ++i, ++a, result += cols)
+              for(integer j = 0; j < cols; ++j)
+                result[j] = a[j * lda];
+            break;
+          case madness::cblas::ConjTrans:
+            for(integer i = 0; i < rows; ++i, ++a, result += cols)
+              for(integer j = 0; j < cols; ++j)
+                result[j] = TiledArray::detail::conj(a[j * lda]);
+            break;
+        }
       }
 
-      std::shared_ptr<T> result() {
-        constexpr integer size = Size * Size;
-        constexpr integer bytes = size * sizeof(T);
+      /// Block-packed copy of <tt>op(A)</tt>
+
+      /// The matrix is partitioned into <tt>block_size x block_size</tt>
+      /// blocks, each of which is stored contiguously in row-major order. The
+      /// blocks are stored block-row by block-row. Boundary blocks are stored
+      /// with their actual dimensions, so each block may be passed to a
+      /// non-transposed \c gemm with a leading dimension equal to its number
+      /// of columns.
+      /// \tparam T The matrix element type
+      template <typename T>
+      class PackedMatrix {
+        integer rows_; ///< Rows of op(A)
+        integer cols_; ///< Columns of op(A)
+        integer block_size_; ///< Block dimension
+        integer block_rows_; ///< Number of block rows
+        integer block_cols_; ///< Number of block columns
+        std::vector<T, Eigen::aligned_allocator<T> > data_; ///< Packed data
+
+      public:
+
+        PackedMatrix(const integer rows, const integer cols,
+            const integer block_size) :
+          rows_(rows), cols_(cols), block_size_(block_size),
+          block_rows_((rows + block_size - 1) / block_size),
+          block_cols_((cols + block_size - 1) / block_size),
+          data_(rows * cols)
+        { }
+
+        integer block_rows() const { return block_rows_; }
+        integer block_cols() const { return block_cols_; }
+
+        /// Number of rows in block row \c i
+        integer rows(const integer i) const {
+          return std::min(block_size_, rows_ - i * block_size_);
+        }
 
-        T* result_ptr = nullptr;
-        if(! posix_memalign(result_ptr, TILEARRAY_ALIGNMENT, bytes))
-          throw std::bad_alloc();
+        /// Number of columns in block column \c j
+        integer cols(const integer j) const {
+          return std::min(block_size_, cols_ - j * block_size_);
+        }
 
-        result_.reset(result_ptr);
+        /// Pointer to the first element of block (i,j)
+        T* block(const integer i, const integer j) {
+          return data_.data() + (i * block_size_ * cols_) + (j * block_size_ * rows(i));
+        }
 
-        return result_;
-      }
+        /// Pointer to the first element of block (i,j)
+        const T* block(const integer i, const integer j) const {
+          return data_.data() + (i * block_size_ * cols_) + (j * block_size_ * rows(i));
+        }
+
+        /// Pack block (i,j) of <tt>op(A)</tt>
+
+        /// \tparam U The element type of \c a
+        /// \param op The operation applied to \c a
+        /// \param i The block row index
+        /// \param j The block column index
+        /// \param a A pointer to the first element of \c A
+        /// \param lda The leading dimension of \c a
+        template <typename U>
+        void pack(const madness::cblas::CBLAS_TRANSPOSE op, const integer i,
+            const integer j, const U* const a, const integer lda)
+        {
+          const integer row = i * block_size_;
+          const integer col = j * block_size_;
+          const U* const first = (op == madness::cblas::NoTrans ?
+              a + (row * lda) + col : a + (col * lda) + row);
+          pack_block(op, rows(i), cols(j), first, lda, block(i, j));
+        }
 
-    }; // class MatrixBlockTask
+      }; // class PackedMatrix
 
+#ifdef HAVE_INTEL_TBB
 
-    template <integer Size, typename C, typename A = C, typename B = C, typename Alpha = C, typename Beta = C>
-    class GemmTask : public tbb::task {
-      const madness::cblas::CBLAS_TRANSPOSE op_a_, op_b_;
-      const integer m_, n_, k_;
-      const Alpha alpha_;
-      std::shared_ptr<A> a_;
-      constexpr integer lda_ = Size;
-      std::shared_ptr<B> b_;
-      const Beta beta_;
-      std::shared_ptr<C> c_;
-      const integer ldc_;
+      /// Task body that packs a range of blocks of a matrix
 
-    public:
+      /// \tparam T The packed element type
+      /// \tparam U The matrix element type
+      template <typename T, typename U>
+      class MatrixBlockTask {
+        PackedMatrix<T>& result_; ///< The packed matrix
+        const madness::cblas::CBLAS_TRANSPOSE op_; ///< Operation applied to data_
+        const U* const data_; ///< The original matrix
+        const integer ld_; ///< Leading dimension of data_
 
+      public:
+        MatrixBlockTask(PackedMatrix<T>& result,
+            const madness::cblas::CBLAS_TRANSPOSE op, const U* const data,
+            const integer ld) :
+          result_(result), op_(op), data_(data), ld_(ld)
+        { }
 
-      GemmTask(madness::cblas::CBLAS_TRANSPOSE op_a,
-          madness::cblas::CBLAS_TRANSPOSE op_b, const integer m, const integer n,
-          const integer k, const Alpha alpha, const std::shared_ptr<A>& a,
-          const std::shared_ptr<B>& b, const Beta beta,
-          const std::shared_ptr<C>& c, const integer ldc) :
-            op_a_(op_a), op_b_(op_b), m_(m), n_(n), k_(k), alpha_(alpha), a_(a),
-            b_(b), beta_(beta), c_(c), ldc_(c)
-      { }
+        void operator()(const tbb::blocked_range2d<integer>& range) const {
+          for(integer i = range.rows().begin(); i != range.rows().end(); ++i)
+            for(integer j = range.cols().begin(); j != range.cols().end(); ++j)
+              result_.pack(op_, i, j, data_, ld_);
+        }
 
-      virtual tbb::task execute() {
-        gemm(op_a_, op_b_, m_, n_, k_, alpha_, a_.get(), Size, b_.get(), Size, c_, ldc_);
-      }
+      }; // class MatrixBlockTask
+
+
+      /// Task body that computes a range of result blocks
+
+      /// \tparam S1 The type of \c alpha
+      /// \tparam T1 The left-hand matrix element type
+      /// \tparam T2 The right-hand matrix element type
+      /// \tparam S2 The type of \c beta
+      /// \tparam T3 The result matrix element type
+      template <typename S1, typename T1, typename T2, typename S2, typename T3>
+      class GemmTask {
+        const PackedMatrix<T1>& a_; ///< Packed op(A)
+        const PackedMatrix<T2>& b_; ///< Packed op(B)
+        const S1 alpha_; ///< Scaling factor for op(A)*op(B)
+        const S2 beta_; ///< Scaling factor for C
+        T3* const c_; ///< The result matrix
+        const integer ldc_; ///< Leading dimension of c_
+        const integer block_size_; ///< Block dimension
+
+      public:
+        GemmTask(const PackedMatrix<T1>& a, const PackedMatrix<T2>& b,
+            const S1 alpha, const S2 beta, T3* const c, const integer ldc,
+            const integer block_size) :
+          a_(a), b_(b), alpha_(alpha), beta_(beta), c_(c), ldc_(ldc),
+          block_size_(block_size)
+        { }
+
+        void operator()(const tbb::blocked_range2d<integer>& range) const {
+          for(integer i = range.rows().begin(); i != range.rows().end(); ++i) {
+            for(integer j = range.cols().begin(); j != range.cols().end(); ++j) {
+              T3* const c_ij = c_ + (i * block_size_ * ldc_) + (j * block_size_);
+
+              // Accumulate the inner products of block row i of op(A) and
+              // block column j of op(B) into block (i,j) of C.
+              math::gemm(madness::cblas::NoTrans, madness::cblas::NoTrans,
+                  a_.rows(i), b_.cols(j), a_.cols(0), alpha_, a_.block(i, 0),
+                  a_.cols(0), b_.block(0, j), b_.cols(j), beta_, c_ij, ldc_);
+              for(integer x = 1; x < a_.block_cols(); ++x)
+                math::gemm(madness::cblas::NoTrans, madness::cblas::NoTrans,
+                    a_.rows(i), b_.cols(j), a_.cols(x), alpha_, a_.block(i, x),
+                    a_.cols(x), b_.block(x, j), b_.cols(j), S2(1), c_ij, ldc_);
+            }
+          }
+        }
 
-    }; // class GemmTask
+      }; // class GemmTask
+
+#endif // HAVE_INTEL_TBB
+
+    } // namespace detail
+
+
+    /// Blocked, multithreaded GEMM
+
+    /// Compute <tt>C = alpha * op(A) * op(B) + beta * C</tt>, where all
+    /// matrices are stored in row-major order. When the operation is large
+    /// enough (see \c ParallelGemmParams ), <tt>op(A)</tt> and <tt>op(B)</tt>
+    /// are packed into contiguous, cache-sized blocks and the blocks of \c C
+    /// are computed concurrently with TBB, by at most
+    /// \c ParallelGemmParams::max_threads() threads. Only one multithreaded
+    /// GEMM runs at a time in each process, so calls from concurrent tasks
+    /// do not oversubscribe the cores. Otherwise, or when TBB is not
+    /// available, this is equivalent to \c gemm .
+    /// \param op_a The operation applied to \c a
+    /// \param op_b The operation applied to \c b
+    /// \param m The number of rows in <tt>op(A)</tt> and \c C
+    /// \param n The number of columns in <tt>op(B)</tt> and \c C
+    /// \param k The number of columns in <tt>op(A)</tt> and rows in <tt>op(B)</tt>
+    /// \param alpha The scaling factor for <tt>op(A) * op(B)</tt>
+    /// \param a A pointer to the first element of \c A
+    /// \param lda The leading dimension of \c a
+    /// \param b A pointer to the first element of \c B
+    /// \param ldb The leading dimension of \c b
+    /// \param beta The scaling factor for \c C
+    /// \param c A pointer to the first element of \c C
+    /// \param ldc The leading dimension of \c c
+    /// \param parallel If \c false , this is equivalent to \c gemm
+    template <typename S1, typename T1, typename T2, typename S2, typename T3>
+    inline void parallel_gemm(madness::cblas::CBLAS_TRANSPOSE op_a,
+        madness::cblas::CBLAS_TRANSPOSE op_b, const integer m, const integer n,
+        const integer k, const S1 alpha, const T1* a, const integer lda,
+        const T2* b, const integer ldb, const S2 beta, T3* c, const integer ldc,
+        const bool parallel = true)
+    {
+#ifdef HAVE_INTEL_TBB
+      const integer block_size = ParallelGemmParams::block_size();
+      if(parallel &&
+          ((std::size_t(m) * std::size_t(n) * std::size_t(k)) >= ParallelGemmParams::threshold())
+          && ((m > block_size) || (n > block_size)) && (k > 0)
+          && detail::acquire_parallel_gemm())
+      {
+        struct Release {
+          ~Release() { detail::release_parallel_gemm(); }
+        } release;
+
+        typedef typename detail::packed_element<T1, T3>::type packed_a_type;
+        typedef typename detail::packed_element<T2, T3>::type packed_b_type;
+        detail::PackedMatrix<packed_a_type> packed_a(m, k, block_size);
+        detail::PackedMatrix<packed_b_type> packed_b(k, n, block_size);
+
+        const int max_threads = ParallelGemmParams::max_threads();
+        tbb::task_arena arena(max_threads > 0 ? max_threads :
+            tbb::task_arena::automatic);
+        arena.execute([&] () {
+          tbb::parallel_for(tbb::blocked_range2d<integer>(0, packed_a.block_rows(),
+              0, packed_a.block_cols()),
+              detail::MatrixBlockTask<packed_a_type, T1>(packed_a, op_a, a, lda));
+          tbb::parallel_for(tbb::blocked_range2d<integer>(0, packed_b.block_rows(),
+              0, packed_b.block_cols()),
+              detail::MatrixBlockTask<packed_b_type, T2>(packed_b, op_b, b, ldb));
+
+          tbb::parallel_for(tbb::blocked_range2d<integer>(0, packed_a.block_rows(),
+              1, 0, packed_b.block_cols(), 1),
+              detail::GemmTask<S1, packed_a_type, packed_b_type, S2, T3>(packed_a,
+              packed_b, alpha, beta, c, ldc, block_size));
+        });
+        return;
+      }
+#endif // HAVE_INTEL_TBB
 
-//#endif // HAVE_INTEL_TBB
+      math::gemm(op_a, op_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
 
   }  // namespace math
 } // namespace TiledArray
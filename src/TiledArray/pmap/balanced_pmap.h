@@ -0,0 +1,127 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  balanced_pmap.h
+ *  Jun 6, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_PMAP_BALANCED_PMAP_H__INCLUDED
+#define TILEDARRAY_PMAP_BALANCED_PMAP_H__INCLUDED
+
+#include <TiledArray/pmap/pmap.h>
+#include <algorithm>
+#include <vector>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// A cost-balanced, blocked process map
+
+    /// Map N elements among P processes into contiguous blocks, such that the
+    /// total cost of the elements in each block is approximately equal. The
+    /// cost of an element is an estimate of the work or storage associated
+    /// with it (e.g. the volume of a non-zero tile, and zero for a zero tile).
+    /// When all costs are zero, the elements are divided as in
+    /// \c BlockedPmap . Only the block boundaries are stored, so the owner of
+    /// an element is found in O(log P) time.
+    class BalancedPmap : public Pmap {
+    protected:
+
+      // Import Pmap protected variables
+      using Pmap::rank_; ///< The rank of this process
+      using Pmap::procs_; ///< The number of processes
+      using Pmap::size_; ///< The number of tiles mapped among all processes
+      using Pmap::local_; ///< A list of local tiles
+
+    private:
+
+      std::vector<size_type> first_; ///< The first element of each process's block
+
+    public:
+      typedef Pmap::size_type size_type; ///< Key type
+
+      /// Construct a balanced map
+
+      /// \param world The world where the tiles will be mapped
+      /// \param costs The cost of each tile, which must be identical on all
+      /// processes
+      /// \throw TiledArray::Exception When \c costs is empty
+      /// \throw TiledArray::Exception When a cost is negative
+      BalancedPmap(World& world, const std::vector<double>& costs) :
+        Pmap(world, costs.size()), first_(procs_ + 1ul, 0ul)
+      {
+        // Compute the cumulative cost of the elements, where
+        // cumulative[i] = costs[0] + ... + costs[i - 1]
+        std::vector<double> cumulative(size_ + 1ul, 0.0);
+        for(size_type i = 0ul; i < size_; ++i) {
+          TA_ASSERT(costs[i] >= 0.0);
+          cumulative[i + 1ul] = cumulative[i] + costs[i];
+        }
+        if(cumulative.back() <= 0.0) {
+          // All elements have zero cost so use a uniform cost
+          for(size_type i = 0ul; i <= size_; ++i)
+            cumulative[i] = i;
+        }
+
+        // Select the block boundaries that are closest to the ideal
+        // cumulative cost of each block
+        const double total = cumulative.back();
+        for(size_type p = 1ul; p < procs_; ++p) {
+          const double target = total * double(p) / double(procs_);
+          size_type first = std::lower_bound(cumulative.begin(),
+              cumulative.end(), target) - cumulative.begin();
+          if((first > 0ul) && ((target - cumulative[first - 1ul]) < (cumulative[first] - target)))
+            --first;
+          first_[p] = std::max(first, first_[p - 1ul]);
+        }
+        first_[procs_] = size_;
+
+        // Construct a map of all local processes
+        local_.reserve(first_[rank_ + 1ul] - first_[rank_]);
+        for(size_type first = first_[rank_]; first < first_[rank_ + 1ul]; ++first) {
+          TA_ASSERT(BalancedPmap::owner(first) == rank_);
+          local_.push_back(first);
+        }
+      }
+
+      virtual ~BalancedPmap() { }
+
+      /// Maps \c tile to the processor that owns it
+
+      /// \param tile The tile to be queried
+      /// \return Processor that logically owns \c tile
+      virtual size_type owner(const size_type tile) const {
+        TA_ASSERT(tile < size_);
+        return (std::upper_bound(first_.begin(), first_.end(), tile) - first_.begin()) - 1ul;
+      }
+
+
+      /// Check that the tile is owned by this process
+
+      /// \param tile The tile to be checked
+      /// \return \c true if \c tile is owned by this process, otherwise \c false .
+      virtual bool is_local(const size_type tile) const {
+        return ((tile >= first_[rank_]) && (tile < first_[rank_ + 1ul]));
+      }
+    }; // class BalancedPmap
+
+  }  // namespace detail
+}  // namespace TiledArray
+
+
+#endif // TILEDARRAY_PMAP_BALANCED_PMAP_H__INCLUDED
@@ -0,0 +1,184 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  layered_pmap.h
+ *  Jun 4, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_PMAP_LAYERED_PMAP_H__INCLUDED
+#define TILEDARRAY_PMAP_LAYERED_PMAP_H__INCLUDED
+
+#include <TiledArray/pmap/pmap.h>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Maps cyclically a sequence of indices onto layers of 2-d process matrices
+
+    /// The processes are divided into \f$ L \f$ layers of
+    /// \f$ P / L \f$ consecutive processes, and the first
+    /// \f$ P_{\rm row} P_{\rm col} \f$ processes of each layer are organized
+    /// into a matrix as in \c CyclicPmap . When the layers are distributed over
+    /// columns, index \f$ \{ k_{\rm row}, k_{\rm col} \} \f$ is mapped to layer
+    /// \f$ k_{\rm col} \% L \f$ and to process
+    /// \f$ \{ k_{\rm row} \% P_{\rm row}, (k_{\rm col} / L) \% P_{\rm col} \} \f$
+    /// in that layer; the roles of the rows and columns are exchanged when the
+    /// layers are distributed over rows.
+    ///
+    /// \note This class is used to map <em>tile</em> indices to processes.
+    class LayeredCyclicPmap : public Pmap {
+    protected:
+
+      // Import Pmap protected variables
+      using Pmap::rank_; ///< The rank of this process
+      using Pmap::procs_; ///< The number of processes
+      using Pmap::size_; ///< The number of tiles mapped among all processes
+      using Pmap::local_; ///< A list of local tiles
+
+    private:
+
+      const size_type rows_; ///< Number of tile rows to be mapped
+      const size_type cols_; ///< Number of tile columns to be mapped
+      const size_type proc_cols_; ///< Number of process columns
+      const size_type proc_rows_; ///< Number of process rows
+      const size_type layers_; ///< Number of process layers
+      const size_type layer_procs_; ///< Number of processes in each layer
+      const bool layer_rows_; ///< Distribute rows, instead of columns, over layers
+
+    public:
+      typedef Pmap::size_type size_type; ///< Size type
+
+      /// Construct process map
+
+      /// \param world The world where the tiles will be mapped
+      /// \param rows The number of tile rows to be mapped
+      /// \param cols The number of tile columns to be mapped
+      /// \param proc_rows The number of process rows in each layer
+      /// \param proc_cols The number of process columns in each layer
+      /// \param layers The number of process layers
+      /// \param layer_rows If \c true , tile rows are distributed over the
+      /// layers, otherwise tile columns are distributed over the layers
+      /// \throw TiledArray::Exception When <tt>layers > world.size()</tt>
+      /// \throw TiledArray::Exception When <tt>proc_rows * proc_cols > world.size() / layers</tt>
+      LayeredCyclicPmap(World& world, size_type rows, size_type cols,
+          size_type proc_rows, size_type proc_cols, size_type layers,
+          bool layer_rows) :
+        Pmap(world, rows * cols), rows_(rows), cols_(cols),
+        proc_cols_(proc_cols), proc_rows_(proc_rows), layers_(layers),
+        layer_procs_(layers ? procs_ / layers : 0ul), layer_rows_(layer_rows)
+      {
+        // Check that the size is non-zero
+        TA_ASSERT(rows_ >= 1ul);
+        TA_ASSERT(cols_ >= 1ul);
+
+        // Check limits of process rows, columns, and layers
+        TA_ASSERT(layers_ >= 1ul);
+        TA_ASSERT(layers_ <= procs_);
+        TA_ASSERT(proc_rows_ >= 1ul);
+        TA_ASSERT(proc_cols_ >= 1ul);
+        TA_ASSERT((proc_rows_ * proc_cols_) <= layer_procs_);
+
+        // Initialize local tile list
+        const size_type layer = rank_ / layer_procs_;
+        const size_type layer_rank = rank_ % layer_procs_;
+        if((layer < layers_) && (layer_rank < (proc_rows_ * proc_cols_))) {
+          // Compute rank coordinates
+          const size_type rank_row = layer_rank / proc_cols_;
+          const size_type rank_col = layer_rank % proc_cols_;
+
+          // Compute the first local row and column, and the stride between
+          // local rows and columns
+          const size_type row_start =
+              (layer_rows_ ? rank_row * layers_ + layer : rank_row);
+          const size_type row_stride =
+              (layer_rows_ ? proc_rows_ * layers_ : proc_rows_);
+          const size_type col_start =
+              (layer_rows_ ? rank_col : rank_col * layers_ + layer);
+          const size_type col_stride =
+              (layer_rows_ ? proc_cols_ : proc_cols_ * layers_);
+
+          // Iterate over local tiles
+          for(size_type i = row_start; i < rows_; i += row_stride) {
+            const size_type row_end = (i + 1) * cols_;
+            for(size_type tile = i * cols_ + col_start; tile < row_end; tile += col_stride) {
+              TA_ASSERT(LayeredCyclicPmap::owner(tile) == rank_);
+              local_.push_back(tile);
+            }
+          }
+        }
+      }
+
+      virtual ~LayeredCyclicPmap() { }
+
+      /// Access number of rows in the tile index matrix
+      size_type nrows() const { return rows_; }
+      /// Access number of columns in the tile index matrix
+      size_type ncols() const { return cols_; }
+      /// Access number of rows in the process matrix of each layer
+      size_type nrows_proc() const { return proc_rows_; }
+      /// Access number of columns in the process matrix of each layer
+      size_type ncols_proc() const { return proc_cols_; }
+      /// Access number of process layers
+      size_type nlayers() const { return layers_; }
+
+      /// Maps \c tile to the processor that owns it
+
+      /// \param tile The tile to be queried
+      /// \return Processor that logically owns \c tile
+      virtual size_type owner(const size_type tile) const {
+        TA_ASSERT(tile < size_);
+        // Compute tile coordinate in tile grid
+        size_type tile_row = tile / cols_;
+        size_type tile_col = tile % cols_;
+        // Compute the layer of the tile, and its coordinate within the layer
+        size_type layer = 0ul;
+        if(layer_rows_) {
+          layer = tile_row % layers_;
+          tile_row /= layers_;
+        } else {
+          layer = tile_col % layers_;
+          tile_col /= layers_;
+        }
+        // Compute process coordinate of tile in the process grid
+        const size_type proc_row = tile_row % proc_rows_;
+        const size_type proc_col = tile_col % proc_cols_;
+        // Compute the process that owns tile
+        const size_type proc =
+            layer * layer_procs_ + proc_row * proc_cols_ + proc_col;
+
+        TA_ASSERT(proc < procs_);
+
+        return proc;
+      }
+
+
+      /// Check that the tile is owned by this process
+
+      /// \param tile The tile to be checked
+      /// \return \c true if \c tile is owned by this process, otherwise \c false .
+      virtual bool is_local(const size_type tile) const {
+        return (LayeredCyclicPmap::owner(tile) == rank_);
+      }
+
+    }; // class LayeredCyclicPmap
+
+  }  // namespace detail
+}  // namespace TiledArray
+
+
+#endif // TILEDARRAY_PMAP_LAYERED_PMAP_H__INCLUDED
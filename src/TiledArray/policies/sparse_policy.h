@@ -28,7 +28,12 @@
 
 #include <TiledArray/tiled_range.h>
 #include <TiledArray/pmap/blocked_pmap.h>
+#include <TiledArray/pmap/balanced_pmap.h>
 #include <TiledArray/sparse_shape.h>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
 
 namespace TiledArray {
 
@@ -51,6 +56,132 @@ namespace TiledArray {
       return std::make_shared<default_pmap_type>(world, size);
     }
 
+    /// Create a process map that balances the non-zero elements of an array
+
+    /// The non-zero tiles are distributed such that each process holds
+    /// approximately the same number of non-zero elements. A tile is
+    /// non-zero when its norm in \c shape.data() is not below the shape
+    /// threshold. This map is not used by default, since it scans the shape;
+    /// pass it to the array constructor, e.g.
+    /// \code
+    /// TSpArrayD a(world, trange, shape,
+    ///     SparsePolicy::balanced_pmap(world, trange, shape));
+    /// \endcode
+    /// \param world The world of the process map
+    /// \param trange The tiled range of the array
+    /// \param shape The shape of the array
+    /// \return A shared pointer to a process map
+    static std::shared_ptr<pmap_interface>
+    balanced_pmap(World& world, const trange_type& trange, const shape_type& shape) {
+      const std::size_t size = trange.tiles_range().volume();
+      if(world.size() == 1)
+        return default_pmap(world, size);
+
+      // The cost of a tile is the number of elements in non-zero tiles
+      const shape_type norms = shape.decompress();
+      const float threshold = shape_type::threshold();
+      std::vector<double> costs(size, 0.0);
+      for(std::size_t i = 0ul; i < size; ++i)
+        if(norms.data()[i] >= threshold)
+          costs[i] = trange.make_tile_range(i).volume();
+
+      return std::make_shared<TiledArray::detail::BalancedPmap>(world, costs);
+    }
+
+    /// Selection of cost-balanced contraction results
+
+    /// When this value is \c true , the result tiles of sparse contractions
+    /// that are not assigned to an existing array, are not permuted, and use
+    /// a 2D process grid are distributed with \c ProcGrid::make_pmap(costs) , where the costs are
+    /// given by \c contraction_costs() . Otherwise, the result follows the
+    /// process grid of the contraction. It is \c false unless the
+    /// \c TA_BALANCED_CONTRACTIONS environment variable is a non-zero
+    /// integer, and may be changed at runtime by assigning to the returned
+    /// value. All processes must use the same value.
+    /// \return A reference to the selection
+    static bool& balanced_contractions() {
+      static bool enabled = [] () {
+        const char* const value = getenv("TA_BALANCED_CONTRACTIONS");
+        if(! value)
+          return false;
+        std::stringstream ss(value);
+        long long setting = 0ll;
+        std::string rest;
+        return (ss >> setting) && !(ss >> rest) && (setting != 0ll);
+      }();
+      return enabled;
+    }
+
+    /// Estimate the cost of each result tile of a contraction
+
+    /// The arguments and the result are viewed as matrices of tiles, where
+    /// the left-hand argument is \f$ M \times K \f$ , the right-hand
+    /// argument is \f$ K \times N \f$ , and the result is
+    /// \f$ M \times N \f$ . The cost of a non-zero result tile is the
+    /// number of floating point operations of the tile products that SUMMA
+    /// evaluates for it,
+    /// \f[
+    ///   c_{ij} = \sum_{k : |A_{ik}|, |B_{kj}| \geq \tau} 2 m_i n_j k_k
+    /// \f]
+    /// where the tile norms are taken from \c data() of the argument shapes,
+    /// \f$ \tau \f$ is the shape threshold, and \f$ 2 m_i n_j k_k \f$ is
+    /// computed from the tile volumes as
+    /// \f$ 2 \sqrt{(m_i k_k) (k_k n_j) (m_i n_j)} \f$ . Zero result tiles
+    /// have no cost.
+    /// \param left_trange The tiled range of the left-hand argument
+    /// \param left_shape The shape of the left-hand argument
+    /// \param right_trange The tiled range of the right-hand argument
+    /// \param right_shape The shape of the right-hand argument
+    /// \param trange The tiled range of the result
+    /// \param shape The shape of the result
+    /// \return The cost of each result tile
+    static std::vector<double>
+    contraction_costs(const trange_type& left_trange, const shape_type& left_shape,
+        const trange_type& right_trange, const shape_type& right_shape,
+        const trange_type& trange, const shape_type& shape)
+    {
+      // Compute the matrix dimensions of the tiles
+      const unsigned int inner_rank = (left_trange.tiles_range().rank() +
+          right_trange.tiles_range().rank() - trange.tiles_range().rank()) / 2u;
+      const unsigned int left_outer_rank = left_trange.tiles_range().rank() - inner_rank;
+      std::size_t M = 1ul;
+      for(unsigned int i = 0u; i < left_outer_rank; ++i)
+        M *= left_trange.tiles_range().extent_data()[i];
+      const std::size_t K = left_trange.tiles_range().volume() / M;
+      const std::size_t N = right_trange.tiles_range().volume() / K;
+      TA_ASSERT(trange.tiles_range().volume() == (M * N));
+
+      // Cache the volumes of the non-zero argument tiles
+      const float threshold = shape_type::threshold();
+      const shape_type left_norms = left_shape.decompress();
+      const shape_type right_norms = right_shape.decompress();
+      std::vector<double> left_volumes(M * K, 0.0);
+      for(std::size_t ik = 0ul; ik < left_volumes.size(); ++ik)
+        if(left_norms.data()[ik] >= threshold)
+          left_volumes[ik] = left_trange.make_tile_range(ik).volume();
+      std::vector<double> right_volumes(K * N, 0.0);
+      for(std::size_t kj = 0ul; kj < right_volumes.size(); ++kj)
+        if(right_norms.data()[kj] >= threshold)
+          right_volumes[kj] = right_trange.make_tile_range(kj).volume();
+
+      std::vector<double> costs(M * N, 0.0);
+      for(std::size_t i = 0ul, ij = 0ul; i < M; ++i) {
+        for(std::size_t j = 0ul; j < N; ++j, ++ij) {
+          if(shape.is_zero(ij))
+            continue;
+
+          const double volume = trange.make_tile_range(ij).volume();
+          double cost = 0.0;
+          for(std::size_t k = 0ul; k < K; ++k)
+            cost += std::sqrt(left_volumes[i * K + k] *
+                right_volumes[k * N + j] * volume);
+          costs[ij] = 2.0 * cost;
+        }
+      }
+
+      return costs;
+    }
+
   }; // class SparsePolicy
 
 } // namespace TiledArray
@@ -0,0 +1,425 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  pool_allocator.h
+ *  Jun 13, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_POOL_ALLOCATOR_H__INCLUDED
+#define TILEDARRAY_POOL_ALLOCATOR_H__INCLUDED
+
+#include <TiledArray/madness.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Size-class memory pool
+
+    /// Memory is allocated in blocks whose sizes are rounded up to one of
+    /// four size classes per power of two (i.e. \f$ 2^k \f$ ,
+    /// \f$ 1.25 \cdot 2^k \f$ , \f$ 1.5 \cdot 2^k \f$ , and
+    /// \f$ 1.75 \cdot 2^k \f$ ), so at most 25% of a block is unused.
+    /// Deallocated blocks are kept in free lists and reused by later
+    /// allocations of the same size class, which avoids the system allocator
+    /// (and page faults on freshly mapped memory) in codes that repeatedly
+    /// allocate and free tiles of similar sizes. Small blocks are first
+    /// returned to a free list that is private to the deallocating thread, so
+    /// most allocations by task threads do not lock; larger blocks, and small
+    /// blocks that do not fit in the thread free lists, are returned to global
+    /// free lists that are guarded by a spinlock per size class.
+    ///
+    /// All blocks are aligned to the cache line size; blocks that are at least
+    /// as large as a huge page are aligned to the huge page size and, on
+    /// Linux, are marked as candidates for transparent huge pages. Requests
+    /// that are larger than the largest size class bypass the free lists.
+    ///
+    /// The pool records the number of bytes in use and its high-water mark.
+    /// Cached blocks are only returned to the system by \c release() .
+    class MemoryPool {
+    public:
+      typedef std::size_t size_type; ///< Size type
+
+#ifdef TILEDARRAY_CACHELINE_SIZE
+      static constexpr size_type alignment = TILEDARRAY_CACHELINE_SIZE; ///< Block alignment
+#else
+      static constexpr size_type alignment = 64ul; ///< Block alignment
+#endif // TILEDARRAY_CACHELINE_SIZE
+      static constexpr size_type huge_page_size = 2097152ul; ///< Huge page size (2 MiB)
+      static constexpr size_type min_block_size = 64ul; ///< Size of the smallest size class
+      static constexpr size_type max_block_size = 1073741824ul; ///< Size of the largest size class (1 GiB)
+      static constexpr size_type max_thread_block_size = 262144ul; ///< Largest block kept in thread free lists (256 KiB)
+      static constexpr size_type max_thread_blocks = 32ul; ///< Maximum number of blocks per size class in each thread free list
+      static constexpr unsigned int num_classes = 97u; ///< Number of size classes
+
+    private:
+
+      typedef std::vector<void*> free_list_type;
+
+      /// Global free list of a size class
+      struct GlobalList : public madness::Spinlock {
+        free_list_type blocks; ///< Free blocks
+      }; // struct GlobalList
+
+      /// Thread-private free lists
+
+      /// The blocks of a thread are returned to the global free lists when
+      /// the thread exits.
+      struct ThreadCache {
+        std::array<free_list_type, num_classes> lists; ///< Free blocks
+
+        ~ThreadCache() {
+          MemoryPool& pool = MemoryPool::instance();
+          for(unsigned int c = 0u; c < num_classes; ++c)
+            for(void* block : lists[c])
+              pool.push_global(c, block);
+        }
+      }; // struct ThreadCache
+
+      std::array<GlobalList, num_classes> global_; ///< Global free lists
+      std::atomic<size_type> bytes_; ///< Bytes in use
+      std::atomic<size_type> high_water_mark_; ///< The maximum bytes in use
+      std::atomic<size_type> cached_bytes_; ///< Bytes in free lists
+      std::atomic<size_type> hits_; ///< Allocations taken from the free lists
+      std::atomic<size_type> misses_; ///< Allocations from the system
+
+      MemoryPool() :
+        global_(), bytes_(0ul), high_water_mark_(0ul), cached_bytes_(0ul),
+        hits_(0ul), misses_(0ul)
+      { }
+
+      // not allowed
+      MemoryPool(const MemoryPool&);
+      MemoryPool& operator=(const MemoryPool&);
+
+      /// The free lists of the calling thread
+      static ThreadCache& thread_cache() {
+        static thread_local ThreadCache cache;
+        return cache;
+      }
+
+      /// Allocate memory from the system
+
+      /// \param size The size of the block
+      /// \return A pointer to the block, or \c nullptr if the allocation failed
+      static void* system_allocate(const size_type size) {
+        void* block = nullptr;
+        const size_type align = (size >= huge_page_size ? huge_page_size : alignment);
+        if(posix_memalign(& block, align, size) != 0)
+          return nullptr;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if(size >= huge_page_size)
+          madvise(block, size, MADV_HUGEPAGE);
+#endif // defined(__linux__) && defined(MADV_HUGEPAGE)
+        return block;
+      }
+
+      /// Record an allocation of \c size bytes
+      void add_bytes(const size_type size) {
+        const size_type bytes = (bytes_ += size);
+        size_type hwm = high_water_mark_.load(std::memory_order_relaxed);
+        while((bytes > hwm) &&
+            ! high_water_mark_.compare_exchange_weak(hwm, bytes, std::memory_order_relaxed))
+        { }
+      }
+
+      void push_global(const unsigned int c, void* block) {
+        madness::ScopedMutex<madness::Spinlock> locker(& global_[c]);
+        global_[c].blocks.push_back(block);
+      }
+
+      void* pop_global(const unsigned int c) {
+        madness::ScopedMutex<madness::Spinlock> locker(& global_[c]);
+        if(global_[c].blocks.empty())
+          return nullptr;
+        void* block = global_[c].blocks.back();
+        global_[c].blocks.pop_back();
+        return block;
+      }
+
+    public:
+
+      /// The memory pool of this process
+
+      /// The pool is never destroyed, so tensors with static storage duration
+      /// may safely be destroyed after \c main returns.
+      /// \return A reference to the memory pool
+      static MemoryPool& instance() {
+        static MemoryPool* pool = new MemoryPool();
+        return *pool;
+      }
+
+      /// Size class of a request
+
+      /// \param size The number of bytes requested
+      /// \return The size class of \c size , or \c num_classes if \c size is
+      /// larger than \c max_block_size
+      static unsigned int size_class(const size_type size) {
+        if(size <= min_block_size)
+          return 0u;
+        if(size > max_block_size)
+          return num_classes;
+
+        // Find k, such that 2^k < size <= 2^(k+1)
+        unsigned int k = 0u;
+        for(size_type n = size - 1ul; n > 1ul; n >>= 1)
+          ++k;
+        const size_type base = 1ul << k;
+        const size_type quarter = base >> 2;
+        const unsigned int sub = (size - base + quarter - 1ul) / quarter;
+        return (k - 6u) * 4u + sub;
+      }
+
+      /// Block size of a size class
+
+      /// \param c The size class
+      /// \return The size of the blocks in size class \c c
+      static size_type class_size(const unsigned int c) {
+        TA_ASSERT(c < num_classes);
+        if(c == 0u)
+          return min_block_size;
+        const unsigned int k = 6u + (c - 1u) / 4u;
+        const size_type sub = (c - 1u) % 4u + 1u;
+        return (1ul << k) + sub * (1ul << (k - 2u));
+      }
+
+      /// Allocate a block
+
+      /// \param size The number of bytes to allocate
+      /// \return A pointer to an aligned block of at least \c size bytes, or
+      /// \c nullptr if \c size is zero
+      /// \throw std::bad_alloc If the system allocation fails
+      void* allocate(const size_type size) {
+        if(size == 0ul)
+          return nullptr;
+
+        const unsigned int c = size_class(size);
+        const size_type block_size = (c < num_classes ? class_size(c) : size);
+        void* block = nullptr;
+
+        // Take a block from the thread or global free list
+        if(c < num_classes) {
+          if(block_size <= max_thread_block_size) {
+            free_list_type& list = thread_cache().lists[c];
+            if(! list.empty()) {
+              block = list.back();
+              list.pop_back();
+            }
+          }
+          if(! block)
+            block = pop_global(c);
+        }
+
+        if(block) {
+          cached_bytes_ -= block_size;
+          ++hits_;
+        } else {
+          block = system_allocate(block_size);
+          if(! block) {
+            // Return the cached blocks to the system and try again
+            release();
+            block = system_allocate(block_size);
+            if(! block)
+              throw std::bad_alloc();
+          }
+          ++misses_;
+        }
+
+        add_bytes(block_size);
+        return block;
+      }
+
+      /// Deallocate a block
+
+      /// \param block The block to be deallocated
+      /// \param size The number of bytes that was passed to \c allocate()
+      void deallocate(void* block, const size_type size) {
+        if(! block)
+          return;
+
+        const unsigned int c = size_class(size);
+        if(c == num_classes) {
+          bytes_ -= size;
+          free(block);
+          return;
+        }
+
+        const size_type block_size = class_size(c);
+        bytes_ -= block_size;
+        cached_bytes_ += block_size;
+        if(block_size <= max_thread_block_size) {
+          free_list_type& list = thread_cache().lists[c];
+          if(list.size() < max_thread_blocks) {
+            list.push_back(block);
+            return;
+          }
+        }
+        push_global(c, block);
+      }
+
+      /// Return cached blocks to the system
+
+      /// The global free lists and the free lists of the calling thread are
+      /// released. Blocks in the free lists of other threads are not affected.
+      void release() {
+        ThreadCache& cache = thread_cache();
+        for(unsigned int c = 0u; c < num_classes; ++c) {
+          free_list_type blocks;
+          blocks.swap(cache.lists[c]);
+          {
+            madness::ScopedMutex<madness::Spinlock> locker(& global_[c]);
+            blocks.insert(blocks.end(), global_[c].blocks.begin(),
+                global_[c].blocks.end());
+            free_list_type().swap(global_[c].blocks);
+          }
+          for(void* block : blocks)
+            free(block);
+          cached_bytes_ -= blocks.size() * class_size(c);
+        }
+      }
+
+      /// Bytes in use accessor
+
+      /// \return The number of bytes in blocks that are currently allocated,
+      /// including the padding of each block to its size class
+      size_type bytes() const { return bytes_; }
+
+      /// High-water mark accessor
+
+      /// \return The maximum value of \c bytes() since the pool was created or
+      /// \c reset_high_water_mark() was called
+      size_type high_water_mark() const { return high_water_mark_; }
+
+      /// Reset the high-water mark to the current number of bytes in use
+      void reset_high_water_mark() { high_water_mark_ = bytes_.load(); }
+
+      /// Cached bytes accessor
+
+      /// \return The number of bytes in the free lists of all threads
+      size_type cached_bytes() const { return cached_bytes_; }
+
+      /// Hit counter accessor
+
+      /// \return The number of allocations that reused a cached block
+      size_type hits() const { return hits_; }
+
+      /// Miss counter accessor
+
+      /// \return The number of allocations that used the system allocator
+      size_type misses() const { return misses_; }
+
+    }; // class MemoryPool
+
+  } // namespace detail
+
+  /// Pooled allocator
+
+  /// A standard allocator that allocates memory from
+  /// \c detail::MemoryPool::instance() . It can be used as the allocator of
+  /// \c Tensor to reuse tile memory, e.g.
+  /// \code
+  /// typedef TiledArray::Tensor<double, TiledArray::pool_allocator<double> > tile_type;
+  /// TiledArray::DistArray<tile_type> a(world, trange);
+  /// \endcode
+  /// Memory is aligned to the cache line size (or the huge page size for large
+  /// blocks), so this allocator can replace \c Eigen::aligned_allocator .
+  /// Statistics of the pool, e.g. the high-water mark of the tile memory, are
+  /// available via \c pool_allocator::pool() .
+  /// \tparam T The element type
+  template <typename T>
+  class pool_allocator {
+  public:
+    typedef T value_type; ///< Element type
+    typedef T* pointer; ///< Element pointer type
+    typedef const T* const_pointer; ///< Element const pointer type
+    typedef T& reference; ///< Element reference type
+    typedef const T& const_reference; ///< Element const reference type
+    typedef std::size_t size_type; ///< Size type
+    typedef std::ptrdiff_t difference_type; ///< Difference type
+
+    /// Rebind this allocator to another element type
+    template <typename U>
+    struct rebind { typedef pool_allocator<U> other; };
+
+    pool_allocator() noexcept { }
+    pool_allocator(const pool_allocator&) noexcept { }
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept { }
+
+    /// The memory pool used by all pool allocators
+
+    /// \return A reference to the memory pool
+    static detail::MemoryPool& pool() { return detail::MemoryPool::instance(); }
+
+    /// Allocate memory for \c n elements
+
+    /// \param n The number of elements
+    /// \return A pointer to uninitialized memory for \c n elements
+    /// \throw std::bad_alloc If the allocation fails
+    pointer allocate(const size_type n, const void* = nullptr) {
+      if(n > max_size())
+        throw std::bad_alloc();
+      return static_cast<pointer>(pool().allocate(n * sizeof(T)));
+    }
+
+    /// Deallocate memory
+
+    /// \param p A pointer returned by \c allocate(n)
+    /// \param n The number of elements that was passed to \c allocate()
+    void deallocate(pointer p, const size_type n) {
+      pool().deallocate(p, n * sizeof(T));
+    }
+
+    /// Maximum allocation size
+
+    /// \return The maximum number of elements that can be allocated
+    size_type max_size() const noexcept {
+      return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+      ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U* p) { p->~U(); }
+
+  }; // class pool_allocator
+
+  template <typename T, typename U>
+  inline bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) {
+    return true;
+  }
+
+  template <typename T, typename U>
+  inline bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) {
+    return false;
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_POOL_ALLOCATOR_H__INCLUDED
@@ -27,6 +27,8 @@
 #define TILEDARRAY_GRID_H__INCLUDED
 
 #include <TiledArray/pmap/cyclic_pmap.h>
+#include <TiledArray/pmap/layered_pmap.h>
+#include <TiledArray/pmap/balanced_pmap.h>
 #include <TiledArray/math/eigen.h>
 
 namespace TiledArray {
@@ -56,6 +58,12 @@ namespace TiledArray {
     /// \f]
     /// where the positive, real root of \f$P_{\rm{row}}\f$ give the optimal
     /// optimal communication time.
+    ///
+    /// The grid may also be replicated in depth (i.e. a 2.5D grid), in which
+    /// case the processes are divided into \c layers groups of
+    /// <tt>P/layers</tt> consecutive processes, and the 2D grid described
+    /// above is constructed for each layer. The inner dimension of a
+    /// contraction is distributed cyclically over the layers.
     class ProcGrid {
     public:
       typedef uint_fast32_t size_type;
@@ -74,6 +82,9 @@ namespace TiledArray {
       size_type local_rows_; ///< The number of local element rows
       size_type local_cols_; ///< The number of local element columns
       size_type local_size_; ///< Number of local elements
+      size_type layers_; ///< Number of process grid layers
+      size_type layer_procs_; ///< Number of processes in each layer
+      ProcessID rank_layer_; ///< This process's layer in the process grid
 
 
       /// Compute the number of process rows that minimizes communication
@@ -246,6 +257,35 @@ namespace TiledArray {
         }
       }
 
+      /// Layered member variable initialization
+
+      /// This function divides the processes into layers and initializes the
+      /// 2D process grid of the layer that contains \c rank . Processes that
+      /// are not included in any layer have no local elements.
+      void init_layers(const size_type rank, const size_type nprocs,
+          const std::size_t row_size, const std::size_t col_size)
+      {
+        layer_procs_ = nprocs / layers_;
+        init(rank % layer_procs_, layer_procs_, row_size, col_size);
+
+        if(rank < (layers_ * layer_procs_)) {
+          rank_layer_ = rank / layer_procs_;
+        } else {
+          // This process is not included in the grid
+          rank_row_ = -1;
+          rank_col_ = -1;
+          local_rows_ = 0u;
+          local_cols_ = 0u;
+          local_size_ = 0u;
+        }
+
+        if(local_size_ == 0u)
+          rank_layer_ = -1;
+      }
+
+      /// The rank offset of this process's layer
+      size_type layer_offset() const { return rank_layer_ * layer_procs_; }
+
     public:
       /// Default constructor
 
@@ -253,7 +293,8 @@ namespace TiledArray {
       ProcGrid() :
         world_(NULL), rows_(0u), cols_(0u), size_(0u), proc_rows_(0u),
         proc_cols_(0u), proc_size_(0u), rank_row_(0), rank_col_(0),
-        local_rows_(0u), local_cols_(0u), local_size_(0u)
+        local_rows_(0u), local_cols_(0u), local_size_(0u), layers_(1u),
+        layer_procs_(0u), rank_layer_(0)
       { }
 
       /// Construct a process grid
@@ -266,20 +307,26 @@ namespace TiledArray {
       /// \param cols The number of tile columns
       /// \param row_size The number of element rows
       /// \param col_size The number of element columns
+      /// \param layers The number of process grid layers (default = 1)
+      /// \throw TiledArray::Exception When <tt>layers > world.size()</tt>
       ProcGrid(World& world, const size_type rows, const size_type cols,
-          const std::size_t row_size, const std::size_t col_size) :
+          const std::size_t row_size, const std::size_t col_size,
+          const size_type layers = 1u) :
         world_(&world), rows_(rows), cols_(cols), size_(rows_ * cols_),
         proc_rows_(0ul), proc_cols_(0ul), proc_size_(0ul),
         rank_row_(-1), rank_col_(-1),
-        local_rows_(0ul), local_cols_(0ul), local_size_(0ul)
+        local_rows_(0ul), local_cols_(0ul), local_size_(0ul),
+        layers_(layers), layer_procs_(0ul), rank_layer_(-1)
       {
         // Check for non-zero sizes
         TA_ASSERT(rows_ >= 1u);
         TA_ASSERT(cols_ >= 1u);
         TA_ASSERT(row_size >= 1ul);
         TA_ASSERT(col_size >= 1ul);
+        TA_ASSERT(layers_ >= 1u);
+        TA_ASSERT(layers_ <= size_type(world_->size()));
 
-        init(world_->rank(), world_->size(), row_size, col_size);
+        init_layers(world_->rank(), world_->size(), row_size, col_size);
       }
 
 #ifdef TILEDARRAY_ENABLE_TEST_PROC_GRID
@@ -300,12 +347,15 @@ namespace TiledArray {
       /// \param cols The number of tile columns
       /// \param row_size The number of element rows
       /// \param col_size The number of element columns
+      /// \param layers The number of process grid layers (default = 1)
       ProcGrid(World& world, const size_type test_rank, size_type test_nprocs,
           const size_type rows, const size_type cols,
-          const std::size_t row_size, const std::size_t col_size) :
+          const std::size_t row_size, const std::size_t col_size,
+          const size_type layers = 1u) :
         world_(&world), rows_(rows), cols_(cols), size_(rows_ * cols_),
         proc_rows_(0u), proc_cols_(0u), proc_size_(0u), rank_row_(-1),
-        rank_col_(-1), local_rows_(0u), local_cols_(0u), local_size_(0u)
+        rank_col_(-1), local_rows_(0u), local_cols_(0u), local_size_(0u),
+        layers_(layers), layer_procs_(0u), rank_layer_(-1)
       {
         // Check for non-zero sizes
         TA_ASSERT(rows >= 1u);
@@ -313,8 +363,10 @@ namespace TiledArray {
         TA_ASSERT(row_size >= 1u);
         TA_ASSERT(col_size >= 1u);
         TA_ASSERT(test_rank < test_nprocs);
+        TA_ASSERT(layers_ >= 1u);
+        TA_ASSERT(layers_ <= test_nprocs);
 
-        init(test_rank, test_nprocs, row_size, col_size);
+        init_layers(test_rank, test_nprocs, row_size, col_size);
       }
 #endif // TILEDARRAY_ENABLE_TEST_PROC_GRID
 
@@ -330,7 +382,8 @@ namespace TiledArray {
         proc_cols_(other.proc_cols_), proc_size_(other.proc_size_),
         rank_row_(other.rank_row_), rank_col_(other.rank_col_),
         local_rows_(other.local_rows_), local_cols_(other.local_cols_),
-        local_size_(other.local_size_)
+        local_size_(other.local_size_), layers_(other.layers_),
+        layer_procs_(other.layer_procs_), rank_layer_(other.rank_layer_)
       { }
 
       /// Copy assignment operator
@@ -349,6 +402,9 @@ namespace TiledArray {
         local_rows_ = other.local_rows_;
         local_cols_ = other.local_cols_;
         local_size_ = other.local_size_;
+        layers_ = other.layers_;
+        layer_procs_ = other.layer_procs_;
+        rank_layer_ = other.rank_layer_;
 
         return *this;
       }
@@ -409,6 +465,16 @@ namespace TiledArray {
       /// less than the number of process in world).
       size_type proc_size() const { return proc_size_; }
 
+      /// Process grid layer count accessor
+
+      /// \return The number of layers in the process grid
+      size_type layers() const { return layers_; }
+
+      /// Rank layer accessor
+
+      /// \return The layer of this process in the process grid
+      ProcessID rank_layer() const { return rank_layer_; }
+
 
       /// Construct a row group
 
@@ -425,7 +491,7 @@ namespace TiledArray {
           proc_list.reserve(proc_cols_);
 
           // Populate the row process list
-          size_type p = rank_row_ * proc_cols_;
+          size_type p = layer_offset() + rank_row_ * proc_cols_;
           const size_type row_end = p + proc_cols_;
           for(; p < row_end; ++p)
             proc_list.push_back(p);
@@ -452,7 +518,8 @@ namespace TiledArray {
           proc_list.reserve(proc_rows_);
 
           // Populate the column process list
-          for(size_type p = rank_col_; p < proc_size_; p += proc_cols_)
+          const size_type col_end = layer_offset() + proc_size_;
+          for(size_type p = layer_offset() + rank_col_; p < col_end; p += proc_cols_)
             proc_list.push_back(p);
 
           // Construct the group
@@ -469,7 +536,7 @@ namespace TiledArray {
       /// \return The process the corresponds to the process coordinate \c (row,rank_col)
       ProcessID map_row(const size_type row) const {
         TA_ASSERT(row < proc_rows_);
-        return rank_col_ + row * proc_cols_;
+        return layer_offset() + rank_col_ + row * proc_cols_;
       }
 
       /// Map a column to the process in this process's row
@@ -478,12 +545,23 @@ namespace TiledArray {
       /// \return The process the corresponds to the process coordinate \c (rank_row,col)
       ProcessID map_col(const size_type col) const {
         TA_ASSERT(col < proc_cols_);
-        return rank_row_ * proc_cols_ + col;
+        return layer_offset() + rank_row_ * proc_cols_ + col;
+      }
+
+      /// Map a layer to the process at this process's row and column
+
+      /// \param layer The layer to be mapped
+      /// \return The process the corresponds to the process coordinate
+      /// \c (rank_row,rank_col) in \c layer
+      ProcessID map_layer(const size_type layer) const {
+        TA_ASSERT(layer < layers_);
+        return layer * layer_procs_ + rank_row_ * proc_cols_ + rank_col_;
       }
 
       /// Construct a cyclic process
 
       /// Construct a cyclic process map with the same phase as the process grid.
+      /// Elements are mapped to the processes of the first layer.
       /// \return Cyclic process map
       std::shared_ptr<Pmap> make_pmap() const {
         TA_ASSERT(world_);
@@ -491,27 +569,53 @@ namespace TiledArray {
         return std::make_shared<CyclicPmap>(*world_, rows_, cols_, proc_rows_, proc_cols_);
       }
 
+      /// Construct a cost-balanced process map
+
+      /// Construct a process map where the tiles are divided into contiguous
+      /// blocks of approximately equal cost (see \c BalancedPmap ). This map
+      /// does not follow the phase of the process grid, so each result tile
+      /// is sent from the process that reduces it to its owner.
+      /// \param costs The cost of each tile, which must be identical on all
+      /// processes
+      /// \return Balanced process map
+      /// \throw TiledArray::Exception When the size of \c costs is not equal
+      /// to the number of tiles in the grid
+      std::shared_ptr<Pmap> make_pmap(const std::vector<double>& costs) const {
+        TA_ASSERT(world_);
+        TA_ASSERT(costs.size() == size_);
+
+        return std::make_shared<BalancedPmap>(*world_, costs);
+      }
+
       /// Construct column phased a cyclic process
 
       /// Construct a cyclic process map where the column phase of the process
-      /// matches that of this process grid.
+      /// matches that of this process grid. When the grid has more than one
+      /// layer, the rows are distributed cyclically over the layers.
       /// \param rows The number of rows in the process map
       /// \return Cyclic process map with matching column phase
       std::shared_ptr<Pmap> make_col_phase_pmap(const size_type rows) const {
         TA_ASSERT(world_);
 
+        if(layers_ > 1u)
+          return std::make_shared<LayeredCyclicPmap>(*world_, rows, cols_,
+              proc_rows_, proc_cols_, layers_, true);
         return std::make_shared<CyclicPmap>(*world_, rows, cols_, proc_rows_, proc_cols_);
       }
 
       /// Construct row phased a cyclic process
 
       /// Construct a cyclic process map where the column phase of the process
-      /// matches that of this process grid.
+      /// matches that of this process grid. When the grid has more than one
+      /// layer, the columns are distributed cyclically over the layers.
       /// \param cols The number of columns in the process map
       /// \return Cyclic process map with matching column phase
       std::shared_ptr<Pmap> make_row_phase_pmap(const size_type cols) const {
         TA_ASSERT(world_);
 
+        if(layers_ > 1u)
+          return std::make_shared<LayeredCyclicPmap>(*world_, rows_, cols,
+              proc_rows_, proc_cols_, layers_, false);
         return std::make_shared<CyclicPmap>(*world_, rows_, cols, proc_rows_, proc_cols_);
       }
     }; // class Grid
@@ -23,6 +23,7 @@
 #include <TiledArray/range_iterator.h>
 #include <TiledArray/permutation.h>
 #include <TiledArray/size_array.h>
+#include <cstring>
 
 namespace TiledArray {
 
@@ -35,6 +36,11 @@ namespace TiledArray {
   /// test if an element is included in the range with a coordinate index or
   /// ordinal offset. Finally, it can be used to convert coordinate indices to
   /// ordinal offsets and vice versa.
+  ///
+  /// The dimension data of ranges with rank less than or equal to
+  /// \c Range::inline_rank is stored in the range object; only ranges with a
+  /// larger rank allocate memory for it. The maximum inline rank may be set
+  /// with the \c TILEDARRAY_RANGE_INLINE_RANK macro.
   /// TODO add Range support for negative indices
   class Range {
   public:
@@ -48,6 +54,12 @@ namespace TiledArray {
     typedef detail::RangeIterator<size_type, Range_> const_iterator; ///< Coordinate iterator
     friend class detail::RangeIterator<size_type, Range_>;
 
+#ifdef TILEDARRAY_RANGE_INLINE_RANK
+    static constexpr unsigned int inline_rank = TILEDARRAY_RANGE_INLINE_RANK; ///< Maximum rank of ranges that do not allocate memory
+#else
+    static constexpr unsigned int inline_rank = 4u; ///< Maximum rank of ranges that do not allocate memory
+#endif // TILEDARRAY_RANGE_INLINE_RANK
+
   protected:
 
     size_type* data_ = nullptr;
@@ -62,6 +74,63 @@ namespace TiledArray {
     size_type offset_ = 0ul; ///< Ordinal index offset correction
     size_type volume_ = 0ul; ///< Total number of elements
     unsigned int rank_ = 0u; ///< The rank (or number of dimensions) in the range
+    size_type inline_data_[(inline_rank > 0u ? inline_rank : 1u) << 2];
+                      ///< Storage for the dimension information of ranges
+                      ///< with rank less than or equal to \c inline_rank
+
+    /// Allocate memory for the range data
+
+    /// \param n The rank of the range
+    /// \pre \c data_ does not hold allocated memory
+    /// \post \c rank_ is equal to \c n , and \c data_ points to the inline
+    /// storage or to allocated memory that holds 4*n elements (or is
+    /// \c nullptr if \c n is zero)
+    /// \throw std::bad_alloc When memory allocation fails.
+    void alloc_data(const unsigned int n) {
+      data_ = (n == 0u ? nullptr :
+          (n <= inline_rank ? inline_data_ : new size_type[n << 2]));
+      rank_ = n;
+    }
+
+    /// Free the memory that holds the range data
+    void free_data() {
+      if(data_ != inline_data_)
+        delete [] data_;
+      data_ = nullptr;
+    }
+
+    /// Reallocate the range data memory if the rank is changed
+
+    /// \param n The rank of the range
+    /// \throw std::bad_alloc When memory allocation fails.
+    void realloc_data(const unsigned int n) {
+      if(rank_ != n) {
+        free_data();
+        alloc_data(n);
+      }
+    }
+
+    /// Move the range data from \c other to this range
+
+    /// \param other The range to be moved
+    /// \pre \c data_ does not hold allocated memory
+    /// \post \c other is an empty range
+    void move_data(Range_& other) {
+      if(other.data_ == other.inline_data_) {
+        data_ = inline_data_;
+        memcpy(inline_data_, other.inline_data_, (sizeof(size_type) << 2) * other.rank_);
+      } else {
+        data_ = other.data_;
+      }
+      offset_ = other.offset_;
+      volume_ = other.volume_;
+      rank_ = other.rank_;
+
+      other.data_ = nullptr;
+      other.offset_ = 0ul;
+      other.volume_ = 0ul;
+      other.rank_ = 0u;
+    }
 
   private:
 
@@ -309,8 +378,7 @@ namespace TiledArray {
       TA_ASSERT(n == detail::size(upper_bound));
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(lower_bound, upper_bound);
       }
     }
@@ -333,8 +401,7 @@ namespace TiledArray {
       TA_ASSERT(n == detail::size(upper_bound));
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(lower_bound, upper_bound);
       }
     }
@@ -353,8 +420,7 @@ namespace TiledArray {
       const size_type n = detail::size(extent);
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(extent);
       }
     }
@@ -371,8 +437,7 @@ namespace TiledArray {
       const size_type n = detail::size(extent);
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(extent);
       }
     }
@@ -393,8 +458,7 @@ namespace TiledArray {
       const size_type n = detail::size(bounds);
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(bounds);
       }
     }
@@ -413,8 +477,7 @@ namespace TiledArray {
       const size_type n = detail::size(bounds);
       if(n) {
         // Initialize array memory
-        data_ = new size_type[n << 2];
-        rank_ = n;
+        alloc_data(n);
         init_range_data(bounds);
       }
     }
@@ -450,27 +513,18 @@ namespace TiledArray {
     /// \throw std::bad_alloc When memory allocation fails.
     Range(const Range_& other) {
       if(other.rank_ > 0ul) {
-        data_ = new size_type[other.rank_ << 2];
+        alloc_data(other.rank_);
         offset_ = other.offset_;
         volume_ = other.volume_;
-        rank_ = other.rank_;
         memcpy(data_, other.data_, (sizeof(size_type) << 2) * other.rank_);
       }
     }
 
-    /// Copy Constructor
+    /// Move Constructor
 
-    /// \param other The range to be copied
-    /// \throw std::bad_alloc When memory allocation fails.
-    Range(Range_&& other) :
-      data_(other.data_), offset_(other.offset_), volume_(other.volume_),
-      rank_(other.rank_)
-    {
-      other.data_ = nullptr;
-      other.offset_ = 0ul;
-      other.volume_ = 0ul;
-      other.rank_ = 0u;
-    }
+    /// \param other The range to be moved
+    /// \throw nothing
+    Range(Range_&& other) { move_data(other); }
 
     /// Permuting copy constructor
 
@@ -481,8 +535,7 @@ namespace TiledArray {
       TA_ASSERT(perm.dim() == other.rank_);
 
       if(other.rank_ > 0ul) {
-        data_ = new size_type[other.rank_ << 2];
-        rank_ = other.rank_;
+        alloc_data(other.rank_);
 
         if(perm) {
           init_range_data(perm, other.data_, other.data_ + rank_);
@@ -496,7 +549,7 @@ namespace TiledArray {
     }
 
     /// Destructor
-    ~Range() { delete [] data_; }
+    ~Range() { free_data(); }
 
     /// Copy assignment operator
 
@@ -504,11 +557,7 @@ namespace TiledArray {
     /// \return A reference to this object
     /// \throw std::bad_alloc When memory allocation fails.
     Range_& operator=(const Range_& other) {
-      if(rank_ != other.rank_) {
-        delete [] data_;
-        data_ = (other.rank_ > 0ul ? new size_type[other.rank_ << 2] : nullptr);
-        rank_ = other.rank_;
-      }
+      realloc_data(other.rank_);
       memcpy(data_, other.data_, (sizeof(size_type) << 2) * rank_);
       offset_ = other.offset_;
       volume_ = other.volume_;
@@ -522,15 +571,10 @@ namespace TiledArray {
     /// \return A reference to this object
     /// \throw nothing
     Range_& operator=(Range_&& other) {
-      data_ = other.data_;
-      offset_ = other.offset_;
-      volume_ = other.volume_;
-      rank_ = other.rank_;
-
-      other.data_ = nullptr;
-      other.offset_ = 0ul;
-      other.volume_ = 0ul;
-      other.rank_ = 0u;
+      if(this != &other) {
+        free_data();
+        move_data(other);
+      }
 
       return *this;
     }
@@ -756,11 +800,7 @@ namespace TiledArray {
       TA_ASSERT(n == detail::size(upper_bound));
 
       // Reallocate memory for range arrays
-      if(rank_ != n) {
-        delete [] data_;
-        data_ = (n > 0ul ? new size_type[n << 2] : nullptr);
-        rank_ = n;
-      }
+      realloc_data(n);
       if(n > 0ul)
         init_range_data(lower_bound, upper_bound);
       else
@@ -924,11 +964,7 @@ namespace TiledArray {
 
       // Reallocate the array
       const unsigned int four_x_rank = rank << 2;
-      if(rank_ != rank) {
-        delete [] data_;
-        data_ = (rank > 0u ? new size_type[four_x_rank] : nullptr);
-        rank_ = rank;
-      }
+      realloc_data(rank);
 
       // Get range data
       ar & madness::archive::wrap(data_, four_x_rank) & offset_ & volume_;
@@ -941,11 +977,17 @@ namespace TiledArray {
     }
 
     void swap(Range_& other) {
-      // Get temp data
-      std::swap(data_, other.data_);
-      std::swap(offset_, other.offset_);
-      std::swap(volume_, other.volume_);
-      std::swap(rank_, other.rank_);
+      if((data_ != inline_data_) && (other.data_ != other.inline_data_)) {
+        std::swap(data_, other.data_);
+        std::swap(offset_, other.offset_);
+        std::swap(volume_, other.volume_);
+        std::swap(rank_, other.rank_);
+      } else {
+        // Inline data must be copied
+        Range_ temp(std::move(other));
+        other.move_data(*this);
+        move_data(temp);
+      }
     }
 
   private:
@@ -1032,14 +1074,17 @@ namespace TiledArray {
     TA_ASSERT(perm.dim() == rank_);
     if(rank_ > 1ul) {
       // Copy the lower and upper bound data into a temporary array
-      size_type* MADNESS_RESTRICT const temp_lower = new size_type[rank_ << 1];
+      size_type temp_data[(inline_rank > 0u ? inline_rank : 1u) << 1];
+      size_type* MADNESS_RESTRICT const temp_lower =
+          (rank_ <= inline_rank ? temp_data : new size_type[rank_ << 1]);
       const size_type* MADNESS_RESTRICT const temp_upper = temp_lower + rank_;
       std::memcpy(temp_lower, data_, (sizeof(size_type) << 1) * rank_);
 
       init_range_data(perm, temp_lower, temp_upper);
 
       // Cleanup old memory.
-      delete[] temp_lower;
+      if(temp_lower != temp_data)
+        delete[] temp_lower;
     }
     return *this;
   }
@@ -364,6 +364,20 @@ namespace TiledArray {
           this->dec();
         }
 
+        /// Reduce the initial value of the result
+
+        /// \param initial The initial value of the result
+        void reduce_initial(const result_type& initial) {
+          auto result = std::make_shared<result_type>(initial);
+
+          // Check for more reductions
+          reduce(result);
+
+          // Decrement the dependency counter for the initial value. This must
+          // be done after the reduce call to avoid a race condition.
+          this->dec();
+        }
+
         /// Reduce two reduction arguments
         void reduce_object_object(const ReduceObject* object1, const ReduceObject* object2) {
           // Construct an empty result object
@@ -408,6 +422,25 @@ namespace TiledArray {
           ready_object_(nullptr), result_(), lock_(), callback_(callback)
         { }
 
+        /// Implementation constructor
+
+        /// The reduction arguments are reduced into \c initial, instead of an
+        /// empty result object, once it has been set.
+        /// \param world The world that owns this task
+        /// \param op The reduction operation
+        /// \param initial The initial value of the result
+        /// \param callback The callback that will be invoked when this task
+        /// has completed
+        ReduceTaskImpl(World& world, opT op, const Future<result_type>& initial,
+            madness::CallbackInterface* callback) :
+          madness::TaskInterface(2, TaskAttributes::hipri()),
+          world_(world), op_(op), ready_result_(), ready_object_(nullptr),
+          result_(), lock_(), callback_(callback)
+        {
+          world_.taskq.add(this, & ReduceTaskImpl::reduce_initial, initial,
+              TaskAttributes::hipri());
+        }
+
         virtual ~ReduceTaskImpl() { }
 
         /// Task function
@@ -480,6 +513,23 @@ namespace TiledArray {
         pimpl_(new ReduceTaskImpl(world, op, callback)), count_(0ul)
       { }
 
+      /// Constructor
+
+      /// The arguments of this task are reduced into \c initial . This may
+      /// be used to accumulate the reduction into an existing result.
+      /// \param world The world that owns this task
+      /// \param op The reduction operation
+      /// \param initial The initial value of the result
+      /// \param callback The callback that will be invoked when this task is
+      /// complete
+      /// \note The result of the reduction may share data with \c initial ,
+      /// which may be modified in place.
+      ReduceTask(World& world, const opT& op,
+          const Future<result_type>& initial,
+          madness::CallbackInterface* callback = nullptr) :
+        pimpl_(new ReduceTaskImpl(world, op, initial, callback)), count_(0ul)
+      { }
+
       /// Move constructor
 
       /// \param other The object to be moved
@@ -670,6 +720,22 @@ namespace TiledArray {
         ReduceTask_(world, op_type(op), callback)
       { }
 
+      /// Constructor
+
+      /// The argument pairs of this task are reduced into \c initial .
+      /// \param world The world that owns this task
+      /// \param op The pair reduction operation
+      /// \param initial The initial value of the result
+      /// \param callback The callback that will be invoked when this task is
+      /// complete
+      /// \note The result of the reduction may share data with \c initial ,
+      /// which may be modified in place.
+      ReducePairTask(World& world, const opT& op,
+          const Future<typename op_type::result_type>& initial,
+          madness::CallbackInterface* callback = nullptr) :
+        ReduceTask_(world, op_type(op), initial, callback)
+      { }
+
       /// Move constructor
 
       /// \param other The object to be moved
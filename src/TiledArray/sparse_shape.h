@@ -26,6 +26,7 @@
 #ifndef TILEDARRAY_SPARSE_SHAPE_H__INCLUDED
 #define TILEDARRAY_SPARSE_SHAPE_H__INCLUDED
 
+#include <TiledArray/compressed_norms.h>
 #include <TiledArray/tensor.h>
 #include <TiledArray/tiled_range.h>
 #include <TiledArray/val_array.h>
@@ -47,6 +48,14 @@ namespace TiledArray {
   /// where \f$ij...\f$ are tile indices, \f$\|A_{ij}\|\f$ is norm of tile
   /// \f$ij...\f$, and \f$N_i N_j ...\f$ is the product of tile \f$ij...\f$ in
   /// each dimension.
+  ///
+  /// The norms may be stored in a dense \c Tensor , or, when only a small
+  /// fraction of the tiles are non-zero, in compressed form (see
+  /// \c detail::CompressedNorms ). Compressed shapes are created by passing
+  /// \c compressed=true to the constructors or with \c compress() , and the
+  /// results of arithmetic, permutation, and block operations on compressed
+  /// shapes are compressed. Only \c data() , \c transform() , and
+  /// \c add(value) , which are inherently dense, require the uncompressed norms.
   /// \tparam T The sparse element value type
   /// \note Scaling operations, such as SparseShape<T>::scale , SparseShape<T>::gemm , etc.
   ///       accept generic scaling factors; internally (modulus of) the scaling factor is first
@@ -59,6 +68,7 @@ namespace TiledArray {
     static_assert(TiledArray::detail::is_scalar<T>::value,
                   "SparseShape<T> only supports scalar numeric types for T");
     typedef typename Tensor<value_type>::size_type size_type;  ///< Size type
+    typedef detail::CompressedNorms<value_type> compressed_type; ///< Compressed norm data type
 
    private:
 
@@ -70,9 +80,11 @@ namespace TiledArray {
     typedef detail::ValArray<value_type> vector_type;
 
     Tensor<value_type> tile_norms_; ///< Tile magnitude data
+    std::shared_ptr<const compressed_type> compressed_norms_; ///< Compressed tile magnitude data, used instead of tile_norms_ when set
     std::shared_ptr<vector_type> size_vectors_; ///< Tile size information; size_vectors_[d][i] reports the size of i-th tile in dimension d
     size_type zero_tile_count_; ///< Number of zero tiles
     static value_type threshold_; ///< The zero threshold
+    static float screened_gemm_ratio_; ///< The work ratio below which gemm uses screening
 
     template <typename Op>
     static vector_type
@@ -181,7 +193,7 @@ namespace TiledArray {
     }
 
     std::shared_ptr<vector_type> perm_size_vectors(const Permutation& perm) const {
-      const unsigned int n = tile_norms_.range().rank();
+      const unsigned int n = norms_range().rank();
 
       // Allocate memory for the contracted size vectors
       std::shared_ptr<vector_type> result_size_vectors(new vector_type[n],
@@ -198,16 +210,224 @@ namespace TiledArray {
 
     SparseShape(const Tensor<T>& tile_norms, const std::shared_ptr<vector_type>& size_vectors,
         const size_type zero_tile_count) :
-      tile_norms_(tile_norms), size_vectors_(size_vectors),
+      tile_norms_(tile_norms), compressed_norms_(), size_vectors_(size_vectors),
       zero_tile_count_(zero_tile_count)
     { }
 
+    SparseShape(compressed_type&& compressed_norms,
+        const std::shared_ptr<vector_type>& size_vectors) :
+      tile_norms_(),
+      compressed_norms_(std::make_shared<const compressed_type>(std::move(compressed_norms))),
+      size_vectors_(size_vectors),
+      zero_tile_count_(compressed_norms_->range().volume() - compressed_norms_->nnz())
+    { }
+
+    /// The range of the norm data
+    const Range& norms_range() const {
+      return (compressed_norms_ ? compressed_norms_->range() : tile_norms_.range());
+    }
+
+    /// Compressed norm data
+
+    /// \return The compressed norms of this shape, which are created from the
+    /// dense norms if this shape is not compressed
+    std::shared_ptr<const compressed_type> compressed_norms() const {
+      if(compressed_norms_)
+        return compressed_norms_;
+      return std::make_shared<const compressed_type>(tile_norms_);
+    }
+
+    /// The number of elements in a tile
+
+    /// \param norms The compressed norms that contain the tile
+    /// \param size_vectors The size vectors of \c norms
+    /// \param ordinal The ordinal index of the tile in \c norms
+    /// \return The product of the tile sizes in each dimension
+    static value_type tile_volume(const compressed_type& norms,
+        const vector_type* MADNESS_RESTRICT const size_vectors,
+        const typename compressed_type::ordinal_type ordinal)
+    {
+      value_type volume = 1;
+      norms.coordinates(ordinal, [&] (const unsigned int d, const std::size_t i)
+          { volume *= size_vectors[d][i]; });
+      return volume;
+    }
+
+    /// Normalize compressed tile norms
+
+    /// This function will divide each norm by the number of elements in the
+    /// tile, and remove the norms that are less than the threshold.
+    static compressed_type compressed_normalize(const compressed_type& norms,
+        const vector_type* MADNESS_RESTRICT const size_vectors)
+    {
+      const value_type threshold = threshold_;
+      return norms.unary([&] (value_type norm,
+          const typename compressed_type::ordinal_type ordinal)
+      {
+        TA_ASSERT(norm >= value_type(0));
+        norm /= tile_volume(norms, size_vectors, ordinal);
+        return (norm < threshold ? value_type(0) : norm);
+      });
+    }
+
+    /// Sum compressed norms over all processes
+
+    /// \param world The world where the norms are summed
+    /// \param norms The local contribution to the norms
+    /// \return The sum of \c norms from all processes
+    static compressed_type all_reduce(World& world, const compressed_type& norms) {
+      typedef madness::TaggedKey<madness::uniqueidT, SparseShape_> key_type;
+      return world.gop.all_reduce(key_type(world.unique_obj_id()), norms,
+          detail::CompressedNormsSum<value_type>()).get();
+    }
+
+    /// Scale compressed norms
+
+    /// \param norms The norms to be scaled
+    /// \param abs_factor The scaling factor
+    /// \return The scaled norms, where norms that are less than the threshold
+    /// are removed
+    static compressed_type compressed_scale(const compressed_type& norms,
+        const value_type abs_factor)
+    {
+      const value_type threshold = threshold_;
+      return norms.unary([threshold, abs_factor] (value_type value,
+          const typename compressed_type::ordinal_type)
+      {
+        value *= abs_factor;
+        return (value < threshold ? value_type(0) : value);
+      });
+    }
+
+    /// Add compressed norms
+
+    /// \param other The shape to be added to this shape
+    /// \param abs_factor The scaling factor
+    /// \return The scaled sum of the norms of this shape and \c other ,
+    /// where norms that are less than the threshold are removed
+    SparseShape_ compressed_add(const SparseShape_& other,
+        const value_type abs_factor) const
+    {
+      TA_ASSERT(norms_range() == other.norms_range());
+      const value_type threshold = threshold_;
+      return SparseShape_(compressed_norms()->merge(*other.compressed_norms(),
+          [threshold, abs_factor] (value_type left, const value_type right,
+              const typename compressed_type::ordinal_type)
+          {
+            left += right;
+            left *= abs_factor;
+            return (left < threshold ? value_type(0) : left);
+          }), size_vectors_);
+    }
+
+    /// Multiply compressed norms
+
+    /// \param other The shape to be multiplied by this shape
+    /// \param abs_factor The scaling factor
+    /// \return The scaled product of the norms of this shape and \c other ,
+    /// where norms that are less than the threshold are removed
+    SparseShape_ compressed_mult(const SparseShape_& other,
+        const value_type abs_factor) const
+    {
+      TA_ASSERT(norms_range() == other.norms_range());
+      const value_type threshold = threshold_;
+      std::shared_ptr<const compressed_type> left = compressed_norms();
+      const vector_type* MADNESS_RESTRICT const size_vectors = size_vectors_.get();
+      return SparseShape_(left->intersect(*other.compressed_norms(),
+          [&] (const value_type l, const value_type r,
+              const typename compressed_type::ordinal_type ordinal)
+          {
+            const value_type value = l * r * abs_factor *
+                tile_volume(*left, size_vectors, ordinal);
+            return (value < threshold ? value_type(0) : value);
+          }), size_vectors_);
+    }
+
+    /// Matrix multiplication of compressed norms
+
+    /// Compute the product of the norms, viewed as compressed sparse row
+    /// matrices, without forming dense norm matrices. Only contractions where
+    /// neither argument is transposed are supported.
+    /// \param other The right-hand shape
+    /// \param abs_factor The scaling factor
+    /// \param N The number of columns in the right-hand and result matrices
+    /// \param K The number of columns in the left-hand matrix
+    /// \param k_sizes The size of the tiles in the contracted dimension
+    /// \param result_range The range of the result norms
+    /// \param result_size_vectors The size vectors of the result
+    /// \return The result shape, which is compressed
+    SparseShape_ compressed_gemm(const SparseShape_& other,
+        const value_type abs_factor, const integer N,
+        const integer K, const vector_type& k_sizes, const Range& result_range,
+        const std::shared_ptr<vector_type>& result_size_vectors) const
+    {
+      typedef typename compressed_type::ordinal_type ordinal_type;
+      const value_type threshold = threshold_;
+      std::shared_ptr<const compressed_type> left = compressed_norms();
+      std::shared_ptr<const compressed_type> right = other.compressed_norms();
+      const std::vector<ordinal_type>& left_ordinals = left->ordinals();
+      const std::vector<value_type>& left_values = left->values();
+      const std::vector<ordinal_type>& right_ordinals = right->ordinals();
+      const std::vector<value_type>& right_values = right->values();
+
+      // Find the first element of each row of right, which is sorted by row
+      std::vector<size_type> right_first(K + 1, 0ul);
+      for(const ordinal_type ordinal : right_ordinals)
+        ++right_first[ordinal / N + 1];
+      for(integer k = 0; k < K; ++k)
+        right_first[k + 1] += right_first[k];
+
+      // Accumulate each row of the result with a sparse accumulator
+      std::vector<value_type> row(N, value_type(0));
+      std::vector<char> touched(N, 0);
+      std::vector<integer> cols;
+      std::vector<ordinal_type> result_ordinals;
+      std::vector<value_type> result_values;
+      size_type x = 0ul;
+      const size_type left_end = left_ordinals.size();
+      while(x < left_end) {
+        const integer i = left_ordinals[x] / K;
+
+        for(; (x < left_end) && (integer(left_ordinals[x] / K) == i); ++x) {
+          const integer k = left_ordinals[x] % K;
+          const value_type left_ik = left_values[x] * k_sizes[k] * k_sizes[k];
+          for(size_type y = right_first[k]; y < right_first[k + 1]; ++y) {
+            const integer j = right_ordinals[y] % N;
+            if(! touched[j]) {
+              touched[j] = 1;
+              cols.push_back(j);
+            }
+            row[j] += left_ik * right_values[y];
+          }
+        }
+
+        // Store the elements of the row that are above the threshold
+        std::sort(cols.begin(), cols.end());
+        for(const integer j : cols) {
+          const value_type value = row[j] * abs_factor;
+          if(value >= threshold) {
+            result_ordinals.push_back(ordinal_type(i) * N + j);
+            result_values.push_back(value);
+          }
+          row[j] = value_type(0);
+          touched[j] = 0;
+        }
+        cols.clear();
+      }
+
+      return SparseShape_(compressed_type(result_range,
+          std::move(result_ordinals), std::move(result_values)),
+          result_size_vectors);
+    }
+
   public:
 
     /// Default constructor
 
     /// Construct a shape with no data.
-    SparseShape() : tile_norms_(), size_vectors_(), zero_tile_count_(0ul) { }
+    SparseShape() :
+      tile_norms_(), compressed_norms_(), size_vectors_(), zero_tile_count_(0ul)
+    { }
 
     /// Constructor
 
@@ -216,14 +436,21 @@ namespace TiledArray {
     /// tile.
     /// \param tile_norms The Frobenius norm of tiles
     /// \param trange The tiled range of the tensor
-    SparseShape(const Tensor<value_type>& tile_norms, const TiledRange& trange) :
-      tile_norms_(tile_norms.clone()), size_vectors_(initialize_size_vectors(trange)),
-      zero_tile_count_(0ul)
+    /// \param compressed If \c true , the norms are stored in compressed form
+    SparseShape(const Tensor<value_type>& tile_norms, const TiledRange& trange,
+        const bool compressed = false) :
+      tile_norms_(tile_norms.clone()), compressed_norms_(),
+      size_vectors_(initialize_size_vectors(trange)), zero_tile_count_(0ul)
     {
       TA_ASSERT(! tile_norms_.empty());
       TA_ASSERT(tile_norms_.range() == trange.tiles_range());
 
       normalize();
+
+      if(compressed) {
+        compressed_norms_ = std::make_shared<const compressed_type>(tile_norms_);
+        tile_norms_ = Tensor<value_type>();
+      }
     }
 
     /// "Sparse" constructor
@@ -236,12 +463,22 @@ namespace TiledArray {
     ///         where \c index is a directly-addressable sequence indices.
     /// \param tile_norms The Frobenius norm of tiles
     /// \param trange The tiled range of the tensor
+    /// \param compressed If \c true , the norms are stored in compressed form,
+    /// and a dense norm tensor is never allocated
     template<typename SparseNormSequence>
     SparseShape(const SparseNormSequence& tile_norms,
-                const TiledRange& trange) :
-      tile_norms_(trange.tiles_range(), value_type(0)), size_vectors_(initialize_size_vectors(trange)),
+                const TiledRange& trange, const bool compressed = false) :
+      tile_norms_(), compressed_norms_(),
+      size_vectors_(initialize_size_vectors(trange)),
       zero_tile_count_(trange.tiles_range().volume())
     {
+      if(compressed) {
+        *this = SparseShape_(compressed_normalize(compressed_type(trange.tiles_range(),
+            tile_norms), size_vectors_.get()), size_vectors_);
+        return;
+      }
+
+      tile_norms_ = Tensor<value_type>(trange.tiles_range(), value_type(0));
       const auto dim = tile_norms_.range().rank();
       for(const auto& pair_idx_norm: tile_norms) {
         auto compute_tile_volume = [dim,this,pair_idx_norm]() -> uint64_t {
@@ -268,13 +505,24 @@ namespace TiledArray {
     /// \param world The world where the shape will live
     /// \param tile_norms The Frobenius norm of tiles
     /// \param trange The tiled range of the tensor
+    /// \param compressed If \c true , the norms are stored in compressed form,
+    /// and only the non-zero norms are communicated
     SparseShape(World& world, const Tensor<value_type>& tile_norms,
-                const TiledRange& trange) :
-      tile_norms_(tile_norms.clone()), size_vectors_(initialize_size_vectors(trange)),
-      zero_tile_count_(0ul)
+                const TiledRange& trange, const bool compressed = false) :
+      tile_norms_(), compressed_norms_(),
+      size_vectors_(initialize_size_vectors(trange)), zero_tile_count_(0ul)
     {
-      TA_ASSERT(! tile_norms_.empty());
-      TA_ASSERT(tile_norms_.range() == trange.tiles_range());
+      TA_ASSERT(! tile_norms.empty());
+      TA_ASSERT(tile_norms.range() == trange.tiles_range());
+
+      if(compressed) {
+        // reduce the non-zero norm data from all processors
+        *this = SparseShape_(compressed_normalize(all_reduce(world,
+            compressed_type(tile_norms)), size_vectors_.get()), size_vectors_);
+        return;
+      }
+
+      tile_norms_ = tile_norms.clone();
 
       // reduce norm data from all processors
       world.gop.sum(tile_norms_.data(), tile_norms_.size());
@@ -294,11 +542,19 @@ namespace TiledArray {
     /// \param world The world where the shape will live
     /// \param tile_norms The Frobenius norm of tiles
     /// \param trange The tiled range of the tensor
+    /// \param compressed If \c true , the norms are stored in compressed form,
+    /// and only the non-zero norms are communicated
     template<typename SparseNormSequence>
     SparseShape(World& world,
                 const SparseNormSequence& tile_norms,
-                const TiledRange& trange) : SparseShape(tile_norms, trange)
+                const TiledRange& trange, const bool compressed = false) :
+      SparseShape(tile_norms, trange, compressed)
     {
+      if(compressed) {
+        *this = SparseShape_(all_reduce(world, *compressed_norms_), size_vectors_);
+        return;
+      }
+
       world.gop.sum(tile_norms_.data(), tile_norms_.size());
     }
 
@@ -307,8 +563,8 @@ namespace TiledArray {
     /// Shallow copy of \c other.
     /// \param other The other shape object to be copied
     SparseShape(const SparseShape<T>& other) :
-      tile_norms_(other.tile_norms_), size_vectors_(other.size_vectors_),
-      zero_tile_count_(other.zero_tile_count_)
+      tile_norms_(other.tile_norms_), compressed_norms_(other.compressed_norms_),
+      size_vectors_(other.size_vectors_), zero_tile_count_(other.zero_tile_count_)
     { }
 
     /// Copy assignment operator
@@ -318,6 +574,7 @@ namespace TiledArray {
     /// \return A reference to this object.
     SparseShape<T>& operator=(const SparseShape<T>& other) {
       tile_norms_ = other.tile_norms_;
+      compressed_norms_ = other.compressed_norms_;
       size_vectors_ = other.size_vectors_;
       zero_tile_count_ = other.zero_tile_count_;
       return *this;
@@ -327,9 +584,9 @@ namespace TiledArray {
 
     /// \return \c true when range matches the range of this shape
     bool validate(const Range& range) const {
-      if(tile_norms_.empty())
+      if(empty())
         return false;
-      return (range == tile_norms_.range());
+      return (range == norms_range());
     }
 
     /// Check that a tile is zero
@@ -338,7 +595,9 @@ namespace TiledArray {
     /// \return false
     template <typename Index>
     bool is_zero(const Index& i) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_)
+        return (*compressed_norms_)[i] < threshold_;
       return tile_norms_[i] < threshold_;
     }
 
@@ -351,8 +610,8 @@ namespace TiledArray {
 
     /// \return The fraction of tiles that are zero.
     float sparsity() const {
-      TA_ASSERT(! tile_norms_.empty());
-      return float(zero_tile_count_) / float(tile_norms_.size());
+      TA_ASSERT(! empty());
+      return float(zero_tile_count_) / float(norms_range().volume());
     }
 
     /// Threshold accessor
@@ -365,6 +624,25 @@ namespace TiledArray {
     /// \param thresh The new threshold
     static void threshold(const value_type thresh) { threshold_ = thresh; }
 
+    /// Screened gemm work ratio accessor
+
+    /// \return The current screened gemm work ratio
+    /// \sa screened_gemm_ratio(const float)
+    static float screened_gemm_ratio() { return screened_gemm_ratio_; }
+
+    /// Set the screened gemm work ratio to \c ratio
+
+    /// \c gemm skips zero norms, and rows and columns of the result that are
+    /// known to be zero, when the number of remaining multiply-add operations
+    /// is less than \c ratio times that of a dense matrix multiplication.
+    /// Otherwise, a dense matrix multiplication is used. The results are the
+    /// same, apart from rounding errors, for all values of \c ratio .
+    /// \param ratio The new ratio, where \c 0 disables screening
+    static void screened_gemm_ratio(const float ratio) {
+      TA_ASSERT(ratio >= 0.0f);
+      screened_gemm_ratio_ = ratio;
+    }
+
     /// Tile norm accessor
 
     /// \tparam Index The index type
@@ -372,7 +650,9 @@ namespace TiledArray {
     /// \return The norm of the tile at \c index
     template <typename Index>
     value_type operator[](const Index& index) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_)
+        return (*compressed_norms_)[index];
       return tile_norms_[index];
     }
 
@@ -385,8 +665,12 @@ namespace TiledArray {
     /// norms will avoid normalization, which is neccesary for correct behavior.  
     /// One example is when Op is an identity operation the output
     /// SparseShape data will have the same values as this.
+    /// Compressed shapes are decompressed before Op is applied, and the
+    /// result is compressed.
     template<typename Op>
     SparseShape_ transform(Op &&op) const { 
+        if(compressed_norms_)
+          return decompress().transform(std::forward<Op>(op)).compress();
 
         Tensor<T> new_norms = op(tile_norms_);
         madness::AtomicInt zero_tile_count;
@@ -411,23 +695,76 @@ namespace TiledArray {
     /// Data accessor
 
     /// \return A reference to the \c Tensor object that stores shape data
-    const Tensor<value_type>& data() const { return tile_norms_; }
+    /// \throw TiledArray::Exception When this shape is compressed
+    const Tensor<value_type>& data() const {
+      TA_ASSERT(! compressed_norms_);
+      return tile_norms_;
+    }
+
+    /// Compressed data accessor
+
+    /// \return A reference to the compressed shape data
+    /// \throw TiledArray::Exception When this shape is not compressed
+    const compressed_type& compressed_data() const {
+      TA_ASSERT(compressed_norms_);
+      return *compressed_norms_;
+    }
+
+    /// Compression check
+
+    /// \return \c true when the norms of this shape are stored in compressed
+    /// form.
+    bool is_compressed() const { return bool(compressed_norms_); }
+
+    /// Compress the shape
+
+    /// \return A shape with the same norms as this shape, stored in
+    /// compressed form
+    SparseShape_ compress() const {
+      TA_ASSERT(! empty());
+      SparseShape_ result(*this);
+      result.compressed_norms_ = compressed_norms();
+      result.tile_norms_ = Tensor<value_type>();
+      return result;
+    }
+
+    /// Decompress the shape
+
+    /// \return A shape with the same norms as this shape, stored in a dense
+    /// tensor
+    SparseShape_ decompress() const {
+      TA_ASSERT(! empty());
+      SparseShape_ result(*this);
+      if(compressed_norms_) {
+        result.tile_norms_ = compressed_norms_->tensor();
+        result.compressed_norms_.reset();
+      }
+      return result;
+    }
 
     /// Initialization check
 
     /// \return \c true when this shape has been initialized.
-    bool empty() const { return tile_norms_.empty(); }
+    bool empty() const { return tile_norms_.empty() && ! compressed_norms_; }
 
     /// Compute union of two shapes
 
     /// \param mask The input shape, hard zeros are used to mask the output.
     /// \return A shape that is masked by the mask.
     SparseShape_ mask(const SparseShape_ &mask_shape) const {
-      TA_ASSERT(!tile_norms_.empty());
-      TA_ASSERT(!mask_shape.empty());
-      TA_ASSERT(tile_norms_.range() == mask_shape.tile_norms_.range());
+      TA_ASSERT(! empty());
+      TA_ASSERT(! mask_shape.empty());
+      TA_ASSERT(norms_range() == mask_shape.norms_range());
 
       const value_type threshold = threshold_;
+
+      if(compressed_norms_ || mask_shape.compressed_norms_)
+        return SparseShape_(compressed_norms()->intersect(
+            *mask_shape.compressed_norms(), [threshold] (const value_type left,
+                const value_type right, const typename compressed_type::ordinal_type)
+            { return (right < threshold ? value_type(0) : left); }),
+            size_vectors_);
+
       madness::AtomicInt zero_tile_count;
       zero_tile_count = zero_tile_count_;
       auto op = [threshold, &zero_tile_count] (value_type left,
@@ -460,6 +797,10 @@ namespace TiledArray {
     SparseShape update_block(const Index& lower_bound, const Index& upper_bound,
         const SparseShape& other) const
     {
+      if(compressed_norms_ || other.compressed_norms_)
+        return SparseShape_(compressed_norms()->update_block(lower_bound,
+            upper_bound, *other.compressed_norms()), size_vectors_);
+
       Tensor<value_type> result_tile_norms = tile_norms_.clone();
 
       auto result_tile_norms_blk = result_tile_norms.block(lower_bound, upper_bound);
@@ -491,8 +832,8 @@ namespace TiledArray {
     template <typename Index>
     std::shared_ptr<vector_type>
     block_range(const Index& lower_bound, const Index& upper_bound) const {
-      TA_ASSERT(detail::size(lower_bound) == tile_norms_.range().rank());
-      TA_ASSERT(detail::size(upper_bound) == tile_norms_.range().rank());
+      TA_ASSERT(detail::size(lower_bound) == norms_range().rank());
+      TA_ASSERT(detail::size(upper_bound) == norms_range().rank());
 
       // Get the number dimensions of the shape
       const auto rank = detail::size(lower_bound);
@@ -510,7 +851,7 @@ namespace TiledArray {
 
         // Check that the input indices are in range
         TA_ASSERT(lower_i < upper_i);
-        TA_ASSERT(upper_i <= tile_norms_.range().upbound(i));
+        TA_ASSERT(upper_i <= norms_range().upbound(i));
 
         // Construct the size vector for rank i
         size_vectors.get()[i] = vector_type(extent_i,
@@ -531,6 +872,10 @@ namespace TiledArray {
       std::shared_ptr<vector_type> size_vectors =
           block_range(lower_bound, upper_bound);
 
+      if(compressed_norms_)
+        return SparseShape(compressed_norms_->block(lower_bound, upper_bound),
+            size_vectors);
+
       // Copy the data from arg to result
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
@@ -569,6 +914,10 @@ namespace TiledArray {
       std::shared_ptr<vector_type> size_vectors =
           block_range(lower_bound, upper_bound);
 
+      if(compressed_norms_)
+        return SparseShape(compressed_scale(compressed_norms_->block(lower_bound,
+            upper_bound), abs_factor), size_vectors);
+
       // Copy the data from arg to result
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
@@ -622,6 +971,9 @@ namespace TiledArray {
     /// \param perm The permutation to be applied
     /// \return A new, permuted shape
     SparseShape_ perm(const Permutation& perm) const {
+      if(compressed_norms_)
+        return SparseShape_(compressed_norms_->permute(perm),
+            perm_size_vectors(perm));
       return SparseShape_(tile_norms_.permute(perm), perm_size_vectors(perm),
           zero_tile_count_);
     }
@@ -638,9 +990,12 @@ namespace TiledArray {
     /// \return A new, scaled shape
     template <typename Factor>
     SparseShape_ scale(const Factor factor) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
       const value_type threshold = threshold_;
       const value_type abs_factor = to_abs_factor(factor);
+      if(compressed_norms_)
+        return SparseShape_(compressed_scale(*compressed_norms_, abs_factor),
+            size_vectors_);
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
       auto op = [threshold, &zero_tile_count, abs_factor] (value_type value) {
@@ -670,7 +1025,9 @@ namespace TiledArray {
     /// \return A new, scaled-and-permuted shape
     template <typename Factor>
     SparseShape_ scale(const Factor factor, const Permutation& perm) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_)
+        return scale(factor).perm(perm);
       const value_type threshold = threshold_;
       const value_type abs_factor = to_abs_factor(factor);
       madness::AtomicInt zero_tile_count;
@@ -699,7 +1056,9 @@ namespace TiledArray {
     /// \param other The shape to be added to this shape
     /// \return A sum of shapes
     SparseShape_ add(const SparseShape_& other) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_add(other, value_type(1));
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
@@ -730,7 +1089,9 @@ namespace TiledArray {
     /// \param perm The permutation that is applied to the result
     /// \return the new shape, equals \c this + \c other
     SparseShape_ add(const SparseShape_& other, const Permutation& perm) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_add(other, value_type(1)).perm(perm);
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
@@ -765,9 +1126,11 @@ namespace TiledArray {
     /// \return A scaled sum of shapes
     template <typename Factor>
     SparseShape_ add(const SparseShape_& other, const Factor factor) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
       const value_type threshold = threshold_;
       const value_type abs_factor = to_abs_factor(factor);
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_add(other, abs_factor);
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
       auto op = [threshold, &zero_tile_count, abs_factor] (value_type left,
@@ -804,9 +1167,11 @@ namespace TiledArray {
     SparseShape_ add(const SparseShape_& other, const Factor factor,
         const Permutation& perm) const
     {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
       const value_type threshold = threshold_;
       const value_type abs_factor = to_abs_factor(factor);
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_add(other, abs_factor).perm(perm);
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
       auto op = [threshold, &zero_tile_count, abs_factor]
@@ -828,8 +1193,17 @@ namespace TiledArray {
           zero_tile_count);
     }
 
+    /// Add a constant to the shape
+
+    /// Every element of the result may be non-zero, so compressed shapes are
+    /// decompressed before the constant is added, and the result is
+    /// compressed.
+    /// \param value The constant to be added
+    /// \return A new shape where each norm is increased by \c value
     SparseShape_ add(value_type value) const {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_)
+        return decompress().add(value).compress();
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
@@ -973,13 +1347,146 @@ namespace TiledArray {
       return zero_tile_count;
     }
 
+    /// Screened matrix multiplication of norms
+
+    /// Compute <tt>result = abs_factor * (left * k_sizes) * (k_sizes * right)</tt>
+    /// for row-major \c left and \c right matrices, and zero the result
+    /// elements that are less than the threshold. Only non-zero norms
+    /// contribute to the result, and the rows and columns of the result whose
+    /// upper bounds are less than the threshold are not computed.
+    /// \param M The number of rows in \c left and \c result
+    /// \param N The number of columns in \c right and \c result
+    /// \param K The number of columns in \c left and rows in \c right
+    /// \param left The left-hand norm matrix
+    /// \param right The right-hand norm matrix
+    /// \param k_sizes The size of the tiles in the contracted dimension
+    /// \param abs_factor The scaling factor
+    /// \param[out] result The result norm matrix, which must be zero filled
+    /// \param[out] zero_tile_count The number of zero elements in \c result
+    /// \return \c true if the result was computed, or \c false , and
+    /// \c result is not modified, when the screened algorithm would do at
+    /// least \c screened_gemm_ratio_ times the work of a dense matrix
+    /// multiplication
+    static bool screened_gemm(const integer M, const integer N, const integer K,
+        const value_type* MADNESS_RESTRICT const left,
+        const value_type* MADNESS_RESTRICT const right,
+        const vector_type& k_sizes, const value_type abs_factor,
+        value_type* MADNESS_RESTRICT const result, size_type& zero_tile_count)
+    {
+      // The bounds are computed in double precision and are increased by the
+      // worst-case rounding error of the inner products, so screening never
+      // removes an element that would be above the threshold.
+      const double threshold = double(threshold_) /
+          (1.0 + 2.0 * double(K) * double(std::numeric_limits<value_type>::epsilon()));
+
+      // Find the largest norm in each column of left
+      std::vector<double> left_max(K, 0.0);
+      for(integer i = 0; i < M; ++i) {
+        const value_type* MADNESS_RESTRICT const left_i = left + i * K;
+        for(integer k = 0; k < K; ++k)
+          left_max[k] = std::max(left_max[k], double(left_i[k]));
+      }
+
+      // Compute the upper bound of each column of the result, and find the
+      // largest norm in each row of right
+      std::vector<double> col_bound(N, 0.0);
+      std::vector<double> right_max(K, 0.0);
+      for(integer k = 0; k < K; ++k) {
+        const value_type* MADNESS_RESTRICT const right_k = right + k * N;
+        const double scale = double(k_sizes[k]) * double(k_sizes[k]) * double(abs_factor);
+        const double left_max_k = left_max[k] * scale;
+        for(integer j = 0; j < N; ++j) {
+          col_bound[j] += left_max_k * double(right_k[j]);
+          right_max[k] = std::max(right_max[k], double(right_k[j]));
+        }
+        right_max[k] *= scale;
+      }
+
+      // Compress the rows of right, keeping only the non-zero norms in
+      // columns that may be non-zero in the result
+      std::vector<integer> right_first(K + 1, 0);
+      std::vector<integer> right_cols;
+      std::vector<value_type> right_norms;
+      for(integer k = 0; k < K; ++k) {
+        const value_type* MADNESS_RESTRICT const right_k = right + k * N;
+        const value_type size = k_sizes[k];
+        for(integer j = 0; j < N; ++j) {
+          if((right_k[j] > value_type(0)) && (col_bound[j] >= threshold)) {
+            right_cols.push_back(j);
+            right_norms.push_back(right_k[j] * size);
+          }
+        }
+        right_first[k + 1] = right_cols.size();
+      }
+
+      // Compute the upper bound of each row of the result, and count the
+      // multiply-add operations of the rows that may be non-zero
+      std::vector<char> row_screened(M, 0);
+      const double dense_work = double(M) * double(N) * double(K);
+      const double max_work = dense_work * double(screened_gemm_ratio_);
+      double work = 0.0;
+      for(integer i = 0; i < M; ++i) {
+        const value_type* MADNESS_RESTRICT const left_i = left + i * K;
+        double row_bound = 0.0;
+        double row_work = 0.0;
+        for(integer k = 0; k < K; ++k) {
+          if(left_i[k] > value_type(0)) {
+            row_bound += double(left_i[k]) * right_max[k];
+            row_work += double(right_first[k + 1] - right_first[k]);
+          }
+        }
+        if(row_bound < threshold)
+          row_screened[i] = 1;
+        else
+          work += row_work;
+      }
+      if(! (work < max_work))
+        return false;
+
+      // Accumulate the products of the non-zero norms into each row of the
+      // result that may be non-zero
+      size_type zero_count = 0ul;
+      const value_type value_threshold = threshold_;
+      for(integer i = 0; i < M; ++i) {
+        if(row_screened[i]) {
+          zero_count += N;
+          continue;
+        }
+
+        const value_type* MADNESS_RESTRICT const left_i = left + i * K;
+        value_type* MADNESS_RESTRICT const result_i = result + i * N;
+        for(integer k = 0; k < K; ++k) {
+          if(left_i[k] > value_type(0)) {
+            const value_type left_ik = left_i[k] * k_sizes[k];
+            for(integer x = right_first[k]; x < right_first[k + 1]; ++x)
+              result_i[right_cols[x]] += left_ik * right_norms[x];
+          }
+        }
+
+        // Scale the row and hard zero elements that are below the threshold
+        for(integer j = 0; j < N; ++j) {
+          value_type& value = result_i[j];
+          value *= abs_factor;
+          if(value < value_threshold) {
+            value = value_type(0);
+            ++zero_count;
+          }
+        }
+      }
+
+      zero_tile_count = zero_count;
+      return true;
+    }
+
   public:
 
     SparseShape_ mult(const SparseShape_& other) const {
       // TODO: Optimize this function so that the tensor arithmetic and
       // scale_by_size operations are performed in one step instead of two.
 
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_mult(other, value_type(1));
       Tensor<T> result_tile_norms = tile_norms_.mult(other.tile_norms_);
       const size_type zero_tile_count =
           scale_by_size(result_tile_norms, size_vectors_.get());
@@ -991,7 +1498,9 @@ namespace TiledArray {
       // TODO: Optimize this function so that the tensor arithmetic and
       // scale_by_size operations are performed in one step instead of two.
 
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_mult(other, value_type(1)).perm(perm);
       Tensor<T> result_tile_norms = tile_norms_.mult(other.tile_norms_, perm);
       std::shared_ptr<vector_type> result_size_vector = perm_size_vectors(perm);
       const size_type zero_tile_count =
@@ -1007,8 +1516,10 @@ namespace TiledArray {
       // TODO: Optimize this function so that the tensor arithmetic and
       // scale_by_size operations are performed in one step instead of two.
 
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
       const value_type abs_factor = to_abs_factor(factor);
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_mult(other, abs_factor);
       Tensor<T> result_tile_norms = tile_norms_.mult(other.tile_norms_, abs_factor);
       const size_type zero_tile_count =
           scale_by_size(result_tile_norms, size_vectors_.get());
@@ -1025,8 +1536,10 @@ namespace TiledArray {
       // TODO: Optimize this function so that the tensor arithmetic and
       // scale_by_size operations are performed in one step instead of two.
 
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
       const value_type abs_factor = to_abs_factor(factor);
+      if(compressed_norms_ || other.compressed_norms_)
+        return compressed_mult(other, abs_factor).perm(perm);
       Tensor<T> result_tile_norms = tile_norms_.mult(other.tile_norms_, abs_factor, perm);
       std::shared_ptr<vector_type> result_size_vector = perm_size_vectors(perm);
       const size_type zero_tile_count =
@@ -1041,14 +1554,19 @@ namespace TiledArray {
     SparseShape_ gemm(const SparseShape_& other, const Factor factor,
         const math::GemmHelper& gemm_helper) const
     {
-      TA_ASSERT(! tile_norms_.empty());
+      TA_ASSERT(! empty());
+
+      const bool compressed = (compressed_norms_ || other.compressed_norms_);
+      if(compressed && ((gemm_helper.left_op() != madness::cblas::NoTrans) ||
+          (gemm_helper.right_op() != madness::cblas::NoTrans)))
+        return decompress().gemm(other.decompress(), factor, gemm_helper).compress();
 
       const value_type abs_factor = to_abs_factor(factor);
       const value_type threshold = threshold_;
       madness::AtomicInt zero_tile_count;
       zero_tile_count = 0;
       integer M = 0, N = 0, K = 0;
-      gemm_helper.compute_matrix_sizes(M, N, K, tile_norms_.range(), other.tile_norms_.range());
+      gemm_helper.compute_matrix_sizes(M, N, K, norms_range(), other.norms_range());
 
       // Allocate memory for the contracted size vectors
       std::shared_ptr<vector_type> result_size_vectors(new vector_type[gemm_helper.result_rank()],
@@ -1064,6 +1582,20 @@ namespace TiledArray {
       // Compute the number of inner ranks
       const unsigned int k_rank = gemm_helper.left_inner_end() - gemm_helper.left_inner_begin();
 
+      if(compressed) {
+        // The contracted tile sizes are used to scale the norms, which is
+        // the identity for outer products
+        const value_type one = 1;
+        const vector_type k_sizes = (k_rank > 0u ?
+            recursive_outer_product(size_vectors_.get() + gemm_helper.left_inner_begin(),
+                k_rank, [] (const vector_type& size_vector) -> const vector_type&
+                { return size_vector; }) :
+            vector_type(1ul, &one));
+        return compressed_gemm(other, abs_factor, N, K, k_sizes,
+            gemm_helper.make_result_range<Range>(norms_range(), other.norms_range()),
+            result_size_vectors);
+      }
+
       // Construct the result norm tensor
       Tensor<value_type> result_norms(gemm_helper.make_result_range<typename Tensor<T>::range_type>(
           tile_norms_.range(), other.tile_norms_.range()), 0);
@@ -1076,6 +1608,16 @@ namespace TiledArray {
                 k_rank, [] (const vector_type& size_vector) -> const vector_type&
                 { return size_vector; });
 
+        // Use the screened algorithm when the norms are sufficiently sparse
+        size_type screened_zero_tile_count = 0ul;
+        if((gemm_helper.left_op() == madness::cblas::NoTrans) &&
+            (gemm_helper.right_op() == madness::cblas::NoTrans) &&
+            (screened_gemm_ratio_ > 0.0f) &&
+            screened_gemm(M, N, K, tile_norms_.data(), other.tile_norms_.data(),
+                k_sizes, abs_factor, result_norms.data(), screened_zero_tile_count))
+          return SparseShape_(result_norms, result_size_vectors,
+              screened_zero_tile_count);
+
         // TODO: Make this faster. It can be done without using temporaries
         // for the arguments, but requires a custom matrix multiply.
 
@@ -1147,6 +1689,8 @@ namespace TiledArray {
   // Static member initialization
   template <typename T>
   typename SparseShape<T>::value_type SparseShape<T>::threshold_ = std::numeric_limits<T>::epsilon();
+  template <typename T>
+  float SparseShape<T>::screened_gemm_ratio_ = 0.01f;
 
   /// Add the shape to an output stream
 
@@ -1156,8 +1700,16 @@ namespace TiledArray {
   /// \return A reference to the output stream
   template <typename T>
   inline std::ostream& operator<<(std::ostream& os, const SparseShape<T>& shape) {
-    os << "SparseShape<" << typeid(T).name() << ">:" << std::endl
-       << shape.data() << std::endl;
+    os << "SparseShape<" << typeid(T).name() << ">:" << std::endl;
+    if(shape.is_compressed()) {
+      const auto& norms = shape.compressed_data();
+      os << norms.range() << " { ";
+      for(std::size_t i = 0ul; i < norms.nnz(); ++i)
+        os << norms.ordinals()[i] << ":" << norms.values()[i] << " ";
+      os << "}" << std::endl;
+    } else {
+      os << shape.data() << std::endl;
+    }
     return os;
   }
 
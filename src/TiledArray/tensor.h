@@ -31,6 +31,8 @@
 #include <TiledArray/tensor/tensor_interface.h>
 #include <TiledArray/tensor/shift_wrapper.h>
 #include <TiledArray/tensor/operators.h>
+#include <TiledArray/tensor/permute_gemm.h>
+#include <TiledArray/tensor/nested_gemm.h>
 #include <TiledArray/block_range.h>
 
 namespace TiledArray {
@@ -0,0 +1,407 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  nested_gemm.h
+ *  Jul 16, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TENSOR_NESTED_GEMM_H__INCLUDED
+#define TILEDARRAY_TENSOR_NESTED_GEMM_H__INCLUDED
+
+#include <TiledArray/tensor/permute_gemm.h>
+#include <algorithm>
+#include <vector>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Compute the ordinal offsets of the rows and columns of a matrix
+
+    /// The elements of a matrix in the form <tt>op(arg)[rows,cols]</tt> are
+    /// located at <tt>row_offsets[i] + col_offsets[j]</tt> .
+    /// \param[out] row_offsets The ordinal offsets of the rows
+    /// \param[out] col_offsets The ordinal offsets of the columns
+    /// \param[in] rows The number of rows
+    /// \param[in] cols The number of columns
+    /// \param[in] op The matrix operation (\c NoTrans or \c Trans)
+    inline void matrix_offsets(std::vector<std::size_t>& row_offsets,
+        std::vector<std::size_t>& col_offsets, const std::size_t rows,
+        const std::size_t cols, const madness::cblas::CBLAS_TRANSPOSE op)
+    {
+      const bool no_trans = (op == madness::cblas::NoTrans);
+      row_offsets.resize(rows);
+      for(std::size_t i = 0ul; i < rows; ++i)
+        row_offsets[i] = (no_trans ? i * cols : i);
+      col_offsets.resize(cols);
+      for(std::size_t j = 0ul; j < cols; ++j)
+        col_offsets[j] = (no_trans ? j : j * rows);
+    }
+
+    /// Fused size of a range of dimensions
+
+    /// \param range The range of a tensor
+    /// \param first The first dimension
+    /// \param last The last dimension
+    /// \return The product of the extents of <tt>[first, last)</tt>
+    template <typename R>
+    inline integer fused_extent(const R& range, const unsigned int first,
+        const unsigned int last)
+    {
+      integer result = 1;
+      for(unsigned int i = first; i < last; ++i)
+        result *= range.extent_data()[i];
+      return result;
+    }
+
+    /// Inner tensors of a contraction that are multiplied by one GEMM
+
+    /// The inner tensors of a row of the right-hand argument that have the
+    /// same fused dimensions are packed into a single matrix, so the inner
+    /// contractions of each left-hand inner tensor with all of them are
+    /// evaluated by one GEMM.
+    /// \tparam T The numeric type of the packed matrix
+    template <typename T>
+    struct NestedGemmGroup {
+      integer k; ///< The fused contracted size of the inner tensors
+      integer n; ///< The fused outer size of each inner tensor
+      std::vector<std::size_t> cols; ///< Outer column indices of the group
+      std::vector<T> packed; ///< The packed inner tensors
+    }; // struct NestedGemmGroup
+
+  } // namespace detail
+
+  /// Contract nested tensors and accumulate the scaled result
+
+  /// The outer dimensions of \c left and \c right are contracted as defined
+  /// by \c gemm_helper , and each product of inner tensors is evaluated as
+  /// defined by \c nested , i.e.
+  /// \code
+  /// result[i,j] += factor * sum_k nested(left[i,k], right[k,j])
+  /// \endcode
+  /// Inner contractions are evaluated with grouped GEMMs: the inner tensors
+  /// in a row of \c right with equal dimensions are packed into one matrix
+  /// that is contracted with each inner tensor of \c left by a single GEMM,
+  /// instead of one small GEMM for each pair of inner tensors. Permutations of
+  /// the outer dimensions of the arguments are applied by indexing and do not
+  /// copy the inner tensors; an empty permutation indicates that the argument
+  /// is used as is. Empty inner tensors are treated as zero.
+  /// \tparam T The result tensor element type
+  /// \tparam A The result tensor allocator type
+  /// \tparam U The left-hand tensor element type
+  /// \tparam AU The left-hand tensor allocator type
+  /// \tparam V The right-hand tensor element type
+  /// \tparam AV The right-hand tensor allocator type
+  /// \tparam W The type of the scaling factor
+  /// \param result The result tensor; if it is empty, it will be initialized
+  /// with the result of the contraction
+  /// \param left The left-hand tensor that will be contracted
+  /// \param right The right-hand tensor that will be contracted
+  /// \param factor The contraction result will be scaling by this value, then
+  /// accumulated into \c result
+  /// \param gemm_helper The *GEMM operation meta data of the outer dimensions
+  /// of the permuted arguments
+  /// \param nested The product of the inner tensors
+  /// \param left_perm The permutation applied to the outer dimensions of
+  /// \c left
+  /// \param right_perm The permutation applied to the outer dimensions of
+  /// \c right
+  /// \return A reference to \c result
+  template <typename T, typename A, typename U, typename AU, typename V,
+      typename AV, typename W,
+      typename std::enable_if<detail::is_tensor_of_tensor<Tensor<T, A>,
+          Tensor<U, AU>, Tensor<V, AV> >::value>::type* = nullptr>
+  inline Tensor<T, A>& nested_gemm(Tensor<T, A>& result,
+      const Tensor<U, AU>& left, const Tensor<V, AV>& right, const W factor,
+      const math::GemmHelper& gemm_helper, const math::NestedProduct& nested,
+      const Permutation& left_perm = Permutation(),
+      const Permutation& right_perm = Permutation())
+  {
+    typedef typename T::numeric_type numeric_type;
+    typedef typename V::numeric_type right_numeric_type;
+
+    TA_ASSERT(! left.empty());
+    TA_ASSERT(! right.empty());
+    TA_ASSERT((! left_perm) || (gemm_helper.left_op() == madness::cblas::NoTrans));
+    TA_ASSERT((! right_perm) || (gemm_helper.right_op() == madness::cblas::NoTrans));
+
+    // Get the ranges of the permuted arguments
+    const Range left_range = (left_perm ? left_perm * left.range() : left.range());
+    const Range right_range = (right_perm ? right_perm * right.range() : right.range());
+    TA_ASSERT(left_range.rank() == gemm_helper.left_rank());
+    TA_ASSERT(right_range.rank() == gemm_helper.right_rank());
+    TA_ASSERT(gemm_helper.left_right_congruent(left_range.extent_data(),
+        right_range.extent_data()));
+
+    if(result.empty())
+      result = Tensor<T, A>(gemm_helper.make_result_range<Range>(left_range,
+          right_range));
+    TA_ASSERT(result.range().rank() == gemm_helper.result_rank());
+    TA_ASSERT(gemm_helper.left_result_congruent(left_range.extent_data(),
+        result.range().extent_data()));
+    TA_ASSERT(gemm_helper.right_result_congruent(right_range.extent_data(),
+        result.range().extent_data()));
+
+    // Compute gemm dimensions
+    integer m, n, k;
+    gemm_helper.compute_matrix_sizes(m, n, k, left_range, right_range);
+
+    // Compute the offsets of the elements of the arguments, which are indexed
+    // as left[M...,K...] and right[K...,N...].
+    const unsigned int inner_rank = gemm_helper.num_contract_ranks();
+    const unsigned int left_outer_rank = gemm_helper.left_rank() - inner_rank;
+    std::vector<std::size_t> left_row_offsets, left_col_offsets,
+        right_row_offsets, right_col_offsets;
+    if(left_perm) {
+      detail::permuted_offsets(left_row_offsets, left.range(), left_perm, 0u,
+          left_outer_rank);
+      detail::permuted_offsets(left_col_offsets, left.range(), left_perm,
+          left_outer_rank, gemm_helper.left_rank());
+    } else {
+      detail::matrix_offsets(left_row_offsets, left_col_offsets, m, k,
+          gemm_helper.left_op());
+    }
+    if(right_perm) {
+      detail::permuted_offsets(right_row_offsets, right.range(), right_perm,
+          0u, inner_rank);
+      detail::permuted_offsets(right_col_offsets, right.range(), right_perm,
+          inner_rank, gemm_helper.right_rank());
+    } else {
+      detail::matrix_offsets(right_row_offsets, right_col_offsets, k, n,
+          gemm_helper.right_op());
+    }
+
+    const U* MADNESS_RESTRICT const left_data = left.data();
+    const V* MADNESS_RESTRICT const right_data = right.data();
+    T* MADNESS_RESTRICT const result_data = result.data();
+
+    if(! nested.is_contraction()) {
+      // Accumulate the coefficient-wise products of the inner tensors
+      for(integer i = 0; i < m; ++i) {
+        for(integer x = 0; x < k; ++x) {
+          const U& l = left_data[left_row_offsets[i] + left_col_offsets[x]];
+          if(l.empty())
+            continue;
+          for(integer j = 0; j < n; ++j) {
+            const V& r = right_data[right_row_offsets[x] + right_col_offsets[j]];
+            if(r.empty())
+              continue;
+            T& c = result_data[i * n + j];
+            if(c.empty())
+              c = l.mult(r, factor);
+            else
+              detail::inplace_tensor_op([factor] (numeric_type& MADNESS_RESTRICT c_i,
+                  const typename U::numeric_type l_i, const right_numeric_type r_i)
+                  { c_i += (l_i * r_i) * factor; }, c, l, r);
+          }
+        }
+      }
+
+      return result;
+    }
+
+    // Get the dimensions of the inner contraction
+    const math::GemmHelper& inner_helper = nested.gemm_helper();
+    const bool right_no_trans = (inner_helper.right_op() == madness::cblas::NoTrans);
+
+    std::vector<detail::NestedGemmGroup<right_numeric_type> > groups;
+    std::vector<numeric_type> work;
+    for(integer x = 0; x < k; ++x) {
+
+      // Group the inner tensors in row x of right by their dimensions
+      groups.clear();
+      for(integer j = 0; j < n; ++j) {
+        const V& r = right_data[right_row_offsets[x] + right_col_offsets[j]];
+        if(r.empty())
+          continue;
+        const integer rk = detail::fused_extent(r.range(),
+            inner_helper.right_inner_begin(), inner_helper.right_inner_end());
+        const integer rn = detail::fused_extent(r.range(),
+            inner_helper.right_outer_begin(), inner_helper.right_outer_end());
+        auto it = std::find_if(groups.begin(), groups.end(),
+            [=] (const detail::NestedGemmGroup<right_numeric_type>& group)
+            { return (group.k == rk) && (group.n == rn); });
+        if(it == groups.end())
+          it = groups.insert(groups.end(),
+              detail::NestedGemmGroup<right_numeric_type>{ rk, rn, { }, { } });
+        it->cols.push_back(j);
+      }
+
+      // Pack the inner tensors of each group into a single matrix, which is
+      // in the form packed[K,g*N] or, for transposed inner tensors,
+      // packed[g*N,K].
+      for(auto& group : groups) {
+        const std::size_t g = group.cols.size();
+        if(g == 1ul)
+          continue;
+        const std::size_t rk = group.k, rn = group.n;
+        group.packed.resize(g * rk * rn);
+        for(std::size_t q = 0ul; q < g; ++q) {
+          const V& r = right_data[right_row_offsets[x] + right_col_offsets[group.cols[q]]];
+          const right_numeric_type* MADNESS_RESTRICT const r_data = r.data();
+          if(right_no_trans) {
+            for(std::size_t p = 0ul; p < rk; ++p)
+              std::copy(r_data + p * rn, r_data + (p + 1ul) * rn,
+                  group.packed.data() + p * g * rn + q * rn);
+          } else {
+            std::copy(r_data, r_data + rn * rk, group.packed.data() + q * rn * rk);
+          }
+        }
+      }
+
+      // Contract the inner tensors in column x of left with each group
+      for(integer i = 0; i < m; ++i) {
+        const U& l = left_data[left_row_offsets[i] + left_col_offsets[x]];
+        if(l.empty())
+          continue;
+
+        for(const auto& group : groups) {
+          if(group.cols.size() == 1ul) {
+            const V& r = right_data[right_row_offsets[x] + right_col_offsets[group.cols.front()]];
+            T& c = result_data[i * n + group.cols.front()];
+            if(c.empty())
+              c = l.gemm(r, factor, inner_helper);
+            else
+              c.gemm(l, r, factor, inner_helper);
+            continue;
+          }
+
+          const integer lm = detail::fused_extent(l.range(),
+              inner_helper.left_outer_begin(), inner_helper.left_outer_end());
+          TA_ASSERT(detail::fused_extent(l.range(), inner_helper.left_inner_begin(),
+              inner_helper.left_inner_end()) == group.k);
+          const integer gn = group.n * integer(group.cols.size());
+          const integer lda =
+              (inner_helper.left_op() == madness::cblas::NoTrans ? group.k : lm);
+          const integer ldb = (right_no_trans ? gn : group.k);
+
+          work.resize(lm * gn);
+          math::gemm(inner_helper.left_op(), inner_helper.right_op(), lm, gn,
+              group.k, factor, l.data(), lda, group.packed.data(), ldb,
+              numeric_type(0), work.data(), gn);
+
+          // Scatter the block of each inner tensor to the result
+          for(std::size_t q = 0ul; q < group.cols.size(); ++q) {
+            const std::size_t j = group.cols[q];
+            const V& r = right_data[right_row_offsets[x] + right_col_offsets[j]];
+            T& c = result_data[i * n + j];
+            const bool init = c.empty();
+            if(init)
+              c = T(inner_helper.make_result_range<typename T::range_type>(
+                  l.range(), r.range()));
+            numeric_type* MADNESS_RESTRICT const c_data = c.data();
+            for(integer a = 0; a < lm; ++a) {
+              const numeric_type* MADNESS_RESTRICT const w =
+                  work.data() + a * gn + q * group.n;
+              numeric_type* MADNESS_RESTRICT const c_a = c_data + a * group.n;
+              if(init)
+                std::copy(w, w + group.n, c_a);
+              else
+                for(integer b = 0; b < group.n; ++b)
+                  c_a[b] += w[b];
+            }
+          }
+        }
+      }
+    }
+
+    return result;
+  }
+
+  /// Contract and scale nested tensors
+
+  /// \tparam U The left-hand tensor element type
+  /// \tparam AU The left-hand tensor allocator type
+  /// \tparam V The right-hand tensor element type
+  /// \tparam AV The right-hand tensor allocator type
+  /// \tparam W The type of the scaling factor
+  /// \param left The left-hand tensor that will be contracted
+  /// \param right The right-hand tensor that will be contracted
+  /// \param factor Multiply the result by this constant
+  /// \param gemm_helper The *GEMM operation meta data of the outer dimensions
+  /// of the permuted arguments
+  /// \param nested The product of the inner tensors
+  /// \param left_perm The permutation applied to the outer dimensions of
+  /// \c left
+  /// \param right_perm The permutation applied to the outer dimensions of
+  /// \c right
+  /// \return A new tensor which is the result of contracting \c left with
+  /// \c right and scaled by \c factor
+  /// \sa nested_gemm(Tensor<T, A>&, const Tensor<U, AU>&, const Tensor<V, AV>&, const W, const math::GemmHelper&, const math::NestedProduct&, const Permutation&, const Permutation&)
+  template <typename U, typename AU, typename V, typename AV, typename W,
+      typename std::enable_if<detail::is_tensor_of_tensor<Tensor<U, AU>,
+          Tensor<V, AV> >::value>::type* = nullptr>
+  inline Tensor<U, AU> nested_gemm(const Tensor<U, AU>& left,
+      const Tensor<V, AV>& right, const W factor,
+      const math::GemmHelper& gemm_helper, const math::NestedProduct& nested,
+      const Permutation& left_perm = Permutation(),
+      const Permutation& right_perm = Permutation())
+  {
+    Tensor<U, AU> result;
+    nested_gemm(result, left, right, factor, gemm_helper, nested, left_perm,
+        right_perm);
+    return result;
+  }
+
+  /// Multiply the elements of nested tensors
+
+  /// The outer dimensions of \c left and \c right are multiplied
+  /// coefficient-wise, and each pair of inner tensors is multiplied as
+  /// defined by \c nested , i.e.
+  /// <tt>result[i] = factor * nested(left[i], right[i])</tt> . Empty inner
+  /// tensors are treated as zero.
+  /// \tparam U The left-hand tensor element type
+  /// \tparam AU The left-hand tensor allocator type
+  /// \tparam V The right-hand tensor element type
+  /// \tparam AV The right-hand tensor allocator type
+  /// \tparam W The type of the scaling factor
+  /// \param left The left-hand tensor
+  /// \param right The right-hand tensor
+  /// \param factor The scaling factor
+  /// \param nested The product of the inner tensors
+  /// \return A new tensor with the scaled products of the inner tensors of
+  /// \c left and \c right
+  template <typename U, typename AU, typename V, typename AV, typename W,
+      typename std::enable_if<detail::is_tensor_of_tensor<Tensor<U, AU>,
+          Tensor<V, AV> >::value>::type* = nullptr>
+  inline Tensor<U, AU> nested_mult(const Tensor<U, AU>& left,
+      const Tensor<V, AV>& right, const W factor,
+      const math::NestedProduct& nested)
+  {
+    TA_ASSERT(! left.empty());
+    TA_ASSERT(! right.empty());
+    TA_ASSERT(left.range() == right.range());
+
+    Tensor<U, AU> result(left.range());
+    const auto volume = left.range().volume();
+    for(decltype(left.range().volume()) i = 0ul; i < volume; ++i) {
+      const U& l = left.data()[i];
+      const V& r = right.data()[i];
+      if(l.empty() || r.empty())
+        continue;
+      if(nested.is_contraction())
+        result.data()[i] = l.gemm(r, factor, nested.gemm_helper());
+      else
+        result.data()[i] = l.mult(r, factor);
+    }
+
+    return result;
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TENSOR_NESTED_GEMM_H__INCLUDED
@@ -0,0 +1,271 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  permute_gemm.h
+ *  Jun 15, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TENSOR_PERMUTE_GEMM_H__INCLUDED
+#define TILEDARRAY_TENSOR_PERMUTE_GEMM_H__INCLUDED
+
+#include <TiledArray/tensor/tensor.h>
+#include <TiledArray/math/parallel_gemm.h>
+#include <vector>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Number of elements in the operand panels of \c permute_gemm
+
+    /// Permuted operands are copied to panels with at least
+    /// \c permute_gemm_min_panel_cols columns, and as many more as fit in this
+    /// number of elements (256 KiB of \c double ).
+    constexpr std::size_t permute_gemm_panel_size = 32768ul;
+
+    /// Minimum number of contracted columns in the panels of \c permute_gemm
+    constexpr std::size_t permute_gemm_min_panel_cols = 64ul;
+
+    /// Compute the ordinal offsets of a permuted index range
+
+    /// The dimensions <tt>[first, last)</tt> of <tt>perm ^ range</tt> are
+    /// fused into a single, row-major index. This function computes the
+    /// offset, in \c range , of each element of the fused index.
+    /// \param[out] offsets The ordinal offsets of the fused index
+    /// \param[in] range The range of the unpermuted tensor
+    /// \param[in] perm The permutation applied to \c range
+    /// \param[in] first The first dimension of the permuted range
+    /// \param[in] last The last dimension of the permuted range
+    inline void permuted_offsets(std::vector<std::size_t>& offsets,
+        const Range& range, const Permutation& perm, const unsigned int first,
+        const unsigned int last)
+    {
+      const Permutation inv_perm = perm.inv();
+      offsets.assign(1ul, 0ul);
+      std::vector<std::size_t> temp;
+      for(unsigned int i = first; i < last; ++i) {
+        const std::size_t extent = range.extent_data()[inv_perm[i]];
+        const std::size_t stride = range.stride_data()[inv_perm[i]];
+
+        temp.clear();
+        temp.reserve(offsets.size() * extent);
+        for(const std::size_t offset : offsets)
+          for(std::size_t x = 0ul; x < extent; ++x)
+            temp.push_back(offset + x * stride);
+        offsets.swap(temp);
+      }
+    }
+
+    /// Copy a block of a permuted tensor to a row-major matrix panel
+
+    /// \tparam T The element type
+    /// \param[out] panel The matrix panel with \c rows rows and \c cols
+    /// columns
+    /// \param[in] data The data of the unpermuted tensor
+    /// \param[in] row_offsets The offsets of the panel rows in \c data
+    /// \param[in] rows The number of rows in the panel
+    /// \param[in] col_offsets The offsets of the panel columns in \c data
+    /// \param[in] cols The number of columns in the panel
+    template <typename T>
+    inline void pack_permuted_panel(T* MADNESS_RESTRICT const panel,
+        const T* MADNESS_RESTRICT const data,
+        const std::size_t* MADNESS_RESTRICT const row_offsets, const std::size_t rows,
+        const std::size_t* MADNESS_RESTRICT const col_offsets, const std::size_t cols)
+    {
+      for(std::size_t i = 0ul; i < rows; ++i) {
+        const T* MADNESS_RESTRICT const data_i = data + row_offsets[i];
+        T* MADNESS_RESTRICT const panel_i = panel + i * cols;
+        for(std::size_t j = 0ul; j < cols; ++j)
+          panel_i[j] = data_i[col_offsets[j]];
+      }
+    }
+
+  } // namespace detail
+
+
+  /// Contract permuted tensors and accumulate the scaled result
+
+  /// This computes the same result as
+  /// \code
+  /// result.gemm(left.permute(left_perm), right.permute(right_perm), factor, gemm_helper);
+  /// \endcode
+  /// without the permuted copies of \c left and \c right . The contracted
+  /// dimension is split into panels; for each panel, the elements of the
+  /// permuted arguments are gathered into a cache-sized matrix that is
+  /// contracted and accumulated to \c result . An empty permutation indicates
+  /// that the argument is used as is.
+  /// \tparam T The result tensor element type
+  /// \tparam A The result tensor allocator type
+  /// \tparam U The left-hand tensor element type
+  /// \tparam AU The left-hand tensor allocator type
+  /// \tparam V The right-hand tensor element type
+  /// \tparam AV The right-hand tensor allocator type
+  /// \tparam W The type of the scaling factor
+  /// \param result The result tensor; if it is empty, it will be initialized
+  /// with the result of the contraction
+  /// \param left The left-hand tensor that will be contracted
+  /// \param right The right-hand tensor that will be contracted
+  /// \param factor The contraction result will be scaling by this value, then accumulated into \c result
+  /// \param gemm_helper The *GEMM operation meta data of the permuted arguments
+  /// \param left_perm The permutation applied to \c left
+  /// \param right_perm The permutation applied to \c right
+  /// \return A reference to \c result
+  template <typename T, typename A, typename U, typename AU, typename V,
+      typename AV, typename W,
+      typename std::enable_if<!detail::is_tensor_of_tensor<Tensor<T, A>,
+          Tensor<U, AU>, Tensor<V, AV> >::value>::type* = nullptr>
+  inline Tensor<T, A>& permute_gemm(Tensor<T, A>& result,
+      const Tensor<U, AU>& left, const Tensor<V, AV>& right, const W factor,
+      const math::GemmHelper& gemm_helper, const Permutation& left_perm,
+      const Permutation& right_perm)
+  {
+    typedef typename Tensor<T, A>::numeric_type numeric_type;
+
+    TA_ASSERT(! left.empty());
+    TA_ASSERT(! right.empty());
+    TA_ASSERT((! left_perm) || (gemm_helper.left_op() == madness::cblas::NoTrans));
+    TA_ASSERT((! right_perm) || (gemm_helper.right_op() == madness::cblas::NoTrans));
+
+    // Get the ranges of the permuted arguments
+    const Range left_range = (left_perm ? left_perm * left.range() : left.range());
+    const Range right_range = (right_perm ? right_perm * right.range() : right.range());
+    TA_ASSERT(left_range.rank() == gemm_helper.left_rank());
+    TA_ASSERT(right_range.rank() == gemm_helper.right_rank());
+    TA_ASSERT(gemm_helper.left_right_congruent(left_range.extent_data(),
+        right_range.extent_data()));
+
+    numeric_type beta(1);
+    if(result.empty()) {
+      result = Tensor<T, A>(gemm_helper.make_result_range<Range>(left_range, right_range));
+      beta = numeric_type(0);
+    }
+    TA_ASSERT(result.range().rank() == gemm_helper.result_rank());
+    TA_ASSERT(gemm_helper.left_result_congruent(left_range.extent_data(),
+        result.range().extent_data()));
+    TA_ASSERT(gemm_helper.right_result_congruent(right_range.extent_data(),
+        result.range().extent_data()));
+
+    // Compute gemm dimensions
+    integer m, n, k;
+    gemm_helper.compute_matrix_sizes(m, n, k, left_range, right_range);
+
+    // Compute the offsets of the rows and columns of the permuted arguments,
+    // which are in the form left[M...,K...] and right[K...,N...].
+    const unsigned int inner_rank = gemm_helper.num_contract_ranks();
+    const unsigned int left_outer_rank = gemm_helper.left_rank() - inner_rank;
+    std::vector<std::size_t> left_row_offsets, left_col_offsets,
+        right_row_offsets, right_col_offsets;
+    std::size_t panel_rows = 1ul;
+    if(left_perm) {
+      detail::permuted_offsets(left_row_offsets, left.range(), left_perm, 0u,
+          left_outer_rank);
+      detail::permuted_offsets(left_col_offsets, left.range(), left_perm,
+          left_outer_rank, gemm_helper.left_rank());
+      panel_rows = std::max<std::size_t>(panel_rows, m);
+    }
+    if(right_perm) {
+      detail::permuted_offsets(right_row_offsets, right.range(), right_perm, 0u,
+          inner_rank);
+      detail::permuted_offsets(right_col_offsets, right.range(), right_perm,
+          inner_rank, gemm_helper.right_rank());
+      panel_rows = std::max<std::size_t>(panel_rows, n);
+    }
+
+    // Select the number of contracted columns in each panel
+    const integer panel_cols = std::min<integer>(k,
+        std::max(detail::permute_gemm_min_panel_cols,
+        detail::permute_gemm_panel_size / panel_rows));
+
+    std::vector<U> left_panel(left_perm ? m * panel_cols : 0ul);
+    std::vector<V> right_panel(right_perm ? panel_cols * n : 0ul);
+
+    for(integer k0 = 0; k0 < k; k0 += panel_cols) {
+      const integer kn = std::min(panel_cols, k - k0);
+
+      // Get the left-hand panel
+      const U* a = nullptr;
+      integer lda = 0;
+      if(left_perm) {
+        detail::pack_permuted_panel(left_panel.data(), left.data(),
+            left_row_offsets.data(), m, left_col_offsets.data() + k0, kn);
+        a = left_panel.data();
+        lda = kn;
+      } else if(gemm_helper.left_op() == madness::cblas::NoTrans) {
+        a = left.data() + k0;
+        lda = k;
+      } else {
+        a = left.data() + k0 * m;
+        lda = m;
+      }
+
+      // Get the right-hand panel
+      const V* b = nullptr;
+      integer ldb = 0;
+      if(right_perm) {
+        detail::pack_permuted_panel(right_panel.data(), right.data(),
+            right_row_offsets.data() + k0, kn, right_col_offsets.data(), n);
+        b = right_panel.data();
+        ldb = n;
+      } else if(gemm_helper.right_op() == madness::cblas::NoTrans) {
+        b = right.data() + k0 * n;
+        ldb = n;
+      } else {
+        b = right.data() + k0;
+        ldb = k;
+      }
+
+      math::parallel_gemm(gemm_helper.left_op(), gemm_helper.right_op(), m, n,
+          kn, factor, a, lda, b, ldb, beta, result.data(), n,
+          gemm_helper.parallel());
+      beta = numeric_type(1);
+    }
+
+    return result;
+  }
+
+  /// Contract and scale permuted tensors
+
+  /// \tparam U The left-hand tensor element type
+  /// \tparam AU The left-hand tensor allocator type
+  /// \tparam V The right-hand tensor element type
+  /// \tparam AV The right-hand tensor allocator type
+  /// \tparam W The type of the scaling factor
+  /// \param left The left-hand tensor that will be contracted
+  /// \param right The right-hand tensor that will be contracted
+  /// \param factor Multiply the result by this constant
+  /// \param gemm_helper The *GEMM operation meta data of the permuted arguments
+  /// \param left_perm The permutation applied to \c left
+  /// \param right_perm The permutation applied to \c right
+  /// \return A new tensor which is the result of contracting
+  /// <tt>left_perm ^ left</tt> with <tt>right_perm ^ right</tt> and scaled by
+  /// \c factor
+  template <typename U, typename AU, typename V, typename AV, typename W,
+      typename std::enable_if<!detail::is_tensor_of_tensor<Tensor<U, AU>,
+          Tensor<V, AV> >::value>::type* = nullptr>
+  inline Tensor<U, AU> permute_gemm(const Tensor<U, AU>& left,
+      const Tensor<V, AV>& right, const W factor,
+      const math::GemmHelper& gemm_helper, const Permutation& left_perm,
+      const Permutation& right_perm)
+  {
+    Tensor<U, AU> result;
+    permute_gemm(result, left, right, factor, gemm_helper, left_perm, right_perm);
+    return result;
+  }
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TENSOR_PERMUTE_GEMM_H__INCLUDED
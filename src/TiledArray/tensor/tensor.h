@@ -22,6 +22,7 @@
 
 #include <TiledArray/math/gemm_helper.h>
 #include <TiledArray/math/blas.h>
+#include <TiledArray/math/parallel_gemm.h>
 #include <TiledArray/tensor/kernels.h>
 #include <TiledArray/tensor/complex.h>
 
@@ -65,13 +66,13 @@ namespace TiledArray {
       /// Default constructor
 
       /// Construct an empty tensor that has no data or dimensions
-      Impl() : allocator_type(), range_(), data_(NULL) { }
+      Impl() : allocator_type(), range_(), data_(NULL), owner_() { }
 
       /// Construct with range
 
       /// \param range The N-dimensional range for this tensor
       explicit Impl(const range_type& range) :
-        allocator_type(), range_(range), data_(NULL)
+        allocator_type(), range_(range), data_(NULL), owner_()
       {
         data_ = allocator_type::allocate(range.volume());
       }
@@ -80,19 +81,32 @@ namespace TiledArray {
 
       /// \param range The N-dimensional range for this tensor
       explicit Impl(range_type&& range) :
-        allocator_type(), range_(range), data_(NULL)
+        allocator_type(), range_(range), data_(NULL), owner_()
       {
         data_ = allocator_type::allocate(range.volume());
       }
 
+      /// Construct with external data
+
+      /// \param range The N-dimensional range for this tensor
+      /// \param data The tensor data
+      /// \param owner The object that owns \c data
+      Impl(const range_type& range, pointer data,
+          const std::shared_ptr<const void>& owner) :
+        allocator_type(), range_(range), data_(data), owner_(owner)
+      { }
+
       ~Impl() {
-        math::destroy_vector(range_.volume(), data_);
-        allocator_type::deallocate(data_, range_.volume());
+        if(! owner_) {
+          math::destroy_vector(range_.volume(), data_);
+          allocator_type::deallocate(data_, range_.volume());
+        }
         data_ = NULL;
       }
 
       range_type range_; ///< Tensor size info
       pointer data_; ///< Tensor data
+      std::shared_ptr<const void> owner_; ///< Owner of external data
     }; // class Impl
 
     template <typename... Ts>
@@ -188,6 +202,21 @@ namespace TiledArray {
       math::uninitialized_copy_vector(range.volume(), u, pimpl_->data_);
     }
 
+    /// Construct a tensor that uses external data
+
+    /// The tensor does not copy or free \c data . Instead, it holds a
+    /// reference to \c owner , which must keep \c data valid. The elements
+    /// of \c data must be initialized.
+    /// \param range The range of the tensor
+    /// \param data The tensor data, which has \c range.volume() elements
+    /// \param owner The object that owns \c data
+    Tensor(const range_type& range, pointer data,
+        const std::shared_ptr<const void>& owner) :
+      pimpl_(std::make_shared<Impl>(range, data, owner))
+    {
+      TA_ASSERT(owner);
+    }
+
     /// Construct a copy of a tensor interface object
 
     /// \tparam T1 A tensor type
@@ -426,6 +455,12 @@ namespace TiledArray {
     /// data), otherwise \c false.
     bool empty() const { return !pimpl_; }
 
+    /// Test if the tensor data is shared
+
+    /// \return \c true if other tensors share the data of this tensor,
+    /// otherwise \c false.
+    bool is_shared() const { return pimpl_.use_count() > 1l; }
+
     /// Output serialization function
 
     /// This function enables serialization within MADNESS
@@ -1159,8 +1194,9 @@ namespace TiledArray {
       const integer lda = (gemm_helper.left_op() == madness::cblas::NoTrans ? k : m);
       const integer ldb = (gemm_helper.right_op() == madness::cblas::NoTrans ? n : k);
 
-      math::gemm(gemm_helper.left_op(), gemm_helper.right_op(), m, n, k, factor,
-          pimpl_->data_, lda, other.data(), ldb, numeric_type(0), result.data(), n);
+      math::parallel_gemm(gemm_helper.left_op(), gemm_helper.right_op(), m, n, k, factor,
+          pimpl_->data_, lda, other.data(), ldb, numeric_type(0), result.data(), n,
+          gemm_helper.parallel());
 
       return result;
     }
@@ -1256,8 +1292,9 @@ namespace TiledArray {
       const integer ldb =
           (gemm_helper.right_op() == madness::cblas::NoTrans ? n : k);
 
-      math::gemm(gemm_helper.left_op(), gemm_helper.right_op(), m, n, k, factor,
-          left.data(), lda, right.data(), ldb, numeric_type(1), pimpl_->data_, n);
+      math::parallel_gemm(gemm_helper.left_op(), gemm_helper.right_op(), m, n, k, factor,
+          left.data(), lda, right.data(), ldb, numeric_type(1), pimpl_->data_, n,
+          gemm_helper.parallel());
 
       return *this;
     }
@@ -0,0 +1,313 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_cache.h
+ *  Jun 12, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TILE_CACHE_H__INCLUDED
+#define TILEDARRAY_TILE_CACHE_H__INCLUDED
+
+#include <TiledArray/madness.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Estimate the memory footprint of a tile
+
+    /// This overload is used for tiles that provide \c size() and
+    /// \c value_type , e.g. \c Tensor .
+    /// \tparam T The tile type
+    /// \param tile The tile
+    /// \return The approximate number of bytes used by \c tile
+    template <typename T>
+    inline auto tile_bytes(const T& tile, int) ->
+        decltype(tile.size() * sizeof(typename T::value_type))
+    {
+      return sizeof(T) + tile.size() * sizeof(typename T::value_type);
+    }
+
+    /// Estimate the memory footprint of a tile
+
+    /// This overload is used for all other tile types.
+    /// \tparam T The tile type
+    /// \return The size of the tile object
+    template <typename T>
+    inline std::size_t tile_bytes(const T&, long) { return sizeof(T); }
+
+  } // namespace detail
+
+  /// Per-process cache of remote tiles
+
+  /// Tiles that are fetched from other processes by
+  /// \c detail::DistributedStorage::get are kept in this cache, so repeated
+  /// requests for the same remote tile do not communicate. Cached tiles are
+  /// identified by the id of the distributed container and the ordinal index
+  /// of the tile, and are evicted in least-recently-used order when the total
+  /// size of the cached tiles exceeds the maximum size. A request for a tile
+  /// that is still in transit is also a hit, so concurrent requests for the
+  /// same tile send a single message.
+  ///
+  /// The cache is disabled by default; it is enabled by setting a non-zero
+  /// maximum size with \c max_bytes() on each process, e.g.
+  /// \code
+  /// TiledArray::TileCache::instance().max_bytes(1ul << 30); // 1 GiB
+  /// \endcode
+  /// Tiles of a distributed container are set only once, and operations
+  /// that modify an array (e.g. expression assignment, \c foreach_inplace ,
+  /// \c truncate ) construct a new container with a new id, so cached tiles
+  /// are never stale. The tiles of a container are removed from the cache when
+  /// the container is destroyed. Tiles that are modified in place by user code
+  /// must be removed with \c erase() on all processes.
+  /// \note Cached tiles are shared with the futures returned by
+  /// \c DistributedStorage::get , and must not be modified.
+  class TileCache : private madness::Spinlock {
+  public:
+    typedef std::size_t size_type; ///< Size type
+
+  private:
+
+    /// Cached tile key: world id, object id, and tile ordinal
+    typedef std::tuple<unsigned long, unsigned long, size_type> key_type;
+
+    /// Cached tile data
+    struct Entry {
+      key_type key; ///< The key of the tile
+      std::shared_ptr<void> tile; ///< A pointer to the Future that holds the tile
+      size_type bytes; ///< The size of the tile, zero if it is in transit
+      unsigned long serial; ///< Unique entry number
+    }; // struct Entry
+
+    typedef std::list<Entry> list_type;
+
+    list_type entries_; ///< Cached tiles, ordered from most to least recently used
+    std::map<key_type, list_type::iterator> index_; ///< Index of the cached tiles
+    size_type max_bytes_; ///< The maximum size of the cached tiles
+    size_type bytes_; ///< The size of the cached tiles
+    size_type hits_; ///< The number of requests that were found in the cache
+    size_type misses_; ///< The number of requests that were not in the cache
+    unsigned long serial_; ///< The serial number of the next entry
+
+    // not allowed
+    TileCache(const TileCache&);
+    TileCache& operator=(const TileCache&);
+
+    static key_type make_key(const madness::uniqueidT& id, const size_type i) {
+      return key_type(id.get_world_id(), id.get_obj_id(), i);
+    }
+
+    /// Remove least-recently used tiles until the cache is within its size
+
+    /// \note The cache must be locked by the caller
+    void evict() {
+      while((bytes_ > max_bytes_) && ! entries_.empty()) {
+        bytes_ -= entries_.back().bytes;
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+      }
+    }
+
+    /// Record the size of a tile when it arrives
+    template <typename T>
+    class Arrival : public madness::CallbackInterface {
+      TileCache& cache_; ///< The cache that holds the tile
+      key_type key_; ///< The key of the tile
+      unsigned long serial_; ///< The serial number of the entry
+      Future<T> tile_; ///< The future that will hold the tile
+
+    public:
+
+      Arrival(TileCache& cache, const key_type& key,
+          const unsigned long serial, const Future<T>& tile) :
+        cache_(cache), key_(key), serial_(serial), tile_(tile)
+      { }
+
+      virtual ~Arrival() { }
+
+      virtual void notify() {
+        cache_.arrived(key_, serial_, detail::tile_bytes(tile_.get(), 0));
+        delete this;
+      }
+    }; // class Arrival
+
+    void arrived(const key_type& key, const unsigned long serial,
+        const size_type bytes)
+    {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+
+      // The entry may have been evicted or erased while the tile was in transit
+      auto it = index_.find(key);
+      if((it == index_.end()) || (it->second->serial != serial))
+        return;
+
+      it->second->bytes = bytes;
+      bytes_ += bytes;
+      evict();
+    }
+
+  public:
+
+    /// Construct an empty, disabled cache
+    TileCache() :
+      madness::Spinlock(), entries_(), index_(), max_bytes_(0ul), bytes_(0ul),
+      hits_(0ul), misses_(0ul), serial_(0ul)
+    { }
+
+    /// The cache of this process
+
+    /// \return A reference to the cache used by all distributed containers in
+    /// this process
+    static TileCache& instance() {
+      static TileCache cache;
+      return cache;
+    }
+
+    /// Maximum size accessor
+
+    /// \return The maximum size of the cached tiles, in bytes
+    size_type max_bytes() const { return max_bytes_; }
+
+    /// Set the maximum size of the cached tiles
+
+    /// Tiles are evicted if the cache is larger than the new size. A size of
+    /// zero disables the cache.
+    /// \param bytes The maximum size of the cached tiles, in bytes
+    void max_bytes(const size_type bytes) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      max_bytes_ = bytes;
+      if(max_bytes_ == 0ul) {
+        entries_.clear();
+        index_.clear();
+        bytes_ = 0ul;
+      } else {
+        evict();
+      }
+    }
+
+    /// Cache state query
+
+    /// \return \c true when the maximum size is non-zero
+    bool enabled() const { return max_bytes_ != 0ul; }
+
+    /// Cache size accessor
+
+    /// \return The size of the tiles that have arrived, in bytes
+    size_type bytes() const { return bytes_; }
+
+    /// Number of cached tiles
+
+    /// This function does not lock the cache, so the result is exact only
+    /// when no tiles are requested or erased concurrently, e.g. after a fence.
+    /// \return The number of tiles in the cache, including tiles in transit
+    size_type size() const { return entries_.size(); }
+
+    /// Hit counter accessor
+
+    /// \return The number of requests that were found in the cache
+    size_type hits() const { return hits_; }
+
+    /// Miss counter accessor
+
+    /// \return The number of requests that were not found in the cache
+    size_type misses() const { return misses_; }
+
+    /// Reset the hit and miss counters
+    void reset_counters() {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      hits_ = 0ul;
+      misses_ = 0ul;
+    }
+
+    /// Find or insert a tile
+
+    /// If tile \c i of container \c id is cached, \c tile is set to the cached
+    /// future. Otherwise \c tile is inserted into the cache, and the caller is
+    /// responsible for requesting the tile.
+    /// \tparam T The tile type
+    /// \param id The id of the distributed container
+    /// \param i The ordinal index of the tile
+    /// \param[in,out] tile The future of the tile
+    /// \return \c true if the tile was found in the cache, otherwise \c false
+    template <typename T>
+    bool find_or_insert(const madness::uniqueidT& id, const size_type i,
+        Future<T>& tile)
+    {
+      const key_type key = make_key(id, i);
+      unsigned long serial = 0ul;
+      {
+        madness::ScopedMutex<madness::Spinlock> locker(this);
+        if(max_bytes_ == 0ul)
+          return false;
+
+        auto it = index_.find(key);
+        if(it != index_.end()) {
+          // Move the tile to the front of the list
+          entries_.splice(entries_.begin(), entries_, it->second);
+          tile = *std::static_pointer_cast<Future<T> >(entries_.front().tile);
+          ++hits_;
+          return true;
+        }
+
+        ++misses_;
+        serial = serial_++;
+        entries_.push_front(Entry{ key,
+            std::static_pointer_cast<void>(std::make_shared<Future<T> >(tile)),
+            0ul, serial });
+        index_.emplace(key, entries_.begin());
+      }
+
+      // Record the size of the tile when it arrives
+      Arrival<T>* arrival = new Arrival<T>(*this, key, serial, tile);
+      tile.register_callback(arrival);
+
+      return false;
+    }
+
+    /// Remove the tiles of a container
+
+    /// \param id The id of the distributed container
+    void erase(const madness::uniqueidT& id) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      auto first = index_.lower_bound(make_key(id, 0ul));
+      while((first != index_.end()) &&
+          (std::get<0>(first->first) == id.get_world_id()) &&
+          (std::get<1>(first->first) == id.get_obj_id()))
+      {
+        bytes_ -= first->second->bytes;
+        entries_.erase(first->second);
+        first = index_.erase(first);
+      }
+    }
+
+    /// Remove all tiles
+    void clear() {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      entries_.clear();
+      index_.clear();
+      bytes_ = 0ul;
+    }
+
+  }; // class TileCache
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TILE_CACHE_H__INCLUDED
@@ -0,0 +1,547 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_compression.h
+ *  Jul 2, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TILE_COMPRESSION_H__INCLUDED
+#define TILEDARRAY_TILE_COMPRESSION_H__INCLUDED
+
+#include <TiledArray/madness.h>
+#include <TiledArray/tensor/tensor.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace TiledArray {
+
+  /// Accuracy contract for tile transfers
+
+  /// The contract selects how tiles are encoded when they are sent to other
+  /// processes by \c detail::DistributedStorage::get and by the SUMMA
+  /// broadcasts. The available modes are:
+  /// - \c none : tiles are sent as they are (the default).
+  /// - \c lossless : the bytes of the elements are shuffled, so that bytes of
+  ///   equal significance are adjacent, and compressed with LZ77. Tiles are
+  ///   received bit-for-bit.
+  /// - \c single : \c double elements are rounded to \c float , then
+  ///   compressed as in \c lossless . The relative error of each element is
+  ///   at most 2^-24. Other element types are compressed losslessly.
+  /// - \c bounded : floating-point elements are quantized to multiples of
+  ///   <tt>2 * tolerance</tt>, then compressed as in \c lossless . The
+  ///   absolute error of each element is at most \c tolerance . Other element
+  ///   types are compressed losslessly.
+  ///
+  /// Only \c Tensor tiles with arithmetic elements are compressed; other tile
+  /// types are always sent as they are. Tiles are encoded and decoded by
+  /// tasks, so the communication threads only copy the encoded data.
+  class TileCompression {
+  public:
+    typedef std::size_t size_type; ///< Size type
+
+    /// Compression modes
+    enum Mode { none = 0, lossless = 1, single = 2, bounded = 3 };
+
+  private:
+    Mode mode_; ///< The compression mode
+    double tolerance_; ///< The absolute error bound of \c bounded
+
+    static std::atomic<size_type>& counter(const int i) {
+      static std::atomic<size_type> counters[4];
+      return counters[i];
+    }
+
+  public:
+
+    /// Construct a contract that does not compress tiles
+    TileCompression() : mode_(none), tolerance_(0.0) { }
+
+    /// Construct a contract
+
+    /// \param mode The compression mode
+    /// \param tolerance The absolute error bound, used with \c bounded
+    /// \throw TiledArray::Exception When \c mode is \c bounded and
+    /// \c tolerance is not positive
+    explicit TileCompression(const Mode mode, const double tolerance = 0.0) :
+      mode_(mode), tolerance_(tolerance)
+    {
+      if((mode_ == bounded) && ! (tolerance_ > 0.0))
+        TA_EXCEPTION("TileCompression: bounded compression requires a positive tolerance.");
+    }
+
+    /// Mode accessor
+
+    /// \return The compression mode
+    Mode mode() const { return mode_; }
+
+    /// Tolerance accessor
+
+    /// \return The absolute error bound of \c bounded compression
+    double tolerance() const { return tolerance_; }
+
+    /// Compression query
+
+    /// \return \c true if tiles are compressed
+    bool enabled() const { return mode_ != none; }
+
+    /// Serialize the contract
+
+    /// \tparam Archive The archive type
+    /// \param ar The archive
+    template <typename Archive>
+    void serialize(Archive& ar) {
+      int mode = mode_;
+      ar & mode & tolerance_;
+      mode_ = Mode(mode);
+    }
+
+    /// Record an encoded tile
+
+    /// \param raw_bytes The size of the tile data
+    /// \param packed_bytes The size of the encoded data
+    /// \param time The encoding time, in seconds
+    static void record_encode(const size_type raw_bytes,
+        const size_type packed_bytes, const double time)
+    {
+      counter(0) += raw_bytes;
+      counter(1) += packed_bytes;
+      counter(2) += size_type(time * 1.0e9);
+    }
+
+    /// Record a decoded tile
+
+    /// \param time The decoding time, in seconds
+    static void record_decode(const double time) {
+      counter(3) += size_type(time * 1.0e9);
+    }
+
+    /// Encoded data accessor
+
+    /// \return The size of the tile data that was encoded by this process
+    static size_type raw_bytes() { return counter(0); }
+
+    /// Compressed data accessor
+
+    /// \return The size of the encoded data produced by this process
+    static size_type packed_bytes() { return counter(1); }
+
+    /// Encoding time accessor
+
+    /// \return The time spent encoding tiles by this process, in seconds
+    static double encode_time() { return double(counter(2)) * 1.0e-9; }
+
+    /// Decoding time accessor
+
+    /// \return The time spent decoding tiles by this process, in seconds
+    static double decode_time() { return double(counter(3)) * 1.0e-9; }
+
+    /// Reset the statistics counters
+    static void reset_counters() {
+      for(int i = 0; i < 4; ++i)
+        counter(i) = 0ul;
+    }
+
+  }; // class TileCompression
+
+  namespace detail {
+
+    /// Shuffle the bytes of an array
+
+    /// Byte \c b of element \c i is moved to position <tt>b * n + i</tt>.
+    /// \param in The input data
+    /// \param n The number of elements
+    /// \param size The size of an element, in bytes
+    /// \param[out] out The shuffled data
+    inline void byte_shuffle(const unsigned char* const in, const std::size_t n,
+        const std::size_t size, unsigned char* const out)
+    {
+      for(std::size_t i = 0ul; i < n; ++i)
+        for(std::size_t b = 0ul; b < size; ++b)
+          out[b * n + i] = in[i * size + b];
+    }
+
+    /// Reverse \c byte_shuffle
+
+    /// \param in The shuffled data
+    /// \param n The number of elements
+    /// \param size The size of an element, in bytes
+    /// \param[out] out The original data
+    inline void byte_unshuffle(const unsigned char* const in, const std::size_t n,
+        const std::size_t size, unsigned char* const out)
+    {
+      for(std::size_t b = 0ul; b < size; ++b)
+        for(std::size_t i = 0ul; i < n; ++i)
+          out[i * size + b] = in[b * n + i];
+    }
+
+    /// Write an LZ77 length extension
+    inline void lz_write_length(std::size_t length, std::vector<unsigned char>& out) {
+      while(length >= 255ul) {
+        out.push_back(255u);
+        length -= 255ul;
+      }
+      out.push_back(static_cast<unsigned char>(length));
+    }
+
+    /// Read an LZ77 length extension
+    inline std::size_t lz_read_length(const unsigned char* const in,
+        const std::size_t n, std::size_t& ip)
+    {
+      std::size_t length = 0ul;
+      unsigned char b = 255u;
+      while(b == 255u) {
+        if(ip >= n)
+          TA_EXCEPTION("Compressed tile data is corrupt.");
+        b = in[ip++];
+        length += b;
+      }
+      return length;
+    }
+
+    /// Write an LZ77 sequence: literals, followed by an optional match
+    inline void lz_write_sequence(const unsigned char* const literals,
+        const std::size_t literal_length, const std::size_t offset,
+        const std::size_t match_length, std::vector<unsigned char>& out)
+    {
+      const std::size_t ml = (match_length ? match_length - 4ul : 0ul);
+      out.push_back(static_cast<unsigned char>(
+          (std::min<std::size_t>(literal_length, 15ul) << 4) |
+          std::min<std::size_t>(ml, 15ul)));
+      if(literal_length >= 15ul)
+        lz_write_length(literal_length - 15ul, out);
+      out.insert(out.end(), literals, literals + literal_length);
+      if(match_length) {
+        out.push_back(static_cast<unsigned char>(offset & 0xfful));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if(ml >= 15ul)
+          lz_write_length(ml - 15ul, out);
+      }
+    }
+
+    /// Compress data with LZ77
+
+    /// The format is a sequence of tokens, each followed by literal bytes and
+    /// an optional back reference of at least 4 bytes within a 64 KiB window.
+    /// \param in The input data
+    /// \param n The size of the input data
+    /// \param[out] out The compressed data
+    inline void lz_compress(const unsigned char* const in, const std::size_t n,
+        std::vector<unsigned char>& out)
+    {
+      constexpr unsigned int hash_bits = 14u;
+      constexpr std::size_t window = 65535ul;
+      std::vector<std::size_t> table(1ul << hash_bits, n);
+
+      out.clear();
+      out.reserve(n / 2ul + 16ul);
+      std::size_t ip = 0ul, anchor = 0ul;
+      while(ip + 4ul <= n) {
+        std::uint32_t seq;
+        std::memcpy(&seq, in + ip, 4ul);
+        const std::size_t h = (seq * 2654435761u) >> (32u - hash_bits);
+        const std::size_t ref = table[h];
+        table[h] = ip;
+
+        if((ref < ip) && (ip - ref <= window) &&
+            (std::memcmp(in + ref, in + ip, 4ul) == 0))
+        {
+          std::size_t length = 4ul;
+          while((ip + length < n) && (in[ref + length] == in[ip + length]))
+            ++length;
+          lz_write_sequence(in + anchor, ip - anchor, ip - ref, length, out);
+          ip += length;
+          anchor = ip;
+        } else {
+          ++ip;
+        }
+      }
+
+      lz_write_sequence(in + anchor, n - anchor, 0ul, 0ul, out);
+    }
+
+    /// Decompress data produced by \c lz_compress
+
+    /// \param in The compressed data
+    /// \param n The size of the compressed data
+    /// \param[out] out The decompressed data
+    /// \param size The size of the decompressed data
+    /// \throw TiledArray::Exception When the data is corrupt
+    inline void lz_decompress(const unsigned char* const in, const std::size_t n,
+        unsigned char* const out, const std::size_t size)
+    {
+      std::size_t ip = 0ul, op = 0ul;
+      while(ip < n) {
+        const unsigned char token = in[ip++];
+
+        std::size_t length = token >> 4;
+        if(length == 15ul)
+          length += lz_read_length(in, n, ip);
+        if((ip + length > n) || (op + length > size))
+          TA_EXCEPTION("Compressed tile data is corrupt.");
+        std::memcpy(out + op, in + ip, length);
+        ip += length;
+        op += length;
+        if(ip == n)
+          break;
+
+        if(ip + 2ul > n)
+          TA_EXCEPTION("Compressed tile data is corrupt.");
+        const std::size_t offset = in[ip] | (std::size_t(in[ip + 1ul]) << 8);
+        ip += 2ul;
+        length = token & 15u;
+        if(length == 15ul)
+          length += lz_read_length(in, n, ip);
+        length += 4ul;
+        if((offset == 0ul) || (offset > op) || (op + length > size))
+          TA_EXCEPTION("Compressed tile data is corrupt.");
+        // The source and destination may overlap, so copy bytewise
+        for(std::size_t i = 0ul; i < length; ++i, ++op)
+          out[op] = out[op - offset];
+      }
+      if(op != size)
+        TA_EXCEPTION("Compressed tile data is corrupt.");
+    }
+
+    /// Encoded tile
+
+    /// This is the form of a tile that is sent when compression is enabled.
+    /// The generic form holds the tile itself.
+    /// \tparam T The tile type
+    template <typename T, typename Enabler = void>
+    struct CompressedTile {
+      T tile; ///< The tile
+
+      template <typename Archive>
+      void serialize(Archive& ar) { ar & tile; }
+    }; // struct CompressedTile
+
+    /// Tile encoder and decoder
+
+    /// The generic codec does not compress tiles.
+    /// \tparam T The tile type
+    template <typename T, typename Enabler = void>
+    struct TileCodec {
+      typedef CompressedTile<T> packed_type; ///< Encoded tile type
+
+      static packed_type compress(const T& tile, const TileCompression&) {
+        return packed_type{ tile };
+      }
+
+      static T decompress(const packed_type& packed) { return packed.tile; }
+    }; // struct TileCodec
+
+    /// Encoded \c Tensor with arithmetic elements
+
+    /// Other \c Tensor tiles, e.g. with complex or tensor elements, use the
+    /// generic form.
+    template <typename T, typename A>
+    struct CompressedTile<Tensor<T, A>,
+        typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    {
+      int format; ///< The encoding: 0 for the raw tensor, otherwise the mode
+      bool packed; ///< \c true if \c data was compressed with LZ77
+      double scale; ///< The quantization step of \c bounded encoding
+      Range range; ///< The range of the tile
+      std::vector<unsigned char> data; ///< The encoded elements
+      Tensor<T, A> tile; ///< The tile, when \c format is 0
+
+      template <typename Archive>
+      void serialize(Archive& ar) {
+        ar & format;
+        if(format)
+          ar & packed & scale & range & data;
+        else
+          ar & tile;
+      }
+    }; // struct CompressedTile
+
+    /// Codec for \c Tensor tiles with arithmetic elements
+    template <typename T, typename A>
+    struct TileCodec<Tensor<T, A>,
+        typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    {
+      typedef Tensor<T, A> tile_type; ///< Tile type
+      typedef CompressedTile<tile_type> packed_type; ///< Encoded tile type
+
+    private:
+
+      /// Shuffle and compress elements
+
+      /// \tparam U The element type
+      /// \param in The elements
+      /// \param n The number of elements
+      /// \param[out] result The encoded tile
+      template <typename U>
+      static void pack(const U* const in, const std::size_t n, packed_type& result) {
+        const std::size_t bytes = n * sizeof(U);
+        std::vector<unsigned char> shuffled(bytes);
+        byte_shuffle(reinterpret_cast<const unsigned char*>(in), n, sizeof(U),
+            shuffled.data());
+        lz_compress(shuffled.data(), bytes, result.data);
+        result.packed = (result.data.size() < bytes);
+        if(! result.packed)
+          result.data.swap(shuffled);
+      }
+
+      /// Decompress and unshuffle elements
+
+      /// \tparam U The element type
+      /// \param packed The encoded tile
+      /// \param n The number of elements
+      /// \param[out] out The elements
+      template <typename U>
+      static void unpack(const packed_type& packed, const std::size_t n, U* const out) {
+        const std::size_t bytes = n * sizeof(U);
+        const unsigned char* shuffled = packed.data.data();
+        std::vector<unsigned char> buffer;
+        if(packed.packed) {
+          buffer.resize(bytes);
+          lz_decompress(packed.data.data(), packed.data.size(), buffer.data(), bytes);
+          shuffled = buffer.data();
+        } else {
+          if(packed.data.size() != bytes)
+            TA_EXCEPTION("Compressed tile data is corrupt.");
+        }
+        byte_unshuffle(shuffled, n, sizeof(U), reinterpret_cast<unsigned char*>(out));
+      }
+
+      /// Quantize elements
+
+      /// \param tile The tile
+      /// \param tolerance The absolute error bound
+      /// \param[out] result The encoded tile
+      /// \return \c false if an element cannot be quantized
+      static bool quantize(const tile_type& tile, const double tolerance,
+          packed_type& result, std::true_type)
+      {
+        const double scale = 2.0 * tolerance;
+        const double limit = double(std::numeric_limits<std::int64_t>::max() / 2);
+        std::vector<std::uint64_t> q(tile.size());
+        for(std::size_t i = 0ul; i < q.size(); ++i) {
+          const double x = double(tile[i]) / scale;
+          if(! (std::abs(x) < limit))
+            return false;
+          // Zig-zag encoding keeps the high bytes of small values zero
+          const std::int64_t v = std::llround(x);
+          q[i] = (std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63);
+        }
+        result.scale = scale;
+        pack(q.data(), q.size(), result);
+        return true;
+      }
+
+      static bool quantize(const tile_type&, const double, packed_type&, std::false_type) {
+        return false;
+      }
+
+      static void dequantize(const packed_type& packed, tile_type& tile) {
+        std::vector<std::uint64_t> q(tile.size());
+        unpack(packed, q.size(), q.data());
+        for(std::size_t i = 0ul; i < q.size(); ++i) {
+          const std::int64_t v = std::int64_t(q[i] >> 1) ^ -std::int64_t(q[i] & 1ul);
+          tile[i] = T(double(v) * packed.scale);
+        }
+      }
+
+      static void round_to_float(const tile_type& tile, packed_type& result) {
+        std::vector<float> f(tile.begin(), tile.end());
+        pack(f.data(), f.size(), result);
+      }
+
+      static void widen_from_float(const packed_type& packed, tile_type& tile) {
+        std::vector<float> f(tile.size());
+        unpack(packed, f.size(), f.data());
+        std::copy(f.begin(), f.end(), tile.begin());
+      }
+
+    public:
+
+      /// Encode a tile
+
+      /// \param tile The tile
+      /// \param compression The accuracy contract
+      /// \return The encoded tile
+      static packed_type compress(const tile_type& tile,
+          const TileCompression& compression)
+      {
+        packed_type result{ 0, false, 0.0, Range(), std::vector<unsigned char>(),
+            tile_type() };
+        if(tile.empty() || ! compression.enabled()) {
+          result.tile = tile;
+          return result;
+        }
+
+        const double start = madness::wall_time();
+        result.range = tile.range();
+        result.format = TileCompression::lossless;
+        if((compression.mode() == TileCompression::bounded) &&
+            quantize(tile, compression.tolerance(), result,
+                std::is_floating_point<T>()))
+        {
+          result.format = TileCompression::bounded;
+        } else if((compression.mode() == TileCompression::single) &&
+            std::is_same<T, double>::value)
+        {
+          round_to_float(tile, result);
+          result.format = TileCompression::single;
+        } else {
+          pack(tile.data(), tile.size(), result);
+        }
+
+        TileCompression::record_encode(tile.size() * sizeof(T),
+            result.data.size(), madness::wall_time() - start);
+        return result;
+      }
+
+      /// Decode a tile
+
+      /// \param packed The encoded tile
+      /// \return The tile
+      static tile_type decompress(const packed_type& packed) {
+        if(packed.format == 0)
+          return packed.tile;
+
+        const double start = madness::wall_time();
+        tile_type tile(packed.range);
+        switch(packed.format) {
+          case TileCompression::lossless:
+            unpack(packed, tile.size(), tile.data());
+            break;
+          case TileCompression::single:
+            widen_from_float(packed, tile);
+            break;
+          case TileCompression::bounded:
+            dequantize(packed, tile);
+            break;
+          default:
+            TA_EXCEPTION("Compressed tile data is corrupt.");
+        }
+
+        TileCompression::record_decode(madness::wall_time() - start);
+        return tile;
+      }
+    }; // struct TileCodec
+
+  } // namespace detail
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TILE_COMPRESSION_H__INCLUDED
@@ -32,6 +32,7 @@
 #include "../tile_interface/add.h"
 #include "../tile_interface/permute.h"
 #include <TiledArray/tensor/complex.h>
+#include <TiledArray/tensor/type_traits.h>
 
 namespace TiledArray {
   namespace detail {
@@ -61,9 +62,13 @@ namespace TiledArray {
             const madness::cblas::CBLAS_TRANSPOSE right_op,
             const scalar_type alpha, const unsigned int result_rank,
             const unsigned int left_rank, const unsigned int right_rank,
-            const Permutation& perm = Permutation()) :
+            const Permutation& perm = Permutation(),
+            const Permutation& left_perm = Permutation(),
+            const Permutation& right_perm = Permutation(),
+            const math::NestedProduct& nested_product = math::NestedProduct()) :
           gemm_helper_(left_op, right_op, result_rank, left_rank, right_rank),
-          alpha_(alpha), perm_(perm)
+          alpha_(alpha), perm_(perm), left_perm_(left_perm),
+          right_perm_(right_perm), nested_product_(nested_product)
         { }
 
         math::GemmHelper gemm_helper_; ///< Gemm helper object
@@ -71,6 +76,12 @@ namespace TiledArray {
             ///< the left- and right-hand arguments
         Permutation perm_; ///< Permutation that is applied to the final result
             ///< tensor
+        Permutation left_perm_; ///< Permutation that is applied to the
+            ///< left-hand argument tiles
+        Permutation right_perm_; ///< Permutation that is applied to the
+            ///< right-hand argument tiles
+        math::NestedProduct nested_product_; ///< The product of the inner
+            ///< tensors of tensor-of-tensor tiles
       };
 
       std::shared_ptr<Impl> pimpl_;
@@ -96,13 +107,22 @@ namespace TiledArray {
       /// \param right_rank The rank of the right-hand tensor
       /// \param perm The permutation to be applied to the result tensor
       /// (default = no permute)
+      /// \param left_perm The permutation to be applied to the left-hand
+      /// argument tiles (default = no permute)
+      /// \param right_perm The permutation to be applied to the right-hand
+      /// argument tiles (default = no permute)
+      /// \param nested_product The product of the inner tensors of
+      /// tensor-of-tensor tiles (default = Hadamard product)
       ContractReduceBase(const madness::cblas::CBLAS_TRANSPOSE left_op,
           const madness::cblas::CBLAS_TRANSPOSE right_op,
           const scalar_type alpha, const unsigned int result_rank,
           const unsigned int left_rank, const unsigned int right_rank,
-          const Permutation& perm = Permutation()) :
+          const Permutation& perm = Permutation(),
+          const Permutation& left_perm = Permutation(),
+          const Permutation& right_perm = Permutation(),
+          const math::NestedProduct& nested_product = math::NestedProduct()) :
         pimpl_(std::make_shared<Impl>(left_op, right_op, alpha, result_rank, left_rank,
-            right_rank, perm))
+            right_rank, perm, left_perm, right_perm, nested_product))
       { }
 
 
@@ -114,6 +134,17 @@ namespace TiledArray {
         return pimpl_->gemm_helper_;
       }
 
+      /// Select the multithreaded GEMM for the tile contractions
+
+      /// This must be called before the functor is copied to the evaluation
+      /// tasks.
+      /// \param parallel If \c true , the tile contractions may use
+      /// \c math::parallel_gemm with more than one thread
+      void parallel_gemm(const bool parallel) {
+        TA_ASSERT(pimpl_);
+        pimpl_->gemm_helper_.parallel(parallel);
+      }
+
       /// Permutation accessor
 
       /// \return A const reference to the permutation for this operation
@@ -122,6 +153,33 @@ namespace TiledArray {
         return pimpl_->perm_;
       }
 
+      /// Left-hand argument permutation accessor
+
+      /// \return A const reference to the permutation that is applied to the
+      /// left-hand argument tiles
+      const Permutation& left_perm() const {
+        TA_ASSERT(pimpl_);
+        return pimpl_->left_perm_;
+      }
+
+      /// Right-hand argument permutation accessor
+
+      /// \return A const reference to the permutation that is applied to the
+      /// right-hand argument tiles
+      const Permutation& right_perm() const {
+        TA_ASSERT(pimpl_);
+        return pimpl_->right_perm_;
+      }
+
+      /// Nested product accessor
+
+      /// \return A const reference to the product of the inner tensors of
+      /// tensor-of-tensor tiles
+      const math::NestedProduct& nested_product() const {
+        TA_ASSERT(pimpl_);
+        return pimpl_->nested_product_;
+      }
+
 
       /// Scaling factor accessor
 
@@ -167,6 +225,29 @@ namespace TiledArray {
 
     }; // class ContractReduceBase
 
+    /// Test if a contraction promotes the argument tiles to the result type
+
+    /// This is \c true when the result tile type differs from the type of the
+    /// contracted argument tiles, e.g. when single precision tiles are
+    /// contracted into double precision result tiles. Tensor-of-tensor tiles
+    /// are contracted by \c nested_gemm and are never promoted.
+    /// \tparam Result The result tile type
+    /// \tparam Left The left-hand tile type
+    /// \tparam Right The right-hand tile type
+    /// \tparam Scalar The scaling factor type
+    template <typename Result, typename Left, typename Right, typename Scalar,
+        bool = is_tensor_of_tensor<Left, Right>::value>
+    struct is_promoting_contraction :
+        public std::integral_constant<bool, ! std::is_same<Result,
+            decltype(gemm(std::declval<Left>(), std::declval<Right>(),
+            std::declval<Scalar>(), std::declval<math::GemmHelper>()))>::value>
+    { };
+
+    template <typename Result, typename Left, typename Right, typename Scalar>
+    struct is_promoting_contraction<Result, Left, Right, Scalar, true> :
+        public std::false_type
+    { };
+
     /// Contract and (sum) reduce operation
     
     /// This encodes a binary tensor contraction mapped to a GEMM, as well as the sum reduction and post-processing.
@@ -190,6 +271,73 @@ namespace TiledArray {
       typedef Result result_type; ///< The result tile type.
       typedef Scalar scalar_type;
 
+    private:
+
+      /// Tag for the contraction of tensor-of-tensor tiles
+      struct nested_tag { };
+
+      /// The contraction tag; tensor-of-tensor tiles are tagged with
+      /// \c nested_tag , and other tiles with \c std::true_type when the
+      /// contraction promotes the argument tiles to the result type.
+      typedef typename std::conditional<is_tensor_of_tensor<Left, Right>::value,
+          nested_tag, std::integral_constant<bool,
+          is_promoting_contraction<result_type, Left, Right,
+          scalar_type>::value> >::type contract_tag;
+
+      // Contract the argument tiles in their own type
+      void contract(result_type& result, first_argument_type left,
+          second_argument_type right, std::false_type) const
+      {
+        using TiledArray::empty;
+        using TiledArray::gemm;
+        using TiledArray::permute_gemm;
+        if(ContractReduceBase_::left_perm() || ContractReduceBase_::right_perm()) {
+          if(empty(result))
+            result = permute_gemm(left, right, ContractReduceBase_::factor(),
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+          else
+            permute_gemm(result, left, right, ContractReduceBase_::factor(),
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+        } else if(empty(result))
+          result = gemm(left, right, ContractReduceBase_::factor(),
+              ContractReduceBase_::gemm_helper());
+        else
+          gemm(result, left, right, ContractReduceBase_::factor(),
+              ContractReduceBase_::gemm_helper());
+      }
+
+      // Contract the argument tiles directly into the result type, so the
+      // products are accumulated in the precision of the result. An empty
+      // result tile is initialized by the accumulating contraction.
+      void contract(result_type& result, first_argument_type left,
+          second_argument_type right, std::true_type) const
+      {
+        using TiledArray::permute_gemm;
+        permute_gemm(result, left, right, ContractReduceBase_::factor(),
+            ContractReduceBase_::gemm_helper(),
+            ContractReduceBase_::left_perm(),
+            ContractReduceBase_::right_perm());
+      }
+
+      // Contract tensor-of-tensor tiles, where the inner tensors are
+      // multiplied as defined by the nested product. An empty result tile is
+      // initialized by the contraction.
+      void contract(result_type& result, first_argument_type left,
+          second_argument_type right, nested_tag) const
+      {
+        nested_gemm(result, left, right, ContractReduceBase_::factor(),
+            ContractReduceBase_::gemm_helper(),
+            ContractReduceBase_::nested_product(),
+            ContractReduceBase_::left_perm(),
+            ContractReduceBase_::right_perm());
+      }
+
+    public:
+
       // Compiler generated defaults are fine. N.B. this is shallow-copy.
       
       ContractReduce() = default;
@@ -209,13 +357,22 @@ namespace TiledArray {
       /// \param right_rank The rank of the right-hand tensor
       /// \param perm The permutation to be applied to the result tensor
       /// (default = no permute)
+      /// \param left_perm The permutation to be applied to the left-hand
+      /// argument tiles (default = no permute)
+      /// \param right_perm The permutation to be applied to the right-hand
+      /// argument tiles (default = no permute)
+      /// \param nested_product The product of the inner tensors of
+      /// tensor-of-tensor tiles (default = Hadamard product)
       ContractReduce(const madness::cblas::CBLAS_TRANSPOSE left_op,
           const madness::cblas::CBLAS_TRANSPOSE right_op,
           const scalar_type alpha, const unsigned int result_rank,
           const unsigned int left_rank, const unsigned int right_rank,
-          const Permutation& perm = Permutation()) :
+          const Permutation& perm = Permutation(),
+          const Permutation& left_perm = Permutation(),
+          const Permutation& right_perm = Permutation(),
+          const math::NestedProduct& nested_product = math::NestedProduct()) :
         ContractReduceBase_(left_op, right_op, alpha, result_rank, left_rank,
-            right_rank, perm)
+            right_rank, perm, left_perm, right_perm, nested_product)
       { }
 
 
@@ -259,14 +416,7 @@ namespace TiledArray {
       void operator()(result_type& result, first_argument_type left,
           second_argument_type right) const
       {
-        using TiledArray::empty;
-        using TiledArray::gemm;
-        if(empty(result))
-          result = gemm(left, right, ContractReduceBase_::factor(),
-              ContractReduceBase_::gemm_helper());
-        else
-          gemm(result, left, right, ContractReduceBase_::factor(),
-              ContractReduceBase_::gemm_helper());
+        contract(result, left, right, contract_tag());
       }
 
     }; // class ContractReduce
@@ -319,13 +469,22 @@ namespace TiledArray {
       /// \param right_rank The rank of the right-hand tensor
       /// \param perm The permutation to be applied to the result tensor
       /// (default = no permute)
+      /// \param left_perm The permutation to be applied to the left-hand
+      /// argument tiles (default = no permute)
+      /// \param right_perm The permutation to be applied to the right-hand
+      /// argument tiles (default = no permute)
+      /// \param nested_product The product of the inner tensors of
+      /// tensor-of-tensor tiles (default = Hadamard product)
       ContractReduce(const madness::cblas::CBLAS_TRANSPOSE left_op,
           const madness::cblas::CBLAS_TRANSPOSE right_op,
           const scalar_type alpha, const unsigned int result_rank,
           const unsigned int left_rank, const unsigned int right_rank,
-          const Permutation& perm = Permutation()) :
+          const Permutation& perm = Permutation(),
+          const Permutation& left_perm = Permutation(),
+          const Permutation& right_perm = Permutation(),
+          const math::NestedProduct& nested_product = math::NestedProduct()) :
         ContractReduceBase_(left_op, right_op, alpha, result_rank, left_rank,
-            right_rank, perm)
+            right_rank, perm, left_perm, right_perm, nested_product)
       { }
 
 
@@ -373,7 +532,19 @@ namespace TiledArray {
       {
         using TiledArray::empty;
         using TiledArray::gemm;
-        if(empty(result))
+        using TiledArray::permute_gemm;
+        if(ContractReduceBase_::left_perm() || ContractReduceBase_::right_perm()) {
+          if(empty(result))
+            result = permute_gemm(left, right, 1,
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+          else
+            permute_gemm(result, left, right, 1,
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+        } else if(empty(result))
           result = gemm(left, right, 1, ContractReduceBase_::gemm_helper());
         else
           gemm(result, left, right, 1, ContractReduceBase_::gemm_helper());
@@ -430,13 +601,22 @@ namespace TiledArray {
       /// \param right_rank The rank of the right-hand tensor
       /// \param perm The permutation to be applied to the result tensor
       /// (default = no permute)
+      /// \param left_perm The permutation to be applied to the left-hand
+      /// argument tiles (default = no permute)
+      /// \param right_perm The permutation to be applied to the right-hand
+      /// argument tiles (default = no permute)
+      /// \param nested_product The product of the inner tensors of
+      /// tensor-of-tensor tiles (default = Hadamard product)
       ContractReduce(const madness::cblas::CBLAS_TRANSPOSE left_op,
           const madness::cblas::CBLAS_TRANSPOSE right_op,
           const scalar_type alpha, const unsigned int result_rank,
           const unsigned int left_rank, const unsigned int right_rank,
-          const Permutation& perm = Permutation()) :
+          const Permutation& perm = Permutation(),
+          const Permutation& left_perm = Permutation(),
+          const Permutation& right_perm = Permutation(),
+          const math::NestedProduct& nested_product = math::NestedProduct()) :
         ContractReduceBase_(left_op, right_op, alpha, result_rank, left_rank,
-            right_rank, perm)
+            right_rank, perm, left_perm, right_perm, nested_product)
       { }
 
 
@@ -485,7 +665,19 @@ namespace TiledArray {
       {
         using TiledArray::empty;
         using TiledArray::gemm;
-        if(empty(result))
+        using TiledArray::permute_gemm;
+        if(ContractReduceBase_::left_perm() || ContractReduceBase_::right_perm()) {
+          if(empty(result))
+            result = permute_gemm(left, right, 1,
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+          else
+            permute_gemm(result, left, right, 1,
+                ContractReduceBase_::gemm_helper(),
+                ContractReduceBase_::left_perm(),
+                ContractReduceBase_::right_perm());
+        } else if(empty(result))
           result = gemm(left, right, 1, ContractReduceBase_::gemm_helper());
         else
           gemm(result, left, right, 1, ContractReduceBase_::gemm_helper());
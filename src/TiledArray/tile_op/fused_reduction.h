@@ -0,0 +1,466 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  fused_reduction.h
+ *  Aug 9, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TILE_OP_FUSED_REDUCTION_H__INCLUDED
+#define TILEDARRAY_TILE_OP_FUSED_REDUCTION_H__INCLUDED
+
+#include <TiledArray/error.h>
+#include <TiledArray/reduce_task.h>
+#include <TiledArray/tensor/kernels.h>
+#include <TiledArray/tile_op/unary_reduction.h>
+#include <TiledArray/type_traits.h>
+#include <TiledArray/zero_tensor.h>
+
+namespace TiledArray {
+  namespace detail {
+
+    // Forward declaration
+    template <typename, typename> class LazyArrayTile;
+
+    /// Element-wise kernel of a tile reduction
+
+    /// Specializations of this class reduce a single element of a tile in the
+    /// same way that the tile reduction \c Op reduces a whole tile, so that the
+    /// reduction may be fused into the loop that computes the elements.
+    /// Reductions that are not element-wise, e.g. \c TraceReduction , use the
+    /// primary template where \c fusable is \c false .
+    /// \tparam Op The tile reduction type
+    template <typename Op>
+    struct ElementReduction {
+      static constexpr bool fusable = false;
+    }; // struct ElementReduction
+
+    template <typename Tile>
+    struct ElementReduction<SumReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result += arg;
+      }
+    }; // struct ElementReduction<SumReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<ProductReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result *= arg;
+      }
+    }; // struct ElementReduction<ProductReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<SquaredNormReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result += TiledArray::detail::norm(arg);
+      }
+    }; // struct ElementReduction<SquaredNormReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<MinReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result = std::min<Result>(result, arg);
+      }
+    }; // struct ElementReduction<MinReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<MaxReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result = std::max<Result>(result, arg);
+      }
+    }; // struct ElementReduction<MaxReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<AbsMinReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result = std::min<Result>(result, std::abs(arg));
+      }
+    }; // struct ElementReduction<AbsMinReduction<Tile> >
+
+    template <typename Tile>
+    struct ElementReduction<AbsMaxReduction<Tile> > {
+      static constexpr bool fusable = true;
+
+      template <typename Result, typename Numeric>
+      void operator()(Result& MADNESS_RESTRICT result, const Numeric arg) const {
+        result = std::max<Result>(result, std::abs(arg));
+      }
+    }; // struct ElementReduction<AbsMaxReduction<Tile> >
+
+
+    /// Element-wise scaling operation
+
+    /// \tparam Scalar The scaling factor type
+    template <typename Scalar>
+    struct ElementScal {
+      Scalar factor; ///< The scaling factor
+
+      template <typename T>
+      auto operator()(const T arg) const { return arg * factor; }
+    }; // struct ElementScal
+
+    /// Element-wise addition operation
+    struct ElementAdd {
+      template <typename L, typename R>
+      auto operator()(const L left, const R right) const { return left + right; }
+    }; // struct ElementAdd
+
+    /// Element-wise scaled addition operation
+
+    /// \tparam Scalar The scaling factor type
+    template <typename Scalar>
+    struct ElementScalAdd {
+      Scalar factor; ///< The scaling factor
+
+      template <typename L, typename R>
+      auto operator()(const L left, const R right) const {
+        return (left + right) * factor;
+      }
+    }; // struct ElementScalAdd
+
+    /// Element-wise subtraction operation
+    struct ElementSubt {
+      template <typename L, typename R>
+      auto operator()(const L left, const R right) const { return left - right; }
+    }; // struct ElementSubt
+
+    /// Element-wise scaled subtraction operation
+
+    /// \tparam Scalar The scaling factor type
+    template <typename Scalar>
+    struct ElementScalSubt {
+      Scalar factor; ///< The scaling factor
+
+      template <typename L, typename R>
+      auto operator()(const L left, const R right) const {
+        return (left - right) * factor;
+      }
+    }; // struct ElementScalSubt
+
+
+    /// Reduction of partial results
+
+    /// This reduction operation joins the partial results of a tile
+    /// reduction, which have been computed by other tasks, with the join and
+    /// post-processing functions of \c Op . It is used with \c ReduceTask .
+    /// \tparam Op The tile reduction type
+    template <typename Op>
+    class PartialReduction : public Op {
+    public:
+      typedef typename Op::result_type result_type; ///< The reduction result type
+      typedef result_type argument_type; ///< The reduction argument type
+
+      PartialReduction(const Op& op) : Op(op) { }
+
+      // Import base class functionality; the join function of Op is also used
+      // to reduce arguments.
+      using Op::operator();
+
+    }; // class PartialReduction
+
+    /// Fused reduction of a unary element-wise tile operation
+
+    /// This object reduces the result of an element-wise unary tile operation
+    /// with the tile reduction \c Op , without storing the result tile. Both
+    /// operations are applied to each element in a single loop over the
+    /// argument tile. Lazy array tiles are reduced without evaluating them,
+    /// so \c ElementOp must include their tile operation. A permutation of
+    /// the tile is ignored, since it does not change the reduction.
+    /// \tparam Op The tile reduction type
+    /// \tparam ElementOp The element-wise operation type
+    template <typename Op, typename ElementOp>
+    class FusedUnaryReduction {
+    public:
+      typedef FusedUnaryReduction<Op, ElementOp> FusedUnaryReduction_; ///< This class type
+      typedef typename Op::result_type result_type; ///< The reduction result type
+
+    private:
+
+      Op op_; ///< The tile reduction
+      ElementOp element_op_; ///< The element-wise operation
+
+      template <typename Arg>
+      result_type reduce(const Arg& arg) const {
+        const ElementReduction<Op> element_reduce;
+        const ElementOp& element_op = element_op_;
+        auto reduce_op = [&element_reduce, &element_op] (
+            result_type& MADNESS_RESTRICT result, const numeric_t<Arg> value)
+            { element_reduce(result, element_op(value)); };
+        auto join_op = [this] (result_type& MADNESS_RESTRICT result,
+            const result_type value)
+            { op_(result, value); };
+        return tensor_reduce(reduce_op, join_op, op_(), arg);
+      }
+
+    public:
+
+      /// Constructor
+
+      /// \param op The tile reduction
+      /// \param element_op The element-wise operation
+      FusedUnaryReduction(const Op& op, const ElementOp& element_op) :
+        op_(op), element_op_(element_op)
+      { }
+
+      /// Reduce a lazy array tile
+
+      /// \tparam Tile The array tile type
+      /// \tparam LazyOp The tile operation of the lazy tile
+      /// \param arg The lazy array tile
+      /// \return The reduction of the operation applied to the input tile
+      template <typename Tile, typename LazyOp>
+      result_type operator()(const LazyArrayTile<Tile, LazyOp>& arg) const {
+        return reduce(arg.tile());
+      }
+
+      /// Reduce a tile
+
+      /// \tparam Arg The argument tile type
+      /// \param arg The argument tile
+      /// \return The reduction of the operation applied to \c arg
+      template <typename Arg,
+          typename std::enable_if<! is_lazy_tile<Arg>::value>::type* = nullptr>
+      result_type operator()(const Arg& arg) const {
+        return reduce(arg);
+      }
+
+    }; // class FusedUnaryReduction
+
+    /// Fused reduction of a binary element-wise tile operation
+
+    /// This object reduces the result of an element-wise binary tile operation
+    /// with the tile reduction \c Op , without storing the result tile. Both
+    /// operations are applied to each pair of elements in a single loop over
+    /// the argument tiles. A zero argument tile is treated as a tile of zeros.
+    /// \tparam Op The tile reduction type
+    /// \tparam ElementOp The element-wise operation type
+    template <typename Op, typename ElementOp>
+    class FusedBinaryReduction {
+    public:
+      typedef FusedBinaryReduction<Op, ElementOp> FusedBinaryReduction_; ///< This class type
+      typedef typename Op::result_type result_type; ///< The reduction result type
+
+    private:
+
+      Op op_; ///< The tile reduction
+      ElementOp element_op_; ///< The element-wise operation
+
+      template <typename T,
+          typename std::enable_if<is_lazy_tile<T>::value>::type* = nullptr>
+      static typename eval_trait<T>::type eval_arg(const T& arg) {
+        return typename eval_trait<T>::type(arg);
+      }
+
+      template <typename T,
+          typename std::enable_if<! is_lazy_tile<T>::value>::type* = nullptr>
+      static const T& eval_arg(const T& arg) { return arg; }
+
+      template <typename ReduceOp, typename... Args>
+      result_type reduce(ReduceOp& reduce_op, const Args&... args) const {
+        auto join_op = [this] (result_type& MADNESS_RESTRICT result,
+            const result_type value)
+            { op_(result, value); };
+        return tensor_reduce(reduce_op, join_op, op_(), args...);
+      }
+
+      template <typename L, typename R>
+      result_type eval(const L& left, const R& right) const {
+        const ElementReduction<Op> element_reduce;
+        const ElementOp& element_op = element_op_;
+        auto reduce_op = [&element_reduce, &element_op] (
+            result_type& MADNESS_RESTRICT result, const numeric_t<L> l,
+            const numeric_t<R> r)
+            { element_reduce(result, element_op(l, r)); };
+        return reduce(reduce_op, left, right);
+      }
+
+      template <typename R>
+      result_type eval(ZeroTensor, const R& right) const {
+        const ElementReduction<Op> element_reduce;
+        const ElementOp& element_op = element_op_;
+        auto reduce_op = [&element_reduce, &element_op] (
+            result_type& MADNESS_RESTRICT result, const numeric_t<R> r)
+            { element_reduce(result, element_op(numeric_t<R>(0), r)); };
+        return reduce(reduce_op, right);
+      }
+
+      template <typename L>
+      result_type eval(const L& left, ZeroTensor) const {
+        const ElementReduction<Op> element_reduce;
+        const ElementOp& element_op = element_op_;
+        auto reduce_op = [&element_reduce, &element_op] (
+            result_type& MADNESS_RESTRICT result, const numeric_t<L> l)
+            { element_reduce(result, element_op(l, numeric_t<L>(0))); };
+        return reduce(reduce_op, left);
+      }
+
+    public:
+
+      /// Constructor
+
+      /// \param op The tile reduction
+      /// \param element_op The element-wise operation
+      FusedBinaryReduction(const Op& op, const ElementOp& element_op) :
+        op_(op), element_op_(element_op)
+      { }
+
+      /// Reduce a pair of tiles
+
+      /// \tparam L The left-hand tile type
+      /// \tparam R The right-hand tile type
+      /// \param left The left-hand tile or \c ZeroTensor
+      /// \param right The right-hand tile or \c ZeroTensor
+      /// \return The reduction of the operation applied to \c left and
+      /// \c right
+      template <typename L, typename R>
+      result_type operator()(const L& left, const R& right) const {
+        return eval(eval_arg(left), eval_arg(right));
+      }
+
+    }; // class FusedBinaryReduction
+
+
+    /// Reduce the local tiles of a unary element-wise expression
+
+    /// A task is submitted for each local, non-zero tile of \c arg , which
+    /// reduces the result of the expression for that tile with \c kernel .
+    /// Argument tiles that are zero in \c shape are discarded. This function
+    /// blocks until the local tiles of \c arg have been evaluated.
+    /// \tparam Op The tile reduction type
+    /// \tparam Kernel The fused tile reduction type
+    /// \tparam Arg The argument distributed evaluator type
+    /// \tparam Shape The result shape type
+    /// \param op The tile reduction
+    /// \param kernel The fused tile reduction
+    /// \param arg The argument distributed evaluator
+    /// \param shape The shape of the expression result
+    /// \return The reduction of the local tiles
+    template <typename Op, typename Kernel, typename Arg, typename Shape>
+    Future<typename Op::result_type>
+    fused_reduce(const Op& op, const Kernel& kernel, Arg arg, const Shape& shape) {
+      typedef typename Arg::value_type arg_value_type;
+
+      World& world = arg.world();
+      ReduceTask<PartialReduction<Op> > reduce_task(world, PartialReduction<Op>(op));
+
+      arg.eval();
+
+      for(auto it = arg.pmap()->begin(); it != arg.pmap()->end(); ++it) {
+        const auto index = *it;
+        if(arg.is_zero(index))
+          continue;
+
+        if(shape.is_zero(index)) {
+          arg.discard(index);
+          continue;
+        }
+
+        reduce_task.add(world.taskq.add([kernel] (const arg_value_type& tile)
+            { return kernel(tile); }, arg.get(index)));
+      }
+
+      Future<typename Op::result_type> result = reduce_task.submit();
+      arg.wait();
+      return result;
+    }
+
+    /// Reduce the local tiles of a binary element-wise expression
+
+    /// A task is submitted for each local tile that is non-zero in \c shape ,
+    /// which reduces the result of the expression for that tile with
+    /// \c kernel . Argument tiles of zero result tiles are discarded. This
+    /// function blocks until the local tiles of the arguments have been
+    /// evaluated.
+    /// \tparam Op The tile reduction type
+    /// \tparam Kernel The fused tile reduction type
+    /// \tparam Left The left-hand distributed evaluator type
+    /// \tparam Right The right-hand distributed evaluator type
+    /// \tparam Shape The result shape type
+    /// \param op The tile reduction
+    /// \param kernel The fused tile reduction
+    /// \param left The left-hand distributed evaluator
+    /// \param right The right-hand distributed evaluator
+    /// \param shape The shape of the expression result
+    /// \return The reduction of the local tiles
+    template <typename Op, typename Kernel, typename Left, typename Right,
+        typename Shape>
+    Future<typename Op::result_type>
+    fused_reduce(const Op& op, const Kernel& kernel, Left left, Right right,
+        const Shape& shape)
+    {
+      typedef typename Left::value_type left_value_type;
+      typedef typename Right::value_type right_value_type;
+
+      World& world = left.world();
+      ReduceTask<PartialReduction<Op> > reduce_task(world, PartialReduction<Op>(op));
+
+      left.eval();
+      right.eval();
+
+      TA_ASSERT(left.pmap() == right.pmap());
+      for(auto it = left.pmap()->begin(); it != left.pmap()->end(); ++it) {
+        const auto index = *it;
+        const bool left_zero = left.is_zero(index);
+        const bool right_zero = right.is_zero(index);
+
+        if(shape.is_zero(index) || (left_zero && right_zero)) {
+          if(! left_zero) left.discard(index);
+          if(! right_zero) right.discard(index);
+          continue;
+        }
+
+        if(left_zero) {
+          reduce_task.add(world.taskq.add([kernel] (const right_value_type& r)
+              { return kernel(ZeroTensor(), r); }, right.get(index)));
+        } else if(right_zero) {
+          reduce_task.add(world.taskq.add([kernel] (const left_value_type& l)
+              { return kernel(l, ZeroTensor()); }, left.get(index)));
+        } else {
+          reduce_task.add(world.taskq.add([kernel] (const left_value_type& l,
+              const right_value_type& r) { return kernel(l, r); },
+              left.get(index), right.get(index)));
+        }
+      }
+
+      Future<typename Op::result_type> result = reduce_task.submit();
+      left.wait();
+      right.wait();
+      return result;
+    }
+
+  } // namespace detail
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TILE_OP_FUSED_REDUCTION_H__INCLUDED
@@ -0,0 +1,158 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  nested_mult.h
+ *  Jul 16, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TILE_OP_NESTED_MULT_H__INCLUDED
+#define TILEDARRAY_TILE_OP_NESTED_MULT_H__INCLUDED
+
+#include <TiledArray/error.h>
+#include <TiledArray/math/gemm_helper.h>
+#include <TiledArray/tile_op/tile_interface.h>
+#include <TiledArray/zero_tensor.h>
+
+namespace TiledArray {
+  namespace detail {
+
+    /// Tile multiplication operation for tensors of tensors
+
+    /// This operation multiplies the outer dimensions of two tensor-of-tensor
+    /// tiles coefficient-wise, and the inner tensors of each pair of elements
+    /// as defined by a \c math::NestedProduct , e.g.
+    /// \code c("i,j;a,b") = a("i,j;a,c") * b("i,j;c,b") \endcode . The
+    /// argument tiles are never consumed since the inner tensors of the
+    /// result generally differ in size from those of the arguments.
+    /// \tparam Result The result tile type
+    /// \tparam Left The left-hand argument type
+    /// \tparam Right The right-hand argument type
+    /// \tparam Scalar The scaling factor type
+    template <typename Result, typename Left, typename Right, typename Scalar>
+    class NestedMult {
+    public:
+
+      typedef NestedMult<Result, Left, Right, Scalar> NestedMult_; ///< This class type
+      typedef Left left_type; ///< Left-hand argument base type
+      typedef Right right_type; ///< Right-hand argument base type
+      typedef Scalar scalar_type; ///< Scaling factor type
+      typedef Result result_type; ///< Result tile type
+
+      /// The left tile is never consumed
+      static constexpr bool left_is_consumable = false;
+      /// The right tile is never consumed
+      static constexpr bool right_is_consumable = false;
+
+    private:
+
+      math::NestedProduct nested_; ///< The product of the inner tensors
+      scalar_type factor_; ///< The scaling factor
+
+      result_type eval(const left_type& first, const right_type& second) const {
+        return nested_mult(first, second, factor_, nested_);
+      }
+
+      result_type eval(ZeroTensor, const right_type&) const {
+        TA_ASSERT(false); // Invalid arguments for this operation
+        return result_type();
+      }
+
+      result_type eval(const left_type&, ZeroTensor) const {
+        TA_ASSERT(false); // Invalid arguments for this operation
+        return result_type();
+      }
+
+    public:
+
+      // Compiler generated functions
+      NestedMult(const NestedMult_&) = default;
+      NestedMult(NestedMult_&&) = default;
+      ~NestedMult() = default;
+      NestedMult_& operator=(const NestedMult_&) = default;
+      NestedMult_& operator=(NestedMult_&&) = default;
+
+      /// Constructor
+
+      /// \param nested The product of the inner tensors
+      /// \param factor The scaling factor applied to result tiles
+      explicit NestedMult(const math::NestedProduct& nested,
+          const Scalar factor = Scalar(1)) :
+        nested_(nested), factor_(factor)
+      { }
+
+      /// Multiply-and-permute operator
+
+      /// Compute the product of two tiles and permute the result.
+      /// \tparam L The left-hand tile argument type
+      /// \tparam R The right-hand tile argument type
+      /// \param left The left-hand tile argument
+      /// \param right The right-hand tile argument
+      /// \param perm The permutation applied to the result tile
+      /// \return The permuted and scaled product of `left` and `right`.
+      template <typename L, typename R>
+      result_type
+      operator()(L&& left, R&& right, const Permutation& perm) const {
+        using TiledArray::permute;
+        return permute(eval(std::forward<L>(left), std::forward<R>(right)), perm);
+      }
+
+      /// Multiply operator
+
+      /// Compute the product of two tiles.
+      /// \tparam L The left-hand tile argument type
+      /// \tparam R The right-hand tile argument type
+      /// \param left The left-hand tile argument
+      /// \param right The right-hand tile argument
+      /// \return The scaled product of `left` and `right`.
+      template <typename L, typename R>
+      result_type operator()(L&& left, R&& right) const {
+        return eval(std::forward<L>(left), std::forward<R>(right));
+      }
+
+      /// Multiply right to left
+
+      /// The left-hand tile is not modified, since the result is stored in a
+      /// new tile.
+      /// \tparam R The right-hand tile argument type
+      /// \param left The left-hand tile argument
+      /// \param right The right-hand tile argument
+      /// \return The product of `left` and `right`.
+      template <typename R>
+      result_type consume_left(left_type& left, R&& right) const {
+        return eval(left, std::forward<R>(right));
+      }
+
+      /// Multiply left to right
+
+      /// The right-hand tile is not modified, since the result is stored in a
+      /// new tile.
+      /// \tparam L The left-hand tile argument type
+      /// \param left The left-hand tile argument
+      /// \param right The right-hand tile argument
+      /// \return The product of `left` and `right`.
+      template <typename L>
+      result_type consume_right(L&& left, right_type& right) const {
+        return eval(std::forward<L>(left), right);
+      }
+
+    }; // class NestedMult
+
+  } // namespace detail
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TILE_OP_NESTED_MULT_H__INCLUDED
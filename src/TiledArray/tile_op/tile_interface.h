@@ -26,6 +26,7 @@
 #ifndef TILEDARRAY_NONINTRUSIVE_API_TENSOR_H__INCLUDED
 #define TILEDARRAY_NONINTRUSIVE_API_TENSOR_H__INCLUDED
 
+#include <TiledArray/permutation.h>
 #include <TiledArray/type_traits.h>
 #include <vector>
 
@@ -650,6 +651,84 @@ namespace TiledArray {
     return result.gemm(left, right, factor, gemm_config);
   }
 
+  /// Contract and scale permuted tile arguments
+
+  /// The contraction is done via a GEMM operation with fused indices, as
+  /// defined by \c gemm_config , of the permuted arguments. This
+  /// implementation permutes the arguments before they are contracted. Tile
+  /// types may provide an overload that avoids the permuted copies (see
+  /// \c Tensor ).
+  /// \tparam Left The left-hand tile type
+  /// \tparam Right The right-hand tile type
+  /// \tparam Scalar A scalar type
+  /// \param left The left-hand argument to be contracted
+  /// \param right The right-hand argument to be contracted
+  /// \param factor The scaling factor
+  /// \param gemm_config A helper object used to simplify gemm operations
+  /// \param left_perm The permutation applied to \c left , or an empty
+  /// permutation
+  /// \param right_perm The permutation applied to \c right , or an empty
+  /// permutation
+  /// \return A tile that is equal to
+  /// <tt>((left_perm ^ left) * (right_perm ^ right)) * factor</tt>
+  template <typename Left, typename Right, typename Scalar,
+      typename std::enable_if<TiledArray::detail::is_numeric<Scalar>::value>::type* = nullptr>
+  inline auto permute_gemm(const Left& left, const Right& right,
+      const Scalar factor, const math::GemmHelper& gemm_config,
+      const Permutation& left_perm, const Permutation& right_perm)
+      -> decltype(gemm(left, right, factor, gemm_config))
+  {
+    if(left_perm) {
+      if(right_perm)
+        return gemm(permute(left, left_perm), permute(right, right_perm),
+            factor, gemm_config);
+      return gemm(permute(left, left_perm), right, factor, gemm_config);
+    }
+    if(right_perm)
+      return gemm(left, permute(right, right_perm), factor, gemm_config);
+    return gemm(left, right, factor, gemm_config);
+  }
+
+  /// Contract and scale permuted tile arguments to the result tile
+
+  /// The contraction is done via a GEMM operation with fused indices, as
+  /// defined by \c gemm_config , of the permuted arguments. This
+  /// implementation permutes the arguments before they are contracted. Tile
+  /// types may provide an overload that avoids the permuted copies (see
+  /// \c Tensor ).
+  /// \tparam Result The result tile type
+  /// \tparam Left The left-hand tile type
+  /// \tparam Right The right-hand tile type
+  /// \tparam Scalar A scalar type
+  /// \param result The contracted result
+  /// \param left The left-hand argument to be contracted
+  /// \param right The right-hand argument to be contracted
+  /// \param factor The scaling factor
+  /// \param gemm_config A helper object used to simplify gemm operations
+  /// \param left_perm The permutation applied to \c left , or an empty
+  /// permutation
+  /// \param right_perm The permutation applied to \c right , or an empty
+  /// permutation
+  /// \return A tile that is equal to
+  /// <tt>result += ((left_perm ^ left) * (right_perm ^ right)) * factor</tt>
+  template <typename Result, typename Left, typename Right, typename Scalar,
+      typename std::enable_if<TiledArray::detail::is_numeric<Scalar>::value>::type* = nullptr>
+  inline Result& permute_gemm(Result& result, const Left& left,
+      const Right& right, const Scalar factor,
+      const math::GemmHelper& gemm_config, const Permutation& left_perm,
+      const Permutation& right_perm)
+  {
+    if(left_perm) {
+      if(right_perm)
+        return gemm(result, permute(left, left_perm),
+            permute(right, right_perm), factor, gemm_config);
+      return gemm(result, permute(left, left_perm), right, factor, gemm_config);
+    }
+    if(right_perm)
+      return gemm(result, left, permute(right, right_perm), factor, gemm_config);
+    return gemm(result, left, right, factor, gemm_config);
+  }
+
 
   template <typename... T>
   using result_of_gemm_t = decltype(gemm(std::declval<T>()...));
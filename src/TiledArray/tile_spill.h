@@ -0,0 +1,550 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_spill.h
+ *  Jun 25, 2018
+ *
+ */
+
+#ifndef TILEDARRAY_TILE_SPILL_H__INCLUDED
+#define TILEDARRAY_TILE_SPILL_H__INCLUDED
+
+#include <TiledArray/madness.h>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace TiledArray {
+
+  class TileSpill;
+
+  namespace detail {
+
+    /// Interface of containers whose tiles can be spilled to disk
+    class SpillTarget {
+      friend class ::TiledArray::TileSpill;
+
+      std::size_t spilling_; ///< The number of tiles that \c TileSpill is spilling from this container
+
+    public:
+      SpillTarget() : spilling_(0ul) { }
+
+      virtual ~SpillTarget() { }
+
+      /// Move a local tile to disk
+
+      /// \param i The ordinal index of the tile
+      /// \return \c false if the tile must stay in memory, e.g. because it
+      /// is shared with other objects, otherwise \c true
+      virtual bool spill(const std::size_t i) = 0;
+    }; // class SpillTarget
+
+    /// Tile sharing query
+
+    /// This overload is used for tiles that report sharing, e.g. \c Tensor .
+    /// \tparam T The tile type
+    /// \param tile The tile
+    /// \return \c true if the data of \c tile is shared with other tiles
+    template <typename T>
+    inline auto is_shared_tile(const T& tile, int) -> decltype(tile.is_shared()) {
+      return tile.is_shared();
+    }
+
+    /// Tile sharing query
+
+    /// This overload is used for all other tile types, which are assumed not
+    /// to be shared.
+    /// \tparam T The tile type
+    /// \return \c false
+    template <typename T>
+    inline bool is_shared_tile(const T&, long) { return false; }
+
+    /// Disk file that holds the spilled tiles of one container
+
+    /// Tiles are stored as MADNESS archives. The file is unlinked as soon as
+    /// it is created, so it is removed by the operating system when it is
+    /// closed, even if the process is killed. A tile is written only if its
+    /// serialized data differs from the copy that is already in the file, so
+    /// tiles that were read back and not modified are not written again.
+    class SpillFile : private madness::Spinlock {
+    public:
+      typedef std::size_t size_type; ///< Size type
+
+    private:
+
+      /// The location of a tile in the file
+      struct Record {
+        size_type offset; ///< The offset of the tile data
+        size_type capacity; ///< The space reserved for the tile
+        size_type size; ///< The size of the tile data
+        std::uint64_t hash; ///< The hash of the tile data
+      }; // struct Record
+
+      int fd_; ///< The file descriptor
+      size_type end_; ///< The end of the used part of the file
+      std::unordered_map<size_type, Record> records_; ///< The stored tiles
+
+      // not allowed
+      SpillFile(const SpillFile&);
+      SpillFile& operator=(const SpillFile&);
+
+    public:
+
+      /// Create a spill file
+
+      /// \param path The path of the file
+      /// \throw TiledArray::Exception When the file cannot be created
+      explicit SpillFile(const std::string& path) :
+        madness::Spinlock(), fd_(-1), end_(0ul), records_()
+      {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if(fd_ < 0)
+          TA_EXCEPTION("Unable to create tile spill file");
+        ::unlink(path.c_str());
+      }
+
+      ~SpillFile() { ::close(fd_); }
+
+      /// Hash of serialized tile data
+
+      /// \param data The data
+      /// \param size The size of \c data in bytes
+      /// \return A 64-bit hash of \c data
+      static std::uint64_t hash(const unsigned char* data, const size_type size) {
+        std::uint64_t h = 0xcbf29ce484222325ul ^ size;
+        size_type i = 0ul;
+        for(; i + 8ul <= size; i += 8ul) {
+          std::uint64_t word;
+          std::memcpy(&word, data + i, 8ul);
+          h = (h ^ word) * 0x100000001b3ul;
+          h ^= h >> 29;
+        }
+        for(; i < size; ++i)
+          h = (h ^ data[i]) * 0x100000001b3ul;
+        return h;
+      }
+
+      /// Tile query
+
+      /// \param i The ordinal index of the tile
+      /// \return \c true if tile \c i is stored in the file
+      bool contains(const size_type i) const {
+        madness::ScopedMutex<madness::Spinlock> locker(this);
+        return records_.find(i) != records_.end();
+      }
+
+      /// Store a tile
+
+      /// \param i The ordinal index of the tile
+      /// \param buffer The serialized tile
+      /// \return The number of bytes written, which is zero when the file
+      /// already holds the same data
+      /// \throw TiledArray::Exception When the data cannot be written
+      size_type write(const size_type i, const std::vector<unsigned char>& buffer) {
+        const std::uint64_t h = hash(buffer.data(), buffer.size());
+        size_type offset = 0ul;
+        {
+          madness::ScopedMutex<madness::Spinlock> locker(this);
+          auto it = records_.find(i);
+          if(it != records_.end()) {
+            if((it->second.size == buffer.size()) && (it->second.hash == h))
+              return 0ul;
+            if(it->second.capacity < buffer.size()) {
+              it->second.offset = end_;
+              it->second.capacity = buffer.size();
+              end_ += buffer.size();
+            }
+            it->second.size = buffer.size();
+            it->second.hash = h;
+            offset = it->second.offset;
+          } else {
+            records_.emplace(i, Record{ end_, buffer.size(), buffer.size(), h });
+            offset = end_;
+            end_ += buffer.size();
+          }
+        }
+
+        size_type done = 0ul;
+        while(done < buffer.size()) {
+          const ssize_t n = ::pwrite(fd_, buffer.data() + done,
+              buffer.size() - done, offset + done);
+          if(n <= 0)
+            TA_EXCEPTION("Unable to write tile spill file");
+          done += n;
+        }
+
+        return buffer.size();
+      }
+
+      /// Load a tile
+
+      /// \param i The ordinal index of the tile
+      /// \param[out] buffer The serialized tile
+      /// \throw TiledArray::Exception When the data cannot be read
+      void read(const size_type i, std::vector<unsigned char>& buffer) const {
+        Record record;
+        {
+          madness::ScopedMutex<madness::Spinlock> locker(this);
+          auto it = records_.find(i);
+          TA_ASSERT(it != records_.end());
+          record = it->second;
+        }
+
+        buffer.resize(record.size);
+        size_type done = 0ul;
+        while(done < record.size) {
+          const ssize_t n = ::pread(fd_, buffer.data() + done,
+              record.size - done, record.offset + done);
+          if(n <= 0)
+            TA_EXCEPTION("Unable to read tile spill file");
+          done += n;
+        }
+      }
+
+    }; // class SpillFile
+
+  } // namespace detail
+
+  /// Per-process out-of-core tile manager
+
+  /// When enabled, local tiles of distributed arrays are kept in a resident
+  /// set of limited size. Tiles that have not been accessed recently are
+  /// written to a spill file in a local directory and removed from memory.
+  /// They are read back, by a task, when they are accessed again, or when
+  /// \c detail::DistributedStorage::prefetch is called, e.g. by \c Summa for
+  /// the next iteration. Modified tiles are written back when they are
+  /// evicted again; tiles that were not modified are dropped without I/O.
+  ///
+  /// Spilling is disabled by default. It is enabled for arrays that are
+  /// constructed after a non-zero resident set size is set on each process:
+  /// \code
+  /// TiledArray::TileSpill::instance().directory("/local/scratch");
+  /// TiledArray::TileSpill::instance().max_bytes(16ul << 30); // 16 GiB
+  /// \endcode
+  /// Tiles that are shared with other objects, e.g. arguments of tasks that
+  /// are still running, are not evicted, since evicting them would not
+  /// release their memory and reading them back would duplicate them. They
+  /// stay in the resident set, and are counted by \c unspillable_count() ,
+  /// so the resident set may exceed the limit only by shared tiles.
+  /// \note Tile size is estimated in the same way as for \c TileCache .
+  class TileSpill : private madness::Spinlock {
+  public:
+    typedef std::size_t size_type; ///< Size type
+
+  private:
+
+    /// Resident tile key: world id, object id, and tile ordinal
+    typedef std::tuple<unsigned long, unsigned long, size_type> key_type;
+
+    /// Resident tile data
+    struct Entry {
+      key_type key; ///< The key of the tile
+      detail::SpillTarget* target; ///< The container that owns the tile
+      size_type bytes; ///< The size of the tile
+    }; // struct Entry
+
+    typedef std::list<Entry> list_type;
+
+    list_type entries_; ///< Resident tiles, ordered from most to least recently used
+    std::map<key_type, list_type::iterator> index_; ///< Index of the resident tiles
+    size_type max_bytes_; ///< The maximum size of the resident tiles
+    size_type bytes_; ///< The size of the resident tiles
+    std::string directory_; ///< The directory of the spill files
+    size_type spill_count_; ///< The number of tiles that were evicted
+    size_type spill_bytes_; ///< The number of bytes written
+    double spill_time_; ///< The time spent writing tiles
+    size_type fill_count_; ///< The number of tiles that were read back
+    size_type fill_bytes_; ///< The number of bytes read
+    double fill_time_; ///< The time spent reading tiles
+    size_type unspillable_count_; ///< The number of evictions that were refused
+
+    // not allowed
+    TileSpill(const TileSpill&);
+    TileSpill& operator=(const TileSpill&);
+
+    static key_type make_key(const madness::uniqueidT& id, const size_type i) {
+      return key_type(id.get_world_id(), id.get_obj_id(), i);
+    }
+
+    /// Select least-recently used tiles until the resident set is within its size
+
+    /// The most recently used tile is never selected, and nothing is
+    /// selected when spilling is disabled. The selected tiles are counted as
+    /// in flight by their containers, which keeps the containers alive (see
+    /// \c erase() ) until \c spill() is done with them.
+    /// \note The manager must be locked by the caller
+    /// \param[out] victims The tiles that must be spilled
+    void select_victims(std::vector<Entry>& victims) {
+      if(max_bytes_ == 0ul)
+        return;
+      while((bytes_ > max_bytes_) && (entries_.size() > 1ul)) {
+        Entry& victim = entries_.back();
+        bytes_ -= victim.bytes;
+        ++victim.target->spilling_;
+        index_.erase(victim.key);
+        victims.push_back(victim);
+        entries_.pop_back();
+      }
+    }
+
+    /// Spill tiles
+
+    /// Tiles that cannot be spilled are returned to the resident set as the
+    /// most recently used tiles, since they are still in use.
+    /// \param victims The tiles that will be spilled
+    /// \return The number of tiles that were returned to the resident set
+    size_type spill(const std::vector<Entry>& victims) {
+      size_type refused = 0ul;
+      for(const Entry& victim : victims) {
+        const bool spilled = victim.target->spill(std::get<2>(victim.key));
+
+        madness::ScopedMutex<madness::Spinlock> locker(this);
+        if(! spilled) {
+          ++unspillable_count_;
+          ++refused;
+          // The tile may have been used again while it was being spilled
+          if(index_.find(victim.key) == index_.end()) {
+            entries_.push_front(victim);
+            index_.emplace(victim.key, entries_.begin());
+            bytes_ += victim.bytes;
+          }
+        }
+        --victim.target->spilling_;
+      }
+      return refused;
+    }
+
+  public:
+
+    /// Construct a disabled manager
+    TileSpill() :
+      madness::Spinlock(), entries_(), index_(), max_bytes_(0ul), bytes_(0ul),
+      directory_("/tmp"), spill_count_(0ul), spill_bytes_(0ul),
+      spill_time_(0.0), fill_count_(0ul), fill_bytes_(0ul), fill_time_(0.0),
+      unspillable_count_(0ul)
+    { }
+
+    /// The manager of this process
+
+    /// \return A reference to the manager used by all distributed containers
+    /// in this process
+    static TileSpill& instance() {
+      static TileSpill spill;
+      return spill;
+    }
+
+    /// Maximum size accessor
+
+    /// \return The maximum size of the resident tiles, in bytes
+    size_type max_bytes() const { return max_bytes_; }
+
+    /// Set the maximum size of the resident tiles
+
+    /// A size of zero disables spilling for arrays that are constructed
+    /// later, and stops evictions from existing arrays. Tiles are evicted
+    /// when the next tile becomes resident.
+    /// \param bytes The maximum size of the resident tiles, in bytes
+    void max_bytes(const size_type bytes) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      max_bytes_ = bytes;
+    }
+
+    /// Spill state query
+
+    /// \return \c true when the maximum size is non-zero
+    bool enabled() const { return max_bytes_ != 0ul; }
+
+    /// Spill directory accessor
+
+    /// \return The directory where spill files are created
+    const std::string& directory() const { return directory_; }
+
+    /// Set the spill directory
+
+    /// \param path The directory where spill files are created
+    void directory(const std::string& path) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      directory_ = path;
+    }
+
+    /// Resident set size accessor
+
+    /// \return The size of the resident tiles, in bytes
+    size_type bytes() const { return bytes_; }
+
+    /// Number of resident tiles
+
+    /// \return The number of resident tiles
+    size_type size() const { return entries_.size(); }
+
+    /// Spill counter accessor
+
+    /// \return The number of tiles that were evicted
+    size_type spill_count() const { return spill_count_; }
+
+    /// Spill volume accessor
+
+    /// \return The number of bytes written to spill files
+    size_type spill_bytes() const { return spill_bytes_; }
+
+    /// Spill bandwidth accessor
+
+    /// \return The average write bandwidth, in bytes per second
+    double spill_bandwidth() const {
+      return (spill_time_ > 0.0 ? double(spill_bytes_) / spill_time_ : 0.0);
+    }
+
+    /// Fill counter accessor
+
+    /// \return The number of tiles that were read from spill files
+    size_type fill_count() const { return fill_count_; }
+
+    /// Fill volume accessor
+
+    /// \return The number of bytes read from spill files
+    size_type fill_bytes() const { return fill_bytes_; }
+
+    /// Fill bandwidth accessor
+
+    /// \return The average read bandwidth, in bytes per second
+    double fill_bandwidth() const {
+      return (fill_time_ > 0.0 ? double(fill_bytes_) / fill_time_ : 0.0);
+    }
+
+    /// Unspillable tile counter accessor
+
+    /// \return The number of times a tile was kept in memory because it was
+    /// shared
+    size_type unspillable_count() const { return unspillable_count_; }
+
+    /// Reset the spill and fill counters
+    void reset_counters() {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      spill_count_ = spill_bytes_ = fill_count_ = fill_bytes_ =
+          unspillable_count_ = 0ul;
+      spill_time_ = fill_time_ = 0.0;
+    }
+
+    /// Record a tile eviction
+
+    /// \param bytes The number of bytes written
+    /// \param time The time spent serializing and writing the tile
+    void record_spill(const size_type bytes, const double time) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      ++spill_count_;
+      spill_bytes_ += bytes;
+      spill_time_ += time;
+    }
+
+    /// Record a tile fill
+
+    /// \param bytes The number of bytes read
+    /// \param time The time spent reading and deserializing the tile
+    void record_fill(const size_type bytes, const double time) {
+      madness::ScopedMutex<madness::Spinlock> locker(this);
+      ++fill_count_;
+      fill_bytes_ += bytes;
+      fill_time_ += time;
+    }
+
+    /// Add a tile to the resident set, or mark it as recently used
+
+    /// Least-recently used tiles are spilled if the resident set is larger
+    /// than the maximum size. The caller must not hold an accessor to any
+    /// element of a container that spills tiles.
+    /// \param target The container that owns the tile
+    /// \param id The id of the container
+    /// \param i The ordinal index of the tile
+    /// \param bytes The size of the tile
+    void insert(detail::SpillTarget* target, const madness::uniqueidT& id,
+        const size_type i, const size_type bytes)
+    {
+      const key_type key = make_key(id, i);
+      std::vector<Entry> victims;
+      {
+        madness::ScopedMutex<madness::Spinlock> locker(this);
+        auto it = index_.find(key);
+        if(it != index_.end()) {
+          entries_.splice(entries_.begin(), entries_, it->second);
+          return;
+        }
+
+        entries_.push_front(Entry{ key, target, bytes });
+        index_.emplace(key, entries_.begin());
+        bytes_ += bytes;
+        select_victims(victims);
+      }
+
+      // Select other tiles in place of those that cannot be spilled, until
+      // each resident tile was tried once
+      size_type tried = 0ul;
+      while(! victims.empty()) {
+        tried += victims.size();
+        const size_type refused = spill(victims);
+        victims.clear();
+        if(refused == 0ul)
+          break;
+
+        madness::ScopedMutex<madness::Spinlock> locker(this);
+        if(tried >= entries_.size())
+          break;
+        select_victims(victims);
+      }
+    }
+
+    /// Remove the tiles of a container from the resident set
+
+    /// This waits until other threads have finished spilling tiles of the
+    /// container, so the container may be destroyed when it returns.
+    /// \param target The container
+    /// \param id The id of the container
+    void erase(detail::SpillTarget* target, const madness::uniqueidT& id) {
+      while(true) {
+        {
+          madness::ScopedMutex<madness::Spinlock> locker(this);
+          auto first = index_.lower_bound(make_key(id, 0ul));
+          while((first != index_.end()) &&
+              (std::get<0>(first->first) == id.get_world_id()) &&
+              (std::get<1>(first->first) == id.get_obj_id()))
+          {
+            bytes_ -= first->second->bytes;
+            entries_.erase(first->second);
+            first = index_.erase(first);
+          }
+
+          // Tiles that are being spilled may be returned to the resident set
+          // until the count drops to zero, so check it under the lock
+          if(target->spilling_ == 0ul)
+            return;
+        }
+        std::this_thread::yield();
+      }
+    }
+
+  }; // class TileSpill
+
+} // namespace TiledArray
+
+#endif // TILEDARRAY_TILE_SPILL_H__INCLUDED
@@ -24,6 +24,7 @@
 #include <TiledArray/type_traits.h>
 #include <vector>
 #include <initializer_list>
+#include <algorithm>
 
 namespace TiledArray {
 
@@ -32,6 +33,10 @@ namespace TiledArray {
   /// the format {a0, a1, a2, ...}, where 0 <= a0 < a1 < a2 < ... Each tile is
   /// defined as [a0,a1), [a1,a2), ... The number of tiles in the range will be
   /// equal to one less than the number of elements in the array.
+  /// The tile that contains an element is found by division when the tiles
+  /// are uniform (all but the last tile have the same size), or by binary
+  /// search of the tile boundaries otherwise, so the size of this object does
+  /// not depend on the number of elements.
   class TiledRange1 {
   private:
     struct Enabler { };
@@ -43,17 +48,15 @@ namespace TiledArray {
     /// Default constructor, range of 0 tiles and elements.
     TiledRange1() :
         range_(0,0), elements_range_(0,0),
-        tiles_ranges_(1, range_type(0,0)), elem2tile_(1, 0)
-    {
-      init_map_();
-    }
+        tiles_ranges_(1, range_type(0,0)), tile_size_(0)
+    { }
 
     /// Constructs a range with the boundaries provided by [first, last).
     /// Start_tile_index is the index of the first tile.
     template <typename RandIter,
         typename std::enable_if<detail::is_random_iterator<RandIter>::value>::type* = nullptr>
     TiledRange1(RandIter first, RandIter last) :
-        range_(), elements_range_(), tiles_ranges_(), elem2tile_()
+        range_(), elements_range_(), tiles_ranges_(), tile_size_(0)
     {
       init_tiles_(first, last, 0);
       init_map_();
@@ -62,7 +65,7 @@ namespace TiledArray {
     /// Copy constructor
     TiledRange1(const TiledRange1& rng) :
         range_(rng.range_), elements_range_(rng.elements_range_),
-        tiles_ranges_(rng.tiles_ranges_), elem2tile_(rng.elem2tile_)
+        tiles_ranges_(rng.tiles_ranges_), tile_size_(rng.tile_size_)
     { }
 
     /// Construct a 1D tiled range.
@@ -73,7 +76,8 @@ namespace TiledArray {
     /// \param t0 The starting index of the first tile
     /// \param t_rest The rest of tile boundaries
     template<typename... _sizes>
-    explicit TiledRange1(const size_type& t0, const _sizes&... t_rest)
+    explicit TiledRange1(const size_type& t0, const _sizes&... t_rest) :
+        range_(), elements_range_(), tiles_ranges_(), tile_size_(0)
     {
       const size_type n = sizeof...(_sizes) + 1;
       size_type tile_boundaries[n] = {t0, static_cast<size_type>(t_rest)...};
@@ -87,7 +91,8 @@ namespace TiledArray {
     /// The number of tile boundaries is n + 1, where n is the number of tiles.
     /// Tiles are defined as [t0, t1), [t1, t2), [t2, t3), ...
     /// \param list The list of tile boundaries in order from smallest to largest
-    explicit TiledRange1(const std::initializer_list<size_type>& list)
+    explicit TiledRange1(const std::initializer_list<size_type>& list) :
+        range_(), elements_range_(), tiles_ranges_(), tile_size_(0)
     {
       init_tiles_(list.begin(), list.end(), 0);
       init_map_();
@@ -146,12 +151,23 @@ namespace TiledArray {
       return tiles_ranges_[i - range_.first];
     }
 
-    const size_type& element_to_tile(const size_type& i) const {
+    /// Find the tile that contains an element
+
+    /// \param i The element index
+    /// \return The index of the tile that contains element \c i
+    size_type element_to_tile(const size_type& i) const {
       TA_ASSERT( includes(elements_range_, i) );
-      return elem2tile_[i - elements_range_.first];
+      if(tile_size_)
+        return (i - elements_range_.first) / tile_size_ + range_.first;
+
+      // Find the first tile with an upper bound greater than i
+      const_iterator it = std::upper_bound(tiles_ranges_.begin(),
+          tiles_ranges_.end(), i, [] (const size_type e, const range_type& t) {
+            return e < t.second; });
+      return (it - tiles_ranges_.begin()) + range_.first;
     }
 
-    DEPRECATED const size_type& element2tile(const size_type& i) const {
+    DEPRECATED size_type element2tile(const size_type& i) const {
       return element_to_tile(i);
     }
 
@@ -159,7 +175,7 @@ namespace TiledArray {
       std::swap(range_, other.range_);
       std::swap(elements_range_, other.elements_range_);
       std::swap(tiles_ranges_, other.tiles_ranges_);
-      std::swap(elem2tile_, other.elem2tile_);
+      std::swap(tile_size_, other.tile_size_);
     }
 
   private:
@@ -198,12 +214,14 @@ namespace TiledArray {
       if((elements_range_.second - elements_range_.first) == 0)
         return;
 
-      // initialize elem2tile map
-      elem2tile_.resize(elements_range_.second - elements_range_.first);
-      const size_type end = range_.second - range_.first;
-      for(size_type t = 0; t < end; ++t)
-        for(size_type e = tiles_ranges_[t].first; e < tiles_ranges_[t].second; ++e)
-          elem2tile_[e - elements_range_.first] = t + range_.first;
+      // Use the tile size for element lookup if all tiles, except the last
+      // which may be smaller, have the same size.
+      const size_type size = tiles_ranges_.front().second - tiles_ranges_.front().first;
+      for(auto it = tiles_ranges_.begin(); it != (tiles_ranges_.end() - 1); ++it)
+        if((it->second - it->first) != size)
+          return;
+      if((tiles_ranges_.back().second - tiles_ranges_.back().first) <= size)
+        tile_size_ = size;
     }
 
     friend std::ostream& operator <<(std::ostream&, const TiledRange1&);
@@ -212,7 +230,7 @@ namespace TiledArray {
     range_type range_; ///< the range of tile indices
     range_type elements_range_; ///< the range of element indices
     std::vector<range_type> tiles_ranges_; ///< ranges of each tile.
-    std::vector<size_type> elem2tile_; ///< maps element index to tile index (secondary data).
+    size_type tile_size_; ///< the size of uniform tiles, or 0 if the tiles are not uniform (secondary data).
 
   }; // class TiledRange1
 
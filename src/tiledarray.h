@@ -27,6 +27,7 @@
 // Array class
 #include <TiledArray/tensor.h>
 #include <TiledArray/tile.h>
+#include <TiledArray/low_rank_tensor.h>
 
 // Array policy classes
 #include <TiledArray/policies/dense_policy.h>
@@ -51,9 +52,12 @@
 
 // Utility functionality
 #include <TiledArray/conversions/eigen.h>
+#include <TiledArray/io/checkpoint.h>
 
 // Linear algebra
+#include <TiledArray/algebra/cholesky.h>
 #include <TiledArray/algebra/conjgrad.h>
+#include <TiledArray/algebra/heig.h>
 #include "TiledArray/dist_array.h"
 
 #ifdef TILEDARRAY_HAS_ELEMENTAL
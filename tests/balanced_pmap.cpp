@@ -0,0 +1,264 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  balanced_pmap.cpp
+ *  Jun 6, 2018
+ *
+ */
+
+#include "TiledArray/pmap/balanced_pmap.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+#include "global_fixture.h"
+
+using namespace TiledArray;
+
+struct BalancedPmapFixture {
+
+  BalancedPmapFixture() { }
+
+  /// Generate tile costs where every third tile is zero
+  static std::vector<double> make_costs(const std::size_t tiles) {
+    std::vector<double> costs(tiles, 0.0);
+    for(std::size_t i = 0ul; i < tiles; ++i)
+      costs[i] = (i % 3ul ? double(i % 7ul + 1ul) : 0.0);
+    return costs;
+  }
+
+};
+
+// =============================================================================
+// BalancedPmap Test Suite
+
+
+BOOST_FIXTURE_TEST_SUITE( balanced_pmap_suite, BalancedPmapFixture )
+
+BOOST_AUTO_TEST_CASE( constructor )
+{
+  for(std::size_t tiles = 1ul; tiles < 100ul; ++tiles) {
+    BOOST_REQUIRE_NO_THROW(TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, make_costs(tiles)));
+    TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, make_costs(tiles));
+    BOOST_CHECK_EQUAL(pmap.rank(), GlobalFixture::world->rank());
+    BOOST_CHECK_EQUAL(pmap.procs(), GlobalFixture::world->size());
+    BOOST_CHECK_EQUAL(pmap.size(), tiles);
+  }
+
+#ifdef TA_EXCEPTION_ERROR
+  BOOST_CHECK_THROW(TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, std::vector<double>()), TiledArray::Exception);
+  BOOST_CHECK_THROW(TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, std::vector<double>(10, -1.0)), TiledArray::Exception);
+#endif // TA_EXCEPTION_ERROR
+}
+
+BOOST_AUTO_TEST_CASE( owner )
+{
+  const std::size_t rank = GlobalFixture::world->rank();
+  const std::size_t size = GlobalFixture::world->size();
+
+  ProcessID* p_owner = new ProcessID[size];
+
+  // Check various pmap sizes
+  for(std::size_t tiles = 1ul; tiles < 100ul; ++tiles) {
+    TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, make_costs(tiles));
+
+    ProcessID last_owner = 0;
+    for(std::size_t tile = 0; tile < tiles; ++tile) {
+      std::fill_n(p_owner, size, 0);
+      p_owner[rank] = pmap.owner(tile);
+      // check that the value is in range
+      BOOST_CHECK_LT(p_owner[rank], size);
+      // check that the tiles are distributed in contiguous blocks
+      BOOST_CHECK_GE(p_owner[rank], last_owner);
+      last_owner = p_owner[rank];
+      GlobalFixture::world->gop.sum(p_owner, size);
+
+      // Make sure everyone agrees on who owns what.
+      for(std::size_t p = 0ul; p < size; ++p)
+        BOOST_CHECK_EQUAL(p_owner[p], p_owner[rank]);
+    }
+  }
+
+  delete [] p_owner;
+}
+
+BOOST_AUTO_TEST_CASE( local_size )
+{
+  for(std::size_t tiles = 1ul; tiles < 100ul; ++tiles) {
+    TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, make_costs(tiles));
+
+    std::size_t total_size = pmap.local_size();
+    GlobalFixture::world->gop.sum(total_size);
+
+    // Check that the total number of elements in all local groups is equal to
+    // the number of tiles in the map.
+    BOOST_CHECK_EQUAL(total_size, tiles);
+    BOOST_CHECK(pmap.empty() == (pmap.local_size() == 0ul));
+  }
+}
+
+BOOST_AUTO_TEST_CASE( local_group )
+{
+  ProcessID tile_owners[100];
+
+  for(std::size_t tiles = 1ul; tiles < 100ul; ++tiles) {
+    TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, make_costs(tiles));
+
+    // Check that all local elements map to this rank
+    for(detail::BalancedPmap::const_iterator it = pmap.begin(); it != pmap.end(); ++it) {
+      BOOST_CHECK_EQUAL(pmap.owner(*it), GlobalFixture::world->rank());
+      BOOST_CHECK(pmap.is_local(*it));
+    }
+
+    std::fill_n(tile_owners, tiles, 0);
+    for(detail::BalancedPmap::const_iterator it = pmap.begin(); it != pmap.end(); ++it) {
+      tile_owners[*it] += GlobalFixture::world->rank();
+    }
+
+    GlobalFixture::world->gop.sum(tile_owners, tiles);
+    for(std::size_t tile = 0; tile < tiles; ++tile) {
+      BOOST_CHECK_EQUAL(tile_owners[tile], pmap.owner(tile));
+    }
+
+  }
+}
+
+BOOST_AUTO_TEST_CASE( balance )
+{
+  const std::size_t tiles = 99ul;
+  const std::vector<double> costs = make_costs(tiles);
+  TiledArray::detail::BalancedPmap pmap(* GlobalFixture::world, costs);
+
+  // Compute the cost of the local tiles
+  double local_cost = 0.0;
+  for(detail::BalancedPmap::const_iterator it = pmap.begin(); it != pmap.end(); ++it)
+    local_cost += costs[*it];
+
+  // Check that the local cost differs from the average cost by no more than
+  // the largest tile cost
+  const double total_cost = std::accumulate(costs.begin(), costs.end(), 0.0);
+  const double max_cost = *std::max_element(costs.begin(), costs.end());
+  BOOST_CHECK_LE(std::abs(local_cost - total_cost / double(pmap.procs())), max_cost);
+
+  // Check that zero-cost tiles are distributed uniformly
+  TiledArray::detail::BalancedPmap zero_pmap(* GlobalFixture::world,
+      std::vector<double>(tiles, 0.0));
+  BOOST_CHECK_LE(zero_pmap.local_size(), tiles / zero_pmap.procs() + 1ul);
+  BOOST_CHECK_GE(zero_pmap.local_size() + 1ul, tiles / zero_pmap.procs());
+}
+
+BOOST_AUTO_TEST_CASE( sparse_array )
+{
+  World& world = * GlobalFixture::world;
+  const TiledRange trange = { { 0, 2, 5, 9, 14, 20 }, { 0, 3, 6, 9, 12 } };
+
+  // Zero the upper triangle of tiles
+  Tensor<float> norms(trange.tiles_range(), 0.0f);
+  for(std::size_t i = 0ul; i < 5ul; ++i)
+    for(std::size_t j = 0ul; j <= std::min(i, std::size_t(3ul)); ++j)
+      norms(i, j) = 1.0f;
+  const SparsePolicy::shape_type shape(norms, trange);
+
+  // Check that arrays use the blocked map unless the balanced map is given
+  TSpArrayD a(world, trange, shape);
+  BOOST_CHECK(std::dynamic_pointer_cast<detail::BlockedPmap>(a.pmap()));
+
+  const auto pmap = SparsePolicy::balanced_pmap(world, trange, shape);
+  TSpArrayD b(world, trange, shape, pmap);
+  BOOST_CHECK_EQUAL(b.pmap(), pmap);
+  for(std::size_t i = 0ul; i < b.size(); ++i)
+    BOOST_CHECK_EQUAL(b.is_local(i), pmap->is_local(i));
+}
+
+BOOST_AUTO_TEST_CASE( contraction )
+{
+  World& world = * GlobalFixture::world;
+
+  // Contract a 16x4 by 4x16 matrix of tiles, where each tile has 4x4 elements
+  std::vector<std::size_t> tiling16(17ul), tiling4(5ul);
+  for(std::size_t i = 0ul; i < tiling16.size(); ++i)
+    tiling16[i] = i * 4ul;
+  for(std::size_t i = 0ul; i < tiling4.size(); ++i)
+    tiling4[i] = i * 4ul;
+  const TiledRange1 tr16(tiling16.begin(), tiling16.end());
+  const TiledRange1 tr4(tiling4.begin(), tiling4.end());
+  const TiledRange left_trange({ tr16, tr4 });
+  const TiledRange right_trange({ tr4, tr16 });
+  const TiledRange trange({ tr16, tr16 });
+
+  // Only the first row of tiles of the left-hand argument is non-zero, so
+  // all of the work is in the first row of result tiles
+  Tensor<float> left_norms(left_trange.tiles_range(), 0.0f);
+  for(std::size_t k = 0ul; k < 4ul; ++k)
+    left_norms(0ul, k) = 1.0f;
+  const SparsePolicy::shape_type left_shape(left_norms, left_trange);
+  const SparsePolicy::shape_type right_shape(
+      Tensor<float>(right_trange.tiles_range(), 1.0f), right_trange);
+  Tensor<float> norms(trange.tiles_range(), 0.0f);
+  for(std::size_t j = 0ul; j < 16ul; ++j)
+    norms(0ul, j) = 1.0f;
+  const SparsePolicy::shape_type shape(norms, trange);
+
+  // Each non-zero result tile is the sum of 4 products of 4x4 tiles
+  const std::vector<double> costs = SparsePolicy::contraction_costs(
+      left_trange, left_shape, right_trange, right_shape, trange, shape);
+  BOOST_REQUIRE_EQUAL(costs.size(), 256ul);
+  for(std::size_t i = 0ul; i < costs.size(); ++i)
+    BOOST_CHECK_CLOSE(costs[i] + 1.0, (i < 16ul ? 513.0 : 1.0), 1.0e-8);
+
+  // Compare the largest cost of a process with the cyclic map of the
+  // process grid and the balanced map
+  const detail::ProcGrid proc_grid(world, 16ul, 16ul, 64ul, 64ul);
+  const auto max_cost = [&] (const Pmap& pmap) {
+    double local_cost = 0.0;
+    for(const auto tile : pmap)
+      local_cost += costs[tile];
+    world.gop.max(& local_cost, 1);
+    return local_cost;
+  };
+  const double grid_cost = max_cost(*proc_grid.make_pmap());
+  const double balanced_cost = max_cost(*proc_grid.make_pmap(costs));
+  BOOST_CHECK_LE(balanced_cost, grid_cost);
+  BOOST_CHECK_LE(balanced_cost, 16.0 * 512.0 / double(world.size()) + 512.0);
+
+  // The grid map places the first row of tiles on one row of processes
+  if((proc_grid.proc_rows() > 1ul) && (world.size() <= 16))
+    BOOST_CHECK_LT(balanced_cost, grid_cost);
+
+  // Check that contractions use the balanced map when it is selected
+  TSpArrayD a(world, left_trange, left_shape);
+  TSpArrayD b(world, right_trange, right_shape);
+  a.fill_local(1.0);
+  b.fill_local(1.0);
+  const bool balanced = SparsePolicy::balanced_contractions();
+  SparsePolicy::balanced_contractions() = true;
+  TSpArrayD c;
+  BOOST_CHECK_NO_THROW(c("i,j") = a("i,k") * b("k,j"));
+  SparsePolicy::balanced_contractions() = balanced;
+
+  if(world.size() > 1)
+    BOOST_CHECK(std::dynamic_pointer_cast<detail::BalancedPmap>(c.pmap()));
+  for(std::size_t i = 0ul; i < c.size(); ++i) {
+    BOOST_CHECK_EQUAL(c.is_zero(i), i >= 16ul);
+    if(c.is_local(i) && ! c.is_zero(i)) {
+      const TSpArrayD::value_type tile = c.find(i).get();
+      for(std::size_t j = 0ul; j < tile.size(); ++j)
+        BOOST_CHECK_EQUAL(tile[j], 16.0);
+    }
+  }
+  world.gop.fence();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  checkpoint.cpp
+ *  Jun 20, 2018
+ *
+ */
+
+#include "TiledArray/io/checkpoint.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+#include "range_fixture.h"
+#include <cstdio>
+
+using namespace TiledArray;
+
+struct CheckpointFixture : public TiledRangeFixture {
+
+  CheckpointFixture() :
+    world(* GlobalFixture::world),
+    path("checkpoint_test"),
+    a(world, tr),
+    sa(world, tr, make_shape(world, tr))
+  {
+    a.fill_random();
+    sa.fill_random();
+  }
+
+  ~CheckpointFixture() {
+    world.gop.fence();
+    if(world.rank() == 0) {
+      std::remove(path.c_str());
+      for(int rank = 0; rank < world.size(); ++rank)
+        std::remove(detail::CheckpointFormat::data_file(path, rank).c_str());
+    }
+    world.gop.fence();
+  }
+
+  // Make a shape where every third tile is zero
+  static SparseShape<float> make_shape(World& world, const TiledRange& trange) {
+    Tensor<float> norms(trange.tiles_range(), 0.0f);
+    for(std::size_t i = 0ul; i < norms.size(); ++i)
+      if(i % 3ul)
+        norms[i] = float(trange.make_tile_range(i).volume());
+    return SparseShape<float>(world, norms, trange);
+  }
+
+  // Check that the local tiles of result match those of reference
+  template <typename Array>
+  static void check_array(const Array& result, const Array& reference) {
+    BOOST_CHECK_EQUAL(result.trange(), reference.trange());
+    BOOST_REQUIRE(result.shape() == reference.shape());
+    for(const std::size_t index : *result.pmap()) {
+      BOOST_CHECK_EQUAL(result.is_zero(index), reference.is_zero(index));
+      if(result.is_zero(index))
+        continue;
+
+      const typename Array::value_type r = result.find(index).get();
+      const typename Array::value_type ref = reference.find(index).get();
+      BOOST_CHECK_EQUAL(r.range(), ref.range());
+      BOOST_CHECK_EQUAL_COLLECTIONS(r.begin(), r.end(), ref.begin(), ref.end());
+    }
+  }
+
+  World& world;
+  const std::string path;
+  TArrayD a;
+  TSpArrayD sa;
+}; // CheckpointFixture
+
+BOOST_FIXTURE_TEST_SUITE( checkpoint_suite, CheckpointFixture )
+
+BOOST_AUTO_TEST_CASE( dense )
+{
+  BOOST_REQUIRE_NO_THROW(write_checkpoint(a, path));
+
+  TArrayD result;
+  BOOST_REQUIRE_NO_THROW(result = read_checkpoint<TArrayD>(world, path));
+  check_array(result, a);
+}
+
+BOOST_AUTO_TEST_CASE( sparse )
+{
+  BOOST_REQUIRE_NO_THROW(write_checkpoint(sa, path));
+
+  TSpArrayD result;
+  BOOST_REQUIRE_NO_THROW(result = read_checkpoint<TSpArrayD>(world, path));
+  check_array(result, sa);
+}
+
+BOOST_AUTO_TEST_CASE( different_pmap )
+{
+  BOOST_REQUIRE_NO_THROW(write_checkpoint(sa, path));
+
+  // Read with a process map that differs from the one used to write the data
+  const std::shared_ptr<TSpArrayD::pmap_interface> pmap =
+      std::make_shared<detail::HashPmap>(world, tr.tiles_range().volume(), 42ul);
+  TSpArrayD result;
+  BOOST_REQUIRE_NO_THROW(result = read_checkpoint<TSpArrayD>(world, path, pmap));
+  BOOST_CHECK(result.pmap() == pmap);
+  check_array(result, sa);
+}
+
+BOOST_AUTO_TEST_CASE( modify_tiles )
+{
+  BOOST_REQUIRE_NO_THROW(write_checkpoint(a, path));
+
+  // Modify the tiles that were read in place
+  {
+    TArrayD result = read_checkpoint<TArrayD>(world, path);
+    for(const std::size_t index : *result.pmap()) {
+      TArrayD::value_type tile = result.find(index).get();
+      std::fill(tile.begin(), tile.end(), -1.0);
+    }
+    world.gop.fence();
+  }
+
+  // Check that the checkpoint was not modified
+  TArrayD result = read_checkpoint<TArrayD>(world, path);
+  check_array(result, a);
+}
+
+BOOST_AUTO_TEST_CASE( mismatched_type )
+{
+  BOOST_REQUIRE_NO_THROW(write_checkpoint(a, path));
+
+  BOOST_CHECK_THROW(read_checkpoint<TSpArrayD>(world, path), TiledArray::Exception);
+  BOOST_CHECK_THROW(read_checkpoint<TArrayF>(world, path), TiledArray::Exception);
+  BOOST_CHECK_THROW(read_checkpoint<TArrayD>(world, path + ".missing"),
+      TiledArray::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,7 @@
 #include "array_fixture.h"
 
 #include "../src/TiledArray/dist_eval/contraction_eval.h"
+#include "../src/TiledArray/dist_eval/layered_contraction_eval.h"
 #include "../src/tiledarray.h"
 #include "unit_test_config.h"
 #include "sparse_shape_fixture.h"
@@ -449,4 +450,68 @@ BOOST_AUTO_TEST_CASE( sparse_eval )
   do_sparse_eval(true);
 }
 
+BOOST_AUTO_TEST_CASE( governor )
+{
+  // Unbounded memory
+  {
+    detail::SummaGovernor governor;
+    governor.initialize(2ul, 4ul);
+    BOOST_CHECK_EQUAL(governor.depth(), 2ul);
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, true, true), 0);
+    BOOST_CHECK_EQUAL(governor.resident(), 100ul);
+    governor.finish_steps(100ul, 1ul);
+    BOOST_CHECK_EQUAL(governor.resident(), 0ul);
+  }
+
+  // Throttle when the next iteration would exceed the budget
+  {
+    detail::SummaGovernor governor(250ul);
+    governor.initialize(3ul, 3ul);
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, true, true), 0);
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, true, true), -1);
+    BOOST_CHECK_EQUAL(governor.depth(), 2ul);
+
+    // The depth cannot be reduced when the caller is unable to do so
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, false, true), 0);
+    BOOST_CHECK_EQUAL(governor.depth(), 2ul);
+    BOOST_CHECK_EQUAL(governor.resident(), 300ul);
+
+    // The depth is never reduced below one
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, true, true), -1);
+    BOOST_CHECK_EQUAL(governor.start_step(100ul, true, true), 0);
+    BOOST_CHECK_EQUAL(governor.depth(), 1ul);
+
+    // Memory is released when iterations finish
+    governor.finish_steps(500ul, 5ul);
+    BOOST_CHECK_EQUAL(governor.resident(), 0ul);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( contraction_layers )
+{
+  // Check that layers are opt-in and that invalid settings use a 2D grid
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers(nullptr), 1ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("auto"), 0ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("4"), 4ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("four"), 1ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("-2"), 1ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("0"), 1ul);
+  BOOST_CHECK_EQUAL(detail::parse_contraction_layers("2x"), 1ul);
+
+  // Check that a requested number of layers is limited by the processes and
+  // the inner dimension
+  BOOST_CHECK_EQUAL(detail::contraction_layers(64u, 10, 10, 10, 1000, 1000,
+      1000, 8, 1ul), 1u);
+  BOOST_CHECK_EQUAL(detail::contraction_layers(64u, 10, 10, 10, 1000, 1000,
+      1000, 8, 4ul), 4u);
+  BOOST_CHECK_EQUAL(detail::contraction_layers(64u, 10, 10, 2, 1000, 1000,
+      1000, 8, 4ul), 2u);
+
+  // Check the automatic selection
+  BOOST_CHECK_EQUAL(detail::contraction_layers(4u, 10, 10, 100, 1000, 1000,
+      100000, 8, 0ul), 1u);
+  BOOST_CHECK_GT(detail::contraction_layers(64u, 10, 10, 100, 1000, 1000,
+      100000, 8, 0ul), 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
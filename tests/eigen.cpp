@@ -357,4 +357,136 @@ BOOST_AUTO_TEST_CASE( array_to_vector ) {
 }
 
 
+BOOST_AUTO_TEST_CASE( matrix_block_to_array ) {
+  // Fill the matrix with data that is identical on all ranks
+  for(Eigen::Index i = 0; i < matrix.rows(); ++i)
+    for(Eigen::Index j = 0; j < matrix.cols(); ++j)
+      matrix(i, j) = i * matrix.cols() + j;
+
+  const std::size_t rank = GlobalFixture::world->rank();
+  const std::size_t size = GlobalFixture::world->size();
+
+  // Partition the rows of the matrix among ranks
+  const std::size_t first_row = matrix.rows() * rank / size;
+  const std::size_t last_row = matrix.rows() * (rank + 1) / size;
+  BOOST_CHECK_NO_THROW((array = eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+      trange, matrix.middleRows(first_row, last_row - first_row), first_row)));
+
+  for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+    const TArrayI::value_type tile = array.find(*it).get();
+    for(Range::const_iterator tile_it = tile.range().begin(); tile_it != tile.range().end(); ++tile_it)
+      BOOST_CHECK_EQUAL(tile[*tile_it], matrix((*tile_it)[0], (*tile_it)[1]));
+  }
+
+  // Partition the columns of the matrix among ranks
+  const std::size_t first_col = matrix.cols() * rank / size;
+  const std::size_t last_col = matrix.cols() * (rank + 1) / size;
+  BOOST_CHECK_NO_THROW((array = eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+      trange, matrix.middleCols(first_col, last_col - first_col), 0, first_col)));
+
+  for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+    const TArrayI::value_type tile = array.find(*it).get();
+    for(Range::const_iterator tile_it = tile.range().begin(); tile_it != tile.range().end(); ++tile_it)
+      BOOST_CHECK_EQUAL(tile[*tile_it], matrix((*tile_it)[0], (*tile_it)[1]));
+  }
+
+#if !defined(TA_USER_ASSERT_DISABLED)
+  // Check that blocks that do not cover the matrix are rejected
+  if(size == 1ul)
+    BOOST_CHECK_THROW((eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+        trange, matrix.topRows(1), 0)), TiledArray::Exception);
+
+  // An overlap and a hole of the same size are rejected on all ranks
+  if(size > 1ul) {
+    const std::size_t last = last_row + (rank == 0ul ? 1ul : 0ul) -
+        (rank == size - 1ul ? 1ul : 0ul);
+    BOOST_CHECK_THROW((eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+        trange, matrix.middleRows(first_row, last - first_row), first_row)),
+        TiledArray::Exception);
+  }
+
+  // Blocks that are not contained in the matrix are rejected on all ranks
+  BOOST_CHECK_THROW((eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+      trange, matrix.topRows(1), (rank == 0ul ? std::size_t(matrix.rows()) : 0ul))),
+      TiledArray::Exception);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( vector_block_to_array ) {
+  for(Eigen::Index i = 0; i < vector.size(); ++i)
+    vector(i) = 3 * i + 1;
+
+  const std::size_t rank = GlobalFixture::world->rank();
+  const std::size_t size = GlobalFixture::world->size();
+  const std::size_t first = vector.size() * rank / size;
+  const std::size_t last = vector.size() * (rank + 1) / size;
+  BOOST_CHECK_NO_THROW((array1 = eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+      trange1, vector.segment(first, last - first), first)));
+
+  for(auto it = array1.pmap()->begin(); it != array1.pmap()->end(); ++it) {
+    const TArrayI::value_type tile = array1.find(*it).get();
+    for(Range::const_iterator tile_it = tile.range().begin(); tile_it != tile.range().end(); ++tile_it)
+      BOOST_CHECK_EQUAL(tile[*tile_it], vector((*tile_it)[0]));
+  }
+
+  // Convert the array back to a distributed vector
+  Eigen::MatrixXi slab;
+  BOOST_CHECK_NO_THROW(slab = array_to_eigen_rows(array1, first, last - first));
+  BOOST_CHECK_EQUAL(slab.rows(), last - first);
+  BOOST_CHECK_EQUAL(slab.cols(), 1);
+  for(std::size_t i = first; i < last; ++i)
+    BOOST_CHECK_EQUAL(slab(i - first, 0), vector(i));
+}
+
+BOOST_AUTO_TEST_CASE( array_to_matrix_block ) {
+  // Fill the local tiles of the array
+  const std::size_t cols = array.trange().elements_range().extent(1);
+  for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+    TArrayI::value_type tile(array.trange().make_tile_range(*it));
+    for(Range::const_iterator tile_it = tile.range().begin(); tile_it != tile.range().end(); ++tile_it)
+      tile[*tile_it] = (*tile_it)[0] * cols + (*tile_it)[1];
+    array.set(*it, tile);
+  }
+
+  const std::size_t rank = GlobalFixture::world->rank();
+  const std::size_t size = GlobalFixture::world->size();
+  const std::size_t rows = array.trange().elements_range().extent(0);
+
+  // Convert the array to row slabs: column-major (matrix) and row-major (rmatrix)
+  const std::size_t first_row = rows * rank / size;
+  const std::size_t last_row = rows * (rank + 1) / size;
+  BOOST_CHECK_NO_THROW(matrix = array_to_eigen_rows(array, first_row, last_row - first_row));
+  BOOST_CHECK_NO_THROW((rmatrix = array_to_eigen_rows<Tensor<int>, DensePolicy,
+      Eigen::RowMajor>(array, first_row, last_row - first_row)));
+  BOOST_CHECK_EQUAL(matrix.rows(), last_row - first_row);
+  BOOST_CHECK_EQUAL(matrix.cols(), cols);
+  BOOST_CHECK_EQUAL(rmatrix.rows(), last_row - first_row);
+  BOOST_CHECK_EQUAL(rmatrix.cols(), cols);
+  for(std::size_t i = first_row; i < last_row; ++i) {
+    for(std::size_t j = 0ul; j < cols; ++j) {
+      BOOST_CHECK_EQUAL(matrix(i - first_row, j), int(i * cols + j));
+      BOOST_CHECK_EQUAL(rmatrix(i - first_row, j), int(i * cols + j));
+    }
+  }
+
+  // Convert an interior block, which is identical on all ranks
+  BOOST_CHECK_NO_THROW(matrix = array_to_eigen_block(array, 1, rows - 2, 2, cols - 3));
+  BOOST_CHECK_EQUAL(matrix.rows(), rows - 2);
+  BOOST_CHECK_EQUAL(matrix.cols(), cols - 3);
+  for(std::size_t i = 1ul; i < rows - 1ul; ++i)
+    for(std::size_t j = 2ul; j < cols - 1ul; ++j)
+      BOOST_CHECK_EQUAL(matrix(i - 1, j - 2), int(i * cols + j));
+
+  // Round trip the row slabs
+  TArrayI result;
+  BOOST_CHECK_NO_THROW((result = eigen_block_to_array<TArrayI>(*GlobalFixture::world,
+      trange, rmatrix, first_row)));
+  for(auto it = result.pmap()->begin(); it != result.pmap()->end(); ++it) {
+    const TArrayI::value_type tile = result.find(*it).get();
+    const TArrayI::value_type reference = array.find(*it).get();
+    for(std::size_t i = 0ul; i < tile.size(); ++i)
+      BOOST_CHECK_EQUAL(tile[i], reference[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
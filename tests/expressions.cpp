@@ -1242,6 +1242,26 @@ BOOST_AUTO_TEST_CASE( cont )
       }
     }
   }
+
+  // The multithreaded GEMM is selected per contraction
+  BOOST_CHECK(! (a("i,b,c") * b("j,b,c")).parallel_gemm());
+  const std::size_t threshold = TiledArray::math::ParallelGemmParams::threshold();
+  TiledArray::math::ParallelGemmParams::threshold() = 0ul;
+  BOOST_REQUIRE_NO_THROW(w("i,j") = (a("i,b,c") * b("j,b,c")).set_parallel_gemm());
+  GlobalFixture::world->gop.fence();
+  TiledArray::math::ParallelGemmParams::threshold() = threshold;
+
+  for(TArrayI::const_iterator it = w.begin(); it != w.end(); ++it) {
+    TArrayI::value_type tile = *it;
+
+    std::array<std::size_t, 2> i;
+
+    for(i[0] = tile.range().lobound(0); i[0] < tile.range().upbound(0); ++i[0]) {
+      for(i[1] = tile.range().lobound(1); i[1] < tile.range().upbound(1); ++i[1]) {
+          BOOST_CHECK_EQUAL(tile[i], result(i[0], i[1]));
+      }
+    }
+  }
 }
 
 BOOST_AUTO_TEST_CASE( cont_permute )
@@ -1730,6 +1750,193 @@ BOOST_AUTO_TEST_CASE( cont_plus_reduce )
   }
 }
 
+BOOST_AUTO_TEST_CASE( cont_cache )
+{
+  auto check_equal = [] (const TArrayI& result, const TArrayI& ref) {
+    for(std::size_t i = 0ul; i < ref.size(); ++i) {
+      BOOST_CHECK_EQUAL(result.is_zero(i), ref.is_zero(i));
+      if(ref.is_local(i) && ! ref.is_zero(i)) {
+        const TArrayI::value_type tile = result.find(i).get();
+        const TArrayI::value_type ref_tile = ref.find(i).get();
+        BOOST_CHECK_EQUAL_COLLECTIONS(tile.begin(), tile.end(),
+            ref_tile.begin(), ref_tile.end());
+      }
+    }
+  };
+
+  // Compute the reference results without the cache
+  TArrayI ref1, ref2, ref3;
+  BOOST_CHECK(! expressions::ExprCache::active());
+  ref1("a,b") = a("a,i,j") * b("b,i,j");
+  ref2("a,b") = a("a,i,j") * b("b,i,j") + a("a,i,j") * b("b,i,j");
+  ref3("b,a") = a("a,i,j") * b("b,i,j");
+
+  TArrayI r1, r2, r3, r4;
+  {
+    expressions::ExprCache cache;
+    BOOST_CHECK_EQUAL(expressions::ExprCache::active(), & cache);
+
+    r1("a,b") = a("a,i,j") * b("b,i,j");
+    BOOST_CHECK_EQUAL(cache.misses(), 1ul);
+    BOOST_CHECK_EQUAL(cache.hits(), 0ul);
+
+    // Check that identical contractions are reused
+    r2("a,b") = a("a,i,j") * b("b,i,j") + a("a,i,j") * b("b,i,j");
+    BOOST_CHECK_EQUAL(cache.misses(), 1ul);
+    BOOST_CHECK_EQUAL(cache.hits(), 2ul);
+
+    // Check that a permuted result is not reused
+    r3("b,a") = a("a,i,j") * b("b,i,j");
+    BOOST_CHECK_EQUAL(cache.misses(), 2ul);
+    BOOST_CHECK_EQUAL(cache.size(), 2ul);
+
+    // Check that results are not reused after an argument is assigned
+    b("a,i,j") = 2 * b("a,i,j");
+    r4("a,b") = a("a,i,j") * b("b,i,j");
+    BOOST_CHECK_EQUAL(cache.misses(), 3ul);
+    BOOST_CHECK_EQUAL(cache.hits(), 2ul);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  }
+  BOOST_CHECK(! expressions::ExprCache::active());
+
+  // Check that keys distinguish factors that print the same
+  BOOST_CHECK_NE(expressions::exact_factor(1.0),
+      expressions::exact_factor(1.0 + 1.0e-9));
+  BOOST_CHECK_EQUAL(expressions::exact_factor(0.1), expressions::exact_factor(0.1));
+
+  check_equal(r1, ref1);
+  check_equal(r2, ref2);
+  check_equal(r3, ref3);
+  ref2("a,b") = 2 * ref1("a,b");
+  check_equal(r4, ref2);
+}
+
+BOOST_AUTO_TEST_CASE( cont_chain )
+{
+  // The product of a and b is an outer product, so contracting a and c first
+  // is cheaper.
+  std::stringstream trace;
+  trace << w("a,k,l") << a("a,i,j") * b("b,k,l") * c("b,i,j");
+  if(GlobalFixture::world->rank() == 0) {
+    BOOST_CHECK(trace.str().find("[order]") != std::string::npos);
+    BOOST_CHECK(trace.str().find("[selected 2]") != std::string::npos);
+  }
+
+  TArrayI ac, ref1, ref2, r1, r2;
+  ac("a,b") = a("a,i,j") * c("b,i,j");
+  ref1("a,k,l") = ac("a,b") * b("b,k,l");
+  ref2("l,k,a") = ref1("a,k,l");
+
+  BOOST_REQUIRE_NO_THROW(r1("a,k,l") = a("a,i,j") * b("b,k,l") * c("b,i,j"));
+  BOOST_REQUIRE_NO_THROW(r2("l,k,a") = a("a,i,j") * b("b,k,l") * c("b,i,j"));
+
+  // Check that reordering does not change the result
+  for(std::size_t i = 0ul; i < ref1.size(); ++i) {
+    if(ref1.is_local(i)) {
+      const TArrayI::value_type ref_tile = ref1.find(i).get();
+      const TArrayI::value_type tile = r1.find(i).get();
+      BOOST_CHECK_EQUAL_COLLECTIONS(tile.begin(), tile.end(),
+          ref_tile.begin(), ref_tile.end());
+    }
+    if(ref2.is_local(i)) {
+      const TArrayI::value_type ref_tile = ref2.find(i).get();
+      const TArrayI::value_type tile = r2.find(i).get();
+      BOOST_CHECK_EQUAL_COLLECTIONS(tile.begin(), tile.end(),
+          ref_tile.begin(), ref_tile.end());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( cont_sum )
+{
+  // Evaluate each term separately
+  TArrayI ab, bc, ca, ab_bc, ref1, ref2, r1, r2;
+  ab("a,b") = a("a,i,j") * b("b,i,j");
+  bc("a,b") = b("a,i,j") * c("b,i,j");
+  ca("a,b") = c("a,i,j") * a("b,i,j");
+  ab_bc("a,b") = ab("a,b") + bc("a,b");
+  ref1("a,b") = ab_bc("a,b") - 2 * ca("a,b");
+  ref2("b,a") = ref1("a,b");
+
+  // The contractions are accumulated into the same result tiles
+  const bool fused = expressions::fused_sum_contractions();
+  expressions::fused_sum_contractions() = true;
+  BOOST_CHECK_NO_THROW(r1("a,b") = a("a,i,j") * b("b,i,j")
+      + b("a,i,j") * c("b,i,j") - 2 * (c("a,i,j") * a("b,i,j")));
+  BOOST_CHECK_NO_THROW(r2("b,a") = a("a,i,j") * b("b,i,j")
+      + b("a,i,j") * c("b,i,j") - 2 * (c("a,i,j") * a("b,i,j")));
+  expressions::fused_sum_contractions() = fused;
+
+  for(std::size_t i = 0ul; i < ref1.size(); ++i) {
+    if(ref1.is_local(i)) {
+      const TArrayI::value_type ref_tile = ref1.find(i).get();
+      const TArrayI::value_type tile = r1.find(i).get();
+      BOOST_CHECK_EQUAL_COLLECTIONS(tile.begin(), tile.end(),
+          ref_tile.begin(), ref_tile.end());
+    }
+    if(ref2.is_local(i)) {
+      const TArrayI::value_type ref_tile = ref2.find(i).get();
+      const TArrayI::value_type tile = r2.find(i).get();
+      BOOST_CHECK_EQUAL_COLLECTIONS(tile.begin(), tile.end(),
+          ref_tile.begin(), ref_tile.end());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( cont_mixed_precision )
+{
+  // Double precision arrays whose elements are not exact in single precision
+  const auto to_double = [] (const TArrayI::value_type& tile) {
+    return TArrayD::value_type(tile,
+        [] (const int value) { return double(value) / 7.0; });
+  };
+  const auto to_float = [] (const TArrayD::value_type& tile) {
+    return TArrayF::value_type(tile);
+  };
+  const auto to_double_exact = [] (const TArrayF::value_type& tile) {
+    return TArrayD::value_type(tile);
+  };
+  TArrayD ad = to_new_tile_type(a, to_double);
+  TArrayD bd = to_new_tile_type(b, to_double);
+  TArrayF af = to_new_tile_type(ad, to_float);
+  TArrayF bf = to_new_tile_type(bd, to_float);
+
+  // The reference is the double precision contraction of the rounded arrays
+  TArrayD ar = to_new_tile_type(af, to_double_exact);
+  TArrayD br = to_new_tile_type(bf, to_double_exact);
+  TArrayD ref1, ref2, ref3, r1, r2, r3;
+  ref1("a,b") = ar("a,i,j") * br("b,i,j");
+  ref2("b,a") = 2.0 * (ar("a,i,j") * br("b,i,j"));
+  ref3("a,b") = ar("a,j,i") * br("b,i,j");
+
+  // Single precision arrays are contracted with double precision accumulation
+  // when the result is a double precision array.
+  BOOST_REQUIRE_NO_THROW(r1("a,b") = af("a,i,j") * bf("b,i,j"));
+  BOOST_REQUIRE_NO_THROW(r2("b,a") = 2.0 * (af("a,i,j") * bf("b,i,j")));
+  BOOST_REQUIRE_NO_THROW(r3("a,b") = af("a,j,i") * bf("b,i,j"));
+
+  const double norm1 = ref1("a,b").norm().get();
+  BOOST_CHECK_SMALL((r1("a,b") - ref1("a,b")).norm().get(), 1.0e-12 * norm1);
+  BOOST_CHECK_SMALL((r2("a,b") - ref2("a,b")).norm().get(), 2.0e-12 * norm1);
+  BOOST_CHECK_SMALL((r3("a,b") - ref3("a,b")).norm().get(),
+      1.0e-12 * ref3("a,b").norm().get());
+
+  // The only error relative to the double precision arrays is the rounding of
+  // the arguments.
+  TArrayD dd;
+  dd("a,b") = ad("a,i,j") * bd("b,i,j");
+  BOOST_CHECK_SMALL((r1("a,b") - dd("a,b")).norm().get(), 1.0e-6 * norm1);
+
+  // Coefficient-wise products are promoted to the result type
+  TArrayD h, href;
+  BOOST_REQUIRE_NO_THROW(h("a,i,j") = af("a,i,j") * bf("a,i,j"));
+  href("a,i,j") = ar("a,i,j") * br("a,i,j");
+  BOOST_CHECK_SMALL((h("a,i,j") - href("a,i,j")).norm().get(),
+      1.0e-6 * href("a,i,j").norm().get());
+}
+
 BOOST_AUTO_TEST_CASE( no_alias_plus_reduce )
 {
   // Construct the tiled range
@@ -1808,6 +2015,36 @@ BOOST_AUTO_TEST_CASE( outer_product )
   BOOST_CHECK_EQUAL(ew, ew_test);
 }
 
+BOOST_AUTO_TEST_CASE( fused_reduce )
+{
+  // Reductions of element-wise expressions are fused into the tile
+  // operations; compare them to reductions of the evaluated expressions
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = a("a,b,c") - b("c,b,a"));
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).sum().get(),
+      c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).squared_norm().get(),
+      c("a,b,c").squared_norm().get());
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).abs_max().get(),
+      c("a,b,c").abs_max().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = 2 * (a("a,b,c") + b("a,b,c")));
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).sum().get(),
+      c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).max().get(),
+      c("a,b,c").max().get());
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).abs_min().get(),
+      c("a,b,c").abs_min().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = -(a("a,b,c") - b("a,b,c")));
+  BOOST_CHECK_EQUAL((-(a("a,b,c") - b("a,b,c"))).min().get(),
+      c("a,b,c").min().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = 3 * a("c,b,a"));
+  BOOST_CHECK_EQUAL((3 * a("c,b,a")).sum().get(), c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((3 * a("c,b,a")).squared_norm().get(),
+      c("a,b,c").squared_norm().get());
+}
+
 BOOST_AUTO_TEST_CASE( dot )
 {
   // Test the dot expression function
@@ -2181,6 +2181,35 @@ BOOST_AUTO_TEST_CASE(outer_product) {
   BOOST_CHECK_EQUAL(ew, ew_test);
 }
 
+BOOST_AUTO_TEST_CASE(fused_reduce) {
+  // Reductions of element-wise expressions are fused into the tile
+  // operations; compare them to reductions of the evaluated expressions
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = a("a,b,c") - b("c,b,a"));
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).sum().get(),
+      c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).squared_norm().get(),
+      c("a,b,c").squared_norm().get());
+  BOOST_CHECK_EQUAL((a("a,b,c") - b("c,b,a")).abs_max().get(),
+      c("a,b,c").abs_max().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = 2 * (a("a,b,c") + b("a,b,c")));
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).sum().get(),
+      c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).max().get(),
+      c("a,b,c").max().get());
+  BOOST_CHECK_EQUAL((2 * (a("a,b,c") + b("a,b,c"))).abs_min().get(),
+      c("a,b,c").abs_min().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = -(a("a,b,c") - b("a,b,c")));
+  BOOST_CHECK_EQUAL((-(a("a,b,c") - b("a,b,c"))).min().get(),
+      c("a,b,c").min().get());
+
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = 3 * a("c,b,a"));
+  BOOST_CHECK_EQUAL((3 * a("c,b,a")).sum().get(), c("a,b,c").sum().get());
+  BOOST_CHECK_EQUAL((3 * a("c,b,a")).squared_norm().get(),
+      c("a,b,c").squared_norm().get());
+}
+
 BOOST_AUTO_TEST_CASE(dot) {
   // Test the dot expression function
   int result = 0;
@@ -2233,6 +2262,26 @@ BOOST_AUTO_TEST_CASE(dot_permute) {
   BOOST_CHECK_EQUAL(result, expected);
 }
 
+BOOST_AUTO_TEST_CASE(truncate_result) {
+  // A difference that vanishes produces an empty shape
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = (a("a,b,c") - a("a,b,c")).set_truncate());
+  for (std::size_t i = 0ul; i < c.size(); ++i) BOOST_CHECK(c.is_zero(i));
+
+  // The fused truncation is equivalent to truncating the result
+  BOOST_REQUIRE_NO_THROW(c("a,b,c") = a("a,b,c") - b("a,b,c"));
+  c.truncate();
+  BOOST_REQUIRE_NO_THROW(w("a,b,c") = (a("a,b,c") - b("a,b,c")).set_truncate());
+  for (std::size_t i = 0ul; i < c.size(); ++i) {
+    BOOST_CHECK_EQUAL(w.is_zero(i), c.is_zero(i));
+    if (!c.is_zero(i) && !w.is_zero(i)) {
+      TSpArrayI::value_type c_tile = c.find(i).get();
+      TSpArrayI::value_type w_tile = w.find(i).get();
+      for (std::size_t j = 0ul; j < c_tile.size(); ++j)
+        BOOST_CHECK_EQUAL(w_tile[j], c_tile[j]);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(dot_expr) {
   // Test the dot expression function
   int result = 0;
@@ -2260,4 +2309,101 @@ BOOST_AUTO_TEST_CASE(dot_contr) {
         (a("a,b,c") * b("d,b,c")).dot(b("d,e,f") * a("a,e,f")));
 }
 
+BOOST_AUTO_TEST_CASE(cont_sum) {
+  World& world = *GlobalFixture::world;
+
+  // Matrices with 4x4 tiles of 2x2 elements
+  const std::array<std::size_t, 5> tiling{{0ul, 2ul, 4ul, 6ul, 8ul}};
+  const TiledRange trange({TiledRange1(tiling.begin(), tiling.end()),
+                           TiledRange1(tiling.begin(), tiling.end())});
+
+  // Make a matrix where each element of tile (i,j) is value(i,j), and tiles
+  // with a zero value are zero tiles
+  auto make_tiled_matrix = [&](const std::function<double(std::size_t, std::size_t)>& value) {
+    Tensor<float> norms(trange.tiles_range(), 0.0f);
+    for (std::size_t i = 0ul; i < 4ul; ++i)
+      for (std::size_t j = 0ul; j < 4ul; ++j)
+        norms[i * 4ul + j] = 2.0f * float(std::abs(value(i, j)));
+    TSpArrayD matrix(world, trange, SparseShape<float>(norms, trange));
+    for (const auto index : *matrix.pmap()) {
+      if (!matrix.is_zero(index)) {
+        const auto tile = trange.tiles_range().idx(index);
+        matrix.set(index, TSpArrayD::element_type(value(tile[0], tile[1])));
+      }
+    }
+    return matrix;
+  };
+
+  // The first contraction is non-zero everywhere
+  TSpArrayD x = make_tiled_matrix(
+      [](std::size_t, std::size_t) { return 1.0; });
+  // The products of z and w are negligible, so the contraction shape is zero
+  // although z and w are not
+  TSpArrayD z = make_tiled_matrix(
+      [](std::size_t i, std::size_t) { return (i == 0ul ? 1.0e-4 : 0.0); });
+  // The third contraction has no tile pairs in rows 0 and 1
+  TSpArrayD p = make_tiled_matrix(
+      [](std::size_t i, std::size_t) { return (i < 2ul ? 0.0 : double(i)); });
+  // The last contraction has no tile pairs at all
+  TSpArrayD e = make_tiled_matrix(
+      [](std::size_t, std::size_t) { return 0.0; });
+  world.gop.fence();
+
+  TSpArrayD zz;
+  zz("i,j") = z("i,k") * z("k,j");
+  for (std::size_t i = 0ul; i < zz.size(); ++i)
+    BOOST_REQUIRE(zz.is_zero(i));
+  BOOST_REQUIRE(!z.is_zero(0ul));
+
+  // Evaluate the sum term by term
+  const bool fused = expressions::fused_sum_contractions();
+  expressions::fused_sum_contractions() = false;
+  TSpArrayD ref;
+  ref("i,j") = x("i,k") * x("k,j") + z("i,k") * z("k,j") +
+               p("i,k") * x("k,j") - e("i,k") * x("k,j");
+
+  // Accumulate the contractions into the result tiles of the first one, with
+  // the default result distribution and with a result distribution that
+  // differs from the process grid of the contractions
+  expressions::fused_sum_contractions() = true;
+  TSpArrayD r1;
+  TSpArrayD r2(world, trange, ref.shape(),
+               std::make_shared<detail::BlockedPmap>(
+                   world, trange.tiles_range().volume()));
+  BOOST_CHECK_NO_THROW(r1("i,j") = x("i,k") * x("k,j") + z("i,k") * z("k,j") +
+                                   p("i,k") * x("k,j") - e("i,k") * x("k,j"));
+  BOOST_CHECK_NO_THROW(r2("i,j") = x("i,k") * x("k,j") + z("i,k") * z("k,j") +
+                                   p("i,k") * x("k,j") - e("i,k") * x("k,j"));
+  expressions::fused_sum_contractions() = fused;
+
+  for (std::size_t i = 0ul; i < ref.size(); ++i) {
+    BOOST_CHECK(!ref.is_zero(i));
+    BOOST_CHECK_EQUAL(r1.is_zero(i), ref.is_zero(i));
+    BOOST_CHECK_EQUAL(r2.is_zero(i), ref.is_zero(i));
+    if (ref.is_zero(i)) continue;
+
+    const TSpArrayD::value_type ref_tile = ref.find(i).get();
+    if (r1.is_local(i) && !r1.is_zero(i)) {
+      const TSpArrayD::value_type tile = r1.find(i).get();
+      for (std::size_t j = 0ul; j < ref_tile.size(); ++j)
+        BOOST_CHECK_EQUAL(tile[j], ref_tile[j]);
+    }
+    if (r2.is_local(i) && !r2.is_zero(i)) {
+      const TSpArrayD::value_type tile = r2.find(i).get();
+      for (std::size_t j = 0ul; j < ref_tile.size(); ++j)
+        BOOST_CHECK_EQUAL(tile[j], ref_tile[j]);
+    }
+  }
+
+  // Row 0 holds only the first contraction, as the products of z are
+  // screened out of the sum
+  for (std::size_t j = 0ul; j < 4ul; ++j) {
+    if (r1.is_local(j)) {
+      const TSpArrayD::value_type tile = r1.find(j).get();
+      for (std::size_t k = 0ul; k < tile.size(); ++k)
+        BOOST_CHECK_EQUAL(tile[k], 8.0);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,183 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  hierarchical_group.cpp
+ *  Jun 14, 2018
+ *
+ */
+
+#include "TiledArray/hierarchical_group.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+
+using namespace TiledArray;
+using TiledArray::detail::NodeMap;
+using TiledArray::detail::HierarchicalGroup;
+
+struct HierarchicalGroupFixture {
+
+  // Simulate 10 processes on 4 nodes with 3, 3, 3, and 1 processes
+  HierarchicalGroupFixture() : node_map(NodeMap::block(10, 3)) { }
+
+  ~HierarchicalGroupFixture() { }
+
+  NodeMap node_map;
+}; // HierarchicalGroupFixture
+
+BOOST_FIXTURE_TEST_SUITE( hierarchical_group_suite, HierarchicalGroupFixture )
+
+BOOST_AUTO_TEST_CASE( constructor )
+{
+  BOOST_CHECK_EQUAL(node_map.size(), 10);
+  BOOST_CHECK_EQUAL(node_map.nodes(), 4);
+  for(ProcessID p = 0; p < node_map.size(); ++p)
+    BOOST_CHECK_EQUAL(node_map.node(p), p / 3);
+  BOOST_CHECK(node_map.is_hierarchical());
+
+  // Check that nodes are numbered in order of their first process
+  NodeMap labeled(std::vector<std::string>{ "b", "a", "b", "c", "a" });
+  BOOST_CHECK_EQUAL(labeled.size(), 5);
+  BOOST_CHECK_EQUAL(labeled.nodes(), 3);
+  BOOST_CHECK_EQUAL(labeled.node(0), 0);
+  BOOST_CHECK_EQUAL(labeled.node(1), 1);
+  BOOST_CHECK_EQUAL(labeled.node(2), 0);
+  BOOST_CHECK_EQUAL(labeled.node(3), 2);
+  BOOST_CHECK_EQUAL(labeled.node(4), 1);
+
+  // Check that one process per node, or one node, is not hierarchical
+  BOOST_CHECK(! NodeMap::block(10, 1).is_hierarchical());
+  BOOST_CHECK(! NodeMap::block(10, 10).is_hierarchical());
+}
+
+BOOST_AUTO_TEST_CASE( node_map_instance )
+{
+  World& world = * GlobalFixture::world;
+
+  // Check that the node map is set up by TiledArray::initialize
+  std::shared_ptr<const NodeMap> default_map = NodeMap::instance(world);
+  BOOST_REQUIRE(default_map);
+  BOOST_CHECK_EQUAL(default_map->size(), world.size());
+  BOOST_CHECK_EQUAL(NodeMap::instance(world), default_map);
+  NodeMap::setup(world);
+  BOOST_CHECK_EQUAL(NodeMap::instance(world), default_map);
+
+  // Check that a node map can be set to simulate node boundaries
+  std::shared_ptr<const NodeMap> split =
+      std::make_shared<const NodeMap>(NodeMap::block(world.size(), 1));
+  NodeMap::instance(world, split);
+  BOOST_CHECK_EQUAL(NodeMap::instance(world), split);
+  NodeMap::instance(world, default_map);
+  BOOST_CHECK_EQUAL(NodeMap::instance(world), default_map);
+}
+
+BOOST_AUTO_TEST_CASE( partition )
+{
+  // Group members on all nodes, with the root on node 1
+  const std::vector<ProcessID> members = { 0, 2, 3, 4, 5, 7, 8, 9 };
+  const ProcessID root = 4;
+
+  // The root leads node 1, and the first member leads the other nodes
+  const std::vector<ProcessID> expected_leaders = { 0, 4, 7, 9 };
+
+  std::vector<ProcessID> leaders, local;
+  for(ProcessID p : members) {
+    HierarchicalGroup::partition(node_map, members, root, p, leaders, local);
+    BOOST_CHECK_EQUAL_COLLECTIONS(leaders.begin(), leaders.end(),
+        expected_leaders.begin(), expected_leaders.end());
+
+    std::vector<ProcessID> expected;
+    for(ProcessID q : members)
+      if(node_map.node(q) == node_map.node(p))
+        expected.push_back(q);
+    BOOST_CHECK_EQUAL_COLLECTIONS(local.begin(), local.end(),
+        expected.begin(), expected.end());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( flat_group )
+{
+  World& world = * GlobalFixture::world;
+  std::vector<ProcessID> members;
+  for(ProcessID p = 0; p < world.size(); ++p)
+    members.push_back(p);
+  madness::Group group(world, members, madness::DistributedID(madness::uniqueidT(), 0ul));
+
+  // Check that the original group is used without multiple nodes
+  HierarchicalGroup hgroup(NodeMap::block(world.size(), world.size()), group, 0,
+      madness::DistributedID(madness::uniqueidT(), 1ul),
+      madness::DistributedID(madness::uniqueidT(), 2ul));
+  BOOST_CHECK(! hgroup.is_hierarchical());
+  BOOST_CHECK_EQUAL(hgroup.inter_group().size(), group.size());
+  BOOST_CHECK(hgroup.intra_group().empty());
+
+  // Check that the value is broadcast
+  Future<int> value;
+  if(world.rank() == 0)
+    value.set(42);
+  HierarchicalGroup::reset_saved_bytes();
+  hgroup.bcast(madness::DistributedID(madness::uniqueidT(), 3ul),
+      madness::DistributedID(madness::uniqueidT(), 4ul), value, sizeof(int));
+  BOOST_CHECK_EQUAL(value.get(), 42);
+  BOOST_CHECK_EQUAL(HierarchicalGroup::saved_bytes(), 0ul);
+  world.gop.fence();
+}
+
+BOOST_AUTO_TEST_CASE( hierarchical_group )
+{
+  World& world = * GlobalFixture::world;
+  if(world.size() < 3)
+    return;
+
+  // Place two processes on each node, so the group spans several nodes
+  const NodeMap split = NodeMap::block(world.size(), 2);
+  std::vector<ProcessID> members;
+  for(ProcessID p = 0; p < world.size(); ++p)
+    members.push_back(p);
+  madness::Group group(world, members, madness::DistributedID(madness::uniqueidT(), 10ul));
+
+  const ProcessID root = world.size() - 1;
+  HierarchicalGroup hgroup(split, group, root,
+      madness::DistributedID(madness::uniqueidT(), 11ul),
+      madness::DistributedID(madness::uniqueidT(), 12ul + split.node(world.rank())));
+  BOOST_CHECK(hgroup.is_hierarchical());
+
+  // The root leads its node, and the even processes lead the other nodes
+  const ProcessID node = split.node(world.rank());
+  const ProcessID leader = (node == split.node(root) ? root : 2 * node);
+  BOOST_CHECK_EQUAL(hgroup.inter_group().empty(), world.rank() != leader);
+
+  Future<int> value;
+  if(world.rank() == root)
+    value.set(42);
+  HierarchicalGroup::reset_saved_bytes();
+  hgroup.bcast(madness::DistributedID(madness::uniqueidT(), 20ul),
+      madness::DistributedID(madness::uniqueidT(), 21ul), value, sizeof(int));
+  BOOST_CHECK_EQUAL(value.get(), 42);
+
+  // The root saves one message for each remote process that is not a leader
+  if(world.rank() == root) {
+    const std::size_t remote = world.size() - (world.size() % 2 == 0 ? 2 : 1);
+    const std::size_t remote_nodes = split.nodes() - 1;
+    BOOST_CHECK_EQUAL(HierarchicalGroup::saved_bytes(),
+        (remote - remote_nodes) * sizeof(int));
+  } else {
+    BOOST_CHECK_EQUAL(HierarchicalGroup::saved_bytes(), 0ul);
+  }
+  world.gop.fence();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
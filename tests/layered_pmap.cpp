@@ -0,0 +1,142 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  layered_pmap.cpp
+ *  Jun 4, 2018
+ *
+ */
+
+#include "TiledArray/pmap/layered_pmap.h"
+#include "unit_test_config.h"
+#include "global_fixture.h"
+
+using namespace TiledArray;
+
+struct LayeredPmapFixture {
+
+  LayeredPmapFixture() { }
+
+  /// Compute the process grid of a layer
+  static void proc_grid(const std::size_t layers, const std::size_t x,
+      const std::size_t y, std::size_t& p_rows, std::size_t& p_cols)
+  {
+    const std::size_t layer_procs = GlobalFixture::world->size() / layers;
+    p_rows = std::max<std::size_t>(1ul, std::min<std::size_t>(
+        std::sqrt(layer_procs * x / y), std::min(layer_procs, x)));
+    p_cols = std::max<std::size_t>(1ul, layer_procs / p_rows);
+  }
+
+};
+
+
+// =============================================================================
+// LayeredCyclicPmap Test Suite
+
+
+BOOST_FIXTURE_TEST_SUITE( layered_pmap_suite, LayeredPmapFixture )
+
+BOOST_AUTO_TEST_CASE( constructor )
+{
+  const std::size_t size = GlobalFixture::world->size();
+  for(std::size_t layers = 1ul; layers <= size; ++layers) {
+    std::size_t p_rows = 0ul, p_cols = 0ul;
+    proc_grid(layers, 10ul, 10ul, p_rows, p_cols);
+
+    BOOST_REQUIRE_NO_THROW(TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, 10ul, 10ul, p_rows, p_cols, layers, false));
+    TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, 10ul, 10ul, p_rows, p_cols, layers, true);
+    BOOST_CHECK_EQUAL(pmap.rank(), GlobalFixture::world->rank());
+    BOOST_CHECK_EQUAL(pmap.procs(), size);
+    BOOST_CHECK_EQUAL(pmap.size(), 100ul);
+    BOOST_CHECK_EQUAL(pmap.nlayers(), layers);
+  }
+
+#ifdef TA_EXCEPTION_ERROR
+  BOOST_CHECK_THROW(TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, 10ul, 10ul, 1, 1, 0, false), TiledArray::Exception);
+  BOOST_CHECK_THROW(TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, 10ul, 10ul, 1, 1, size + 1, false), TiledArray::Exception);
+  BOOST_CHECK_THROW(TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, 10ul, 10ul, size + 1, 1, 1, false), TiledArray::Exception);
+#endif // TA_EXCEPTION_ERROR
+}
+
+BOOST_AUTO_TEST_CASE( owner )
+{
+  const std::size_t size = GlobalFixture::world->size();
+
+  for(std::size_t layers = 1ul; layers <= size; ++layers) {
+    const std::size_t layer_procs = size / layers;
+    for(std::size_t x = 1ul; x < 10ul; ++x) {
+      for(std::size_t y = 1ul; y < 10ul; ++y) {
+        std::size_t p_rows = 0ul, p_cols = 0ul;
+        proc_grid(layers, x, y, p_rows, p_cols);
+
+        TiledArray::detail::LayeredCyclicPmap col_pmap(* GlobalFixture::world, x, y, p_rows, p_cols, layers, false);
+        TiledArray::detail::LayeredCyclicPmap row_pmap(* GlobalFixture::world, x, y, p_rows, p_cols, layers, true);
+
+        // Check that the columns or rows are distributed over the layers
+        for(std::size_t i = 0ul; i < x; ++i) {
+          for(std::size_t j = 0ul; j < y; ++j) {
+            const std::size_t tile = i * y + j;
+            BOOST_CHECK_EQUAL(col_pmap.owner(tile), (j % layers) * layer_procs
+                + (i % p_rows) * p_cols + (j / layers) % p_cols);
+            BOOST_CHECK_EQUAL(row_pmap.owner(tile), (i % layers) * layer_procs
+                + ((i / layers) % p_rows) * p_cols + j % p_cols);
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( local_group )
+{
+  ProcessID tile_owners[100];
+
+  for(std::size_t layers = 1ul; layers <= std::size_t(GlobalFixture::world->size()); ++layers) {
+    for(std::size_t x = 1ul; x < 10ul; ++x) {
+      for(std::size_t y = 1ul; y < 10ul; ++y) {
+        std::size_t p_rows = 0ul, p_cols = 0ul;
+        proc_grid(layers, x, y, p_rows, p_cols);
+
+        const std::size_t tiles = x * y;
+        for(int layer_rows = 0; layer_rows < 2; ++layer_rows) {
+          TiledArray::detail::LayeredCyclicPmap pmap(* GlobalFixture::world, x, y, p_rows, p_cols, layers, layer_rows);
+
+          // Check that all local elements map to this rank
+          for(detail::LayeredCyclicPmap::const_iterator it = pmap.begin(); it != pmap.end(); ++it) {
+            BOOST_CHECK_EQUAL(pmap.owner(*it), GlobalFixture::world->rank());
+          }
+
+          // Check that the local elements of all ranks include every tile once
+          std::size_t total_size = pmap.local_size();
+          GlobalFixture::world->gop.sum(total_size);
+          BOOST_CHECK_EQUAL(total_size, tiles);
+
+          std::fill_n(tile_owners, tiles, 0);
+          for(detail::LayeredCyclicPmap::const_iterator it = pmap.begin(); it != pmap.end(); ++it) {
+            tile_owners[*it] += GlobalFixture::world->rank();
+          }
+
+          GlobalFixture::world->gop.sum(tile_owners, tiles);
+          for(std::size_t tile = 0; tile < tiles; ++tile) {
+            BOOST_CHECK_EQUAL(tile_owners[tile], pmap.owner(tile));
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  linear_algebra.cpp
+ *  Aug 8, 2018
+ *
+ */
+
+#include "TiledArray/algebra/cholesky.h"
+#include "TiledArray/algebra/heig.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+
+using namespace TiledArray;
+
+struct LinearAlgebraFixture {
+
+  LinearAlgebraFixture() :
+    n(31ul), trange(make_trange({0, 7, 15, 16, 31}, {0, 7, 15, 16, 31})),
+    rhs_trange(make_trange({0, 7, 15, 16, 31}, {0, 2, 5})),
+    a(make_matrix(trange, [] (std::size_t i, std::size_t j) {
+      return 1.0 / (1.0 + double(i > j ? i - j : j - i)) + (i == j ? 4.0 : 0.0); })),
+    b(make_matrix(rhs_trange, [] (std::size_t i, std::size_t j) {
+      return double((3 * i + 7 * j) % 11) - 5.0; })),
+    reference(to_matrix(a, n, n))
+  { }
+
+  static TiledRange make_trange(std::initializer_list<std::size_t> rows,
+      std::initializer_list<std::size_t> cols)
+  {
+    return TiledRange({ TiledRange1(rows.begin(), rows.end()),
+        TiledRange1(cols.begin(), cols.end()) });
+  }
+
+  template <typename Op>
+  static TArrayD make_matrix(const TiledRange& trange, Op op) {
+    TArrayD array(*GlobalFixture::world, trange);
+    for(auto it = array.pmap()->begin(); it != array.pmap()->end(); ++it) {
+      TArrayD::value_type tile(array.trange().make_tile_range(*it));
+      for(auto idx : tile.range())
+        tile[idx] = op(idx[0], idx[1]);
+      array.set(*it, tile);
+    }
+    return array;
+  }
+
+  /// Gather the full matrix on every rank
+  static Eigen::MatrixXd to_matrix(const TArrayD& array, std::size_t rows,
+      std::size_t cols)
+  {
+    return array_to_eigen_block(array, 0, rows, 0, cols);
+  }
+
+  std::size_t n;
+  TiledRange trange;
+  TiledRange rhs_trange;
+  TArrayD a;
+  TArrayD b;
+  Eigen::MatrixXd reference;
+  static const double tol;
+}; // struct LinearAlgebraFixture
+
+const double LinearAlgebraFixture::tol = 1.0e-10;
+
+BOOST_FIXTURE_TEST_SUITE( linear_algebra_suite, LinearAlgebraFixture )
+
+BOOST_AUTO_TEST_CASE( cholesky_factor )
+{
+  TArrayD l;
+  BOOST_REQUIRE_NO_THROW(l = cholesky(a));
+
+  const Eigen::MatrixXd l_ref = reference.llt().matrixL();
+  const Eigen::MatrixXd result = to_matrix(l, n, n);
+  BOOST_CHECK_SMALL((result - l_ref).norm(), tol);
+
+  // The factor reproduces the matrix
+  TArrayD llt;
+  llt("i,j") = l("i,k") * l("j,k");
+  BOOST_CHECK_SMALL((llt("i,j") - a("i,j")).norm().get(), tol);
+
+#if !defined(TA_USER_ASSERT_DISABLED)
+  BOOST_CHECK_THROW(cholesky(b), TiledArray::Exception);
+
+  // A matrix that is not positive definite is detected on all ranks
+  const TArrayD indefinite = make_matrix(trange, [] (std::size_t i, std::size_t j) {
+      return (i == j ? (i == 20ul ? -1.0 : 1.0) : 0.0); });
+  BOOST_CHECK_THROW(cholesky(indefinite), TiledArray::Exception);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( triangular_solves )
+{
+  const TArrayD l = cholesky(a);
+  const Eigen::MatrixXd l_ref = reference.llt().matrixL();
+  const Eigen::MatrixXd b_ref = to_matrix(b, n, 5);
+
+  TArrayD y;
+  BOOST_REQUIRE_NO_THROW(y = triangular_solve(l, b));
+  BOOST_CHECK_SMALL((l_ref * to_matrix(y, n, 5) - b_ref).norm(), tol);
+
+  TArrayD z;
+  BOOST_REQUIRE_NO_THROW(z = triangular_solve(l, b, true));
+  BOOST_CHECK_SMALL((l_ref.transpose() * to_matrix(z, n, 5) - b_ref).norm(), tol);
+
+  TArrayD x;
+  BOOST_REQUIRE_NO_THROW(x = cholesky_solve(a, b));
+  BOOST_CHECK_SMALL((reference * to_matrix(x, n, 5) - b_ref).norm(), tol);
+}
+
+BOOST_AUTO_TEST_CASE( hermitian_eigensolver )
+{
+  std::vector<double> evals;
+  TArrayD evecs;
+  BOOST_REQUIRE_NO_THROW(std::tie(evals, evecs) = heig(a));
+
+  // Compare the eigenvalues to those of the full matrix
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(reference);
+  BOOST_REQUIRE_EQUAL(evals.size(), n);
+  for(std::size_t i = 0ul; i < n; ++i)
+    BOOST_CHECK_CLOSE(evals[i], solver.eigenvalues()(i), 1.0e-8);
+
+  // Check that the eigenvectors are orthonormal and diagonalize the matrix
+  const Eigen::MatrixXd v = to_matrix(evecs, n, n);
+  BOOST_CHECK_SMALL((v.transpose() * v - Eigen::MatrixXd::Identity(n, n)).norm(), tol);
+  const Eigen::VectorXd lambda = Eigen::Map<const Eigen::VectorXd>(evals.data(), n);
+  BOOST_CHECK_SMALL((reference * v - v * lambda.asDiagonal()).norm(), tol);
+
+  // A single tile is diagonalized directly
+  TArrayD single = make_matrix(make_trange({0, 31}, {0, 31}),
+      [] (std::size_t i, std::size_t j) { return double(i + j); });
+  BOOST_REQUIRE_NO_THROW(std::tie(evals, evecs) = heig(single));
+  const Eigen::MatrixXd s = to_matrix(single, n, n);
+  const Eigen::MatrixXd w = to_matrix(evecs, n, n);
+  BOOST_CHECK(std::is_sorted(evals.begin(), evals.end()));
+  BOOST_CHECK_SMALL((s * w - w * Eigen::Map<const Eigen::VectorXd>(
+      evals.data(), n).asDiagonal()).norm(), 1.0e-9);
+
+  // Small off-diagonal tiles are not neglected, and the zero threshold of
+  // sparse shapes is restored
+  const float threshold = SparseShape<float>::threshold();
+  TArrayD weak = make_matrix(trange, [] (std::size_t i, std::size_t j) {
+      return (i == j ? double(i % 3) : 1.0e-9 / (1.0 + double(i + j))); });
+  BOOST_REQUIRE_NO_THROW(std::tie(evals, evecs) = heig(weak));
+  BOOST_CHECK_EQUAL(SparseShape<float>::threshold(), threshold);
+  const Eigen::MatrixXd weak_ref = to_matrix(weak, n, n);
+  const Eigen::MatrixXd weak_v = to_matrix(evecs, n, n);
+  BOOST_CHECK_SMALL((weak_ref * weak_v - weak_v * Eigen::Map<const Eigen::VectorXd>(
+      evals.data(), n).asDiagonal()).norm(), 1.0e-11);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
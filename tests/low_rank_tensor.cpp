@@ -0,0 +1,234 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  low_rank_tensor.cpp
+ *  Jul 9, 2018
+ *
+ */
+
+#include "TiledArray/low_rank_tensor.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+#include "range_fixture.h"
+
+using namespace TiledArray;
+
+struct LowRankTensorFixture : public TiledRangeFixture {
+  typedef LowRankTensor<double> tile_type;
+  typedef tile_type::dense_type dense_type;
+  typedef tile_type::matrix_type matrix_type;
+
+  LowRankTensorFixture() :
+    a(make_dense(Range(std::vector<std::size_t>{ 8, 6, 10 }), 3)),
+    b(make_dense(Range(std::vector<std::size_t>{ 8, 6, 10 }), 2)),
+    la(a, 0.0, 2u), lb(b, 0.0, 2u)
+  { }
+
+  /// Construct a dense tile with rank \c r
+  static dense_type make_dense(const Range& range, const unsigned int r) {
+    const std::size_t n = range.extent_data()[range.rank() - 1u];
+    const std::size_t m = range.volume() / n;
+    dense_type result(range);
+    math::eigen_map(result.data(), m, n) =
+        matrix_type::Random(m, r) * matrix_type::Random(r, n);
+    return result;
+  }
+
+  static double max_abs_diff(const dense_type& x, const dense_type& y) {
+    BOOST_REQUIRE_EQUAL(x.range(), y.range());
+    double result = 0.0;
+    for(std::size_t i = 0ul; i < x.size(); ++i)
+      result = std::max(result, std::abs(x[i] - y[i]));
+    return result;
+  }
+
+  template <typename Tile>
+  static void fill_low_rank(DistArray<Tile, SparsePolicy>& array) {
+    array.init_tiles([] (const Range& range) {
+      return Tile(make_dense(range, 2u));
+    });
+  }
+
+  dense_type a, b;
+  tile_type la, lb;
+}; // LowRankTensorFixture
+
+BOOST_FIXTURE_TEST_SUITE( low_rank_tensor_suite, LowRankTensorFixture )
+
+BOOST_AUTO_TEST_CASE( constructors )
+{
+  BOOST_CHECK(tile_type().empty());
+
+  // Check that the factored tile has the rank of the dense tile
+  BOOST_CHECK_EQUAL(la.range(), a.range());
+  BOOST_CHECK_EQUAL(la.split(), 2u);
+  BOOST_CHECK_EQUAL(la.rank(), 3ul);
+  BOOST_CHECK_EQUAL(la.u().rows(), 48);
+  BOOST_CHECK_EQUAL(la.v().rows(), 10);
+  BOOST_CHECK_LT(la.u().size() + la.v().size(), Eigen::Index(a.size()));
+  BOOST_CHECK_SMALL(max_abs_diff(la.dense(), a), 1.0e-12);
+
+  // Check the default matricization
+  tile_type l(a);
+  BOOST_CHECK_EQUAL(l.split(), 1u);
+  BOOST_CHECK_SMALL(max_abs_diff(l.dense(), a), 1.0e-12);
+
+  // Check the constant tile
+  tile_type c(a.range(), 2.0);
+  BOOST_CHECK_EQUAL(c.rank(), 1ul);
+  BOOST_CHECK_SMALL(max_abs_diff(c.dense(), dense_type(a.range(), 2.0)), 1.0e-12);
+  BOOST_CHECK_EQUAL(tile_type(a.range(), 0.0).rank(), 0ul);
+
+  // Check that truncation respects the tolerance
+  dense_type noisy = a.clone();
+  for(std::size_t i = 0ul; i < noisy.size(); ++i)
+    noisy[i] += 1.0e-8 * double(i % 7ul);
+  tile_type t(noisy, 1.0e-4, 2u);
+  BOOST_CHECK_LE(t.rank(), 4ul);
+  BOOST_CHECK_LE((t.dense().subt(noisy)).norm(), 1.0e-4);
+}
+
+BOOST_AUTO_TEST_CASE( permute )
+{
+  // Check permutations that keep the row and column dimensions apart
+  for(const Permutation& perm : { Permutation{ 1, 0, 2 }, Permutation{ 1, 2, 0 } }) {
+    const tile_type p = la.permute(perm);
+    BOOST_CHECK_SMALL(max_abs_diff(p.dense(), a.permute(perm)), 1.0e-12);
+    BOOST_CHECK_EQUAL(p.rank(), la.rank());
+  }
+  BOOST_CHECK_EQUAL(la.permute(Permutation{ 1, 2, 0 }).split(), 1u);
+
+  // Check a permutation that mixes the row and column dimensions
+  const Permutation perm{ 0, 2, 1 };
+  BOOST_CHECK_SMALL(max_abs_diff(la.permute(perm).dense(), a.permute(perm)), 1.0e-12);
+}
+
+BOOST_AUTO_TEST_CASE( arithmetic )
+{
+  BOOST_CHECK_SMALL(max_abs_diff(la.add(lb).dense(), a.add(b)), 1.0e-12);
+  BOOST_CHECK_EQUAL(la.add(la).rank(), 3ul);
+  BOOST_CHECK_SMALL(max_abs_diff(la.add(lb, 2.0).dense(), a.add(b, 2.0)), 1.0e-12);
+  BOOST_CHECK_SMALL(max_abs_diff(la.subt(lb).dense(), a.subt(b)), 1.0e-12);
+  BOOST_CHECK_SMALL(max_abs_diff(la.subt(1.5).dense(), a.subt(1.5)), 1.0e-12);
+  BOOST_CHECK_SMALL(max_abs_diff(la.mult(lb).dense(), a.mult(b)), 1.0e-12);
+  BOOST_CHECK_LE(la.mult(lb).rank(), 6ul);
+  BOOST_CHECK_SMALL(max_abs_diff(la.scale(3.0).dense(), a.scale(3.0)), 1.0e-12);
+  BOOST_CHECK_SMALL(max_abs_diff(la.neg().dense(), a.neg()), 1.0e-12);
+
+  // Check that in-place operations do not modify copies
+  tile_type c = la;
+  c.subt_to(la);
+  BOOST_CHECK_EQUAL(c.rank(), 0ul);
+  BOOST_CHECK_SMALL(c.norm(), 1.0e-12);
+  BOOST_CHECK_SMALL(max_abs_diff(la.dense(), a), 1.0e-12);
+
+  // Check a different matricization of the right-hand argument
+  const tile_type lb1(b, 0.0, 1u);
+  BOOST_CHECK_SMALL(max_abs_diff(la.add(lb1).dense(), a.add(b)), 1.0e-12);
+  BOOST_CHECK_EQUAL(la.add(lb1).split(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE( reductions )
+{
+  BOOST_CHECK_CLOSE(la.sum(), a.sum(), 1.0e-8);
+  BOOST_CHECK_CLOSE(la.squared_norm(), a.squared_norm(), 1.0e-8);
+  BOOST_CHECK_CLOSE(la.norm(), a.norm(), 1.0e-8);
+  BOOST_CHECK_CLOSE(la.dot(lb), a.dot(b), 1.0e-8);
+  BOOST_CHECK_CLOSE(la.abs_max(), a.abs_max(), 1.0e-8);
+}
+
+BOOST_AUTO_TEST_CASE( gemm )
+{
+  // c[i,j,k] = a[i,j,l] * b[k,l]
+  const dense_type r = make_dense(Range(std::vector<std::size_t>{ 7, 10 }), 2);
+  const tile_type lr(r, 0.0, 1u);
+  math::GemmHelper gemm_helper(madness::cblas::NoTrans, madness::cblas::Trans,
+      3u, 3u, 2u);
+  const dense_type c = a.gemm(r, 0.5, gemm_helper);
+  tile_type lc = la.gemm(lr, 0.5, gemm_helper);
+  BOOST_CHECK_EQUAL(lc.range(), c.range());
+  BOOST_CHECK_LE(lc.rank(), 2ul);
+  BOOST_CHECK_SMALL(max_abs_diff(lc.dense(), c), 1.0e-12);
+
+  // Check accumulation
+  lc.gemm(la, lr, 0.5, gemm_helper);
+  BOOST_CHECK_LE(lc.rank(), 2ul);
+  BOOST_CHECK_SMALL(max_abs_diff(lc.dense(), c.scale(2.0)), 1.0e-12);
+
+  // c[k,l] = a[i,j,k] * b[i,j,l]
+  math::GemmHelper inner_helper(madness::cblas::Trans, madness::cblas::NoTrans,
+      2u, 3u, 3u);
+  BOOST_CHECK_SMALL(max_abs_diff(la.gemm(lb, 1.0, inner_helper).dense(),
+      a.gemm(b, 1.0, inner_helper)), 1.0e-10);
+
+  // c[i,l] = a[i,j,k] * d[j,k,l], which requires new matricizations
+  const dense_type d = make_dense(Range(std::vector<std::size_t>{ 6, 10, 5 }), 2);
+  math::GemmHelper split_helper(madness::cblas::NoTrans, madness::cblas::NoTrans,
+      2u, 3u, 3u);
+  BOOST_CHECK_SMALL(max_abs_diff(la.gemm(tile_type(d, 0.0, 1u), 1.0,
+      split_helper).dense(), a.gemm(d, 1.0, split_helper)), 1.0e-10);
+}
+
+BOOST_AUTO_TEST_CASE( serialization )
+{
+  std::vector<unsigned char> buffer;
+  {
+    madness::archive::VectorOutputArchive oar(buffer);
+    oar & la & tile_type();
+  }
+
+  tile_type t, e = la;
+  madness::archive::VectorInputArchive iar(buffer);
+  iar & t & e;
+  BOOST_CHECK(e.empty());
+  BOOST_CHECK_EQUAL(t.split(), la.split());
+  BOOST_CHECK_EQUAL(t.rank(), la.rank());
+  BOOST_CHECK_SMALL(max_abs_diff(t.dense(), a), 1.0e-12);
+}
+
+BOOST_AUTO_TEST_CASE( contraction )
+{
+  World& world = * GlobalFixture::world;
+  const TiledRange trange = { tr1, tr1 };
+  DistArray<tile_type, SparsePolicy> x(world, trange), y(world, trange), z;
+  fill_low_rank(x);
+  fill_low_rank(y);
+
+  // Reference contraction with dense tiles
+  auto to_dense = [] (const tile_type& tile) { return tile.dense(); };
+  TSpArrayD dx = to_new_tile_type(x, to_dense);
+  TSpArrayD dy = to_new_tile_type(y, to_dense);
+  TSpArrayD dz;
+  dz("i,j") = dx("i,k") * dy("k,j");
+
+  z("i,j") = 2.0 * (x("i,k") * y("k,j")) - x("i,k") * y("k,j");
+  TSpArrayD rz = to_new_tile_type(z, to_dense);
+  BOOST_CHECK_SMALL((rz("i,j") - dz("i,j")).norm().get(), 1.0e-8);
+
+  // Check that the result tiles are low rank
+  for(auto it = z.begin(); it != z.end(); ++it)
+    BOOST_CHECK_LE(it->get().rank(), 2ul);
+
+  // Check the transposed contraction and the norms used by the shape
+  z("i,j") = x("k,i") * y("j,k");
+  dz("i,j") = dx("k,i") * dy("j,k");
+  rz = to_new_tile_type(z, to_dense);
+  BOOST_CHECK_SMALL((rz("i,j") - dz("i,j")).norm().get(), 1.0e-8);
+  BOOST_CHECK_CLOSE(z("i,j").norm().get(), dz("i,j").norm().get(), 1.0e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2015  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  math_parallel_gemm.cpp
+ *  Apr 29, 2015
+ *
+ */
+
+#include "TiledArray/math/parallel_gemm.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+
+struct ParallelGemmFixture {
+
+  ParallelGemmFixture() :
+    m(37), n(53), k(71),
+    threshold(TiledArray::math::ParallelGemmParams::threshold()),
+    block_size(TiledArray::math::ParallelGemmParams::block_size())
+  {
+    // Use small blocks so that all boundary cases are exercised
+    TiledArray::math::ParallelGemmParams::threshold() = 0ul;
+    TiledArray::math::ParallelGemmParams::block_size() = 16;
+  }
+
+  ~ParallelGemmFixture() {
+    TiledArray::math::ParallelGemmParams::threshold() = threshold;
+    TiledArray::math::ParallelGemmParams::block_size() = block_size;
+  }
+
+
+  template <typename T>
+  static void rand_fill(T* first, const std::size_t n, const int seed = 23, const T max = 101) {
+    GlobalFixture::world->srand(seed);
+    for(std::size_t i = 0ul; i < n; ++i)
+      first[i] = GlobalFixture::world->rand() % int(max);
+  }
+
+  /// Compare parallel_gemm to gemm for the given matrix operations
+  template <typename T>
+  void check_gemm(const madness::cblas::CBLAS_TRANSPOSE op_a,
+      const madness::cblas::CBLAS_TRANSPOSE op_b, const T beta) const
+  {
+    const integer lda = (op_a == madness::cblas::NoTrans ? k : m) + 3;
+    const integer ldb = (op_b == madness::cblas::NoTrans ? n : k) + 5;
+    const integer ldc = n + 7;
+
+    std::vector<T> a(lda * std::max(m, k)), b(ldb * std::max(n, k)),
+        c(ldc * m), c_ref;
+    rand_fill(a.data(), a.size(), 29);
+    rand_fill(b.data(), b.size(), 47);
+    rand_fill(c.data(), c.size(), 99);
+    c_ref = c;
+
+    TiledArray::math::gemm(op_a, op_b, m, n, k, T(3), a.data(), lda,
+        b.data(), ldb, beta, c_ref.data(), ldc);
+    BOOST_REQUIRE_NO_THROW(TiledArray::math::parallel_gemm(op_a, op_b, m, n,
+        k, T(3), a.data(), lda, b.data(), ldb, beta, c.data(), ldc));
+
+    for(integer i = 0; i < m; ++i)
+      for(integer j = 0; j < n; ++j)
+        BOOST_CHECK_CLOSE(double(c[i * ldc + j]), double(c_ref[i * ldc + j]), tol);
+  }
+
+  integer m, n, k;
+  std::size_t threshold;
+  integer block_size;
+  static const double tol;
+
+}; // ParallelGemmFixture
+
+const double ParallelGemmFixture::tol = 0.001;
+
+BOOST_FIXTURE_TEST_SUITE( parallel_gemm_suite, ParallelGemmFixture )
+
+typedef boost::mpl::list<int, float, double> gemm_types;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( gemm_nn , T, gemm_types )
+{
+  check_gemm<T>(madness::cblas::NoTrans, madness::cblas::NoTrans, T(0));
+  check_gemm<T>(madness::cblas::NoTrans, madness::cblas::NoTrans, T(2));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( gemm_nt , T, gemm_types )
+{
+  check_gemm<T>(madness::cblas::NoTrans, madness::cblas::Trans, T(0));
+  check_gemm<T>(madness::cblas::NoTrans, madness::cblas::Trans, T(2));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( gemm_tn , T, gemm_types )
+{
+  check_gemm<T>(madness::cblas::Trans, madness::cblas::NoTrans, T(0));
+  check_gemm<T>(madness::cblas::Trans, madness::cblas::NoTrans, T(2));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( gemm_tt , T, gemm_types )
+{
+  check_gemm<T>(madness::cblas::Trans, madness::cblas::Trans, T(0));
+  check_gemm<T>(madness::cblas::Trans, madness::cblas::Trans, T(2));
+}
+
+BOOST_AUTO_TEST_CASE( small_gemm )
+{
+  // Matrices smaller than one block fall back to serial gemm
+  m = 5; n = 7; k = 3;
+  check_gemm<double>(madness::cblas::NoTrans, madness::cblas::Trans, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE( mixed_gemm )
+{
+  // Single precision arguments are accumulated in double precision, so the
+  // result matches double precision gemm of the promoted arguments.
+  const madness::cblas::CBLAS_TRANSPOSE ops[] = { madness::cblas::NoTrans,
+      madness::cblas::Trans };
+  for(const auto op_a : ops) {
+    for(const auto op_b : ops) {
+      const integer lda = (op_a == madness::cblas::NoTrans ? k : m);
+      const integer ldb = (op_b == madness::cblas::NoTrans ? n : k);
+      std::vector<float> a(lda * std::max(m, k)), b(ldb * std::max(n, k));
+      for(std::size_t i = 0ul; i < a.size(); ++i)
+        a[i] = 1.0f / float(i % 13ul + 1ul);
+      for(std::size_t i = 0ul; i < b.size(); ++i)
+        b[i] = 1.0f / float(i % 7ul + 3ul);
+      const std::vector<double> ad(a.begin(), a.end()), bd(b.begin(), b.end());
+
+      std::vector<double> c(m * n, 1.0), c_serial(c), c_ref(c);
+      TiledArray::math::gemm(op_a, op_b, m, n, k, 2.0, ad.data(), lda,
+          bd.data(), ldb, 0.5, c_ref.data(), n);
+      TiledArray::math::gemm(op_a, op_b, m, n, k, 2.0, a.data(), lda,
+          b.data(), ldb, 0.5, c_serial.data(), n);
+      BOOST_REQUIRE_NO_THROW(TiledArray::math::parallel_gemm(op_a, op_b, m, n,
+          k, 2.0, a.data(), lda, b.data(), ldb, 0.5, c.data(), n));
+
+      for(std::size_t i = 0ul; i < c.size(); ++i) {
+        BOOST_CHECK_CLOSE(c_serial[i], c_ref[i], 1.0e-12);
+        BOOST_CHECK_CLOSE(c[i], c_ref[i], 1.0e-12);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( selection )
+{
+  // Tile contractions use the multithreaded GEMM only when it is selected
+  TiledArray::math::GemmHelper gemm_helper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u);
+  BOOST_CHECK(! gemm_helper.parallel());
+  gemm_helper.parallel(true);
+  BOOST_CHECK(gemm_helper.parallel());
+  TiledArray::math::GemmHelper copy(gemm_helper);
+  BOOST_CHECK(copy.parallel());
+
+  // Only one multithreaded GEMM runs at a time
+  BOOST_REQUIRE(TiledArray::math::detail::acquire_parallel_gemm());
+  BOOST_CHECK(! TiledArray::math::detail::acquire_parallel_gemm());
+
+  // A nested call falls back to the serial GEMM
+  check_gemm<double>(madness::cblas::NoTrans, madness::cblas::NoTrans, 2.0);
+
+  TiledArray::math::detail::release_parallel_gemm();
+  BOOST_CHECK(TiledArray::math::detail::acquire_parallel_gemm());
+  TiledArray::math::detail::release_parallel_gemm();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
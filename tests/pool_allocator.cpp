@@ -0,0 +1,199 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  pool_allocator.cpp
+ *  Jun 13, 2018
+ *
+ */
+
+#include "TiledArray/pool_allocator.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+
+using namespace TiledArray;
+
+struct PoolAllocatorFixture {
+  typedef detail::MemoryPool::size_type size_type;
+  typedef Tensor<double, pool_allocator<double> > tile_type;
+
+  PoolAllocatorFixture() : pool(detail::MemoryPool::instance()) {
+    pool.release();
+  }
+
+  ~PoolAllocatorFixture() { }
+
+  static bool is_aligned(const void* p, const size_type alignment) {
+    return (reinterpret_cast<std::uintptr_t>(p) % alignment) == 0ul;
+  }
+
+  detail::MemoryPool& pool;
+};
+
+BOOST_FIXTURE_TEST_SUITE( pool_allocator_suite , PoolAllocatorFixture )
+
+BOOST_AUTO_TEST_CASE( size_class )
+{
+  const size_type min_block_size = detail::MemoryPool::min_block_size;
+  const size_type max_block_size = detail::MemoryPool::max_block_size;
+  const unsigned int num_classes = detail::MemoryPool::num_classes;
+
+  BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(1ul), 0u);
+  BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(min_block_size), 0u);
+  BOOST_CHECK_EQUAL(detail::MemoryPool::class_size(0u), min_block_size);
+  BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(max_block_size), num_classes - 1u);
+  BOOST_CHECK_EQUAL(detail::MemoryPool::class_size(num_classes - 1u), max_block_size);
+  BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(max_block_size + 1ul), num_classes);
+
+  // Check that size classes are increasing, and that each size is in the
+  // smallest class that holds it
+  for(unsigned int c = 1u; c < num_classes; ++c) {
+    const size_type size = detail::MemoryPool::class_size(c);
+    const size_type prev_size = detail::MemoryPool::class_size(c - 1u);
+    BOOST_CHECK_LT(prev_size, size);
+    BOOST_CHECK_LE(size, prev_size + prev_size / 4ul);
+    BOOST_CHECK_EQUAL(size % 16ul, 0ul);
+    BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(size), c);
+    BOOST_CHECK_EQUAL(detail::MemoryPool::size_class(prev_size + 1ul), c);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( allocate )
+{
+  const size_type bytes = pool.bytes();
+  const size_type misses = pool.misses();
+
+  // Check that zero size allocations return null
+  BOOST_CHECK_EQUAL(pool.allocate(0ul), static_cast<void*>(nullptr));
+
+  // Check that blocks are aligned and counted
+  void* block = pool.allocate(100ul);
+  BOOST_REQUIRE(block);
+  BOOST_CHECK(is_aligned(block, detail::MemoryPool::alignment));
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes + 112ul);
+  BOOST_CHECK_GE(pool.high_water_mark(), bytes + 112ul);
+  BOOST_CHECK_EQUAL(pool.misses(), misses + 1ul);
+
+  // Check that deallocated blocks are reused by requests of the same class
+  pool.deallocate(block, 100ul);
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes);
+  BOOST_CHECK_GE(pool.cached_bytes(), 112ul);
+  const size_type hits = pool.hits();
+  void* other = pool.allocate(112ul);
+  BOOST_CHECK_EQUAL(other, block);
+  BOOST_CHECK_EQUAL(pool.hits(), hits + 1ul);
+  BOOST_CHECK_EQUAL(pool.misses(), misses + 1ul);
+  pool.deallocate(other, 112ul);
+
+  // Check that large blocks are aligned to huge pages
+  const size_type huge_page_size = detail::MemoryPool::huge_page_size;
+  void* huge = pool.allocate(3ul * huge_page_size);
+  BOOST_REQUIRE(huge);
+  BOOST_CHECK(is_aligned(huge, huge_page_size));
+  pool.deallocate(huge, 3ul * huge_page_size);
+
+  // Check that release returns the cached blocks to the system
+  pool.release();
+  BOOST_CHECK_EQUAL(pool.cached_bytes(), 0ul);
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes);
+}
+
+BOOST_AUTO_TEST_CASE( high_water_mark )
+{
+  pool.reset_high_water_mark();
+  const size_type bytes = pool.bytes();
+  BOOST_CHECK_EQUAL(pool.high_water_mark(), bytes);
+
+  std::vector<void*> blocks;
+  for(unsigned int i = 0u; i < 10u; ++i)
+    blocks.push_back(pool.allocate(1024ul));
+  for(void* block : blocks)
+    pool.deallocate(block, 1024ul);
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes);
+  BOOST_CHECK_EQUAL(pool.high_water_mark(), bytes + 10ul * 1024ul);
+
+  pool.reset_high_water_mark();
+  BOOST_CHECK_EQUAL(pool.high_water_mark(), bytes);
+}
+
+BOOST_AUTO_TEST_CASE( allocator )
+{
+  pool_allocator<double> a;
+  pool_allocator<int> b(a);
+  BOOST_CHECK(a == b);
+  BOOST_CHECK(! (a != b));
+  BOOST_CHECK_EQUAL(& pool_allocator<double>::pool(), & pool);
+
+  const size_type bytes = pool.bytes();
+  double* p = a.allocate(10ul);
+  BOOST_REQUIRE(p);
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes + 80ul);
+  std::fill_n(p, 10ul, 1.0);
+  a.deallocate(p, 10ul);
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes);
+
+  // Check that the allocator works with standard containers
+  std::vector<double, pool_allocator<double> > v(1000ul, 2.0);
+  BOOST_CHECK_EQUAL(v.size(), 1000ul);
+  BOOST_CHECK_EQUAL(v[999], 2.0);
+}
+
+BOOST_AUTO_TEST_CASE( tensor )
+{
+  const size_type bytes = pool.bytes();
+  const size_type block_size =
+      detail::MemoryPool::class_size(detail::MemoryPool::size_class(800ul));
+  {
+    tile_type t(Range(10, 10), 1.0);
+    BOOST_CHECK(is_aligned(t.data(), detail::MemoryPool::alignment));
+    BOOST_CHECK_EQUAL(pool.bytes(), bytes + block_size);
+
+    tile_type s = t.scale(2.0);
+    BOOST_CHECK_EQUAL(pool.bytes(), bytes + 2ul * block_size);
+    for(std::size_t i = 0ul; i < s.size(); ++i)
+      BOOST_CHECK_EQUAL(s[i], 2.0);
+
+    tile_type r = t.gemm(s, 1.0, math::GemmHelper(madness::cblas::NoTrans,
+        madness::cblas::NoTrans, 2u, 2u, 2u));
+    for(std::size_t i = 0ul; i < r.size(); ++i)
+      BOOST_CHECK_EQUAL(r[i], 20.0);
+  }
+  BOOST_CHECK_EQUAL(pool.bytes(), bytes);
+}
+
+BOOST_AUTO_TEST_CASE( dist_array )
+{
+  TiledArray::World& world = * GlobalFixture::world;
+  std::vector<std::size_t> blocking = { 0ul, 5ul, 10ul };
+  std::vector<TiledRange1> blocking2(2, TiledRange1(blocking.begin(), blocking.end()));
+  TiledRange trange(blocking2.begin(), blocking2.end());
+
+  DistArray<tile_type> a(world, trange);
+  DistArray<tile_type> b(world, trange);
+  a.fill(1.0);
+  b.fill(1.0);
+
+  DistArray<tile_type> c;
+  c("i,j") = a("i,k") * b("k,j");
+  for(auto it = c.begin(); it != c.end(); ++it) {
+    const tile_type tile = it->get();
+    for(std::size_t i = 0ul; i < tile.size(); ++i)
+      BOOST_CHECK_EQUAL(tile[i], 10.0);
+  }
+  world.gop.fence();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -154,6 +154,58 @@ BOOST_AUTO_TEST_CASE( random_constructor_test )
   }
 }
 
+BOOST_AUTO_TEST_CASE( layered_constructor_test )
+{
+  GlobalFixture::world->srand(time(NULL));
+
+  for(int test = 0; test < 100; ++test) {
+
+    // Generate random process and matrix sizes
+    const ProcessID nprocs = GlobalFixture::world->rand() % 4095 + 1;
+    const std::size_t layers = GlobalFixture::world->rand() % std::min(nprocs, 16) + 1;
+    const std::size_t rows = GlobalFixture::world->rand() % 1023 + 1;
+    const std::size_t cols = GlobalFixture::world->rand() % 1023 + 1;
+    const std::size_t row_size = rows * ((GlobalFixture::world->rand() % 511) + 1);
+    const std::size_t col_size = cols * ((GlobalFixture::world->rand() % 512) + 1);
+    const std::size_t layer_procs = nprocs / layers;
+
+    // Each layer has the same grid as a 2D grid with nprocs / layers processes
+    TiledArray::detail::ProcGrid layer_grid(*GlobalFixture::world, 0,
+        layer_procs, rows, cols, row_size, col_size);
+
+    std::size_t local_size = 0ul;
+    for(ProcessID rank = 0; rank < nprocs; ++rank) {
+      TiledArray::detail::ProcGrid proc_grid(*GlobalFixture::world, rank, nprocs,
+          rows, cols, row_size, col_size, layers);
+
+      // Check process grid dimensions
+      BOOST_CHECK_EQUAL(proc_grid.layers(), layers);
+      BOOST_CHECK_EQUAL(proc_grid.proc_rows(), layer_grid.proc_rows());
+      BOOST_CHECK_EQUAL(proc_grid.proc_cols(), layer_grid.proc_cols());
+      BOOST_CHECK_EQUAL(proc_grid.proc_size(), layer_grid.proc_size());
+
+      // Check process grid rank
+      const std::size_t layer_rank = rank % layer_procs;
+      if((std::size_t(rank) < (layers * layer_procs)) && (layer_rank < proc_grid.proc_size())) {
+        BOOST_CHECK_EQUAL(proc_grid.rank_layer(), ProcessID(rank / layer_procs));
+        BOOST_CHECK_EQUAL(proc_grid.rank_row(), ProcessID(layer_rank / proc_grid.proc_cols()));
+        BOOST_CHECK_EQUAL(proc_grid.rank_col(), ProcessID(layer_rank % proc_grid.proc_cols()));
+        BOOST_CHECK_EQUAL(proc_grid.map_layer(proc_grid.rank_layer()), rank);
+        BOOST_CHECK_EQUAL(proc_grid.map_row(proc_grid.rank_row()), rank);
+        BOOST_CHECK_EQUAL(proc_grid.map_col(proc_grid.rank_col()), rank);
+      } else {
+        BOOST_CHECK_EQUAL(proc_grid.rank_layer(), -1);
+        BOOST_CHECK_EQUAL(proc_grid.local_size(), 0ul);
+      }
+
+      local_size += proc_grid.local_size();
+    }
+
+    // Check that each layer includes all elements
+    BOOST_CHECK_EQUAL(local_size, rows * cols * layers);
+  }
+}
+
 BOOST_AUTO_TEST_CASE( make_groups )
 {
   madness::DistributedID did_row(madness::uniqueidT(), 0);
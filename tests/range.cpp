@@ -372,4 +372,59 @@ BOOST_AUTO_TEST_CASE( swap )
   BOOST_CHECK_EQUAL(r.volume(), volume);
 }
 
+BOOST_AUTO_TEST_CASE( inline_storage )
+{
+  auto make_range = [] (const unsigned int n) {
+    std::vector<std::size_t> lobound(n), upbound(n);
+    for(unsigned int d = 0u; d < n; ++d) {
+      lobound[d] = d;
+      upbound[d] = 2u * d + 3u;
+    }
+    return Range(lobound, upbound);
+  };
+
+  for(unsigned int n = 1u; n <= Range::inline_rank + 2u; ++n) {
+    Range r1 = make_range(n);
+
+    // Check that only ranges with a rank larger than inline_rank allocate
+    // memory for their data
+    const char* first = reinterpret_cast<const char*>(& r1);
+    const char* data = reinterpret_cast<const char*>(r1.lobound_data());
+    BOOST_CHECK_EQUAL((data >= first) && (data < (first + sizeof(Range))),
+        n <= Range::inline_rank);
+
+    // Check copy and move semantics
+    Range r2(r1);
+    BOOST_CHECK_EQUAL(r2, r1);
+    BOOST_CHECK(r2.lobound_data() != r1.lobound_data());
+    Range r3(std::move(r2));
+    BOOST_CHECK_EQUAL(r3, r1);
+    BOOST_CHECK_EQUAL(r2.rank(), 0u);
+    BOOST_CHECK(r2.lobound_data() == nullptr);
+    r2 = std::move(r3);
+    BOOST_CHECK_EQUAL(r2, r1);
+    BOOST_CHECK_EQUAL(r3.rank(), 0u);
+    r3 = r2;
+    BOOST_CHECK_EQUAL(r3, r1);
+
+    // Check swap of ranges with inline and allocated data
+    Range other = make_range(n <= Range::inline_rank ? Range::inline_rank + 1u : 1u);
+    const Range other_copy(other);
+    r3.swap(other);
+    BOOST_CHECK_EQUAL(r3, other_copy);
+    BOOST_CHECK_EQUAL(other, r1);
+
+    // Check permutation
+    std::vector<unsigned int> p(n);
+    for(unsigned int d = 0u; d < n; ++d)
+      p[d] = n - d - 1u;
+    const Permutation perm(p);
+    Range r4(r1);
+    r4 *= perm;
+    BOOST_CHECK_EQUAL(r4, perm * r1);
+    for(unsigned int d = 0u; d < n; ++d)
+      BOOST_CHECK_EQUAL(r4.extent(n - d - 1u), r1.extent(d));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1240,4 +1240,198 @@ BOOST_AUTO_TEST_CASE( gemm_perm )
   BOOST_CHECK_CLOSE(result.sparsity(), float(zero_tile_count) / float(result_norms.size()), tolerance);
 }
 
+BOOST_AUTO_TEST_CASE( gemm_screened )
+{
+  const float screened_gemm_ratio = SparseShape<float>::screened_gemm_ratio();
+
+  math::GemmHelper gemm_helper(madness::cblas::NoTrans, madness::cblas::NoTrans,
+      2u, left.data().range().rank(), right.data().range().rank());
+
+  // Evaluate the contraction with the dense algorithm
+  SparseShape<float>::screened_gemm_ratio(0.0f);
+  SparseShape<float> dense_result = left.gemm(right, -7.2, gemm_helper);
+
+  // Evaluate the contraction with the screened algorithm, where the sparse
+  // and dense arguments exercise the row and column screening
+  for(const SparseShape<float>* arg : { &left, &sparse_shape }) {
+    SparseShape<float>::screened_gemm_ratio(1.0f);
+    SparseShape<float> result;
+    BOOST_REQUIRE_NO_THROW(result = arg->gemm(right, -7.2, gemm_helper));
+    SparseShape<float>::screened_gemm_ratio(0.0f);
+    SparseShape<float> expected = arg->gemm(right, -7.2, gemm_helper);
+
+    // Check that the results are the same
+    BOOST_CHECK_EQUAL(result.data().range(), expected.data().range());
+    for(std::size_t i = 0ul; i < expected.data().size(); ++i) {
+      BOOST_CHECK_CLOSE(result[i], expected[i], tolerance);
+      BOOST_CHECK_EQUAL(result.is_zero(i), expected.is_zero(i));
+    }
+    BOOST_CHECK_EQUAL(result.sparsity(), expected.sparsity());
+  }
+
+  // Check that screening is never used for shapes that are too dense
+  SparseShape<float>::screened_gemm_ratio(1.0e-9f);
+  SparseShape<float> result = left.gemm(right, -7.2, gemm_helper);
+  for(std::size_t i = 0ul; i < dense_result.data().size(); ++i)
+    BOOST_CHECK_EQUAL(result[i], dense_result[i]);
+
+  SparseShape<float>::screened_gemm_ratio(screened_gemm_ratio);
+}
+
+BOOST_AUTO_TEST_CASE( compressed_constructor )
+{
+  Tensor<float> tile_norms = make_norm_tensor(tr, 0.1, 23);
+  SparseShape<float> x(tile_norms, tr, true);
+
+  BOOST_CHECK(! x.empty());
+  BOOST_CHECK(x.is_compressed());
+  BOOST_CHECK(! left.is_compressed());
+  BOOST_CHECK(x.validate(tr.tiles_range()));
+#ifdef TA_EXCEPTION_ERROR
+  BOOST_CHECK_THROW(x.data(), Exception);
+  BOOST_CHECK_THROW(left.compressed_data(), Exception);
+#endif // TA_EXCEPTION_ERROR
+
+  // Check that only the non-zero norms are stored
+  std::size_t nnz = 0ul;
+  for(std::size_t i = 0ul; i < tr.tiles_range().volume(); ++i) {
+    BOOST_CHECK_EQUAL(x[i], left[i]);
+    BOOST_CHECK_EQUAL(x.is_zero(i), left.is_zero(i));
+    if(! left.is_zero(i))
+      ++nnz;
+  }
+  BOOST_CHECK_EQUAL(x.compressed_data().nnz(), nnz);
+  BOOST_CHECK_EQUAL(x.sparsity(), left.sparsity());
+
+  // Check compress and decompress
+  SparseShape<float> y = left.compress();
+  BOOST_CHECK(y.is_compressed());
+  SparseShape<float> z = y.decompress();
+  BOOST_CHECK(! z.is_compressed());
+  for(std::size_t i = 0ul; i < tr.tiles_range().volume(); ++i) {
+    BOOST_CHECK_EQUAL(y[i], left[i]);
+    BOOST_CHECK_EQUAL(z.data()[i], left.data()[i]);
+  }
+  BOOST_CHECK_EQUAL(z.sparsity(), left.sparsity());
+
+  // Check the sparse and collective constructors
+  std::vector<std::pair<std::vector<std::size_t>,float>> sparse_tile_norms;
+  for(std::size_t i = 0ul; i < tile_norms.size(); ++i)
+    if(! left.is_zero(i))
+      sparse_tile_norms.push_back(std::make_pair(tr.tiles_range().idx(i), tile_norms[i]));
+  SparseShape<float> x_sp(sparse_tile_norms, tr, true);
+  SparseShape<float> x_comm(*GlobalFixture::world, tile_norms, tr, true);
+  SparseShape<float> expected_comm(*GlobalFixture::world, tile_norms, tr);
+  BOOST_CHECK(x_sp.is_compressed());
+  BOOST_CHECK(x_comm.is_compressed());
+  for(std::size_t i = 0ul; i < tr.tiles_range().volume(); ++i) {
+    BOOST_CHECK_CLOSE(x_sp[i], left[i], tolerance);
+    BOOST_CHECK_CLOSE(x_comm[i], expected_comm[i], tolerance);
+    BOOST_CHECK_EQUAL(x_comm.is_zero(i), expected_comm.is_zero(i));
+  }
+  BOOST_CHECK_EQUAL(x_sp.sparsity(), left.sparsity());
+  BOOST_CHECK_EQUAL(x_comm.sparsity(), expected_comm.sparsity());
+}
+
+BOOST_AUTO_TEST_CASE( compressed_arithmetic )
+{
+  const SparseShape<float> c_left = left.compress();
+  const SparseShape<float> c_right = right.compress();
+
+  // Check that a compressed result matches the uncompressed result
+  auto check = [&] (const SparseShape<float>& result,
+      const SparseShape<float>& expected)
+  {
+    BOOST_CHECK(result.is_compressed());
+    BOOST_CHECK_EQUAL(result.compressed_data().range(), expected.data().range());
+    for(std::size_t i = 0ul; i < expected.data().size(); ++i) {
+      BOOST_CHECK_CLOSE(result[i], expected[i], tolerance);
+      BOOST_CHECK_EQUAL(result.is_zero(i), expected.is_zero(i));
+    }
+    BOOST_CHECK_EQUAL(result.sparsity(), expected.sparsity());
+  };
+
+  check(c_left.perm(perm), left.perm(perm));
+  check(c_left.scale(-4.1), left.scale(-4.1));
+  check(c_left.scale(-4.1, perm), left.scale(-4.1, perm));
+  check(c_left.add(c_right), left.add(right));
+  check(c_left.add(right), left.add(right));
+  check(c_left.add(c_right, perm), left.add(right, perm));
+  check(c_left.add(c_right, -4.1), left.add(right, -4.1));
+  check(c_left.add(c_right, -4.1, perm), left.add(right, -4.1, perm));
+  check(c_left.add(2.0f), left.add(2.0f));
+  check(c_left.subt(c_right), left.subt(right));
+  check(c_left.mult(c_right), left.mult(right));
+  check(left.mult(c_right), left.mult(right));
+  check(c_left.mult(c_right, perm), left.mult(right, perm));
+  check(c_left.mult(c_right, -4.1), left.mult(right, -4.1));
+  check(c_left.mult(c_right, -4.1, perm), left.mult(right, -4.1, perm));
+  check(c_left.mask(c_right), left.mask(right));
+  check(c_left.transform([] (const Tensor<float>& norms) { return norms.clone(); }),
+      left.transform([] (const Tensor<float>& norms) { return norms.clone(); }));
+}
+
+BOOST_AUTO_TEST_CASE( compressed_block )
+{
+  const SparseShape<float> c_shape = sparse_shape.compress();
+  auto less = std::less<std::size_t>();
+
+  for(auto lower_it = tr.tiles_range().begin(); lower_it != tr.tiles_range().end(); ++lower_it) {
+    const auto& lower = *lower_it;
+
+    for(auto upper_it = tr.tiles_range().begin(); upper_it != tr.tiles_range().end(); ++upper_it) {
+      std::vector<std::size_t> upper = *upper_it;
+      for(auto it = upper.begin(); it != upper.end(); ++it)
+        *it += 1;
+      if(! std::equal(lower.begin(), lower.end(), upper.begin(), less))
+        continue;
+
+      SparseShape<float> result = c_shape.block(lower, upper, 2.3);
+      SparseShape<float> expected = sparse_shape.block(lower, upper, 2.3);
+      BOOST_CHECK(result.is_compressed());
+      BOOST_CHECK_EQUAL(result.compressed_data().range(), expected.data().range());
+      for(std::size_t i = 0ul; i < expected.data().size(); ++i)
+        BOOST_CHECK_EQUAL(result[i], expected[i]);
+      BOOST_CHECK_EQUAL(result.sparsity(), expected.sparsity());
+
+      // Check that updating the block restores the original shape
+      SparseShape<float> updated =
+          c_shape.update_block(lower, upper, c_shape.block(lower, upper));
+      for(std::size_t i = 0ul; i < sparse_shape.data().size(); ++i)
+        BOOST_CHECK_EQUAL(updated[i], sparse_shape[i]);
+      BOOST_CHECK_EQUAL(updated.sparsity(), sparse_shape.sparsity());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( compressed_gemm )
+{
+  const float screened_gemm_ratio = SparseShape<float>::screened_gemm_ratio();
+  SparseShape<float>::screened_gemm_ratio(0.0f);
+
+  const Permutation perm({1,0});
+  math::GemmHelper gemm_helper(madness::cblas::NoTrans, madness::cblas::NoTrans,
+      2u, left.data().range().rank(), right.data().range().rank());
+
+  for(const SparseShape<float>* arg : { &left, &sparse_shape }) {
+    const SparseShape<float> expected = arg->gemm(right, -7.2, gemm_helper);
+    const SparseShape<float> expected_perm = arg->gemm(right, -7.2, gemm_helper, perm);
+    SparseShape<float> result, result_perm;
+    BOOST_REQUIRE_NO_THROW(result = arg->compress().gemm(right.compress(), -7.2, gemm_helper));
+    BOOST_REQUIRE_NO_THROW(result_perm = arg->gemm(right.compress(), -7.2, gemm_helper, perm));
+
+    BOOST_CHECK(result.is_compressed());
+    BOOST_CHECK(result_perm.is_compressed());
+    for(std::size_t i = 0ul; i < expected.data().size(); ++i) {
+      BOOST_CHECK_CLOSE(result[i], expected[i], tolerance);
+      BOOST_CHECK_EQUAL(result.is_zero(i), expected.is_zero(i));
+      BOOST_CHECK_CLOSE(result_perm[i], expected_perm[i], tolerance);
+    }
+    BOOST_CHECK_EQUAL(result.sparsity(), expected.sparsity());
+    BOOST_CHECK_EQUAL(result_perm.sparsity(), expected_perm.sparsity());
+  }
+
+  SparseShape<float>::screened_gemm_ratio(screened_gemm_ratio);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
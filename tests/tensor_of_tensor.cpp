@@ -28,6 +28,7 @@
 #include "unit_test_config.h"
 
 #include <boost/mpl/list.hpp>
+#include <functional>
 
 #ifdef TILEDARRAY_HAS_BTAS
 #include <TiledArray/external/btas.h>
@@ -94,6 +95,34 @@ struct TensorOfTensorFixture {
   }
 #endif  // defined(TILEDARRAY_HAS_BTAS)
 
+  // Construct the inner matrix of outer element (i,j) with a deterministic
+  // pattern of small integers, so products are exact
+  static Tensor<double> make_inner(const std::size_t seed, const std::size_t i,
+      const std::size_t j, const std::size_t rows, const std::size_t cols)
+  {
+    Tensor<double> tensor(Range(rows, cols));
+    for(std::size_t x = 0ul; x < tensor.size(); ++x)
+      tensor[x] = double((seed * 31ul + i * 7ul + j * 3ul + x) % 13ul) - 6.0;
+    return tensor;
+  }
+
+  // Reference matrix product op(left) * op(right), where trans_left and
+  // trans_right indicate that the argument is stored transposed
+  static Tensor<double> matrix_product(const Tensor<double>& left,
+      const Tensor<double>& right, const bool trans_left, const bool trans_right)
+  {
+    const std::size_t m = left.range().extent(trans_left ? 1 : 0);
+    const std::size_t k = left.range().extent(trans_left ? 0 : 1);
+    const std::size_t n = right.range().extent(trans_right ? 0 : 1);
+    Tensor<double> result(Range(m, n), 0.0);
+    for(std::size_t a = 0ul; a < m; ++a)
+      for(std::size_t b = 0ul; b < n; ++b)
+        for(std::size_t x = 0ul; x < k; ++x)
+          result(a, b) += (trans_left ? left(x, a) : left(a, x)) *
+              (trans_right ? right(b, x) : right(x, b));
+    return result;
+  }
+
   static const std::array<std::size_t, 2> size;
   static const Permutation perm;
 
@@ -1132,4 +1161,240 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( serialization, ITensor, itensor_types )
   BOOST_CHECK_EQUAL_COLLECTIONS(cbegin(a), cend(a), cbegin(a_roundtrip), cend(a_roundtrip));
 }
 
+
+BOOST_AUTO_TEST_CASE( nested_gemm_hadamard )
+{
+  const std::size_t m = 3ul, k = 4ul, n = 5ul;
+  Tensor<Tensor<double> > left(Range(m, k)), right(Range(k, n));
+  for(std::size_t i = 0ul; i < m; ++i)
+    for(std::size_t x = 0ul; x < k; ++x)
+      left(i, x) = make_inner(1ul, i, x, 2ul, 3ul);
+  for(std::size_t x = 0ul; x < k; ++x)
+    for(std::size_t j = 0ul; j < n; ++j)
+      right(x, j) = make_inner(2ul, x, j, 2ul, 3ul);
+
+  const math::GemmHelper gemm_helper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u);
+  Tensor<Tensor<double> > result;
+  BOOST_REQUIRE_NO_THROW(result = nested_gemm(left, right, 2.0, gemm_helper,
+      math::NestedProduct()));
+
+  BOOST_CHECK_EQUAL(result.range(), Range(m, n));
+  for(std::size_t i = 0ul; i < m; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      Tensor<double> ref(Range(2ul, 3ul), 0.0);
+      for(std::size_t x = 0ul; x < k; ++x)
+        ref.add_to(left(i, x).mult(right(x, j), 2.0));
+      BOOST_CHECK_EQUAL(result(i, j).range(), ref.range());
+      for(std::size_t e = 0ul; e < ref.size(); ++e)
+        BOOST_CHECK_EQUAL(result(i, j)[e], ref[e]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( nested_gemm_contraction )
+{
+  // The inner tensors of right have two different sizes, so the inner
+  // contractions are evaluated by grouped and single GEMMs. The outer
+  // dimensions of left are stored transposed and permuted by the kernel.
+  const std::size_t m = 3ul, k = 4ul, n = 5ul, p = 3ul;
+  Tensor<Tensor<double> > left(Range(k, m)), right(Range(k, n));
+  for(std::size_t i = 0ul; i < m; ++i)
+    for(std::size_t x = 0ul; x < k; ++x)
+      left(x, i) = make_inner(3ul, i, x, i % 2ul + 2ul, p);
+  for(std::size_t x = 0ul; x < k; ++x)
+    for(std::size_t j = 0ul; j < n; ++j)
+      right(x, j) = make_inner(4ul, x, j, p, j % 2ul + 1ul);
+
+  const math::GemmHelper gemm_helper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u);
+  const math::NestedProduct nested(math::GemmHelper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u));
+  const Permutation left_perm{1, 0};
+
+  // Initialize the result and accumulate a second contraction
+  Tensor<Tensor<double> > result;
+  BOOST_REQUIRE_NO_THROW(nested_gemm(result, left, right, 1.0, gemm_helper,
+      nested, left_perm));
+  BOOST_REQUIRE_NO_THROW(nested_gemm(result, left, right, 2.0, gemm_helper,
+      nested, left_perm));
+
+  BOOST_CHECK_EQUAL(result.range(), Range(m, n));
+  for(std::size_t i = 0ul; i < m; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      Tensor<double> ref(Range(i % 2ul + 2ul, j % 2ul + 1ul), 0.0);
+      for(std::size_t x = 0ul; x < k; ++x)
+        ref.add_to(matrix_product(left(x, i), right(x, j), false, false), 3.0);
+      BOOST_CHECK_EQUAL(result(i, j).range(), ref.range());
+      for(std::size_t e = 0ul; e < ref.size(); ++e)
+        BOOST_CHECK_EQUAL(result(i, j)[e], ref[e]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( nested_gemm_contraction_trans )
+{
+  // The inner tensors are stored as left[c,a] and right[b,c]
+  const std::size_t m = 2ul, k = 3ul, n = 4ul, p = 5ul;
+  Tensor<Tensor<double> > left(Range(m, k)), right(Range(k, n));
+  for(std::size_t i = 0ul; i < m; ++i)
+    for(std::size_t x = 0ul; x < k; ++x)
+      left(i, x) = make_inner(5ul, i, x, p, 2ul);
+  for(std::size_t x = 0ul; x < k; ++x)
+    for(std::size_t j = 0ul; j < n; ++j)
+      right(x, j) = make_inner(6ul, x, j, j % 2ul + 2ul, p);
+
+  const math::GemmHelper gemm_helper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u);
+  const math::NestedProduct nested(math::GemmHelper(madness::cblas::Trans,
+      madness::cblas::Trans, 2u, 2u, 2u));
+  Tensor<Tensor<double> > result;
+  BOOST_REQUIRE_NO_THROW(result = nested_gemm(left, right, 1.0, gemm_helper,
+      nested));
+
+  for(std::size_t i = 0ul; i < m; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      Tensor<double> ref(Range(2ul, j % 2ul + 2ul), 0.0);
+      for(std::size_t x = 0ul; x < k; ++x)
+        ref.add_to(matrix_product(left(i, x), right(x, j), true, true));
+      BOOST_CHECK_EQUAL(result(i, j).range(), ref.range());
+      for(std::size_t e = 0ul; e < ref.size(); ++e)
+        BOOST_CHECK_EQUAL(result(i, j)[e], ref[e]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( nested_mult_contraction )
+{
+  const std::size_t m = 3ul, n = 4ul;
+  Tensor<Tensor<double> > left(Range(m, n)), right(Range(m, n));
+  for(std::size_t i = 0ul; i < m; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      left(i, j) = make_inner(7ul, i, j, 2ul, 3ul);
+      right(i, j) = make_inner(8ul, i, j, 3ul, 4ul);
+    }
+  }
+
+  const math::NestedProduct nested(math::GemmHelper(madness::cblas::NoTrans,
+      madness::cblas::NoTrans, 2u, 2u, 2u));
+  Tensor<Tensor<double> > result;
+  BOOST_REQUIRE_NO_THROW(result = nested_mult(left, right, 3.0, nested));
+
+  BOOST_CHECK_EQUAL(result.range(), left.range());
+  for(std::size_t i = 0ul; i < m; ++i) {
+    for(std::size_t j = 0ul; j < n; ++j) {
+      const Tensor<double> ref =
+          matrix_product(left(i, j), right(i, j), false, false).scale(3.0);
+      BOOST_CHECK_EQUAL(result(i, j).range(), ref.range());
+      for(std::size_t e = 0ul; e < ref.size(); ++e)
+        BOOST_CHECK_EQUAL(result(i, j)[e], ref[e]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( nested_expressions )
+{
+  typedef DistArray<Tensor<Tensor<double> >, DensePolicy> TArrayN;
+
+  // Construct the tiled ranges of the outer dimensions
+  const std::array<std::size_t, 3> tiling_i = {{ 0, 2, 5 }};
+  const std::array<std::size_t, 3> tiling_k = {{ 0, 3, 4 }};
+  const std::array<std::size_t, 3> tiling_j = {{ 0, 1, 3 }};
+  const TiledRange1 tr_i(tiling_i.begin(), tiling_i.end());
+  const TiledRange1 tr_k(tiling_k.begin(), tiling_k.end());
+  const TiledRange1 tr_j(tiling_j.begin(), tiling_j.end());
+  const std::array<TiledRange1, 2> tiling_ik = {{ tr_i, tr_k }};
+  const std::array<TiledRange1, 2> tiling_kj = {{ tr_k, tr_j }};
+  const TiledRange trange_ik(tiling_ik.begin(), tiling_ik.end());
+  const TiledRange trange_kj(tiling_kj.begin(), tiling_kj.end());
+  const std::size_t I = 5ul, K = 4ul, J = 3ul;
+
+  auto make_array = [] (const TiledRange& trange, const std::size_t seed,
+      const std::size_t rows, const std::size_t cols)
+  {
+    TArrayN array(*GlobalFixture::world, trange);
+    array.init_tiles([=] (const Range& range) {
+      TArrayN::value_type tile(range);
+      for(const auto& idx : range)
+        tile[idx] = TensorOfTensorFixture::make_inner(seed, idx[0], idx[1],
+            rows, cols);
+      return tile;
+    });
+    return array;
+  };
+
+  // Compare the local tiles of result, where the element at outer index
+  // (i,j) is reference(i,j), or reference(j,i) when transposed
+  auto check = [] (const TArrayN& result, const bool transposed,
+      const std::function<Tensor<double>(std::size_t, std::size_t)>& reference)
+  {
+    for(auto it = result.begin(); it != result.end(); ++it) {
+      const TArrayN::value_type tile = *it;
+      for(const auto& idx : tile.range()) {
+        const Tensor<double> ref = (transposed ? reference(idx[1], idx[0]) :
+            reference(idx[0], idx[1]));
+        const Tensor<double>& element = tile[idx];
+        BOOST_CHECK_EQUAL(element.range(), ref.range());
+        for(std::size_t e = 0ul; e < ref.size(); ++e)
+          BOOST_CHECK_EQUAL(element[e], ref[e]);
+      }
+    }
+  };
+
+  // Outer contraction with inner Hadamard product
+  TArrayN a = make_array(trange_ik, 1ul, 2ul, 3ul);
+  TArrayN b = make_array(trange_kj, 2ul, 2ul, 3ul);
+  TArrayN c;
+  BOOST_REQUIRE_NO_THROW(c("i,j;a,b") = a("i,k;a,b") * b("k,j;a,b"));
+  check(c, false, [&] (const std::size_t i, const std::size_t j) {
+    Tensor<double> ref(Range(2ul, 3ul), 0.0);
+    for(std::size_t x = 0ul; x < K; ++x)
+      ref.add_to(make_inner(1ul, i, x, 2ul, 3ul).mult(make_inner(2ul, x, j, 2ul, 3ul)));
+    return ref;
+  });
+
+  // Outer contraction with inner contraction
+  TArrayN d = make_array(trange_ik, 3ul, 2ul, 4ul);
+  TArrayN e = make_array(trange_kj, 4ul, 4ul, 3ul);
+  auto contraction = [&] (const std::size_t i, const std::size_t j) {
+    Tensor<double> ref(Range(2ul, 3ul), 0.0);
+    for(std::size_t x = 0ul; x < K; ++x)
+      ref.add_to(matrix_product(make_inner(3ul, i, x, 2ul, 4ul),
+          make_inner(4ul, x, j, 4ul, 3ul), false, false));
+    return ref;
+  };
+  TArrayN f;
+  BOOST_REQUIRE_NO_THROW(f("i,j;a,b") = d("i,k;a,c") * e("k,j;c,b"));
+  check(f, false, contraction);
+
+  // Scaled outer contraction with inner contraction and a permuted result
+  TArrayN g;
+  BOOST_REQUIRE_NO_THROW(g("j,i;a,b") = 2.0 * (d("i,k;a,c") * e("k,j;c,b")));
+  check(g, true, [&] (const std::size_t i, const std::size_t j) {
+    return contraction(i, j).scale(2.0);
+  });
+
+  // Outer Hadamard product with inner contraction
+  TArrayN h = make_array(trange_ik, 5ul, 4ul, 3ul);
+  TArrayN r;
+  BOOST_REQUIRE_NO_THROW(r("i,k;a,b") = d("i,k;a,c") * h("i,k;c,b"));
+  check(r, false, [&] (const std::size_t i, const std::size_t j) {
+    return matrix_product(make_inner(3ul, i, j, 2ul, 4ul),
+        make_inner(5ul, i, j, 4ul, 3ul), false, false);
+  });
+
+  // Permutations of the inner tensors are not supported
+  TArrayN s;
+  BOOST_CHECK_THROW(s("i,j;b,a") = d("i,k;a,c") * e("k,j;c,b"),
+      TiledArray::Exception);
+  BOOST_CHECK_THROW(s("i,j;b,a") = c("i,j;a,b"), TiledArray::Exception);
+  BOOST_CHECK_THROW(s("i,j;a,b") = c("i,j;a,b") + f("i,j;b,a"),
+      TiledArray::Exception);
+  BOOST_CHECK_THROW(s("i,j;a,b") = c("i,j;a,b") - 2.0 * f("i,j;b,a"),
+      TiledArray::Exception);
+
+  BOOST_CHECK_EQUAL(c.trange().elements_range().extent(0), I);
+  BOOST_CHECK_EQUAL(c.trange().elements_range().extent(1), J);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,241 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_cache.cpp
+ *  Jun 12, 2018
+ *
+ */
+
+#include "TiledArray/tile_cache.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+
+using namespace TiledArray;
+
+struct TileCacheFixture {
+  typedef Tensor<double> tile_type;
+  typedef detail::DistributedStorage<tile_type> Storage;
+
+  TileCacheFixture() :
+    world(* GlobalFixture::world),
+    id(world.unique_obj_id()),
+    other_id(world.unique_obj_id()),
+    tile_bytes(detail::tile_bytes(make_tile(), 0))
+  { }
+
+  ~TileCacheFixture() {
+    TileCache::instance().max_bytes(0ul);
+    TileCache::instance().reset_counters();
+    world.gop.fence();
+  }
+
+  static tile_type make_tile() { return tile_type(Range(10, 10), 1.0); }
+
+  TiledArray::World& world;
+  madness::uniqueidT id;
+  madness::uniqueidT other_id;
+  const std::size_t tile_bytes;
+};
+
+BOOST_FIXTURE_TEST_SUITE( tile_cache_suite , TileCacheFixture )
+
+BOOST_AUTO_TEST_CASE( constructor )
+{
+  TileCache cache;
+  BOOST_CHECK(! cache.enabled());
+  BOOST_CHECK_EQUAL(cache.max_bytes(), 0ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0ul);
+  BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  BOOST_CHECK_EQUAL(cache.hits(), 0ul);
+  BOOST_CHECK_EQUAL(cache.misses(), 0ul);
+
+  // Check that nothing is cached when the cache is disabled
+  Future<tile_type> f;
+  BOOST_CHECK(! cache.find_or_insert(id, 0ul, f));
+  BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  BOOST_CHECK_EQUAL(cache.misses(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( find_or_insert )
+{
+  TileCache cache;
+  cache.max_bytes(10ul * tile_bytes);
+  BOOST_CHECK(cache.enabled());
+
+  // Insert a tile that is in transit
+  Future<tile_type> f;
+  BOOST_CHECK(! cache.find_or_insert(id, 3ul, f));
+  BOOST_CHECK_EQUAL(cache.size(), 1ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0ul);
+  BOOST_CHECK_EQUAL(cache.misses(), 1ul);
+
+  // Check that the tile is found before and after it arrives
+  Future<tile_type> g;
+  BOOST_CHECK(cache.find_or_insert(id, 3ul, g));
+  f.set(make_tile());
+  BOOST_CHECK_EQUAL(cache.bytes(), tile_bytes);
+  Future<tile_type> h;
+  BOOST_CHECK(cache.find_or_insert(id, 3ul, h));
+  BOOST_CHECK_EQUAL(cache.hits(), 2ul);
+  BOOST_REQUIRE(g.probe());
+  BOOST_REQUIRE(h.probe());
+  BOOST_CHECK_EQUAL(g.get().data(), f.get().data());
+  BOOST_CHECK_EQUAL(h.get().data(), f.get().data());
+
+  // Check that tiles are keyed by container and ordinal
+  Future<tile_type> x, y;
+  BOOST_CHECK(! cache.find_or_insert(id, 4ul, x));
+  BOOST_CHECK(! cache.find_or_insert(other_id, 3ul, y));
+  BOOST_CHECK_EQUAL(cache.size(), 3ul);
+  BOOST_CHECK_EQUAL(cache.misses(), 3ul);
+
+  cache.reset_counters();
+  BOOST_CHECK_EQUAL(cache.hits(), 0ul);
+  BOOST_CHECK_EQUAL(cache.misses(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( evict )
+{
+  TileCache cache;
+  cache.max_bytes(3ul * tile_bytes);
+
+  // Fill the cache
+  for(std::size_t i = 0ul; i < 3ul; ++i) {
+    Future<tile_type> f;
+    cache.find_or_insert(id, i, f);
+    f.set(make_tile());
+  }
+  BOOST_CHECK_EQUAL(cache.size(), 3ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 3ul * tile_bytes);
+
+  // Use tile 0 so tile 1 is the least recently used
+  Future<tile_type> f;
+  BOOST_CHECK(cache.find_or_insert(id, 0ul, f));
+
+  // Check that inserting a fourth tile evicts tile 1
+  Future<tile_type> g(make_tile());
+  BOOST_CHECK(! cache.find_or_insert(id, 3ul, g));
+  BOOST_CHECK_EQUAL(cache.size(), 3ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 3ul * tile_bytes);
+  for(std::size_t i : { 0ul, 2ul, 3ul }) {
+    Future<tile_type> h;
+    BOOST_CHECK(cache.find_or_insert(id, i, h));
+  }
+  Future<tile_type> h(make_tile());
+  BOOST_CHECK(! cache.find_or_insert(id, 1ul, h));
+  BOOST_CHECK_EQUAL(cache.size(), 3ul);
+
+  // Check that reducing the maximum size evicts tiles
+  cache.max_bytes(tile_bytes);
+  BOOST_CHECK_EQUAL(cache.size(), 1ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), tile_bytes);
+
+  // Check that disabling the cache removes all tiles
+  cache.max_bytes(0ul);
+  BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( erase )
+{
+  TileCache cache;
+  cache.max_bytes(10ul * tile_bytes);
+  for(std::size_t i = 0ul; i < 3ul; ++i) {
+    Future<tile_type> f(make_tile()), g(make_tile());
+    cache.find_or_insert(id, i, f);
+    cache.find_or_insert(other_id, i, g);
+  }
+  BOOST_CHECK_EQUAL(cache.size(), 6ul);
+
+  // Check that only the tiles of the erased container are removed
+  cache.erase(id);
+  BOOST_CHECK_EQUAL(cache.size(), 3ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 3ul * tile_bytes);
+  for(std::size_t i = 0ul; i < 3ul; ++i) {
+    Future<tile_type> f;
+    BOOST_CHECK(cache.find_or_insert(other_id, i, f));
+  }
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( distributed_storage )
+{
+  TileCache& cache = TileCache::instance();
+  cache.max_bytes(100ul * tile_bytes);
+  cache.reset_counters();
+
+  {
+    std::shared_ptr<Pmap> pmap(new detail::BlockedPmap(world, 10ul));
+    Storage storage(world, 10ul, pmap);
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i)
+      if(storage.is_local(i))
+        storage.set(i, make_tile());
+
+    // Get all tiles twice, and check that remote tiles are only fetched once
+    std::size_t remote = 0ul;
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i) {
+      if(! storage.is_local(i))
+        ++remote;
+      BOOST_CHECK_EQUAL(storage.get(i).get().data()[0], 1.0);
+    }
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i)
+      BOOST_CHECK_EQUAL(storage.get(i).get().data()[0], 1.0);
+
+    BOOST_CHECK_EQUAL(cache.misses(), remote);
+    BOOST_CHECK_EQUAL(cache.hits(), remote);
+    BOOST_CHECK_EQUAL(cache.size(), remote);
+    world.gop.fence();
+  }
+
+  // Check that the tiles are removed when the container is destroyed
+  BOOST_CHECK_EQUAL(cache.size(), 0ul);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( expressions )
+{
+  TileCache& cache = TileCache::instance();
+  cache.max_bytes(100ul * tile_bytes);
+
+  // Distribute a differently from the result, so some of its tiles are remote
+  const std::array<std::size_t, 4> tiling{{ 0ul, 10ul, 20ul, 30ul }};
+  const TiledRange trange({ TiledRange1(tiling.begin(), tiling.end()),
+      TiledRange1(tiling.begin(), tiling.end()) });
+  TArrayD a(world, trange, std::make_shared<detail::BlockedPmap>(world,
+      trange.tiles_range().volume()));
+  TArrayD b(world, trange);
+  a.fill_local(2.0);
+  b.fill_local(3.0);
+
+  // Cached remote tiles of a are shared by both expressions, so they must
+  // not be consumed by the first one
+  for(int r = 0; r < 2; ++r) {
+    TArrayD c;
+    BOOST_REQUIRE_NO_THROW(c("i,j") = a("i,j") + b("i,j"));
+    for(auto it = c.begin(); it != c.end(); ++it) {
+      const TArrayD::value_type tile = *it;
+      for(std::size_t i = 0ul; i < tile.size(); ++i)
+        BOOST_CHECK_EQUAL(tile[i], 5.0);
+    }
+    world.gop.fence();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,232 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_compression.cpp
+ *  Jul 2, 2018
+ *
+ */
+
+#include "TiledArray/tile_compression.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+#include "range_fixture.h"
+
+using namespace TiledArray;
+
+struct TileCompressionFixture : public TiledRangeFixture {
+  typedef Tensor<double> tile_type;
+  typedef detail::TileCodec<tile_type> codec_type;
+
+  TileCompressionFixture() :
+    world(* GlobalFixture::world), t(Range(20, 30))
+  {
+    // Decaying values, which compress well
+    for(std::size_t i = 0ul; i < t.size(); ++i)
+      t[i] = std::exp(-double(i) / 50.0) * (i % 2 ? 1.0 : -1.0);
+    TileCompression::reset_counters();
+  }
+
+  ~TileCompressionFixture() {
+    TileCompression::reset_counters();
+    world.gop.fence();
+  }
+
+  static double max_abs_diff(const tile_type& a, const tile_type& b) {
+    double result = 0.0;
+    for(std::size_t i = 0ul; i < a.size(); ++i)
+      result = std::max(result, std::abs(a[i] - b[i]));
+    return result;
+  }
+
+  World& world;
+  tile_type t;
+}; // TileCompressionFixture
+
+BOOST_FIXTURE_TEST_SUITE( tile_compression_suite, TileCompressionFixture )
+
+BOOST_AUTO_TEST_CASE( lz )
+{
+  std::vector<unsigned char> in(10000ul), out, back(in.size());
+  for(std::size_t i = 0ul; i < in.size(); ++i)
+    in[i] = static_cast<unsigned char>((i / 7ul) % 13ul);
+  detail::lz_compress(in.data(), in.size(), out);
+  BOOST_CHECK_LT(out.size(), in.size());
+  detail::lz_decompress(out.data(), out.size(), back.data(), back.size());
+  BOOST_CHECK(in == back);
+
+  // Check that empty data and data without matches are handled
+  detail::lz_compress(in.data(), 0ul, out);
+  detail::lz_decompress(out.data(), out.size(), back.data(), 0ul);
+  detail::lz_compress(in.data(), 3ul, out);
+  detail::lz_decompress(out.data(), out.size(), back.data(), 3ul);
+  BOOST_CHECK(std::equal(back.begin(), back.begin() + 3, in.begin()));
+
+  // Check that a size mismatch is detected
+  detail::lz_compress(in.data(), in.size(), out);
+  BOOST_CHECK_THROW(detail::lz_decompress(out.data(), out.size(), back.data(),
+      back.size() - 1ul), TiledArray::Exception);
+}
+
+BOOST_AUTO_TEST_CASE( none )
+{
+  const codec_type::packed_type packed = codec_type::compress(t, TileCompression());
+  BOOST_CHECK_EQUAL(packed.format, 0);
+  const tile_type result = codec_type::decompress(packed);
+  BOOST_CHECK_EQUAL(result.data(), t.data());
+  BOOST_CHECK_EQUAL(TileCompression::raw_bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( lossless )
+{
+  const codec_type::packed_type packed =
+      codec_type::compress(t, TileCompression(TileCompression::lossless));
+  BOOST_CHECK_EQUAL(packed.format, TileCompression::lossless);
+  const tile_type result = codec_type::decompress(packed);
+  BOOST_CHECK_EQUAL(result.range(), t.range());
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), t.begin(), t.end());
+  BOOST_CHECK_EQUAL(TileCompression::raw_bytes(), t.size() * sizeof(double));
+  BOOST_CHECK_EQUAL(TileCompression::packed_bytes(), packed.data.size());
+
+  // Integer tiles are also compressed losslessly
+  Tensor<int> ti(Range(10, 10));
+  for(std::size_t i = 0ul; i < ti.size(); ++i)
+    ti[i] = int(i % 5ul) - 2;
+  const Tensor<int> ri = detail::TileCodec<Tensor<int> >::decompress(
+      detail::TileCodec<Tensor<int> >::compress(ti,
+          TileCompression(TileCompression::bounded, 0.5)));
+  BOOST_CHECK_EQUAL_COLLECTIONS(ri.begin(), ri.end(), ti.begin(), ti.end());
+}
+
+BOOST_AUTO_TEST_CASE( single )
+{
+  const codec_type::packed_type packed =
+      codec_type::compress(t, TileCompression(TileCompression::single));
+  BOOST_CHECK_EQUAL(packed.format, TileCompression::single);
+  BOOST_CHECK_LE(packed.data.size(), t.size() * sizeof(float));
+  const tile_type result = codec_type::decompress(packed);
+  for(std::size_t i = 0ul; i < t.size(); ++i)
+    BOOST_CHECK_LE(std::abs(result[i] - t[i]), std::abs(t[i]) * std::ldexp(1.0, -24));
+}
+
+BOOST_AUTO_TEST_CASE( bounded )
+{
+  for(const double tolerance : { 1.0e-4, 1.0e-8, 1.0e-12 }) {
+    const codec_type::packed_type packed = codec_type::compress(t,
+        TileCompression(TileCompression::bounded, tolerance));
+    BOOST_CHECK_EQUAL(packed.format, TileCompression::bounded);
+    BOOST_CHECK_LT(packed.data.size(), t.size() * sizeof(double));
+    const tile_type result = codec_type::decompress(packed);
+    BOOST_CHECK_LE(max_abs_diff(result, t), tolerance);
+  }
+
+  // Values that cannot be quantized are compressed losslessly
+  tile_type large = t.clone();
+  large[0] = 1.0e300;
+  const codec_type::packed_type packed = codec_type::compress(large,
+      TileCompression(TileCompression::bounded, 1.0e-10));
+  BOOST_CHECK_EQUAL(packed.format, TileCompression::lossless);
+  const tile_type result = codec_type::decompress(packed);
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), large.begin(), large.end());
+
+  BOOST_CHECK_THROW(TileCompression(TileCompression::bounded, 0.0), TiledArray::Exception);
+}
+
+BOOST_AUTO_TEST_CASE( find )
+{
+  TArrayD a(world, tr);
+  a.fill_random();
+  a.compression(TileCompression(TileCompression::lossless));
+  BOOST_CHECK_EQUAL(a.compression().mode(), TileCompression::lossless);
+
+  // Check that remote tiles are received unchanged
+  for(std::size_t i = 0ul; i < a.size(); ++i) {
+    TArrayD::value_type tile = a.find(i).get();
+    BOOST_CHECK_EQUAL(tile.range(), a.trange().make_tile_range(i));
+    if(! a.is_local(i))
+      continue;
+    for(const double x : tile) {
+      BOOST_CHECK_GE(x, 0.0);
+      BOOST_CHECK_LE(x, 1.0);
+    }
+  }
+  world.gop.fence();
+}
+
+BOOST_AUTO_TEST_CASE( contraction )
+{
+  const TiledRange trange = { tr1, tr1 };
+  TArrayD a(world, trange), b(world, trange), c, cc;
+  a.fill_random();
+  b.fill_random();
+  c("i,j") = a("i,k") * b("k,j");
+
+  // Check that the contraction of compressed arguments is within the contract
+  const double tolerance = 1.0e-6;
+  a.compression(TileCompression(TileCompression::bounded, tolerance));
+  b.compression(TileCompression(TileCompression::lossless));
+  cc("i,j") = a("i,k") * b("k,j");
+
+  // Each element of c sums K products with b in [0, 1]
+  const double bound = tolerance * double(trange.elements_range().extent()[0]);
+  BOOST_CHECK_LE((cc("i,j") - c("i,j")).abs_max().get(), bound);
+}
+
+BOOST_AUTO_TEST_CASE( complex )
+{
+  typedef Tensor<std::complex<double> > ztile_type;
+  typedef detail::TileCodec<ztile_type> zcodec_type;
+
+  // Complex tiles are sent as they are
+  ztile_type z(Range(10, 10));
+  for(std::size_t i = 0ul; i < z.size(); ++i)
+    z[i] = std::complex<double>(double(i), -double(i));
+  const zcodec_type::packed_type packed =
+      zcodec_type::compress(z, TileCompression(TileCompression::lossless));
+  const ztile_type result = zcodec_type::decompress(packed);
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), z.begin(), z.end());
+  BOOST_CHECK_EQUAL(TileCompression::raw_bytes(), 0ul);
+
+  // Check that complex arrays are found and contracted with compression set
+  const TiledRange trange = { tr1, tr1 };
+  TArrayZ a(world, trange), b(world, trange), c, cc;
+  a.fill(std::complex<double>(1.0, 2.0));
+  b.fill(std::complex<double>(3.0, -1.0));
+  c("i,j") = a("i,k") * b("k,j");
+  a.compression(TileCompression(TileCompression::lossless));
+  b.compression(TileCompression(TileCompression::single));
+  for(std::size_t i = 0ul; i < a.size(); ++i)
+    BOOST_CHECK_EQUAL(a.find(i).get().range(), a.trange().make_tile_range(i));
+  cc("i,j") = a("i,k") * b("k,j");
+  BOOST_CHECK_EQUAL((cc("i,j") - c("i,j")).norm().get(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE( collective )
+{
+  TArrayD a(world, tr);
+  a.fill_random();
+
+  // The contract must be the same on all processes
+  if(world.size() > 1)
+    BOOST_CHECK_THROW(a.compression(TileCompression(world.rank() == 0 ?
+        TileCompression::lossless : TileCompression::single)),
+        TiledArray::Exception);
+  a.compression(TileCompression(TileCompression::bounded, 1.0e-8));
+  BOOST_CHECK_EQUAL(a.compression().mode(), TileCompression::bounded);
+  BOOST_CHECK_EQUAL(a.compression().tolerance(), 1.0e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -471,5 +471,58 @@ BOOST_AUTO_TEST_CASE( tensor_contract2 )
   BOOST_CHECK_EQUAL(result_map, C);
 }
 
+BOOST_AUTO_TEST_CASE( permuted_contract )
+{
+  // Construct arguments that are contracted as left[a,b,i,j] and right[i,j,c],
+  // where left is stored as [i,a,j,b] and right is stored as [c,j,i]. The
+  // left-hand argument is large enough to be split into several panels.
+  TensorI left(TensorI::range_type(std::vector<std::size_t>{3, 1, 2, 0},
+      std::vector<std::size_t>{13, 21, 14, 20}));
+  TensorI right(TensorI::range_type(std::vector<std::size_t>{4, 2, 3},
+      std::vector<std::size_t>{11, 14, 13}));
+  rand_fill(left);
+  rand_fill(right);
+  const Permutation left_perm({2, 0, 3, 1});
+  const Permutation right_perm({2, 1, 0});
+
+  ContractReduce<TensorI, TensorI, TensorI, int>
+  op(madness::cblas::NoTrans, madness::cblas::NoTrans, 3, 3u, 4u, 3u);
+  ContractReduce<TensorI, TensorI, TensorI, int>
+  perm_op(madness::cblas::NoTrans, madness::cblas::NoTrans, 3, 3u, 4u, 3u,
+      Permutation(), left_perm, right_perm);
+  BOOST_CHECK_EQUAL(perm_op.left_perm(), left_perm);
+  BOOST_CHECK_EQUAL(perm_op.right_perm(), right_perm);
+
+  // Check that the result is equal to the contraction of permuted copies
+  TensorI expected, result;
+  op(expected, left.permute(left_perm), right.permute(right_perm));
+  BOOST_REQUIRE_NO_THROW(perm_op(result, left, right));
+  BOOST_CHECK_EQUAL(result.range(), expected.range());
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(),
+      expected.begin(), expected.end());
+
+  // Check that the contraction is accumulated to a non-empty result
+  op(expected, left.permute(left_perm), right.permute(right_perm));
+  BOOST_REQUIRE_NO_THROW(perm_op(result, left, right));
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(),
+      expected.begin(), expected.end());
+
+  // Check contraction with only one permuted argument
+  ContractReduce<TensorI, TensorI, TensorI, int>
+  left_perm_op(madness::cblas::NoTrans, madness::cblas::NoTrans, 3, 3u, 4u, 3u,
+      Permutation(), left_perm, Permutation());
+  ContractReduce<TensorI, TensorI, TensorI, int>
+  right_perm_op(madness::cblas::NoTrans, madness::cblas::NoTrans, 3, 3u, 4u, 3u,
+      Permutation(), Permutation(), right_perm);
+  TensorI reference, left_result, right_result;
+  op(reference, left.permute(left_perm), right.permute(right_perm));
+  BOOST_REQUIRE_NO_THROW(left_perm_op(left_result, left, right.permute(right_perm)));
+  BOOST_REQUIRE_NO_THROW(right_perm_op(right_result, left.permute(left_perm), right));
+  BOOST_CHECK_EQUAL_COLLECTIONS(left_result.begin(), left_result.end(),
+      reference.begin(), reference.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(right_result.begin(), right_result.end(),
+      reference.begin(), reference.end());
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
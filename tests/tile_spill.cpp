@@ -0,0 +1,264 @@
+/*
+ *  This file is a part of TiledArray.
+ *  Copyright (C) 2018  Virginia Tech
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  tile_spill.cpp
+ *  Jun 25, 2018
+ *
+ */
+
+#include "TiledArray/tile_spill.h"
+#include "tiledarray.h"
+#include "unit_test_config.h"
+#include "range_fixture.h"
+
+using namespace TiledArray;
+
+struct TileSpillFixture : public TiledRangeFixture {
+  typedef Tensor<double> tile_type;
+  typedef detail::DistributedStorage<tile_type> Storage;
+
+  /// Spill target that records the spilled tiles
+  struct Target : public detail::SpillTarget {
+    std::vector<std::size_t> spilled;
+    std::size_t pinned = -1ul; ///< A tile that cannot be spilled
+
+    virtual bool spill(const std::size_t i) {
+      if(i == pinned)
+        return false;
+      spilled.push_back(i);
+      return true;
+    }
+  }; // struct Target
+
+  TileSpillFixture() :
+    world(* GlobalFixture::world),
+    id(world.unique_obj_id()),
+    tile_bytes(detail::tile_bytes(make_tile(0), 0))
+  {
+    TileSpill::instance().reset_counters();
+  }
+
+  ~TileSpillFixture() {
+    TileSpill::instance().max_bytes(0ul);
+    TileSpill::instance().reset_counters();
+    world.gop.fence();
+  }
+
+  static tile_type make_tile(const std::size_t i) {
+    return tile_type(Range(10, 10), double(i + 1ul));
+  }
+
+  static std::vector<unsigned char> make_buffer(const unsigned char value) {
+    return std::vector<unsigned char>(100ul, value);
+  }
+
+  TiledArray::World& world;
+  madness::uniqueidT id;
+  const std::size_t tile_bytes;
+};
+
+BOOST_FIXTURE_TEST_SUITE( tile_spill_suite , TileSpillFixture )
+
+BOOST_AUTO_TEST_CASE( spill_file )
+{
+  detail::SpillFile file(TileSpill::instance().directory() + "/ta_spill_test." +
+      std::to_string(world.rank()));
+  BOOST_CHECK(! file.contains(0ul));
+
+  // Check that tiles are written and read
+  BOOST_CHECK_EQUAL(file.write(0ul, make_buffer(1u)), 100ul);
+  BOOST_CHECK_EQUAL(file.write(1ul, make_buffer(2u)), 100ul);
+  BOOST_CHECK(file.contains(0ul));
+  BOOST_CHECK(file.contains(1ul));
+  std::vector<unsigned char> buffer;
+  file.read(0ul, buffer);
+  BOOST_CHECK(buffer == make_buffer(1u));
+  file.read(1ul, buffer);
+  BOOST_CHECK(buffer == make_buffer(2u));
+
+  // Check that unmodified tiles are not written again
+  BOOST_CHECK_EQUAL(file.write(0ul, make_buffer(1u)), 0ul);
+
+  // Check that modified tiles are written back
+  BOOST_CHECK_EQUAL(file.write(0ul, make_buffer(3u)), 100ul);
+  file.read(0ul, buffer);
+  BOOST_CHECK(buffer == make_buffer(3u));
+  file.read(1ul, buffer);
+  BOOST_CHECK(buffer == make_buffer(2u));
+
+  // Check that larger tiles are moved
+  const std::vector<unsigned char> large(300ul, 4u);
+  BOOST_CHECK_EQUAL(file.write(1ul, large), 300ul);
+  file.read(1ul, buffer);
+  BOOST_CHECK(buffer == large);
+  file.read(0ul, buffer);
+  BOOST_CHECK(buffer == make_buffer(3u));
+}
+
+BOOST_AUTO_TEST_CASE( evict )
+{
+  TileSpill spill;
+  BOOST_CHECK(! spill.enabled());
+  spill.max_bytes(3ul * tile_bytes);
+  BOOST_CHECK(spill.enabled());
+
+  Target target;
+  for(std::size_t i = 0ul; i < 3ul; ++i)
+    spill.insert(&target, id, i, tile_bytes);
+  BOOST_CHECK_EQUAL(spill.size(), 3ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 3ul * tile_bytes);
+  BOOST_CHECK(target.spilled.empty());
+
+  // Use tile 0 so tile 1 is the least recently used
+  spill.insert(&target, id, 0ul, tile_bytes);
+  BOOST_CHECK_EQUAL(spill.size(), 3ul);
+
+  // Check that inserting a fourth tile evicts tile 1
+  spill.insert(&target, id, 3ul, tile_bytes);
+  BOOST_CHECK_EQUAL(spill.size(), 3ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 3ul * tile_bytes);
+  BOOST_REQUIRE_EQUAL(target.spilled.size(), 1ul);
+  BOOST_CHECK_EQUAL(target.spilled.front(), 1ul);
+
+  // Check that a tile larger than the resident set is kept
+  spill.insert(&target, id, 4ul, 4ul * tile_bytes);
+  BOOST_CHECK_EQUAL(spill.size(), 1ul);
+  BOOST_CHECK_EQUAL(target.spilled.size(), 4ul);
+
+  // Check that erased tiles are removed
+  spill.erase(&target, id);
+  BOOST_CHECK_EQUAL(spill.size(), 0ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( unspillable )
+{
+  TileSpill spill;
+  spill.max_bytes(2ul * tile_bytes);
+
+  // Check that a tile that cannot be spilled stays resident and is counted
+  Target target;
+  target.pinned = 0ul;
+  for(std::size_t i = 0ul; i < 3ul; ++i)
+    spill.insert(&target, id, i, tile_bytes);
+  BOOST_CHECK_EQUAL(spill.unspillable_count(), 1ul);
+  BOOST_CHECK_EQUAL(target.spilled.size(), 1ul);
+  BOOST_CHECK_EQUAL(target.spilled.front(), 1ul);
+  BOOST_CHECK_EQUAL(spill.size(), 2ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 2ul * tile_bytes);
+
+  spill.erase(&target, id);
+  BOOST_CHECK_EQUAL(spill.size(), 0ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 0ul);
+
+  // Check that shared tensors are kept in storage
+  TileSpill::instance().max_bytes(1ul);
+  {
+    std::shared_ptr<Pmap> pmap(new detail::BlockedPmap(world, 4ul));
+    Storage storage(world, 4ul, pmap);
+    std::vector<tile_type> held;
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i) {
+      if(storage.is_local(i)) {
+        held.push_back(make_tile(i));
+        storage.set(i, held.back());
+      }
+    }
+    BOOST_CHECK(held.empty() || detail::is_shared_tile(held.front(), 0));
+    BOOST_CHECK_EQUAL(TileSpill::instance().spill_count(), 0ul);
+    BOOST_CHECK_EQUAL(storage.size(), held.size());
+    world.gop.fence();
+  }
+  BOOST_CHECK_EQUAL(TileSpill::instance().size(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( distributed_storage )
+{
+  TileSpill& spill = TileSpill::instance();
+  spill.max_bytes(2ul * tile_bytes);
+
+  {
+    std::shared_ptr<Pmap> pmap(new detail::BlockedPmap(world, 20ul));
+    Storage storage(world, 20ul, pmap);
+    std::size_t local = 0ul;
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i) {
+      if(storage.is_local(i)) {
+        storage.set(i, make_tile(i));
+        ++local;
+      }
+    }
+
+    // Check that all but the two most recently used tiles were spilled
+    const std::size_t spilled = (local > 2ul ? local - 2ul : 0ul);
+    BOOST_CHECK_EQUAL(spill.spill_count(), spilled);
+    BOOST_CHECK_EQUAL(spill.size(), std::min(local, 2ul));
+    BOOST_CHECK_EQUAL(storage.size(), std::min(local, 2ul));
+
+    // Check that spilled tiles are read back
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i) {
+      if(storage.is_local(i)) {
+        storage.prefetch(i);
+        BOOST_CHECK_EQUAL(storage.get(i).get(), make_tile(i));
+      }
+    }
+    BOOST_CHECK_GE(spill.fill_count(), spilled);
+    BOOST_CHECK_LE(spill.bytes(), std::max(spill.max_bytes(), tile_bytes));
+
+    // Check that unmodified tiles are evicted without writing them again
+    const std::size_t spill_bytes = spill.spill_bytes();
+    for(std::size_t i = 0ul; i < storage.max_size(); ++i)
+      if(storage.is_local(i))
+        storage.get(i).get();
+    BOOST_CHECK_EQUAL(spill.spill_bytes(), spill_bytes);
+    if(spilled)
+      BOOST_CHECK_GT(spill.fill_bandwidth(), 0.0);
+
+    world.gop.fence();
+  }
+
+  // Check that the tiles are removed when the container is destroyed
+  BOOST_CHECK_EQUAL(spill.size(), 0ul);
+  BOOST_CHECK_EQUAL(spill.bytes(), 0ul);
+}
+
+BOOST_AUTO_TEST_CASE( contraction )
+{
+  const TiledRange trange = { tr1, tr1 };
+  TArrayD a(world, trange), b(world, trange);
+  a.fill_random();
+  b.fill_random();
+  TArrayD c;
+  c("i,j") = a("i,k") * b("k,j");
+
+  // Copy the arguments into arrays that spill all but one tile
+  TileSpill& spill = TileSpill::instance();
+  spill.max_bytes(1ul);
+  TArrayD sa(world, trange), sb(world, trange);
+  sa("i,j") = a("i,j");
+  sb("i,j") = b("i,j");
+  world.gop.fence();
+
+  TArrayD sc;
+  sc("i,j") = sa("i,k") * sb("k,j");
+  spill.max_bytes(0ul);
+
+  BOOST_CHECK_SMALL((sc("i,j") - c("i,j")).norm().get(), 1.0e-10);
+  double count = spill.fill_count();
+  world.gop.sum(count);
+  BOOST_CHECK_GT(count, 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -184,6 +184,25 @@ BOOST_AUTO_TEST_CASE( element_to_tile )
   BOOST_CHECK_EQUAL_COLLECTIONS(c.begin(), c.end(), e.begin(), e.end());
 }
 
+BOOST_AUTO_TEST_CASE( element_to_tile_uniform )
+{
+  // Check uniform tilings, with and without a smaller last tile, and a
+  // tiling where only the last tile is larger.
+  std::vector<TiledRange1> ranges = { TiledRange1{ 3, 7, 11, 15, 19 },
+      TiledRange1{ 3, 7, 11, 15, 17 }, TiledRange1{ 3, 7, 11, 15, 21 },
+      TiledRange1{ 3, 4 } };
+
+  for(const TiledRange1& r : ranges) {
+    for(std::size_t t = r.tiles_range().first; t < r.tiles_range().second; ++t) {
+      for(std::size_t i = r.tile(t).first; i < r.tile(t).second; ++i) {
+        BOOST_CHECK_EQUAL(r.element_to_tile(i), t);
+        BOOST_CHECK(r.find(i) == (r.begin() + (t - r.tiles_range().first)));
+      }
+    }
+    BOOST_CHECK(r.find(r.elements_range().second) == r.end());
+  }
+}
+
 BOOST_AUTO_TEST_CASE( comparison )
 {
   TiledRange1 r1{ 1, 2, 4, 6, 8, 10 };